@@ -43,14 +43,19 @@ SOURCES += \
     src/widgets/settingsdialog.cpp \
     src/widgets/messagedialog.cpp \
     src/widgets/profiledialog.cpp \
+    src/widgets/mapdiagnosticsoverlay.cpp \
     src/tilemap/tilemapmanager.cpp \
     src/tilemap/tileworker.cpp \
+    src/tilemap/tilecompositor.cpp \
     src/tilemap/manifeststore.cpp \
     src/tilemap/downloadscheduler.cpp \
     src/core/common/logger.cpp \
     src/core/common/config.cpp \
     src/core/utils/idgenerator.cpp \
     src/core/database/databasemanager.cpp \
+    src/core/database/changelistener.cpp \
+    src/core/database/offlineexporter.cpp \
+    src/core/database/queryprofiler.cpp \
     src/core/models/pipeline.cpp \
     src/core/models/workorder.cpp \
     src/core/models/facility.cpp \
@@ -61,15 +66,37 @@ SOURCES += \
     src/core/commands/drawcommand.cpp \
     src/core/io/drawingdatamanager.cpp \
     src/core/io/drawingdatabasemanager.cpp \
+    src/core/io/streamingpngwriter.cpp \
+    src/core/io/wkbcodec.cpp \
     src/dao/pipelinedao.cpp \
     src/dao/workorderdao.cpp \
     src/dao/facilitydao.cpp \
     src/dao/userdao.cpp \
+    src/dao/bulkwriter.cpp \
+    src/dao/assetstatisticsdao.cpp \
+    src/dao/entitycache.cpp \
+    src/dao/asyncdao.cpp \
+    src/dao/sqldialect.cpp \
     src/map/layermanager.cpp \
     src/map/symbolmanager.cpp \
     src/map/pipelinerenderer.cpp \
     src/map/facilityrenderer.cpp \
+    src/map/facilityclusterindex.cpp \
+    src/map/facilityclusteritem.cpp \
     src/map/annotationrenderer.cpp \
+    src/map/labelengine.cpp \
+    src/map/labellayeritem.cpp \
+    src/map/heatmaprenderer.cpp \
+    src/map/heatmaplayeritem.cpp \
+    src/map/layeritemregistry.cpp \
+    src/map/vectortilecache.cpp \
+    src/map/entitypickindex.cpp \
+    src/map/entitygraphicsitem.cpp \
+    src/map/viewupdatescheduler.cpp \
+    src/map/mapexportengine.cpp \
+    src/map/vectortilelayeritem.cpp \
+    src/map/thematicattributetable.cpp \
+    src/map/thematicrenderer.cpp \
     src/map/mapdrawingmanager.cpp \
     src/analysis/spatialanalyzer.cpp \
     src/analysis/burstanalyzer.cpp \
@@ -104,34 +131,62 @@ HEADERS += \
     src/widgets/settingsdialog.h \
     src/widgets/messagedialog.h \
     src/widgets/profiledialog.h \
+    src/widgets/mapdiagnosticsoverlay.h \
     src/tilemap/tilemapmanager.h \
     src/tilemap/tileworker.h \
+    src/tilemap/tilecompositor.h \
     src/tilemap/manifeststore.h \
     src/tilemap/downloadscheduler.h \
     src/core/common/logger.h \
     src/core/common/config.h \
     src/core/utils/idgenerator.h \
     src/core/database/databasemanager.h \
+    src/core/database/changelistener.h \
+    src/core/database/offlineexporter.h \
+    src/core/database/queryprofiler.h \
     src/core/models/pipeline.h \
     src/core/models/workorder.h \
     src/core/models/facility.h \
     src/core/models/user.h \
+    src/core/models/renderrecord.h \
     src/core/auth/sessionmanager.h \
     src/core/auth/permissionmanager.h \
     src/core/workorder/workorderstatustransition.h \
     src/core/commands/drawcommand.h \
     src/core/io/drawingdatamanager.h \
     src/core/io/drawingdatabasemanager.h \
+    src/core/io/streamingpngwriter.h \
+    src/core/io/wkbcodec.h \
     src/dao/basedao.h \
     src/dao/pipelinedao.h \
     src/dao/workorderdao.h \
     src/dao/facilitydao.h \
     src/dao/userdao.h \
+    src/dao/bulkwriter.h \
+    src/dao/assetstatisticsdao.h \
+    src/dao/entitycache.h \
+    src/dao/asyncdao.h \
+    src/dao/sqldialect.h \
     src/map/layermanager.h \
     src/map/symbolmanager.h \
     src/map/pipelinerenderer.h \
     src/map/facilityrenderer.h \
+    src/map/facilityclusterindex.h \
+    src/map/facilityclusteritem.h \
     src/map/annotationrenderer.h \
+    src/map/labelengine.h \
+    src/map/labellayeritem.h \
+    src/map/heatmaprenderer.h \
+    src/map/heatmaplayeritem.h \
+    src/map/layeritemregistry.h \
+    src/map/vectortilecache.h \
+    src/map/entitypickindex.h \
+    src/map/entitygraphicsitem.h \
+    src/map/viewupdatescheduler.h \
+    src/map/mapexportengine.h \
+    src/map/vectortilelayeritem.h \
+    src/map/thematicattributetable.h \
+    src/map/thematicrenderer.h \
     src/map/mapdrawingmanager.h \
     src/analysis/spatialanalyzer.h \
     src/analysis/burstanalyzer.h \
@@ -0,0 +1,232 @@
+-- ==========================================
+-- UGIMS 资产统计汇总表
+-- 资产统计报表对话框按 (资产类别, 统计维度, 分类) 读取预聚合结果，
+-- 打开耗时与资产数量无关；pipelines / facilities 的增删改由语句级触发器
+-- 通过转换表增量维护汇总行
+--
+-- 在 schema.sql 之后执行（可重复执行，末尾会全量重建汇总）：
+--   psql -U postgres -d ugims -f database/asset_statistics.sql
+--
+-- 分类规则须与 AssetStatisticsDAO 中的实时聚合表达式保持一致
+--
+-- 并发取舍：汇总行是热点行，写入同一分类的并发事务在行锁上排队直到提交
+-- （如多个客户端同时修改同类型管线）。编辑类负载下等待很短；若大批量导入与
+-- 在线编辑长时间并发，可改为只追加差量行、读取时再聚合，以牺牲读取速度换取无锁写入。
+-- 计数归零的分类行只在本语句扣除过的分类中清理，不扫描、不锁定其他分类行
+-- ==========================================
+
+CREATE TABLE IF NOT EXISTS asset_statistics (
+    asset_kind VARCHAR(20) NOT NULL,     -- pipeline, facility
+    dimension VARCHAR(30) NOT NULL,      -- type, status, material, build_year, health_level, length, diameter
+    bucket VARCHAR(100) NOT NULL,
+    item_count BIGINT NOT NULL DEFAULT 0,
+    length_sum DOUBLE PRECISION NOT NULL DEFAULT 0,
+    health_sum BIGINT NOT NULL DEFAULT 0,
+    PRIMARY KEY (asset_kind, dimension, bucket)
+);
+
+COMMENT ON TABLE asset_statistics IS '资产统计汇总表（触发器增量维护）';
+
+-- ==========================================
+-- 分类函数
+-- ==========================================
+CREATE OR REPLACE FUNCTION asset_build_year_bucket(d DATE)
+RETURNS TEXT AS $$
+    SELECT CASE
+        WHEN d IS NULL THEN '未知'
+        WHEN EXTRACT(YEAR FROM d) < 1980 THEN '1980年以前'
+        WHEN EXTRACT(YEAR FROM d) < 1990 THEN '1980-1989年'
+        WHEN EXTRACT(YEAR FROM d) < 2000 THEN '1990-1999年'
+        WHEN EXTRACT(YEAR FROM d) < 2010 THEN '2000-2009年'
+        WHEN EXTRACT(YEAR FROM d) < 2020 THEN '2010-2019年'
+        ELSE '2020年及以后'
+    END
+$$ LANGUAGE sql IMMUTABLE;
+
+CREATE OR REPLACE FUNCTION asset_health_level_bucket(score INTEGER)
+RETURNS TEXT AS $$
+    SELECT CASE
+        WHEN COALESCE(score, 0) >= 90 THEN '优秀(90-100)'
+        WHEN COALESCE(score, 0) >= 80 THEN '良好(80-89)'
+        WHEN COALESCE(score, 0) >= 60 THEN '一般(60-79)'
+        WHEN COALESCE(score, 0) >= 40 THEN '较差(40-59)'
+        ELSE '危险(0-39)'
+    END
+$$ LANGUAGE sql IMMUTABLE;
+
+-- 每条管线落入的 (维度, 分类)
+CREATE OR REPLACE FUNCTION pipeline_statistics_buckets(p pipelines)
+RETURNS TABLE(dimension TEXT, bucket TEXT) AS $$
+    VALUES
+        ('type', p.pipeline_type::TEXT),
+        ('status', COALESCE(NULLIF(p.status, ''), '未知')::TEXT),
+        ('material', COALESCE(NULLIF(p.material, ''), '未知')::TEXT),
+        ('build_year', asset_build_year_bucket(p.build_date)),
+        ('health_level', asset_health_level_bucket(p.health_score)),
+        ('length', CASE
+            WHEN COALESCE(p.length_m, 0) < 100 THEN '0-100m'
+            WHEN p.length_m < 500 THEN '100-500m'
+            WHEN p.length_m < 1000 THEN '500-1000m'
+            WHEN p.length_m < 2000 THEN '1000-2000m'
+            ELSE '2000m以上'
+        END),
+        ('diameter', CASE
+            WHEN COALESCE(p.diameter_mm, 0) < 50 THEN 'DN50以下'
+            WHEN p.diameter_mm < 100 THEN 'DN50-DN100'
+            WHEN p.diameter_mm < 200 THEN 'DN100-DN200'
+            WHEN p.diameter_mm < 500 THEN 'DN200-DN500'
+            ELSE 'DN500以上'
+        END)
+$$ LANGUAGE sql IMMUTABLE;
+
+-- 每个设施落入的 (维度, 分类)
+CREATE OR REPLACE FUNCTION facility_statistics_buckets(f facilities)
+RETURNS TABLE(dimension TEXT, bucket TEXT) AS $$
+    VALUES
+        ('type', f.facility_type::TEXT),
+        ('status', COALESCE(NULLIF(f.status, ''), '未知')::TEXT),
+        ('material', COALESCE(NULLIF(f.material, ''), '未知')::TEXT),
+        ('build_year', asset_build_year_bucket(f.build_date)),
+        ('health_level', asset_health_level_bucket(f.health_score))
+$$ LANGUAGE sql IMMUTABLE;
+
+-- ==========================================
+-- 增量维护：direction 为 1 计入、-1 扣除
+-- ==========================================
+CREATE OR REPLACE FUNCTION apply_pipeline_statistics(changed pipelines[], direction INTEGER)
+RETURNS VOID AS $$
+    INSERT INTO asset_statistics AS s (asset_kind, dimension, bucket, item_count, length_sum, health_sum)
+    SELECT 'pipeline', b.dimension, b.bucket,
+           direction * COUNT(*),
+           direction * SUM(COALESCE(p.length_m, 0)),
+           direction * SUM(COALESCE(p.health_score, 0))
+    FROM unnest(changed) AS p, LATERAL pipeline_statistics_buckets(p) AS b
+    GROUP BY b.dimension, b.bucket
+    ON CONFLICT (asset_kind, dimension, bucket) DO UPDATE SET
+        item_count = s.item_count + EXCLUDED.item_count,
+        length_sum = s.length_sum + EXCLUDED.length_sum,
+        health_sum = s.health_sum + EXCLUDED.health_sum;
+$$ LANGUAGE sql;
+
+CREATE OR REPLACE FUNCTION apply_facility_statistics(changed facilities[], direction INTEGER)
+RETURNS VOID AS $$
+    INSERT INTO asset_statistics AS s (asset_kind, dimension, bucket, item_count, length_sum, health_sum)
+    SELECT 'facility', b.dimension, b.bucket,
+           direction * COUNT(*),
+           0,
+           direction * SUM(COALESCE(f.health_score, 0))
+    FROM unnest(changed) AS f, LATERAL facility_statistics_buckets(f) AS b
+    GROUP BY b.dimension, b.bucket
+    ON CONFLICT (asset_kind, dimension, bucket) DO UPDATE SET
+        item_count = s.item_count + EXCLUDED.item_count,
+        health_sum = s.health_sum + EXCLUDED.health_sum;
+$$ LANGUAGE sql;
+
+-- 语句级触发器：每条语句只合并一次差量，批量写入（BulkWriter）不会逐行放大
+CREATE OR REPLACE FUNCTION pipelines_statistics_trigger()
+RETURNS TRIGGER AS $$
+DECLARE
+    old_array pipelines[];
+BEGIN
+    IF TG_OP IN ('UPDATE', 'DELETE') THEN
+        old_array := ARRAY(SELECT o FROM old_rows o);
+        PERFORM apply_pipeline_statistics(old_array, -1);
+    END IF;
+    IF TG_OP IN ('INSERT', 'UPDATE') THEN
+        PERFORM apply_pipeline_statistics(ARRAY(SELECT n FROM new_rows n), 1);
+    END IF;
+    -- 只有扣除能使计数归零：只清理本语句扣除过的分类
+    IF old_array IS NOT NULL THEN
+        DELETE FROM asset_statistics s
+        USING (SELECT DISTINCT b.dimension, b.bucket
+               FROM unnest(old_array) AS x, LATERAL pipeline_statistics_buckets(x) AS b) AS touched
+        WHERE s.asset_kind = 'pipeline'
+          AND s.dimension = touched.dimension
+          AND s.bucket = touched.bucket
+          AND s.item_count = 0;
+    END IF;
+    RETURN NULL;
+END;
+$$ LANGUAGE plpgsql;
+
+CREATE OR REPLACE FUNCTION facilities_statistics_trigger()
+RETURNS TRIGGER AS $$
+DECLARE
+    old_array facilities[];
+BEGIN
+    IF TG_OP IN ('UPDATE', 'DELETE') THEN
+        old_array := ARRAY(SELECT o FROM old_rows o);
+        PERFORM apply_facility_statistics(old_array, -1);
+    END IF;
+    IF TG_OP IN ('INSERT', 'UPDATE') THEN
+        PERFORM apply_facility_statistics(ARRAY(SELECT n FROM new_rows n), 1);
+    END IF;
+    -- 只有扣除能使计数归零：只清理本语句扣除过的分类
+    IF old_array IS NOT NULL THEN
+        DELETE FROM asset_statistics s
+        USING (SELECT DISTINCT b.dimension, b.bucket
+               FROM unnest(old_array) AS x, LATERAL facility_statistics_buckets(x) AS b) AS touched
+        WHERE s.asset_kind = 'facility'
+          AND s.dimension = touched.dimension
+          AND s.bucket = touched.bucket
+          AND s.item_count = 0;
+    END IF;
+    RETURN NULL;
+END;
+$$ LANGUAGE plpgsql;
+
+DROP TRIGGER IF EXISTS pipelines_statistics_insert ON pipelines;
+DROP TRIGGER IF EXISTS pipelines_statistics_update ON pipelines;
+DROP TRIGGER IF EXISTS pipelines_statistics_delete ON pipelines;
+DROP TRIGGER IF EXISTS facilities_statistics_insert ON facilities;
+DROP TRIGGER IF EXISTS facilities_statistics_update ON facilities;
+DROP TRIGGER IF EXISTS facilities_statistics_delete ON facilities;
+
+CREATE TRIGGER pipelines_statistics_insert AFTER INSERT ON pipelines
+    REFERENCING NEW TABLE AS new_rows
+    FOR EACH STATEMENT EXECUTE FUNCTION pipelines_statistics_trigger();
+
+CREATE TRIGGER pipelines_statistics_update AFTER UPDATE ON pipelines
+    REFERENCING OLD TABLE AS old_rows NEW TABLE AS new_rows
+    FOR EACH STATEMENT EXECUTE FUNCTION pipelines_statistics_trigger();
+
+CREATE TRIGGER pipelines_statistics_delete AFTER DELETE ON pipelines
+    REFERENCING OLD TABLE AS old_rows
+    FOR EACH STATEMENT EXECUTE FUNCTION pipelines_statistics_trigger();
+
+CREATE TRIGGER facilities_statistics_insert AFTER INSERT ON facilities
+    REFERENCING NEW TABLE AS new_rows
+    FOR EACH STATEMENT EXECUTE FUNCTION facilities_statistics_trigger();
+
+CREATE TRIGGER facilities_statistics_update AFTER UPDATE ON facilities
+    REFERENCING OLD TABLE AS old_rows NEW TABLE AS new_rows
+    FOR EACH STATEMENT EXECUTE FUNCTION facilities_statistics_trigger();
+
+CREATE TRIGGER facilities_statistics_delete AFTER DELETE ON facilities
+    REFERENCING OLD TABLE AS old_rows
+    FOR EACH STATEMENT EXECUTE FUNCTION facilities_statistics_trigger();
+
+-- ==========================================
+-- 全量重建（初次安装或怀疑汇总漂移时调用：SELECT refresh_asset_statistics();）
+-- ==========================================
+CREATE OR REPLACE FUNCTION refresh_asset_statistics()
+RETURNS VOID AS $$
+BEGIN
+    LOCK TABLE asset_statistics IN EXCLUSIVE MODE;
+    DELETE FROM asset_statistics;
+
+    INSERT INTO asset_statistics (asset_kind, dimension, bucket, item_count, length_sum, health_sum)
+    SELECT 'pipeline', b.dimension, b.bucket, COUNT(*),
+           SUM(COALESCE(p.length_m, 0)), SUM(COALESCE(p.health_score, 0))
+    FROM pipelines p, LATERAL pipeline_statistics_buckets(p) AS b
+    GROUP BY b.dimension, b.bucket;
+
+    INSERT INTO asset_statistics (asset_kind, dimension, bucket, item_count, length_sum, health_sum)
+    SELECT 'facility', b.dimension, b.bucket, COUNT(*),
+           0, SUM(COALESCE(f.health_score, 0))
+    FROM facilities f, LATERAL facility_statistics_buckets(f) AS b
+    GROUP BY b.dimension, b.bucket;
+END;
+$$ LANGUAGE plpgsql;
+
+SELECT refresh_asset_statistics();
@@ -0,0 +1,53 @@
+-- ==========================================
+-- UGIMS 数据变更通知
+-- pipelines / facilities 的每次增删改在事务提交时通过 NOTIFY ugims_changes
+-- 广播 (表名, 操作, 主键, 业务编号, 来源会话)，各客户端的 ChangeListener
+-- 据此增量刷新实体缓存、图层与设备树，不再整表重载
+--
+-- 在 schema.sql 之后执行（可重复执行）：
+--   psql -U postgres -d ugims -f database/change_notify.sql
+--
+-- 负载示例：{"table":"pipelines","op":"UPDATE","id":42,"key":"WS-001","src":"UGIMS-1234-5678"}
+-- src 为写入方连接的 application_name，客户端据此忽略自身产生的通知
+-- ==========================================
+
+CREATE OR REPLACE FUNCTION notify_asset_change()
+RETURNS TRIGGER AS $$
+DECLARE
+    key_column TEXT := CASE TG_TABLE_NAME WHEN 'pipelines' THEN 'pipeline_id' ELSE 'facility_id' END;
+    old_key TEXT;
+    new_key TEXT;
+    source TEXT := current_setting('application_name', true);
+BEGIN
+    IF TG_OP IN ('UPDATE', 'DELETE') THEN
+        old_key := to_jsonb(OLD) ->> key_column;
+    END IF;
+    IF TG_OP IN ('INSERT', 'UPDATE') THEN
+        new_key := to_jsonb(NEW) ->> key_column;
+    END IF;
+
+    -- 业务编号变化时拆成删除旧编号 + 插入新编号，客户端按编号索引图形项
+    IF TG_OP = 'UPDATE' AND old_key IS DISTINCT FROM new_key THEN
+        PERFORM pg_notify('ugims_changes', json_build_object(
+            'table', TG_TABLE_NAME, 'op', 'DELETE', 'id', OLD.id, 'key', old_key, 'src', source)::TEXT);
+        PERFORM pg_notify('ugims_changes', json_build_object(
+            'table', TG_TABLE_NAME, 'op', 'INSERT', 'id', NEW.id, 'key', new_key, 'src', source)::TEXT);
+    ELSIF TG_OP = 'DELETE' THEN
+        PERFORM pg_notify('ugims_changes', json_build_object(
+            'table', TG_TABLE_NAME, 'op', TG_OP, 'id', OLD.id, 'key', old_key, 'src', source)::TEXT);
+    ELSE
+        PERFORM pg_notify('ugims_changes', json_build_object(
+            'table', TG_TABLE_NAME, 'op', TG_OP, 'id', NEW.id, 'key', new_key, 'src', source)::TEXT);
+    END IF;
+    RETURN NULL;
+END;
+$$ LANGUAGE plpgsql;
+
+DROP TRIGGER IF EXISTS pipelines_notify_change ON pipelines;
+DROP TRIGGER IF EXISTS facilities_notify_change ON facilities;
+
+CREATE TRIGGER pipelines_notify_change AFTER INSERT OR UPDATE OR DELETE ON pipelines
+    FOR EACH ROW EXECUTE FUNCTION notify_asset_change();
+
+CREATE TRIGGER facilities_notify_change AFTER INSERT OR UPDATE OR DELETE ON facilities
+    FOR EACH ROW EXECUTE FUNCTION notify_asset_change();
@@ -402,6 +402,10 @@ CREATE TRIGGER update_work_orders_updated_at BEFORE UPDATE ON work_orders
 CREATE TRIGGER update_users_updated_at BEFORE UPDATE ON users
     FOR EACH ROW EXECUTE FUNCTION update_updated_at_column();
 
+-- 故障报修：热力图按 updated_at 探测数据版本
+CREATE TRIGGER update_fault_reports_updated_at BEFORE UPDATE ON fault_reports
+    FOR EACH ROW EXECUTE FUNCTION update_updated_at_column();
+
 -- ==========================================
 -- 视图：管线统计
 -- ==========================================
@@ -2,6 +2,8 @@
 #include "dao/pipelinedao.h"
 #include "dao/facilitydao.h"
 #include "core/common/logger.h"
+#include "core/database/databasemanager.h"
+#include "core/database/queryprofiler.h"
 #include <QDebug>
 #include <QtMath>
 #include <QFuture>
@@ -39,6 +41,7 @@ void BurstAnalyzer::setUserDensity(int usersPerKm2)
 BurstAnalysisResult BurstAnalyzer::analyzeBurst(const QPointF &burstPoint, const QString &pipelineId)
 {
     qDebug() << "[BurstAnalyzer] Starting burst analysis at point:" << burstPoint;
+    QueryProfiler::ActionScope profileScope("爆管分析");
     
     BurstAnalysisResult result;
     result.burstLocation = burstPoint;
@@ -111,8 +114,8 @@ BurstAnalysisResult BurstAnalyzer::analyzeBurst(const QPointF &burstPoint, const
 
 void BurstAnalyzer::analyzeBurstAsync(const QPointF &burstPoint, const QString &pipelineId)
 {
-    // 使用QtConcurrent异步执行分析
-    QFuture<BurstAnalysisResult> future = QtConcurrent::run([this, burstPoint, pipelineId]() {
+    // 在数据库任务线程池中异步执行分析（线程各自持有连接）
+    QFuture<BurstAnalysisResult> future = QtConcurrent::run(DatabaseManager::instance().queryPool(), [this, burstPoint, pipelineId]() {
         return analyzeBurst(burstPoint, pipelineId);
     });
     
@@ -193,13 +196,16 @@ QList<QString> BurstAnalyzer::findAffectedValves(const QString &pipelineId, cons
             return valveList;
         }
         
-        // 查找附近的所有阀门
+        // 查找所有阀门，同时查找其他类型的关键设施（如接头）；按键集分页遍历，不截断
         FacilityDAO facilityDao;
-        QVector<Facility> allFacilities = facilityDao.findByType("valve", 1000);
-        
-        // 同时查找其他类型的关键设施（如消火栓、接头）
-        QVector<Facility> otherFacilities = facilityDao.findByType("junction", 1000);
-        allFacilities.append(otherFacilities);
+        QVector<Facility> allFacilities;
+        QVariantMap typeParams;
+        typeParams[":valve"] = "valve";
+        typeParams[":junction"] = "junction";
+        facilityDao.forEach([&allFacilities](const Facility &facility) {
+            allFacilities.append(facility);
+            return true;
+        }, "facility_type IN (:valve, :junction)", typeParams);
         
         // 计算管线的上游和下游阀门
         // 首先，找到爆管点在管线上的位置
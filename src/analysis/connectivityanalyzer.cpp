@@ -1,6 +1,7 @@
 #include "connectivityanalyzer.h"
 #include "dao/pipelinedao.h"
 #include "core/database/databasemanager.h"
+#include "core/database/queryprofiler.h"
 #include "core/common/logger.h"
 #include <QDebug>
 #include <QQueue>
@@ -67,6 +68,7 @@ ConnectivityResult ConnectivityAnalyzer::traceDownstream(const QPointF &startPoi
 ConnectivityResult ConnectivityAnalyzer::findShortestPath(const QPointF &startPoint, const QPointF &endPoint)
 {
     qDebug() << "[ConnectivityAnalyzer] Finding shortest path from:" << startPoint << "to:" << endPoint;
+    QueryProfiler::ActionScope profileScope("最短路径分析");
     
     ConnectivityResult result;
     result.type = ConnectivityType::ShortestPath;
@@ -239,20 +241,11 @@ ConnectivityResult ConnectivityAnalyzer::checkNetworkConnectivity()
     try {
         PipelineDAO dao;
         
-        // 获取所有管线（限制数量以避免性能问题）
-        QVector<Pipeline> allPipelines = dao.findByBounds(QRectF(-180, -90, 360, 180), 10000);
-        
-        if (allPipelines.isEmpty()) {
-            result.success = false;
-            result.message = "未找到管网数据";
-            return result;
-        }
-        
-        // 构建图：管线ID -> 连接的管线ID列表
+        // 构建图：管线ID -> 连接的管线ID列表（流式遍历全部管线，不设数量上限）
         QMap<QString, QSet<QString>> graph;
         QSet<QString> allNodes;
         
-        for (const Pipeline &pipeline : allPipelines) {
+        int pipelineCount = dao.forEach([&](const Pipeline &pipeline) {
             QString pid = pipeline.pipelineId();
             allNodes.insert(pid);
             graph[pid] = QSet<QString>();
@@ -260,7 +253,7 @@ ConnectivityResult ConnectivityAnalyzer::checkNetworkConnectivity()
             // 查找连接的管线
             QPair<QPointF, QPointF> endpoints = getPipelineEndpoints(pid);
             if (endpoints.first.isNull() || endpoints.second.isNull()) {
-                continue;
+                return true;
             }
             
             QList<QString> connected1 = findConnectedPipelines(pid, endpoints.first, m_connectionTolerance);
@@ -272,6 +265,13 @@ ConnectivityResult ConnectivityAnalyzer::checkNetworkConnectivity()
             for (const QString &connected : connected2) {
                 graph[pid].insert(connected);
             }
+            return true;
+        });
+        
+        if (pipelineCount <= 0) {
+            result.success = false;
+            result.message = "未找到管网数据";
+            return result;
         }
         
         // 使用DFS检查连通性
@@ -364,25 +364,18 @@ QList<QList<QString>> ConnectivityAnalyzer::detectLoops()
     try {
         PipelineDAO dao;
         
-        // 获取所有管线
-        QVector<Pipeline> allPipelines = dao.findByBounds(QRectF(-180, -90, 360, 180), 10000);
-        
-        if (allPipelines.isEmpty()) {
-            return loops;
-        }
-        
-        // 构建图
+        // 构建图（流式遍历全部管线）
         QMap<QString, QSet<QString>> graph;
         QSet<QString> allNodes;
         
-        for (const Pipeline &pipeline : allPipelines) {
+        int pipelineCount = dao.forEach([&](const Pipeline &pipeline) {
             QString pid = pipeline.pipelineId();
             allNodes.insert(pid);
             graph[pid] = QSet<QString>();
             
             QPair<QPointF, QPointF> endpoints = getPipelineEndpoints(pid);
             if (endpoints.first.isNull() || endpoints.second.isNull()) {
-                continue;
+                return true;
             }
             
             QList<QString> connected1 = findConnectedPipelines(pid, endpoints.first, m_connectionTolerance);
@@ -394,6 +387,11 @@ QList<QList<QString>> ConnectivityAnalyzer::detectLoops()
             for (const QString &connected : connected2) {
                 graph[pid].insert(connected);
             }
+            return true;
+        });
+        
+        if (pipelineCount <= 0) {
+            return loops;
         }
         
         // 使用DFS查找所有环
@@ -854,6 +852,9 @@ QList<QString> ConnectivityAnalyzer::findConnectedPipelines(const QString &pipel
 
 ConnectivityResult ConnectivityAnalyzer::bfsTrace(const QPointF &startPoint, bool upstream, int maxDepth)
 {
+    // 每访问一条管线都会查询相邻管线，整个追踪作为一次用户操作检查 N+1
+    QueryProfiler::ActionScope profileScope(upstream ? "上游追踪" : "下游追踪");
+
     ConnectivityResult result;
     result.type = upstream ? ConnectivityType::Upstream : ConnectivityType::Downstream;
     result.startPoint = startPoint;
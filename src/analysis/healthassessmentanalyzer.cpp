@@ -3,6 +3,8 @@
 #include "core/models/facility.h"
 #include "dao/pipelinedao.h"
 #include "dao/facilitydao.h"
+#include "dao/bulkwriter.h"
+#include "core/common/logger.h"
 #include <QDate>
 #include <QDebug>
 #include <QColor>
@@ -141,30 +143,27 @@ QMap<QString, int> HealthAssessmentAnalyzer::batchAssessPipelines()
     statistics["危险"] = 0;
     
     PipelineDAO dao;
-    // 查询所有类型的管线（因为 BaseDAO::findAll 不包含 ST_AsText，需要分别查询）
-    QVector<Pipeline> pipelines;
-    QStringList types = {"water_supply", "sewage", "gas", "electric", "telecom", "heat"};
-    for (const QString &type : types) {
-        QVector<Pipeline> typePipelines = dao.findByType(type, 10000);
-        pipelines.append(typePipelines);
-    }
-    
-    int total = pipelines.size();
+    // 流式遍历全部管线（按批读取，不设数量上限）
+    int total = dao.count();
     int current = 0;
     
-    for (const Pipeline &pipeline : pipelines) {
+    BulkWriter writer(dao.tableName(), BulkWriter::Update, {"id", "integer"},
+                      {{"health_score", "integer"}});
+    dao.forEach([&](const Pipeline &pipeline) {
         HealthAssessmentResult result = assessPipeline(pipeline);
         
-        // 更新健康度分数到数据库
-        Pipeline updatedPipeline = pipeline;
-        updatedPipeline.setHealthScore(result.score);
-        dao.update(updatedPipeline, pipeline.id());
+        // 健康度分数按批写回（单事务、只更新 health_score 列）
+        writer.add(pipeline.id(), {result.score});
         
         // 统计
         statistics[result.level]++;
         
         current++;
         emit assessmentProgress(current, total);
+        return true;
+    });
+    if (!writer.finish()) {
+        LOG_ERROR(QString("Failed to write health scores: %1").arg(writer.lastError()));
     }
     
     emit assessmentComplete(total, 0);
@@ -181,24 +180,27 @@ QMap<QString, int> HealthAssessmentAnalyzer::batchAssessFacilities()
     statistics["危险"] = 0;
     
     FacilityDAO dao;
-    QVector<Facility> facilities = dao.findAll(10000); // 查询所有设施
-    
-    int total = facilities.size();
+    // 流式遍历全部设施
+    int total = dao.count();
     int current = 0;
     
-    for (const Facility &facility : facilities) {
+    BulkWriter writer(dao.tableName(), BulkWriter::Update, {"id", "integer"},
+                      {{"health_score", "integer"}});
+    dao.forEach([&](const Facility &facility) {
         HealthAssessmentResult result = assessFacility(facility);
         
-        // 更新健康度分数到数据库
-        Facility updatedFacility = facility;
-        updatedFacility.setHealthScore(result.score);
-        dao.update(updatedFacility, facility.id());
+        // 健康度分数按批写回（单事务、只更新 health_score 列）
+        writer.add(facility.id(), {result.score});
         
         // 统计
         statistics[result.level]++;
         
         current++;
         emit assessmentProgress(current, total);
+        return true;
+    });
+    if (!writer.finish()) {
+        LOG_ERROR(QString("Failed to write health scores: %1").arg(writer.lastError()));
     }
     
     emit assessmentComplete(0, total);
@@ -282,19 +282,23 @@ QList<QString> SpatialAnalyzer::queryByBox(const QRectF &box)
     qDebug() << "[SpatialAnalyzer] Query by box:" << box;
     
     try {
+        // 按键集分页遍历框内全部实体，不截断
+        QVariantMap boundsParams;
+        SqlDialect::bindBounds(boundsParams, box);
+
         // 查询管线
         PipelineDAO pipelineDao;
-        QVector<Pipeline> pipelines = pipelineDao.findByBounds(box, 1000);
-        for (const Pipeline &pipeline : pipelines) {
+        pipelineDao.forEach([&results](const Pipeline &pipeline) {
             results.append(pipeline.pipelineId());
-        }
+            return true;
+        }, pipelineDao.dialect().intersectsBoundsFilter(pipelineDao.tableName()), boundsParams);
         
         // 查询设施
         FacilityDAO facilityDao;
-        QVector<Facility> facilities = facilityDao.findByBounds(box, 1000);
-        for (const Facility &facility : facilities) {
+        facilityDao.forEach([&results](const Facility &facility) {
             results.append(facility.facilityId());
-        }
+            return true;
+        }, facilityDao.dialect().withinBoundsFilter(facilityDao.tableName()), boundsParams);
         
         qDebug() << "[SpatialAnalyzer] Found" << results.size() << "entities in box";
         
@@ -1,4 +1,6 @@
 #include "core/commands/drawcommand.h"
+#include "map/entitypickindex.h"
+#include "map/entitygraphicsitem.h"
 #include <QGraphicsPathItem>
 #include <QGraphicsEllipseItem>
 #include <QPen>
@@ -144,17 +146,13 @@ void ChangeStyleCommand::applyStyle(const QColor &color, int width)
         return;
     }
     
-    // 保存到data
-    m_item->setData(3, color);
-    m_item->setData(4, width);
-    
-    // 应用到图形
-    if (auto pathItem = qgraphicsitem_cast<QGraphicsPathItem*>(m_item)) {
+    // 应用到图形（样式只保存在画笔/画刷中；实体图形项为子类，用 dynamic_cast 匹配）
+    if (auto pathItem = dynamic_cast<QGraphicsPathItem*>(m_item)) {
         QPen pen = pathItem->pen();
         pen.setColor(color);
         pen.setWidth(width);
         pathItem->setPen(pen);
-    } else if (auto ellipseItem = qgraphicsitem_cast<QGraphicsEllipseItem*>(m_item)) {
+    } else if (auto ellipseItem = dynamic_cast<QGraphicsEllipseItem*>(m_item)) {
         ellipseItem->setBrush(QBrush(color));
         QPen pen = ellipseItem->pen();
         pen.setColor(color.darker(120));
@@ -169,11 +167,13 @@ void ChangeStyleCommand::applyStyle(const QColor &color, int width)
 MoveEntityCommand::MoveEntityCommand(QGraphicsItem *item,
                                     const QPointF &oldPos,
                                     const QPointF &newPos,
+                                    EntityPickIndex *pickIndex,
                                     QUndoCommand *parent)
     : QUndoCommand(parent)
     , m_item(item)
     , m_oldPos(oldPos)
     , m_newPos(newPos)
+    , m_pickIndex(pickIndex)
 {
     setText("移动实体");
 }
@@ -182,6 +182,9 @@ void MoveEntityCommand::undo()
 {
     if (m_item) {
         m_item->setPos(m_oldPos);
+        if (m_pickIndex) {
+            m_pickIndex->updateItem(m_item);
+        }
     }
 }
 
@@ -189,6 +192,9 @@ void MoveEntityCommand::redo()
 {
     if (m_item) {
         m_item->setPos(m_newPos);
+        if (m_pickIndex) {
+            m_pickIndex->updateItem(m_item);
+        }
     }
 }
 
@@ -242,36 +248,37 @@ void ChangePropertyCommand::applyProperty(const QVariant &value)
         return;
     }
     
-    QString entityType = m_item->data(0).toString();
-    
-    // 如果是管线，更新 pipelineHash 中的对象
-    if (entityType == "pipeline" && m_pipelineHash && m_pipelineHash->contains(m_item)) {
+    // 如果是管线，更新 pipelineHash 中的对象与图形项字段
+    auto *pipelineItem = qgraphicsitem_cast<PipelineGraphicsItem*>(m_item);
+    if (pipelineItem && m_pipelineHash && m_pipelineHash->contains(m_item)) {
         Pipeline &pipeline = (*m_pipelineHash)[m_item];
         
         if (m_propertyName == "名称" || m_propertyName == "pipelineName") {
             pipeline.setPipelineName(value.toString());
+            pipelineItem->setName(pipeline.pipelineName());
             m_item->setToolTip(QString("%1\n类型: %2\n管径: DN%3")
                               .arg(pipeline.pipelineName())
-                              .arg(m_item->data(2).toString())
+                              .arg(pipelineItem->entityType())
                               .arg(pipeline.diameterMm()));
         } else if (m_propertyName == "类型" || m_propertyName == "pipelineType") {
             pipeline.setPipelineType(value.toString());
         } else if (m_propertyName == "管径" || m_propertyName == "diameterMm") {
             pipeline.setDiameterMm(value.toInt());
+            pipelineItem->setDiameterMm(pipeline.diameterMm());
             m_item->setToolTip(QString("%1\n类型: %2\n管径: DN%3")
                               .arg(pipeline.pipelineName())
-                              .arg(m_item->data(2).toString())
+                              .arg(pipelineItem->entityType())
                               .arg(pipeline.diameterMm()));
         }
     }
     
-    // 如果是设施，更新工具提示
-    if (entityType == "facility") {
+    // 如果是设施，更新名称与工具提示
+    if (auto *facilityItem = qgraphicsitem_cast<FacilityGraphicsItem*>(m_item)) {
         if (m_propertyName == "名称" || m_propertyName == "facilityName") {
-            QString typeName = m_item->data(2).toString();
+            facilityItem->setName(value.toString());
             m_item->setToolTip(QString("%1\n类型: %2")
                               .arg(value.toString())
-                              .arg(typeName));
+                              .arg(facilityItem->entityType()));
         }
     }
 }
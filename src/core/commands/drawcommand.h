@@ -7,6 +7,8 @@
 #include <QHash>
 #include "core/models/pipeline.h"
 
+class EntityPickIndex;
+
 /**
  * @brief 绘制命令基类
  * 用于实现撤销/重做功能
@@ -92,6 +94,7 @@ public:
     MoveEntityCommand(QGraphicsItem *item,
                       const QPointF &oldPos,
                       const QPointF &newPos,
+                      EntityPickIndex *pickIndex = nullptr,
                       QUndoCommand *parent = nullptr);
     
     void undo() override;
@@ -105,6 +108,7 @@ private:
     QGraphicsItem *m_item;
     QPointF m_oldPos;
     QPointF m_newPos;
+    EntityPickIndex *m_pickIndex;  // 位置变化后同步点选索引
 };
 
 // ==========================================
@@ -126,6 +126,13 @@ QString Config::getDatabasePassword() const
     return m_dbSettings->value("database/password", "").toString();
 }
 
+QString Config::getSqlitePath() const
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_dbSettings) return "data/ugims.db";
+    return m_dbSettings->value("database/sqlite_path", "data/ugims.db").toString();
+}
+
 int Config::getMaxConnections() const
 {
     QMutexLocker locker(&m_mutex);
@@ -140,6 +147,70 @@ int Config::getMinConnections() const
     return m_dbSettings->value("database/min_connections", 2).toInt();
 }
 
+int Config::getConnectionTimeout() const
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_dbSettings) return 30;
+    return m_dbSettings->value("database/connection_timeout", 30).toInt();
+}
+
+int Config::getIdleTimeout() const
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_dbSettings) return 300;
+    return m_dbSettings->value("database/idle_timeout", 300).toInt();
+}
+
+int Config::getHealthCheckInterval() const
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_dbSettings) return 60;
+    return m_dbSettings->value("database/health_check_interval", 60).toInt();
+}
+
+int Config::getStatementCacheSize() const
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_dbSettings) return 64;
+    return m_dbSettings->value("performance/statement_cache_size", 64).toInt();
+}
+
+int Config::getBatchSize() const
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_dbSettings) return 1000;
+    return m_dbSettings->value("performance/batch_size", 1000).toInt();
+}
+
+int Config::getEntityCacheSizeMb() const
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_dbSettings) return 100;
+    if (!m_dbSettings->value("performance/enable_cache", true).toBool()) return 0;
+    return m_dbSettings->value("performance/cache_size", 100).toInt();
+}
+
+bool Config::isQueryProfileEnabled() const
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_dbSettings) return true;
+    return m_dbSettings->value("logging/enable_query_profile", true).toBool();
+}
+
+int Config::getSlowQueryMs() const
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_dbSettings) return 200;
+    return m_dbSettings->value("logging/slow_query_ms", 200).toInt();
+}
+
+int Config::getNPlusOneThreshold() const
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_dbSettings) return 20;
+    return m_dbSettings->value("logging/n_plus_one_threshold", 20).toInt();
+}
+
 void Config::setValue(const QString &key, const QVariant &value)
 {
     QMutexLocker locker(&m_mutex);
@@ -35,8 +35,20 @@ public:
     QString getDatabaseName() const;
     QString getDatabaseUsername() const;
     QString getDatabasePassword() const;
+    QString getSqlitePath() const;          // 离线 SQLite 库路径（type=sqlite 时使用）
     int getMaxConnections() const;
     int getMinConnections() const;
+    int getConnectionTimeout() const;       // 等待空闲连接的超时（秒）
+    int getIdleTimeout() const;             // 后台连接空闲回收时间（秒）
+    int getHealthCheckInterval() const;     // 连接空闲超过该时间后使用前检查（秒）
+    int getStatementCacheSize() const;      // 每条连接缓存的预编译语句数
+    int getBatchSize() const;               // 批量写入每条语句的行数
+    int getEntityCacheSizeMb() const;       // 实体缓存内存上限（MB，0 为不缓存）
+
+    // 查询剖析配置
+    bool isQueryProfileEnabled() const;     // 按语句统计耗时/行数/字节
+    int getSlowQueryMs() const;             // 慢查询阈值（毫秒，0 为不记录）
+    int getNPlusOneThreshold() const;       // 一次用户操作内同一语句的执行次数上限
 
     // 设置配置值
     void setValue(const QString &key, const QVariant &value);
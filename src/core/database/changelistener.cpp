@@ -0,0 +1,212 @@
+#include "core/database/changelistener.h"
+#include "core/database/databasemanager.h"
+#include "core/common/logger.h"
+#include "dao/entitycache.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+const char *const ChangeListener::CHANNEL = "ugims_changes";
+
+namespace {
+const char *LISTENER_CONNECTION = "listener";
+
+bool parseOperation(const QString &op, EntityChange::Operation *operation)
+{
+    if (op == "INSERT") {
+        *operation = EntityChange::Insert;
+    } else if (op == "UPDATE") {
+        *operation = EntityChange::Update;
+    } else if (op == "DELETE") {
+        *operation = EntityChange::Delete;
+    } else {
+        return false;
+    }
+    return true;
+}
+}
+
+ChangeListener& ChangeListener::instance()
+{
+    static ChangeListener instance;
+    return instance;
+}
+
+ChangeListener::ChangeListener(QObject *parent)
+    : QObject(parent)
+    , m_listening(false)
+    , m_overflow(false)
+{
+    // 首条变更到达后固定延迟发送，连续写入不会无限推迟刷新
+    m_flushTimer.setSingleShot(true);
+    m_flushTimer.setInterval(FLUSH_DELAY_MS);
+    connect(&m_flushTimer, &QTimer::timeout, this, &ChangeListener::flushPending);
+
+    m_pingTimer.setInterval(PING_INTERVAL_MS);
+    connect(&m_pingTimer, &QTimer::timeout, this, &ChangeListener::checkConnection);
+}
+
+ChangeListener::~ChangeListener()
+{
+    stop();
+}
+
+bool ChangeListener::start()
+{
+    if (m_listening) {
+        return true;
+    }
+
+    if (!subscribe()) {
+        return false;
+    }
+    m_pingTimer.start();
+    LOG_INFO(QString("Listening for data changes on channel %1").arg(CHANNEL));
+    return true;
+}
+
+void ChangeListener::stop()
+{
+    m_pingTimer.stop();
+    m_flushTimer.stop();
+    m_pending.clear();
+    m_pendingIndex.clear();
+    m_overflow = false;
+
+    if (m_connection.isValid()) {
+        if (m_connection.isOpen()) {
+            m_connection.driver()->unsubscribeFromNotification(CHANNEL);
+        }
+        m_connection = QSqlDatabase();
+        DatabaseManager::instance().closeDedicatedConnection(LISTENER_CONNECTION);
+    }
+    m_listening = false;
+}
+
+bool ChangeListener::subscribe()
+{
+    m_listening = false;
+    if (m_connection.isValid()) {
+        m_connection = QSqlDatabase();
+        DatabaseManager::instance().closeDedicatedConnection(LISTENER_CONNECTION);
+    }
+
+    m_connection = DatabaseManager::instance().openDedicatedConnection(LISTENER_CONNECTION);
+    if (!m_connection.isValid()) {
+        return false;
+    }
+
+    QSqlDriver *driver = m_connection.driver();
+    if (!driver->hasFeature(QSqlDriver::EventNotifications)) {
+        LOG_WARNING("Database driver does not support change notifications, live sync disabled");
+        m_connection = QSqlDatabase();
+        DatabaseManager::instance().closeDedicatedConnection(LISTENER_CONNECTION);
+        return false;
+    }
+
+    if (!driver->subscribeToNotification(CHANNEL)) {
+        LOG_ERROR(QString("Failed to subscribe to %1: %2").arg(CHANNEL, driver->lastError().text()));
+        m_connection = QSqlDatabase();
+        DatabaseManager::instance().closeDedicatedConnection(LISTENER_CONNECTION);
+        return false;
+    }
+
+    connect(driver, &QSqlDriver::notification, this, &ChangeListener::onNotification, Qt::UniqueConnection);
+    m_listening = true;
+    return true;
+}
+
+void ChangeListener::onNotification(const QString &name, QSqlDriver::NotificationSource source,
+                                    const QVariant &payload)
+{
+    if (name != CHANNEL || source == QSqlDriver::SelfSource) {
+        return;
+    }
+
+    const QJsonObject object = QJsonDocument::fromJson(payload.toString().toUtf8()).object();
+    EntityChange change;
+    change.table = object.value("table").toString();
+    change.id = object.value("id").toInt();
+    change.key = object.value("key").toString();
+    if (change.table.isEmpty() || !parseOperation(object.value("op").toString(), &change.op)) {
+        LOG_WARNING(QString("Ignoring malformed change notification: %1").arg(payload.toString()));
+        return;
+    }
+
+    // 本进程的写入已在本地生效
+    if (object.value("src").toString() == DatabaseManager::instance().sessionTag()) {
+        return;
+    }
+
+    // 缓存立即失效，之后的查询不会再读到旧数据
+    EntityCacheBase::invalidateEntity(change.table, change.id, change.key);
+
+    if (m_overflow) {
+        return;
+    }
+
+    // 同一实体多次变更只保留最后一次（界面侧插入与更新同样处理）
+    const QString pendingKey = change.table + ':' + change.key;
+    auto it = m_pendingIndex.constFind(pendingKey);
+    if (it != m_pendingIndex.constEnd()) {
+        m_pending[it.value()] = change;
+    } else {
+        m_pendingIndex.insert(pendingKey, m_pending.size());
+        m_pending.append(change);
+    }
+
+    if (m_pending.size() > MAX_PENDING_CHANGES) {
+        // 批量导入等大规模变更，逐项更新不如整体重载
+        m_overflow = true;
+        m_pending.clear();
+        m_pendingIndex.clear();
+    }
+
+    if (!m_flushTimer.isActive()) {
+        m_flushTimer.start();
+    }
+}
+
+void ChangeListener::flushPending()
+{
+    if (m_overflow) {
+        m_overflow = false;
+        LOG_INFO("Too many remote changes in one batch, requesting full reload");
+        emit resyncRequired();
+        return;
+    }
+
+    if (m_pending.isEmpty()) {
+        return;
+    }
+
+    QVector<EntityChange> changes;
+    changes.swap(m_pending);
+    m_pendingIndex.clear();
+    LOG_DEBUG(QString("Applying %1 remote changes").arg(changes.size()));
+    emit changesReceived(changes);
+}
+
+void ChangeListener::checkConnection()
+{
+    if (m_listening && m_connection.isOpen()) {
+        QSqlQuery query(m_connection);
+        if (query.exec("SELECT 1")) {
+            return;
+        }
+        LOG_WARNING(QString("Change listener connection lost: %1").arg(query.lastError().text()));
+    }
+
+    if (!DatabaseManager::instance().isConnected()) {
+        return;
+    }
+
+    // 断开期间的通知已丢失：重新订阅后整体刷新一次
+    if (subscribe()) {
+        LOG_INFO("Change listener reconnected");
+        EntityCacheBase::invalidateTable("pipelines");
+        EntityCacheBase::invalidateTable("facilities");
+        emit resyncRequired();
+    }
+}
@@ -0,0 +1,90 @@
+#ifndef CHANGELISTENER_H
+#define CHANGELISTENER_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QHash>
+#include <QTimer>
+#include <QSqlDatabase>
+#include <QSqlDriver>
+
+/**
+ * @brief 单条数据变更（来自其他客户端）
+ */
+struct EntityChange {
+    enum Operation {
+        Insert,
+        Update,
+        Delete
+    };
+
+    QString table;      // pipelines, facilities
+    Operation op = Update;
+    int id = 0;         // 数据库主键
+    QString key;        // 业务编号（pipeline_id / facility_id）
+};
+
+/**
+ * @brief 数据变更监听器
+ * 单例，在主线程的专用连接上 LISTEN ugims_changes（database/change_notify.sql 中的
+ * 触发器在事务提交时发出通知）。收到通知后立即失效实体缓存，再按 (表, 业务编号)
+ * 合并，短暂去抖后以 changesReceived() 批量交给界面增量更新；本进程自身的写入
+ * 通过 application_name 识别并忽略
+ *
+ * 监听连接断开期间的通知会丢失，重连成功后发出 resyncRequired()，由界面整体刷新一次
+ */
+class ChangeListener : public QObject
+{
+    Q_OBJECT
+
+public:
+    static ChangeListener& instance();
+
+    // 通知通道名
+    static const char *const CHANNEL;
+
+    // 打开专用连接并订阅（数据库已连接后调用），驱动不支持通知时返回 false
+    bool start();
+
+    // 取消订阅并关闭专用连接
+    void stop();
+
+    bool isListening() const { return m_listening; }
+
+signals:
+    // 合并后的一批变更（按到达顺序）
+    void changesReceived(const QVector<EntityChange> &changes);
+
+    // 可能漏掉了通知（重连、单批变更过多），需要整体重新加载
+    void resyncRequired();
+
+private slots:
+    void onNotification(const QString &name, QSqlDriver::NotificationSource source, const QVariant &payload);
+    void flushPending();
+    void checkConnection();
+
+private:
+    ChangeListener(QObject *parent = nullptr);
+    ~ChangeListener();
+    ChangeListener(const ChangeListener&) = delete;
+    ChangeListener& operator=(const ChangeListener&) = delete;
+
+    bool subscribe();
+
+    QSqlDatabase m_connection;
+    bool m_listening;
+    QTimer m_flushTimer;
+    QTimer m_pingTimer;
+
+    // 待发送的变更，"表:编号" -> m_pending 下标
+    QVector<EntityChange> m_pending;
+    QHash<QString, int> m_pendingIndex;
+    bool m_overflow;
+
+    static const int FLUSH_DELAY_MS = 100;
+    static const int PING_INTERVAL_MS = 30000;
+    static const int MAX_PENDING_CHANGES = 5000;
+};
+
+#endif // CHANGELISTENER_H
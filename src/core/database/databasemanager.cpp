@@ -1,11 +1,63 @@
 #include "core/database/databasemanager.h"
+#include "core/database/queryprofiler.h"
 #include "core/common/logger.h"
 #include "core/common/config.h"
 #include <QSqlDatabase>
 #include <QSqlQuery>
 #include <QSqlError>
+#include <QSqlRecord>
+#include <QSqlField>
+#include <QSqlDriver>
+#include <QRegularExpression>
+#include <QElapsedTimer>
+#include <QDeadlineTimer>
+#include <QSemaphore>
+#include <QSharedPointer>
+#include <QThread>
+#include <QCoreApplication>
+#include <QRandomGenerator>
+#include <QFileInfo>
+#include <algorithm>
 #include <QDebug>
 
+namespace {
+const char *PRIMARY_CONNECTION = "ugims_connection";
+
+// 抽样时逐列估算字节的行数，超出部分按均值外推
+const qint64 SAMPLE_ROW_LIMIT = 1000;
+
+// 预扫描结果集统计行数与读取字节，完成后回到首行之前（查询须为非 forward-only）
+void measureResult(QSqlQuery &query, QueryProfiler::Execution *execution)
+{
+    if (!query.isSelect()) {
+        execution->rows = query.numRowsAffected();
+        return;
+    }
+
+    const int columns = query.record().count();
+    qint64 rows = 0;
+    qint64 bytes = 0;
+    while (query.next()) {
+        if (rows < SAMPLE_ROW_LIMIT) {
+            for (int i = 0; i < columns; ++i) {
+                bytes += QueryProfiler::valueBytes(query.value(i));
+            }
+        }
+        rows++;
+    }
+    query.seek(-1);
+
+    execution->rows = rows;
+    execution->bytes = rows > SAMPLE_ROW_LIMIT ? bytes * rows / SAMPLE_ROW_LIMIT : bytes;
+}
+
+// 未抽样时的行数：SELECT 取驱动报告的结果行数（QSQLITE 不支持，为 -1），命令取影响行数
+qint64 resultRows(const QSqlQuery &query)
+{
+    return query.isSelect() ? query.size() : query.numRowsAffected();
+}
+}
+
 DatabaseManager& DatabaseManager::instance()
 {
     static DatabaseManager instance;
@@ -14,7 +66,19 @@ DatabaseManager& DatabaseManager::instance()
 
 DatabaseManager::DatabaseManager()
     : m_initialized(false)
+    , m_connected(false)
+    , m_connectionSerial(0)
+    , m_maxConnections(10)
+    , m_minConnections(2)
+    , m_connectTimeoutMs(30000)
+    , m_healthCheckMs(60000)
+    , m_statementCacheSize(64)
+    , m_sessionTag(QString("UGIMS-%1-%2")
+                       .arg(QCoreApplication::applicationPid())
+                       .arg(QRandomGenerator::global()->bounded(100000)))
+    , m_timingHead(0)
 {
+    m_clock.start();
 }
 
 DatabaseManager::~DatabaseManager()
@@ -46,9 +110,9 @@ bool DatabaseManager::initialize()
             qDebug() << "[DB] Available drivers:" << QSqlDatabase::drivers();
             return false;
         }
-        m_database = QSqlDatabase::addDatabase("QPSQL", "ugims_connection");
+        m_database = QSqlDatabase::addDatabase("QPSQL", PRIMARY_CONNECTION);
     } else if (dbType == "sqlite") {
-        m_database = QSqlDatabase::addDatabase("QSQLITE", "ugims_connection");
+        m_database = QSqlDatabase::addDatabase("QSQLITE", PRIMARY_CONNECTION);
     } else {
         m_lastError = QString("Unsupported database type: %1").arg(dbType);
         LOG_ERROR(m_lastError);
@@ -83,11 +147,24 @@ bool DatabaseManager::initialize()
         qDebug() << "[DB] Password:" << (password.isEmpty() ? "empty" : "***");
         
     } else if (dbType == "sqlite") {
-        m_database.setDatabaseName(config.getString("database/sqlite_path", "data/ugims.db"));
+        // 离线库由 --export-offline 从 PostGIS 导出（见 OfflineExporter）
+        m_database.setDatabaseName(config.getSqlitePath());
         LOG_INFO(QString("Database configured: SQLite at %1")
                      .arg(m_database.databaseName()));
     }
 
+    // 连接池参数
+    m_maxConnections = qMax(1, config.getMaxConnections());
+    m_minConnections = qBound(1, config.getMinConnections(), m_maxConnections);
+    m_connectTimeoutMs = qMax(1, config.getConnectionTimeout()) * 1000;
+    m_healthCheckMs = qMax(0, config.getHealthCheckInterval()) * 1000;
+    m_statementCacheSize = qMax(0, config.getStatementCacheSize());
+    m_queryPool.setMaxThreadCount(qMax(1, m_maxConnections - 1));
+    m_queryPool.setExpiryTimeout(qMax(1, config.getIdleTimeout()) * 1000);
+
+    LOG_INFO(QString("Connection pool: min %1, max %2, idle timeout %3 s")
+                 .arg(m_minConnections).arg(m_maxConnections).arg(config.getIdleTimeout()));
+
     m_initialized = true;
     return true;
 }
@@ -107,11 +184,21 @@ bool DatabaseManager::connect()
         return true;
     }
 
-    // 设置连接选项（添加超时）
+    // 设置连接选项（添加超时，克隆的线程连接沿用）
     if (m_database.driverName() == "QPSQL") {
-        // PostgreSQL 连接超时设置
-        m_database.setConnectOptions("connect_timeout=5");  // 5秒超时
+        // PostgreSQL 连接超时设置（5秒）；application_name 标识本进程，变更通知据此过滤自身写入
+        m_database.setConnectOptions(QString("connect_timeout=5;application_name=%1").arg(m_sessionTag));
         LOG_INFO("Set PostgreSQL connection timeout to 5 seconds");
+    } else if (m_database.driverName() == "QSQLITE") {
+        // QSQLITE 打开不存在的文件会新建空库，这里先检查
+        if (!QFileInfo::exists(m_database.databaseName())) {
+            m_lastError = QString("离线数据库 %1 不存在，请先在联网环境运行 UGIMS --export-offline %1 导出")
+                              .arg(m_database.databaseName());
+            LOG_ERROR(m_lastError);
+            return false;
+        }
+        // 后台线程写入时其他连接等待锁而不是立即报 SQLITE_BUSY
+        m_database.setConnectOptions("QSQLITE_BUSY_TIMEOUT=5000");
     }
 
     LOG_INFO("Attempting to connect to database...");
@@ -134,6 +221,16 @@ bool DatabaseManager::connect()
     }
 
     LOG_INFO("Successfully connected to database");
+    configureConnection(m_database);
+
+    // 主连接归属当前线程
+    PooledConnection primary;
+    primary.name = PRIMARY_CONNECTION;
+    primary.database = m_database;
+    primary.statements = QSharedPointer<StatementCache>::create();
+    primary.lastUsedMs = m_clock.elapsed();
+    m_connections.insert(QThread::currentThread(), primary);
+    m_connected = true;
 
     // 对于PostgreSQL，测试PostGIS扩展是否可用
     if (m_database.driverName() == "QPSQL") {
@@ -151,74 +248,257 @@ bool DatabaseManager::connect()
         }
     }
 
+    // 离线库缺少 R*Tree 空间索引时范围查询不可用
+    if (m_database.driverName() == "QSQLITE") {
+        QSqlQuery query(m_database);
+        if (!query.exec("SELECT 1 FROM sqlite_master WHERE name = 'pipelines_rtree'") || !query.next()) {
+            LOG_WARNING("Offline database has no spatial index (pipelines_rtree), re-export it with --export-offline");
+        }
+    }
+
+    // SQLite 文件库不需要预热
+    if (m_database.driverName() == "QPSQL") {
+        prewarmConnections(m_minConnections - 1);
+    }
+
     return true;
 }
 
 void DatabaseManager::disconnect()
 {
-    QMutexLocker locker(&m_mutex);
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_connected) {
+            return;
+        }
+        // 不再分配新连接
+        m_connected = false;
+        m_connectionReleased.wakeAll();
+    }
 
-    if (m_database.isOpen()) {
-        m_database.close();
-        LOG_INFO("Database disconnected");
+    // 等待进行中的后台任务结束，此后其他线程不再使用各自的连接
+    m_queryPool.clear();
+    m_queryPool.waitForDone();
+
+    QList<PooledConnection> connections;
+    {
+        QMutexLocker locker(&m_mutex);
+        connections = m_connections.values();
+        m_connections.clear();
+    }
+
+    for (PooledConnection &connection : connections) {
+        // 已准备语句须先于连接释放
+        connection.statements->clear();
+        connection.database.close();
+        connection.database = QSqlDatabase();
+        if (connection.name != PRIMARY_CONNECTION) {
+            QSqlDatabase::removeDatabase(connection.name);
+        }
     }
+    LOG_INFO(QString("Database disconnected (%1 connections closed)").arg(connections.size()));
 }
 
 bool DatabaseManager::isConnected() const
 {
     QMutexLocker locker(&m_mutex);
-    return m_database.isOpen();
+    return m_connected;
 }
 
-QSqlQuery DatabaseManager::executeQuery(const QString &sql, const QVariantMap &params)
+QString DatabaseManager::driverName() const
 {
     QMutexLocker locker(&m_mutex);
+    return m_database.driverName();
+}
+
+QSqlQuery DatabaseManager::executeQuery(const QString &sql, const QVariantMap &params)
+{
+    QSqlDatabase db = threadConnection();
+    if (!db.isValid()) {
+        LOG_ERROR(QString("Query skipped, no connection: %1").arg(sql));
+        return QSqlQuery();
+    }
 
-    QSqlQuery query(m_database);
+    QueryProfiler &profiler = QueryProfiler::instance();
+    const bool sample = profiler.shouldSample(sql);
+
+    QSqlQuery query(db);
+    QElapsedTimer timer;
+    timer.start();
+    bool success = false;
     
     // 如果没有参数，直接执行（避免QPSQL驱动的prepare问题）
     if (params.isEmpty()) {
         if (!query.exec(sql)) {
-            m_lastError = query.lastError().text();
-            LOG_ERROR(QString("Query failed: %1\nSQL: %2").arg(m_lastError, sql));
+            setLastError(query.lastError().text());
+            markSuspect(query.lastError());
+            LOG_ERROR(QString("Query failed: %1\nSQL: %2").arg(query.lastError().text(), sql));
         } else {
+            success = true;
             LOG_DEBUG(QString("Query executed: %1").arg(sql));
         }
     } else {
         query.prepare(sql);
         bindParameters(query, params);
         if (!query.exec()) {
-            m_lastError = query.lastError().text();
-            LOG_ERROR(QString("Query failed: %1\nSQL: %2").arg(m_lastError, sql));
+            setLastError(query.lastError().text());
+            markSuspect(query.lastError());
+            LOG_ERROR(QString("Query failed: %1\nSQL: %2").arg(query.lastError().text(), sql));
         } else {
+            success = true;
             LOG_DEBUG(QString("Query executed: %1").arg(sql));
         }
     }
 
+    QueryProfiler::Execution execution;
+    execution.elapsedNs = timer.nsecsElapsed();
+    execution.success = success;
+    {
+        QMutexLocker locker(&m_mutex);
+        recordTiming(sql, execution.elapsedNs, success);
+    }
+
+    if (success && profiler.isEnabled()) {
+        if (sample) {
+            measureResult(query, &execution);
+        } else {
+            execution.rows = resultRows(query);
+        }
+    }
+    profileExecution(db, sql, params, execution);
     return query;
 }
 
-bool DatabaseManager::executeCommand(const QString &sql, const QVariantMap &params)
+bool DatabaseManager::executePrepared(const QString &sql, const QVariantMap &params, const RowReader &reader)
 {
-    QMutexLocker locker(&m_mutex);
+    QSharedPointer<StatementCache> cache;
+    QSqlDatabase db = threadConnection(&cache);
+    if (!db.isValid() || !cache) {
+        LOG_ERROR(QString("Query skipped, no connection: %1").arg(sql));
+        return false;
+    }
 
-    QSqlQuery query(m_database);
-    
-    // 如果没有参数，直接执行（避免QPSQL驱动的prepare问题）
-    if (params.isEmpty()) {
-        if (!query.exec(sql)) {
-            m_lastError = query.lastError().text();
-            LOG_ERROR(QString("Command failed: %1\nSQL: %2").arg(m_lastError, sql));
+    // 取出空闲语句（取出期间不在缓存中，嵌套的同一SQL会另建一条）
+    auto idle = cache->idle.find(sql);
+    const bool hit = idle != cache->idle.end() && !idle->isEmpty();
+    QSqlQuery query = hit ? idle->takeLast() : QSqlQuery(db);
+    if (hit) {
+        cache->size--;
+    } else {
+        query.setForwardOnly(true);
+        if (!query.prepare(sql)) {
+            setLastError(query.lastError().text());
+            markSuspect(query.lastError());
+            LOG_ERROR(QString("Prepare failed: %1\nSQL: %2").arg(query.lastError().text(), sql));
             return false;
         }
+    }
+
+    // 抽样执行需在 reader 读取前预扫描结果集（exec 前设置，对已准备的语句同样有效）
+    QueryProfiler &profiler = QueryProfiler::instance();
+    const bool sample = profiler.shouldSample(sql);
+    query.setForwardOnly(!sample);
+
+    QElapsedTimer timer;
+    timer.start();
+    bindParameters(query, params);
+    const bool success = query.exec();
+    const qint64 elapsedNs = timer.nsecsElapsed();
+
+    QueryProfiler::Execution execution;
+    execution.elapsedNs = elapsedNs;
+    execution.success = success;
+    if (success) {
+        LOG_DEBUG(QString("Prepared query executed (%1): %2").arg(hit ? "cached" : "new", sql));
+        if (profiler.isEnabled()) {
+            if (sample) {
+                measureResult(query, &execution);
+            } else {
+                execution.rows = resultRows(query);
+            }
+        }
+        if (reader) {
+            reader(query);
+        }
     } else {
+        setLastError(query.lastError().text());
+        markSuspect(query.lastError());
+        LOG_ERROR(QString("Query failed: %1\nSQL: %2").arg(query.lastError().text(), sql));
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        recordTiming(sql, elapsedNs, success);
+
+        StatementStats &stats = m_statementStats[sql];
+        if (stats.sql.isEmpty()) {
+            stats.sql = sql.simplified();
+        }
+        const double elapsedMs = elapsedNs / 1.0e6;
+        stats.executions++;
+        stats.cacheHits += hit ? 1 : 0;
+        stats.prepares += hit ? 0 : 1;
+        stats.totalMs += elapsedMs;
+        stats.maxMs = qMax(stats.maxMs, elapsedMs);
+    }
+    profileExecution(db, sql, params, execution);
+
+    // 归还语句：释放结果集但保留服务端的预编译计划；出错的语句不再复用
+    if (!success || m_statementCacheSize <= 0) {
+        return success;
+    }
+    query.finish();
+    cache->idle[sql].append(query);
+    cache->size++;
+    cache->lru.removeOne(sql);
+    cache->lru.append(sql);
+
+    // 超出上限时淘汰最久未用的SQL
+    while (cache->size > m_statementCacheSize && !cache->lru.isEmpty()) {
+        const QString oldest = cache->lru.takeFirst();
+        cache->size -= cache->idle.value(oldest).size();
+        cache->idle.remove(oldest);
+    }
+    return true;
+}
+
+bool DatabaseManager::executeCommand(const QString &sql, const QVariantMap &params)
+{
+    QSqlDatabase db = threadConnection();
+    if (!db.isValid()) {
+        LOG_ERROR(QString("Command skipped, no connection: %1").arg(sql));
+        return false;
+    }
+
+    QSqlQuery query(db);
+    QElapsedTimer timer;
+    timer.start();
+    
+    // 如果没有参数，直接执行（避免QPSQL驱动的prepare问题）
+    bool success = params.isEmpty() ? query.exec(sql) : false;
+    if (!params.isEmpty()) {
         query.prepare(sql);
         bindParameters(query, params);
-        if (!query.exec()) {
-            m_lastError = query.lastError().text();
-            LOG_ERROR(QString("Command failed: %1\nSQL: %2").arg(m_lastError, sql));
-            return false;
-        }
+        success = query.exec();
+    }
+
+    QueryProfiler::Execution execution;
+    execution.elapsedNs = timer.nsecsElapsed();
+    execution.success = success;
+    {
+        QMutexLocker locker(&m_mutex);
+        recordTiming(sql, execution.elapsedNs, success);
+    }
+    if (success) {
+        execution.rows = resultRows(query);
+    }
+    profileExecution(db, sql, params, execution);
+
+    if (!success) {
+        setLastError(query.lastError().text());
+        markSuspect(query.lastError());
+        LOG_ERROR(QString("Command failed: %1\nSQL: %2").arg(query.lastError().text(), sql));
+        return false;
     }
 
     LOG_DEBUG(QString("Command executed: %1, affected rows: %2")
@@ -229,11 +509,10 @@ bool DatabaseManager::executeCommand(const QString &sql, const QVariantMap &para
 
 bool DatabaseManager::beginTransaction()
 {
-    QMutexLocker locker(&m_mutex);
-
-    if (!m_database.transaction()) {
-        m_lastError = m_database.lastError().text();
-        LOG_ERROR(QString("Failed to begin transaction: %1").arg(m_lastError));
+    QSqlDatabase db = threadConnection();
+    if (!db.transaction()) {
+        setLastError(db.lastError().text());
+        LOG_ERROR(QString("Failed to begin transaction: %1").arg(db.lastError().text()));
         return false;
     }
 
@@ -243,11 +522,10 @@ bool DatabaseManager::beginTransaction()
 
 bool DatabaseManager::commit()
 {
-    QMutexLocker locker(&m_mutex);
-
-    if (!m_database.commit()) {
-        m_lastError = m_database.lastError().text();
-        LOG_ERROR(QString("Failed to commit transaction: %1").arg(m_lastError));
+    QSqlDatabase db = threadConnection();
+    if (!db.commit()) {
+        setLastError(db.lastError().text());
+        LOG_ERROR(QString("Failed to commit transaction: %1").arg(db.lastError().text()));
         return false;
     }
 
@@ -257,11 +535,10 @@ bool DatabaseManager::commit()
 
 bool DatabaseManager::rollback()
 {
-    QMutexLocker locker(&m_mutex);
-
-    if (!m_database.rollback()) {
-        m_lastError = m_database.lastError().text();
-        LOG_ERROR(QString("Failed to rollback transaction: %1").arg(m_lastError));
+    QSqlDatabase db = threadConnection();
+    if (!db.rollback()) {
+        setLastError(db.lastError().text());
+        LOG_ERROR(QString("Failed to rollback transaction: %1").arg(db.lastError().text()));
         return false;
     }
 
@@ -272,12 +549,375 @@ bool DatabaseManager::rollback()
 QString DatabaseManager::lastError() const
 {
     QMutexLocker locker(&m_mutex);
+    auto it = m_connections.constFind(QThread::currentThread());
+    if (it != m_connections.constEnd() && !it->lastError.isEmpty()) {
+        return it->lastError;
+    }
     return m_lastError;
 }
 
 QSqlDatabase DatabaseManager::database()
 {
-    return m_database;
+    return threadConnection();
+}
+
+QThreadPool* DatabaseManager::queryPool()
+{
+    return &m_queryPool;
+}
+
+int DatabaseManager::connectionCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_connections.size();
+}
+
+QSqlDatabase DatabaseManager::openDedicatedConnection(const QString &name)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_connected) {
+            m_lastError = "Database not connected";
+            return QSqlDatabase();
+        }
+    }
+
+    const QString connectionName = QString("%1_%2").arg(PRIMARY_CONNECTION, name);
+    if (QSqlDatabase::contains(connectionName)) {
+        closeDedicatedConnection(name);
+    }
+
+    QSqlDatabase db = QSqlDatabase::cloneDatabase(PRIMARY_CONNECTION, connectionName);
+    if (!db.open()) {
+        setLastError(db.lastError().text());
+        LOG_ERROR(QString("Failed to open dedicated connection %1: %2").arg(connectionName, db.lastError().text()));
+        db = QSqlDatabase();
+        QSqlDatabase::removeDatabase(connectionName);
+        return QSqlDatabase();
+    }
+    configureConnection(db);
+
+    LOG_DEBUG(QString("Opened dedicated connection %1").arg(connectionName));
+    return db;
+}
+
+void DatabaseManager::closeDedicatedConnection(const QString &name)
+{
+    const QString connectionName = QString("%1_%2").arg(PRIMARY_CONNECTION, name);
+    {
+        QSqlDatabase db = QSqlDatabase::database(connectionName, false);
+        if (db.isValid()) {
+            db.close();
+        }
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+}
+
+QSqlDatabase DatabaseManager::threadConnection(QSharedPointer<StatementCache> *statements)
+{
+    QThread *thread = QThread::currentThread();
+    QMutexLocker locker(&m_mutex);
+
+    auto it = m_connections.find(thread);
+    if (it != m_connections.end() && it->database.isValid()) {
+        const qint64 now = m_clock.elapsed();
+        const bool check = it->suspect || now - it->lastUsedMs > m_healthCheckMs;
+        it->lastUsedMs = now;
+        it->suspect = false;
+        QSqlDatabase db = it->database;
+        QSharedPointer<StatementCache> cache = it->statements;
+        locker.unlock();
+
+        // 长时间空闲或出错后的连接先检查再使用（只在所属线程中操作）
+        if (check && !ensureHealthy(db, cache.data())) {
+            setLastError(db.lastError().text());
+        }
+        if (statements) {
+            *statements = cache;
+        }
+        return db;
+    }
+
+    if (!m_connected) {
+        m_lastError = "Database not connected";
+        return QSqlDatabase();
+    }
+
+    // 达到上限时等待其他线程退出释放连接
+    QDeadlineTimer deadline(m_connectTimeoutMs);
+    while (m_connections.size() >= m_maxConnections) {
+        if (!m_connectionReleased.wait(&m_mutex, deadline) || !m_connected) {
+            m_lastError = QString("No database connection available (max %1)").arg(m_maxConnections);
+            LOG_ERROR(m_lastError);
+            return QSqlDatabase();
+        }
+    }
+
+    // 先占位，打开连接时不持有锁
+    const QString name = QString("%1_%2").arg(PRIMARY_CONNECTION).arg(++m_connectionSerial);
+    PooledConnection entry;
+    entry.name = name;
+    entry.statements = QSharedPointer<StatementCache>::create();
+    m_connections.insert(thread, entry);
+    locker.unlock();
+
+    QSqlDatabase db = QSqlDatabase::cloneDatabase(PRIMARY_CONNECTION, name);
+    if (!db.open()) {
+        const QString error = db.lastError().text();
+        db = QSqlDatabase();
+        QSqlDatabase::removeDatabase(name);
+
+        locker.relock();
+        m_connections.remove(thread);
+        m_lastError = error;
+        m_connectionReleased.wakeOne();
+        LOG_ERROR(QString("Failed to open pooled connection %1: %2").arg(name, error));
+        return QSqlDatabase();
+    }
+    configureConnection(db);
+
+    // 线程退出时（在该线程中）关闭其连接
+    QObject::connect(thread, &QThread::finished, thread, [this, thread]() {
+        releaseThreadConnection(thread);
+    }, Qt::DirectConnection);
+
+    locker.relock();
+    auto reserved = m_connections.find(thread);
+    if (reserved != m_connections.end()) {
+        reserved->database = db;
+        reserved->lastUsedMs = m_clock.elapsed();
+        if (statements) {
+            *statements = reserved->statements;
+        }
+    }
+    LOG_DEBUG(QString("Opened pooled connection %1 (%2/%3)")
+                  .arg(name).arg(m_connections.size()).arg(m_maxConnections));
+    return db;
+}
+
+void DatabaseManager::releaseThreadConnection(QThread *thread)
+{
+    PooledConnection connection;
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_connections.find(thread);
+        if (it == m_connections.end() || it->name == PRIMARY_CONNECTION) {
+            return;
+        }
+        connection = it.value();
+        m_connections.erase(it);
+        m_connectionReleased.wakeOne();
+    }
+
+    connection.statements->clear();
+    connection.database.close();
+    connection.database = QSqlDatabase();
+    QSqlDatabase::removeDatabase(connection.name);
+    LOG_DEBUG(QString("Released pooled connection %1").arg(connection.name));
+}
+
+bool DatabaseManager::ensureHealthy(QSqlDatabase &database, StatementCache *statements)
+{
+    if (database.isOpen()) {
+        QSqlQuery probe(database);
+        if (probe.exec("SELECT 1")) {
+            return true;
+        }
+        LOG_WARNING(QString("Connection %1 failed health check: %2")
+                        .arg(database.connectionName(), probe.lastError().text()));
+    }
+
+    // 重连后服务端的预编译语句已失效
+    if (statements) {
+        statements->clear();
+    }
+    database.close();
+
+    if (!database.open()) {
+        LOG_ERROR(QString("Failed to reopen connection %1: %2")
+                      .arg(database.connectionName(), database.lastError().text()));
+        return false;
+    }
+    configureConnection(database);
+    LOG_INFO(QString("Connection %1 reopened").arg(database.connectionName()));
+    return true;
+}
+
+void DatabaseManager::configureConnection(QSqlDatabase &database)
+{
+    if (database.driverName() != "QSQLITE") {
+        return;
+    }
+
+    // WAL：后台线程读取不阻塞界面线程写入；NORMAL 同步在 WAL 下不会损坏数据库
+    // mmap 与页缓存让 R*Tree 与表页常驻内存，点/框查询不经过 read() 系统调用
+    static const char *const PRAGMAS[] = {
+        "PRAGMA journal_mode = WAL",
+        "PRAGMA synchronous = NORMAL",
+        "PRAGMA mmap_size = 268435456",
+        "PRAGMA cache_size = -65536",
+        "PRAGMA temp_store = MEMORY"
+    };
+
+    QSqlQuery query(database);
+    for (const char *pragma : PRAGMAS) {
+        if (!query.exec(pragma)) {
+            LOG_WARNING(QString("%1 failed on %2: %3")
+                            .arg(pragma, database.connectionName(), query.lastError().text()));
+        }
+    }
+}
+
+void DatabaseManager::prewarmConnections(int count)
+{
+    if (count <= 0) {
+        return;
+    }
+
+    // 每个预热任务占住线程直到全部任务都已开始，使连接落在不同线程上
+    auto arrived = QSharedPointer<QSemaphore>::create(0);
+    for (int i = 0; i < count; ++i) {
+        m_queryPool.start([this, arrived, count]() {
+            threadConnection();
+            arrived->release();
+            if (arrived->tryAcquire(count, 5000)) {
+                arrived->release(count);
+            }
+        });
+    }
+}
+
+void DatabaseManager::setLastError(const QString &error)
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_connections.find(QThread::currentThread());
+    if (it != m_connections.end()) {
+        it->lastError = error;
+    }
+    m_lastError = error;
+}
+
+void DatabaseManager::markSuspect(const QSqlError &error)
+{
+    if (error.type() != QSqlError::ConnectionError) {
+        return;
+    }
+    QMutexLocker locker(&m_mutex);
+    auto it = m_connections.find(QThread::currentThread());
+    if (it != m_connections.end()) {
+        it->suspect = true;
+    }
+}
+
+QVector<DatabaseManager::QueryTiming> DatabaseManager::recentQueryTimings() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    // 环形缓冲按执行顺序展开
+    QVector<QueryTiming> timings;
+    timings.reserve(m_recentTimings.size());
+    const int start = m_recentTimings.size() < RECENT_TIMING_COUNT ? 0 : m_timingHead;
+    for (int i = 0; i < m_recentTimings.size(); ++i) {
+        timings.append(m_recentTimings[(start + i) % m_recentTimings.size()]);
+    }
+    return timings;
+}
+
+QVector<DatabaseManager::StatementStats> DatabaseManager::statementStats() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    // 按累计耗时降序
+    QVector<StatementStats> stats;
+    stats.reserve(m_statementStats.size());
+    for (const StatementStats &entry : m_statementStats) {
+        stats.append(entry);
+    }
+    std::sort(stats.begin(), stats.end(), [](const StatementStats &a, const StatementStats &b) {
+        return a.totalMs > b.totalMs;
+    });
+    return stats;
+}
+
+void DatabaseManager::resetStatementStats()
+{
+    QMutexLocker locker(&m_mutex);
+    m_statementStats.clear();
+}
+
+void DatabaseManager::recordTiming(const QString &sql, qint64 elapsedNs, bool success)
+{
+    QueryTiming timing;
+    timing.sql = sql.simplified().left(120);
+    timing.elapsedMs = elapsedNs / 1.0e6;
+    timing.success = success;
+
+    if (m_recentTimings.size() < RECENT_TIMING_COUNT) {
+        m_recentTimings.append(timing);
+    } else {
+        m_recentTimings[m_timingHead] = timing;
+    }
+    m_timingHead = (m_timingHead + 1) % RECENT_TIMING_COUNT;
+}
+
+void DatabaseManager::profileExecution(QSqlDatabase &database, const QString &sql, const QVariantMap &params,
+                                       const QueryProfiler::Execution &execution)
+{
+    QueryProfiler &profiler = QueryProfiler::instance();
+    if (!profiler.record(sql, execution)) {
+        return;
+    }
+    const QString plan = execution.success && profiler.shouldExplain(sql)
+                             ? explainQuery(database, sql, params) : QString();
+    profiler.recordSlowQuery(sql, execution, plan);
+}
+
+QString DatabaseManager::explainQuery(QSqlDatabase &database, const QString &sql, const QVariantMap &params)
+{
+    // PostgreSQL 不能 PREPARE 一条 EXPLAIN，参数按驱动格式内联为字面量；
+    // 直接在本线程连接上执行，不经 executeQuery，不计入统计
+    QString explainSql = sql;
+    for (auto param = params.constBegin(); param != params.constEnd(); ++param) {
+        const QString placeholder = param.key().startsWith(':') ? param.key() : (":" + param.key());
+        QSqlField field(QString(), param.value().metaType());
+        field.setValue(param.value());
+        const QString literal = database.driver()->formatValue(field);
+
+        const QRegularExpression pattern(QRegularExpression::escape(placeholder) + "\\b");
+        QList<QRegularExpressionMatch> matches;
+        QRegularExpressionMatchIterator it = pattern.globalMatch(explainSql);
+        while (it.hasNext()) {
+            matches.prepend(it.next());
+        }
+        for (const QRegularExpressionMatch &match : matches) {
+            explainSql.replace(match.capturedStart(), match.capturedLength(), literal);
+        }
+    }
+
+    const bool sqlite = database.driverName() == "QSQLITE";
+    QSqlQuery query(database);
+    query.setForwardOnly(true);
+
+    // 处于事务中时用保存点隔离，EXPLAIN 出错不会使调用方的事务中止
+    // （事务外 SAVEPOINT 本身失败，无需处理）
+    QSqlQuery savepoint(database);
+    const bool isolated = !sqlite && savepoint.exec("SAVEPOINT ugims_explain");
+    const bool explained = query.exec((sqlite ? "EXPLAIN QUERY PLAN " : "EXPLAIN ") + explainSql);
+    if (isolated) {
+        savepoint.exec(explained ? "RELEASE SAVEPOINT ugims_explain"
+                                 : "ROLLBACK TO SAVEPOINT ugims_explain");
+    }
+    if (!explained) {
+        LOG_DEBUG(QString("EXPLAIN failed: %1").arg(query.lastError().text()));
+        return QString();
+    }
+
+    // PostgreSQL 每行一段计划文本；SQLite 为 (id, parent, notused, detail)
+    QStringList lines;
+    while (query.next()) {
+        lines << query.value(sqlite ? 3 : 0).toString();
+    }
+    return lines.join('\n');
 }
 
 void DatabaseManager::bindParameters(QSqlQuery &query, const QVariantMap &params)
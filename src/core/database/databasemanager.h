@@ -6,13 +6,29 @@
 #include <QSqlError>
 #include <QString>
 #include <QMutex>
+#include <QWaitCondition>
 #include <QVector>
 #include <QVariantMap>
+#include <QHash>
+#include <QThreadPool>
+#include <QElapsedTimer>
+#include <QSharedPointer>
+#include <functional>
+#include "core/database/queryprofiler.h"
+
+class QThread;
 
 /**
  * @brief 数据库管理器
- * 单例模式，管理PostgreSQL数据库连接
+ * 单例模式，管理PostgreSQL数据库连接（离线时为 SQLite 文件库，SQL 差异见 SqlDialect）
  * 使用Qt的QSqlDatabase实现
+ *
+ * 连接按线程分配（Qt 要求连接只在创建它的线程中使用）：每个线程首次访问时
+ * 克隆一条独立连接，总数不超过 max_connections，已满时等待其他线程释放；
+ * 线程退出时其连接随之关闭。查询执行不再持有全局锁，分析任务与界面互不排队
+ *
+ * 后台数据库任务应提交到 queryPool()：该线程池在连接后预热 min_connections
+ * 条连接，空闲线程超过 idle_timeout 后退出并回收连接
  */
 class DatabaseManager
 {
@@ -32,9 +48,18 @@ public:
     // 检查连接状态
     bool isConnected() const;
 
+    // 主连接的Qt驱动名（QPSQL / QSQLITE），SqlDialect 据此选择方言
+    QString driverName() const;
+
     // 执行SQL查询（SELECT）
     QSqlQuery executeQuery(const QString &sql, const QVariantMap &params = QVariantMap());
 
+    // 使用缓存的预编译语句执行查询，结果在 reader 中读取（高频查询使用）
+    // 语句在 reader 返回后归还本线程连接的缓存，下次同一SQL只需重新绑定参数；
+    // reader 中嵌套执行同一SQL时会另外准备一条语句，互不干扰
+    using RowReader = std::function<void(QSqlQuery &query)>;
+    bool executePrepared(const QString &sql, const QVariantMap &params, const RowReader &reader);
+
     // 执行SQL命令（INSERT, UPDATE, DELETE）
     bool executeCommand(const QString &sql, const QVariantMap &params = QVariantMap());
 
@@ -50,9 +75,42 @@ public:
     // 获取最后的错误信息
     QString lastError() const;
 
-    // 获取数据库实例（用于高级操作）
+    // 获取当前线程的数据库连接（用于高级操作）
     QSqlDatabase database();
 
+    // 数据库后台任务线程池（线程数不超过 max_connections - 1，主线程占用一条连接）
+    QThreadPool* queryPool();
+
+    // 当前已打开的连接数
+    int connectionCount() const;
+
+    // 本进程的会话标识（PostgreSQL application_name），用于识别本进程自身产生的变更通知
+    QString sessionTag() const { return m_sessionTag; }
+
+    // 打开独立于连接池的专用连接（如 LISTEN 长连接），只能在调用线程中使用
+    QSqlDatabase openDedicatedConnection(const QString &name);
+    void closeDedicatedConnection(const QString &name);
+
+    // 最近查询耗时（诊断浮层使用，按执行顺序，最多 RECENT_TIMING_COUNT 条）
+    struct QueryTiming {
+        QString sql;
+        double elapsedMs;
+        bool success;
+    };
+    QVector<QueryTiming> recentQueryTimings() const;
+
+    // 预编译语句统计（所有连接汇总，按SQL文本）
+    struct StatementStats {
+        QString sql;
+        qint64 executions = 0;
+        qint64 cacheHits = 0;       // 复用已准备语句的次数
+        qint64 prepares = 0;        // 实际 prepare 的次数
+        double totalMs = 0.0;
+        double maxMs = 0.0;
+    };
+    QVector<StatementStats> statementStats() const;
+    void resetStatementStats();
+
     // 禁用拷贝
     DatabaseManager(const DatabaseManager&) = delete;
     DatabaseManager& operator=(const DatabaseManager&) = delete;
@@ -61,13 +119,76 @@ private:
     DatabaseManager();
     ~DatabaseManager();
 
-    QSqlDatabase m_database;
+    // 连接内的预编译语句缓存（只由所属线程访问）
+    struct StatementCache {
+        QHash<QString, QList<QSqlQuery>> idle;  // SQL -> 空闲的已准备语句
+        QList<QString> lru;                     // 最近使用的SQL在尾部
+        int size = 0;
+
+        void clear() { idle.clear(); lru.clear(); size = 0; }
+    };
+
+    // 线程连接
+    struct PooledConnection {
+        QString name;
+        QSqlDatabase database;
+        QSharedPointer<StatementCache> statements;
+        qint64 lastUsedMs = 0;
+        bool suspect = false;       // 出现连接级错误，下次使用前检查
+        QString lastError;
+    };
+
+    // 取得（必要时创建）当前线程的连接，失败时返回无效连接
+    QSqlDatabase threadConnection(QSharedPointer<StatementCache> *statements = nullptr);
+    // 关闭并移除线程的连接（在该线程中调用）
+    void releaseThreadConnection(QThread *thread);
+    // 连接检查：执行 SELECT 1，失败则清空语句缓存并重新打开
+    bool ensureHealthy(QSqlDatabase &database, StatementCache *statements);
+    // 预热后台线程池连接
+    void prewarmConnections(int count);
+    // 每次打开连接后的会话设置（SQLite：WAL、内存映射、页缓存等 PRAGMA）
+    void configureConnection(QSqlDatabase &database);
+
+    void setLastError(const QString &error);
+    void markSuspect(const QSqlError &error);
+
+    QSqlDatabase m_database;        // 主连接（初始化线程使用，也是克隆模板）
     mutable QMutex m_mutex;
+    QWaitCondition m_connectionReleased;
     QString m_lastError;
     bool m_initialized;
+    bool m_connected;
+
+    // 线程 -> 连接（受 m_mutex 保护）
+    QHash<QThread*, PooledConnection> m_connections;
+    int m_connectionSerial;
+    int m_maxConnections;
+    int m_minConnections;
+    int m_connectTimeoutMs;
+    int m_healthCheckMs;
+    int m_statementCacheSize;       // 每条连接缓存的语句数上限
+    QString m_sessionTag;
+    QElapsedTimer m_clock;
+    QHash<QString, StatementStats> m_statementStats;
+
+    // 最近查询耗时环形缓冲（调用方已持有 m_mutex）
+    QVector<QueryTiming> m_recentTimings;
+    int m_timingHead;
+    static const int RECENT_TIMING_COUNT = 32;
 
     // 绑定参数到查询
     void bindParameters(QSqlQuery &query, const QVariantMap &params);
+
+    // 记录一次查询耗时（调用方已持有 m_mutex）
+    void recordTiming(const QString &sql, qint64 elapsedNs, bool success);
+
+    // 提交查询剖析；慢查询在同一连接上采集 EXPLAIN（不持有 m_mutex）
+    void profileExecution(QSqlDatabase &database, const QString &sql, const QVariantMap &params,
+                          const QueryProfiler::Execution &execution);
+    QString explainQuery(QSqlDatabase &database, const QString &sql, const QVariantMap &params);
+
+    // 最后析构：退出的工作线程仍会回调 releaseThreadConnection()
+    QThreadPool m_queryPool;
 };
 
 #endif // DATABASEMANAGER_H
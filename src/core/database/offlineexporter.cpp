@@ -0,0 +1,325 @@
+#include "core/database/offlineexporter.h"
+#include "core/database/databasemanager.h"
+#include "core/common/logger.h"
+#include "dao/sqldialect.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QSqlRecord>
+#include <QSqlField>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDateTime>
+#include <QElapsedTimer>
+
+namespace {
+// 源字段类型 -> SQLite 列类型
+QString sqliteType(const QSqlField &field)
+{
+    switch (field.metaType().id()) {
+    case QMetaType::Bool:
+    case QMetaType::Int:
+    case QMetaType::UInt:
+    case QMetaType::LongLong:
+    case QMetaType::ULongLong:
+        return "INTEGER";
+    case QMetaType::Double:
+        return "REAL";
+    case QMetaType::QByteArray:
+        return "BLOB";
+    default:
+        return "TEXT";
+    }
+}
+
+// 日期时间以 ISO 文本存储（QSQLITE 读取时可直接 toDate()/toDateTime()）
+QVariant sqliteValue(const QVariant &value)
+{
+    if (value.isNull() || !value.isValid()) {
+        return QVariant();
+    }
+    switch (value.metaType().id()) {
+    case QMetaType::Bool:
+        return value.toBool() ? 1 : 0;
+    case QMetaType::QDate:
+        return value.toDate().toString(Qt::ISODate);
+    case QMetaType::QDateTime:
+        return value.toDateTime().toString(Qt::ISODate);
+    case QMetaType::QTime:
+        return value.toTime().toString(Qt::ISODate);
+    default:
+        return value;
+    }
+}
+}
+
+OfflineExporter::OfflineExporter(const QString &targetPath)
+    : m_targetPath(targetPath)
+    , m_connectionName(QString("offline_export_%1").arg(reinterpret_cast<quintptr>(this)))
+    , m_rowsExported(0)
+{
+}
+
+OfflineExporter::~OfflineExporter()
+{
+    if (m_target.isValid()) {
+        m_target.close();
+        m_target = QSqlDatabase();
+    }
+    QSqlDatabase::removeDatabase(m_connectionName);
+}
+
+QVector<OfflineExporter::TableSpec> OfflineExporter::tables()
+{
+    return {
+        {"pipelines", "pipeline_id", true, {"pipeline_type", "status", "created_by"}},
+        {"facilities", "facility_id", true, {"facility_type", "pipeline_id", "status", "created_by"}},
+        {"users", "username", false, {"role", "status"}}
+    };
+}
+
+bool OfflineExporter::exportAll()
+{
+    if (DatabaseManager::instance().driverName() != "QPSQL" || !DatabaseManager::instance().isConnected()) {
+        fail("Offline export requires a connected PostgreSQL database");
+        return false;
+    }
+    if (!QSqlDatabase::isDriverAvailable("QSQLITE")) {
+        fail("SQLite driver (QSQLITE) is not available");
+        return false;
+    }
+
+    const QString tempPath = m_targetPath + ".tmp";
+    QDir().mkpath(QFileInfo(m_targetPath).absolutePath());
+    QFile::remove(tempPath);
+
+    m_target = QSqlDatabase::addDatabase("QSQLITE", m_connectionName);
+    m_target.setDatabaseName(tempPath);
+    if (!m_target.open()) {
+        fail(QString("Cannot create %1: %2").arg(tempPath, m_target.lastError().text()));
+        return false;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    LOG_INFO(QString("Exporting offline database to %1").arg(m_targetPath));
+
+    // 导出期间不需要回滚日志与同步写盘，失败时整个临时文件丢弃
+    bool ok = exec("PRAGMA journal_mode = OFF") && exec("PRAGMA synchronous = OFF")
+           && exec("CREATE TABLE offline_metadata (key TEXT PRIMARY KEY, value TEXT)");
+    if (ok) {
+        QSqlQuery meta(m_target);
+        meta.prepare("INSERT INTO offline_metadata (key, value) VALUES (?, ?)");
+        meta.addBindValue(QVariantList{"exported_at", "source"});
+        meta.addBindValue(QVariantList{QDateTime::currentDateTime().toString(Qt::ISODate),
+                                       DatabaseManager::instance().database().databaseName()});
+        ok = meta.execBatch();
+        if (!ok) {
+            fail(meta.lastError().text());
+        }
+    }
+
+    for (const TableSpec &spec : tables()) {
+        if (!ok) {
+            break;
+        }
+        ok = exportTable(spec);
+    }
+
+    ok = ok && exec("ANALYZE") && exec("PRAGMA journal_mode = WAL");
+    m_target.close();
+    m_target = QSqlDatabase();
+    QSqlDatabase::removeDatabase(m_connectionName);
+
+    if (!ok) {
+        QFile::remove(tempPath);
+        LOG_ERROR(QString("Offline export failed: %1").arg(m_lastError));
+        return false;
+    }
+
+    // 替换旧的离线库（连同其 WAL 文件）
+    QFile::remove(m_targetPath + "-wal");
+    QFile::remove(m_targetPath + "-shm");
+    if ((QFile::exists(m_targetPath) && !QFile::remove(m_targetPath)) || !QFile::rename(tempPath, m_targetPath)) {
+        fail(QString("Cannot replace %1").arg(m_targetPath));
+        QFile::remove(tempPath);
+        return false;
+    }
+
+    LOG_INFO(QString("Offline database exported: %1 rows in %2 ms")
+                 .arg(m_rowsExported).arg(timer.elapsed()));
+    return true;
+}
+
+bool OfflineExporter::exportTable(const TableSpec &spec)
+{
+    const QString sql = QString("SELECT *%1 FROM %2 WHERE id > :last_id ORDER BY id LIMIT :chunk")
+                            .arg(spec.spatial ? ", " + PostgisDialect().geometryColumn("geom_wkb") : QString(),
+                                 spec.table);
+
+    if (!m_target.transaction()) {
+        fail(m_target.lastError().text());
+        return false;
+    }
+
+    QStringList columns;
+    QSqlQuery insert(m_target);
+    QSqlQuery index(m_target);     // R*Tree 写入，建表后才能 prepare
+
+    QVariantMap params;
+    params[":chunk"] = CHUNK_SIZE;
+    int lastId = 0;
+    qint64 rows = 0;
+    bool failed = false;
+    forever {
+        params[":last_id"] = lastId;
+        int chunkRows = 0;
+        bool ok = DatabaseManager::instance().executePrepared(sql, params, [&](QSqlQuery &query) {
+            while (!failed && query.next()) {
+                if (columns.isEmpty()) {
+                    if (!createSchema(spec, query.record(), &columns)) {
+                        failed = true;
+                        return;
+                    }
+                    QStringList placeholders;
+                    for (int i = 0; i < columns.size(); ++i) {
+                        placeholders.append("?");
+                    }
+                    insert.prepare(QString("INSERT INTO %1 (%2) VALUES (%3)")
+                                       .arg(spec.table, columns.join(", "), placeholders.join(", ")));
+                    if (spec.spatial) {
+                        index.prepare(QString("INSERT INTO %1 (id, min_x, max_x, min_y, max_y) VALUES (?, ?, ?, ?, ?)")
+                                          .arg(SqliteDialect::spatialIndexName(spec.table)));
+                    }
+                }
+
+                // 几何列写入 WKB，其余列按名称取值
+                const QByteArray wkb = spec.spatial ? query.value("geom_wkb").toByteArray() : QByteArray();
+                for (const QString &column : columns) {
+                    insert.addBindValue(column == "geom" ? QVariant(wkb) : sqliteValue(query.value(column)));
+                }
+                if (!insert.exec()) {
+                    fail(QString("%1: %2").arg(spec.table, insert.lastError().text()));
+                    failed = true;
+                    return;
+                }
+
+                lastId = query.value("id").toInt();
+                QRectF bounds;
+                if (spec.spatial && SqliteDialect::wkbBounds(wkb, &bounds)) {
+                    index.addBindValue(lastId);
+                    index.addBindValue(bounds.left());
+                    index.addBindValue(bounds.right());
+                    index.addBindValue(bounds.top());
+                    index.addBindValue(bounds.bottom());
+                    if (!index.exec()) {
+                        fail(QString("%1 spatial index: %2").arg(spec.table, index.lastError().text()));
+                        failed = true;
+                        return;
+                    }
+                }
+                chunkRows++;
+            }
+        });
+
+        if (!ok && !failed) {
+            fail(QString("%1: %2").arg(spec.table, DatabaseManager::instance().lastError()));
+            failed = true;
+        }
+        if (failed) {
+            m_target.rollback();
+            return false;
+        }
+        rows += chunkRows;
+        if (chunkRows < CHUNK_SIZE) {
+            break;
+        }
+    }
+
+    // 空表也需要建表（离线编辑可能新增）
+    if (columns.isEmpty()) {
+        QSqlQuery probe = DatabaseManager::instance().executeQuery(
+            QString("SELECT *%1 FROM %2 LIMIT 0")
+                .arg(spec.spatial ? ", " + PostgisDialect().geometryColumn("geom_wkb") : QString(), spec.table));
+        if (!probe.isActive() || !createSchema(spec, probe.record(), &columns)) {
+            if (m_lastError.isEmpty()) {
+                fail(QString("%1: %2").arg(spec.table, DatabaseManager::instance().lastError()));
+            }
+            m_target.rollback();
+            return false;
+        }
+    }
+
+    if (!createIndexes(spec) || !m_target.commit()) {
+        if (m_lastError.isEmpty()) {
+            fail(m_target.lastError().text());
+        }
+        m_target.rollback();
+        return false;
+    }
+
+    m_rowsExported += rows;
+    LOG_INFO(QString("Exported %1 rows from %2").arg(rows).arg(spec.table));
+    return true;
+}
+
+bool OfflineExporter::createSchema(const TableSpec &spec, const QSqlRecord &record, QStringList *columns)
+{
+    QStringList definitions;
+    for (int i = 0; i < record.count(); ++i) {
+        const QSqlField field = record.field(i);
+        const QString name = field.name();
+        if (name == "geom" || name == "geom_wkb") {
+            continue;
+        }
+        columns->append(name);
+        definitions.append(name == "id" ? QString("id INTEGER PRIMARY KEY")
+                                        : QString("%1 %2").arg(name, sqliteType(field)));
+    }
+    if (spec.spatial) {
+        columns->append("geom");
+        definitions.append("geom BLOB");
+    }
+
+    if (!exec(QString("CREATE TABLE %1 (%2)").arg(spec.table, definitions.join(", ")))) {
+        return false;
+    }
+    if (!spec.spatial) {
+        return true;
+    }
+
+    const QString rtree = SqliteDialect::spatialIndexName(spec.table);
+    return exec(QString("CREATE VIRTUAL TABLE %1 USING rtree(id, min_x, max_x, min_y, max_y)").arg(rtree))
+        && exec(QString("CREATE TRIGGER %1_delete AFTER DELETE ON %2 "
+                        "BEGIN DELETE FROM %1 WHERE id = OLD.id; END").arg(rtree, spec.table));
+}
+
+bool OfflineExporter::createIndexes(const TableSpec &spec)
+{
+    // 数据写入后再建索引，比逐行维护快
+    if (!exec(QString("CREATE UNIQUE INDEX idx_%1_%2 ON %1 (%2)").arg(spec.table, spec.keyColumn))) {
+        return false;
+    }
+    for (const QString &column : spec.indexColumns) {
+        if (!exec(QString("CREATE INDEX idx_%1_%2 ON %1 (%2)").arg(spec.table, column))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool OfflineExporter::exec(const QString &sql)
+{
+    QSqlQuery query(m_target);
+    if (!query.exec(sql)) {
+        fail(QString("%1\nSQL: %2").arg(query.lastError().text(), sql));
+        return false;
+    }
+    return true;
+}
+
+void OfflineExporter::fail(const QString &error)
+{
+    m_lastError = error;
+    LOG_ERROR(QString("Offline export: %1").arg(error));
+}
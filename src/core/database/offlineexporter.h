@@ -0,0 +1,64 @@
+#ifndef OFFLINEEXPORTER_H
+#define OFFLINEEXPORTER_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QSqlDatabase>
+
+class QSqlRecord;
+
+/**
+ * @brief 离线库导出器
+ * 将当前 PostGIS 数据库中的管线、设施与用户表导出为 SQLite 文件，供现场笔记本
+ * 在无服务器时以 database/type=sqlite 打开（SqliteDialect）
+ *
+ * - 表结构按源查询的字段类型生成（id 为 INTEGER PRIMARY KEY，日期以 ISO 文本存储）
+ * - 几何列 geom 存 WKB，另建 R*Tree 虚表 <表名>_rtree(id, min_x, max_x, min_y, max_y)，
+ *   删除行由触发器同步；业务编号建唯一索引（BulkWriter 的 Upsert 依赖）
+ * - 源表按 id 键集分页读取，目标库单事务写入，完成后 ANALYZE
+ * - 先写入 <目标>.tmp，成功后替换目标文件，导出中断不会破坏已有离线库
+ *
+ * 离线库是导出时刻的快照，工单与热力图仍需连接 PostGIS
+ */
+class OfflineExporter
+{
+public:
+    explicit OfflineExporter(const QString &targetPath);
+    ~OfflineExporter();
+
+    // 导出全部表（须在 PostGIS 已连接的线程中调用）
+    bool exportAll();
+
+    QString lastError() const { return m_lastError; }
+    qint64 rowsExported() const { return m_rowsExported; }
+
+    OfflineExporter(const OfflineExporter&) = delete;
+    OfflineExporter& operator=(const OfflineExporter&) = delete;
+
+private:
+    struct TableSpec {
+        QString table;
+        QString keyColumn;          // 业务编号（唯一索引）
+        bool spatial;               // 含 geom 列，建 R*Tree 索引
+        QStringList indexColumns;   // 常用过滤列
+    };
+
+    bool exportTable(const TableSpec &spec);
+    bool createSchema(const TableSpec &spec, const QSqlRecord &record, QStringList *columns);
+    bool createIndexes(const TableSpec &spec);
+    bool exec(const QString &sql);
+    void fail(const QString &error);
+
+    static QVector<TableSpec> tables();
+
+    QString m_targetPath;
+    QString m_connectionName;
+    QSqlDatabase m_target;
+    QString m_lastError;
+    qint64 m_rowsExported;
+
+    static const int CHUNK_SIZE = 5000;
+};
+
+#endif // OFFLINEEXPORTER_H
@@ -0,0 +1,398 @@
+#include "core/database/queryprofiler.h"
+#include "core/common/config.h"
+#include "core/common/logger.h"
+#include <QRegularExpression>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QFile>
+#include <QDir>
+#include <QPair>
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+namespace {
+const double BUCKET_BOUNDS[] = {1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000};
+const int BUCKET_COUNT = sizeof(BUCKET_BOUNDS) / sizeof(BUCKET_BOUNDS[0]) + 1;
+
+// 当前线程的用户操作（ActionScope 维护）
+struct ActionState {
+    QString name;
+    int depth = 0;
+    QHash<QString, QPair<int, double>> counts;  // 归一化SQL -> (次数, 耗时ms)
+};
+thread_local ActionState currentAction;
+
+QString truncated(const QString &sql, int limit)
+{
+    const QString text = sql.simplified();
+    return text.size() > limit ? text.left(limit) + "..." : text;
+}
+}
+
+QueryProfiler& QueryProfiler::instance()
+{
+    static QueryProfiler instance;
+    return instance;
+}
+
+QueryProfiler::QueryProfiler()
+    : m_enabled(Config::instance().isQueryProfileEnabled())
+    , m_slowQueryMs(Config::instance().getSlowQueryMs())
+    , m_nPlusOneThreshold(Config::instance().getNPlusOneThreshold())
+{
+    m_clock.start();
+}
+
+double QueryProfiler::StatementProfile::percentileMs(double p) const
+{
+    qint64 total = 0;
+    for (qint64 count : histogram) {
+        total += count;
+    }
+    if (total == 0) {
+        return 0.0;
+    }
+    const qint64 target = qMax<qint64>(1, static_cast<qint64>(std::ceil(p * total)));
+    qint64 cumulative = 0;
+    for (int i = 0; i < histogram.size(); ++i) {
+        cumulative += histogram[i];
+        if (cumulative >= target) {
+            return i < BUCKET_COUNT - 1 ? qMin(BUCKET_BOUNDS[i], maxMs) : maxMs;
+        }
+    }
+    return maxMs;
+}
+
+QueryProfiler::ActionScope::ActionScope(const QString &name)
+    : m_outermost(currentAction.depth == 0)
+{
+    if (m_outermost) {
+        currentAction.name = name;
+        currentAction.counts.clear();
+    }
+    currentAction.depth++;
+}
+
+QueryProfiler::ActionScope::~ActionScope()
+{
+    currentAction.depth--;
+    if (m_outermost) {
+        QueryProfiler::instance().finishAction();
+    }
+}
+
+void QueryProfiler::finishAction()
+{
+    if (!m_enabled || m_nPlusOneThreshold <= 0) {
+        currentAction.counts.clear();
+        return;
+    }
+
+    QVector<NPlusOneWarning> warnings;
+    for (auto it = currentAction.counts.constBegin(); it != currentAction.counts.constEnd(); ++it) {
+        if (it.value().first <= m_nPlusOneThreshold) {
+            continue;
+        }
+        NPlusOneWarning warning;
+        warning.time = QDateTime::currentDateTime();
+        warning.action = currentAction.name;
+        warning.sql = it.key();
+        warning.executions = it.value().first;
+        warning.totalMs = it.value().second;
+        warnings.append(warning);
+        LOG_WARNING(QString("N+1 query in \"%1\": %2 executions, %3 ms total: %4")
+                        .arg(warning.action)
+                        .arg(warning.executions)
+                        .arg(warning.totalMs, 0, 'f', 1)
+                        .arg(truncated(warning.sql, 200)));
+    }
+    currentAction.counts.clear();
+
+    if (warnings.isEmpty()) {
+        return;
+    }
+    QMutexLocker locker(&m_mutex);
+    m_nPlusOne += warnings;
+    if (m_nPlusOne.size() > NPLUSONE_LOG_SIZE) {
+        m_nPlusOne.remove(0, m_nPlusOne.size() - NPLUSONE_LOG_SIZE);
+    }
+}
+
+QString QueryProfiler::normalize(const QString &sql)
+{
+    QMutexLocker locker(&m_mutex);
+    return normalizeLocked(sql);
+}
+
+QString QueryProfiler::normalizeLocked(const QString &sql)
+{
+    auto cached = m_normalized.constFind(sql);
+    if (cached != m_normalized.constEnd()) {
+        return cached.value();
+    }
+
+    static const QRegularExpression stringLiteral("'(?:[^']|'')*'");
+    static const QRegularExpression numberedPlaceholder(":([A-Za-z_]+?)\\d+(?:_\\d+)*\\b");
+    static const QRegularExpression number("\\b\\d+(?:\\.\\d+)?(?:[eE][-+]?\\d+)?\\b");
+    static const QRegularExpression inList("\\bIN\\s*\\(\\s*\\?(?:\\s*,\\s*\\?)+\\s*\\)",
+                                           QRegularExpression::CaseInsensitiveOption);
+    // 连续重复的括号组（多行 VALUES），(?1) 递归匹配嵌套括号
+    static const QRegularExpression repeatedTuple("(\\((?:[^()]++|(?1))*\\))(?:\\s*,\\s*\\1)+");
+
+    QString text = sql.simplified();
+    text.replace(stringLiteral, "?");
+    text.replace(numberedPlaceholder, ":\\1?");
+    text.replace(number, "?");
+    text.replace(inList, "IN (?...)");
+    text.replace(repeatedTuple, "\\1, ...");
+
+    // 拼接字面量的SQL每次文本不同，缓存满时整体清空
+    if (m_normalized.size() >= NORMALIZE_CACHE_SIZE) {
+        m_normalized.clear();
+    }
+    m_normalized.insert(sql, text);
+    return text;
+}
+
+bool QueryProfiler::shouldSample(const QString &sql)
+{
+    if (!m_enabled) {
+        return false;
+    }
+    QMutexLocker locker(&m_mutex);
+    auto it = m_profiles.constFind(normalizeLocked(sql));
+    return it == m_profiles.constEnd() || it->executions % SAMPLE_INTERVAL == 0;
+}
+
+bool QueryProfiler::record(const QString &sql, const Execution &execution)
+{
+    if (!m_enabled) {
+        return false;
+    }
+
+    const double elapsedMs = execution.elapsedNs / 1.0e6;
+    QString normalized;
+    {
+        QMutexLocker locker(&m_mutex);
+        normalized = normalizeLocked(sql);
+        StatementProfile &profile = m_profiles[normalized];
+        if (profile.sql.isEmpty()) {
+            profile.sql = normalized;
+            profile.histogram.fill(0, BUCKET_COUNT);
+        }
+
+        profile.executions++;
+        profile.errors += execution.success ? 0 : 1;
+        profile.totalMs += elapsedMs;
+        profile.maxMs = qMax(profile.maxMs, elapsedMs);
+        int bucket = 0;
+        while (bucket < BUCKET_COUNT - 1 && elapsedMs > BUCKET_BOUNDS[bucket]) {
+            bucket++;
+        }
+        profile.histogram[bucket]++;
+        if (execution.rows >= 0) {
+            profile.rows += execution.rows;
+            profile.rowSamples++;
+        }
+        if (execution.bytes >= 0) {
+            profile.bytes += execution.bytes;
+            profile.byteSamples++;
+        }
+    }
+
+    if (currentAction.depth > 0) {
+        QPair<int, double> &count = currentAction.counts[normalized];
+        count.first++;
+        count.second += elapsedMs;
+    }
+
+    return m_slowQueryMs > 0 && elapsedMs >= m_slowQueryMs;
+}
+
+bool QueryProfiler::shouldExplain(const QString &sql)
+{
+    static const QRegularExpression readOnly("^\\s*(SELECT|WITH)\\b", QRegularExpression::CaseInsensitiveOption);
+    if (!m_enabled || !readOnly.match(sql).hasMatch()) {
+        return false;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    const QString normalized = normalizeLocked(sql);
+    const qint64 now = m_clock.elapsed();
+    auto last = m_lastExplainMs.constFind(normalized);
+    if (last != m_lastExplainMs.constEnd() && now - last.value() < EXPLAIN_INTERVAL_MS) {
+        return false;
+    }
+    m_lastExplainMs.insert(normalized, now);
+    return true;
+}
+
+void QueryProfiler::recordSlowQuery(const QString &sql, const Execution &execution, const QString &plan)
+{
+    SlowQuery slow;
+    slow.time = QDateTime::currentDateTime();
+    slow.sql = truncated(sql, SQL_TEXT_LIMIT);
+    slow.action = currentAction.depth > 0 ? currentAction.name : QString();
+    slow.elapsedMs = execution.elapsedNs / 1.0e6;
+    slow.rows = execution.rows;
+    slow.plan = plan;
+
+    LOG_WARNING(QString("Slow query (%1 ms%2): %3")
+                    .arg(slow.elapsedMs, 0, 'f', 1)
+                    .arg(slow.action.isEmpty() ? QString() : ", " + slow.action)
+                    .arg(truncated(sql, 500)));
+
+    QMutexLocker locker(&m_mutex);
+    slow.normalized = normalizeLocked(sql);
+    m_slowQueries.append(slow);
+    if (m_slowQueries.size() > SLOW_LOG_SIZE) {
+        m_slowQueries.remove(0, m_slowQueries.size() - SLOW_LOG_SIZE);
+    }
+}
+
+QVector<QueryProfiler::StatementProfile> QueryProfiler::statementProfiles() const
+{
+    QMutexLocker locker(&m_mutex);
+    QVector<StatementProfile> profiles;
+    profiles.reserve(m_profiles.size());
+    for (const StatementProfile &profile : m_profiles) {
+        profiles.append(profile);
+    }
+    locker.unlock();
+
+    std::sort(profiles.begin(), profiles.end(), [](const StatementProfile &a, const StatementProfile &b) {
+        return a.totalMs > b.totalMs;
+    });
+    return profiles;
+}
+
+QVector<QueryProfiler::SlowQuery> QueryProfiler::slowQueries() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_slowQueries;
+}
+
+QVector<QueryProfiler::NPlusOneWarning> QueryProfiler::nPlusOneWarnings() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_nPlusOne;
+}
+
+void QueryProfiler::reset()
+{
+    QMutexLocker locker(&m_mutex);
+    m_profiles.clear();
+    m_lastExplainMs.clear();
+    m_slowQueries.clear();
+    m_nPlusOne.clear();
+}
+
+qint64 QueryProfiler::valueBytes(const QVariant &value)
+{
+    if (value.isNull() || !value.isValid()) {
+        return 0;
+    }
+    switch (value.metaType().id()) {
+    case QMetaType::QString:
+        return value.toString().size();
+    case QMetaType::QByteArray:
+        return value.toByteArray().size();
+    default:
+        return 8;
+    }
+}
+
+QVector<double> QueryProfiler::bucketBounds()
+{
+    return QVector<double>(std::begin(BUCKET_BOUNDS), std::end(BUCKET_BOUNDS));
+}
+
+QJsonObject QueryProfiler::toJson() const
+{
+    QJsonArray bounds;
+    for (double bound : bucketBounds()) {
+        bounds.append(bound);
+    }
+
+    QJsonArray statements;
+    for (const StatementProfile &profile : statementProfiles()) {
+        QJsonArray histogram;
+        for (qint64 count : profile.histogram) {
+            histogram.append(count);
+        }
+        QJsonObject object;
+        object["sql"] = profile.sql;
+        object["executions"] = profile.executions;
+        object["errors"] = profile.errors;
+        object["total_ms"] = profile.totalMs;
+        object["avg_ms"] = profile.averageMs();
+        object["p50_ms"] = profile.percentileMs(0.50);
+        object["p95_ms"] = profile.percentileMs(0.95);
+        object["p99_ms"] = profile.percentileMs(0.99);
+        object["max_ms"] = profile.maxMs;
+        object["avg_rows"] = profile.averageRows();
+        object["avg_bytes"] = profile.averageBytes();
+        object["row_samples"] = profile.rowSamples;
+        object["byte_samples"] = profile.byteSamples;
+        object["histogram"] = histogram;
+        statements.append(object);
+    }
+
+    QJsonArray slow;
+    for (const SlowQuery &query : slowQueries()) {
+        QJsonObject object;
+        object["time"] = query.time.toString(Qt::ISODateWithMs);
+        object["elapsed_ms"] = query.elapsedMs;
+        object["rows"] = query.rows;
+        object["action"] = query.action;
+        object["sql"] = query.sql;
+        object["normalized"] = query.normalized;
+        object["plan"] = query.plan;
+        slow.append(object);
+    }
+
+    QJsonArray nPlusOne;
+    for (const NPlusOneWarning &warning : nPlusOneWarnings()) {
+        QJsonObject object;
+        object["time"] = warning.time.toString(Qt::ISODateWithMs);
+        object["action"] = warning.action;
+        object["sql"] = warning.sql;
+        object["executions"] = warning.executions;
+        object["total_ms"] = warning.totalMs;
+        nPlusOne.append(object);
+    }
+
+    QJsonObject root;
+    root["generated_at"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+    root["slow_query_ms"] = m_slowQueryMs;
+    root["n_plus_one_threshold"] = m_nPlusOneThreshold;
+    root["sample_interval"] = SAMPLE_INTERVAL;
+    root["bucket_bounds_ms"] = bounds;
+    root["statements"] = statements;
+    root["slow_queries"] = slow;
+    root["n_plus_one"] = nPlusOne;
+    return root;
+}
+
+QString QueryProfiler::dumpJson(const QString &filePath) const
+{
+    QString path = filePath;
+    if (path.isEmpty()) {
+        const QString logDir = QDir::currentPath() + "/logs";
+        QDir().mkpath(logDir);
+        path = logDir + QString("/query_profile_%1.json")
+                            .arg(QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss"));
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        LOG_WARNING(QString("Failed to write query profile: %1").arg(path));
+        return QString();
+    }
+    file.write(QJsonDocument(toJson()).toJson(QJsonDocument::Indented));
+    file.close();
+
+    LOG_INFO(QString("Query profile written to %1").arg(path));
+    return path;
+}
@@ -0,0 +1,160 @@
+#ifndef QUERYPROFILER_H
+#define QUERYPROFILER_H
+
+#include <QString>
+#include <QVector>
+#include <QHash>
+#include <QMutex>
+#include <QDateTime>
+#include <QVariant>
+#include <QJsonObject>
+#include <QElapsedTimer>
+
+/**
+ * @brief 查询剖析器
+ * 单例，DatabaseManager 每次执行SQL后回调 record()，按归一化SQL（字面量替换为 ?，
+ * IN 列表与多行 VALUES 折叠）汇总：
+ * - 执行次数、失败次数、耗时直方图（分位数按桶上界估算）与最大耗时
+ * - 返回行数与读取字节数：每条语句首次及此后每 SAMPLE_INTERVAL 次执行预扫描结果集，
+ *   其余执行只记耗时（PostgreSQL 的 SELECT 行数由驱动直接给出）
+ * - 超过 slow_query_ms 的查询进入慢查询日志，SELECT 附带 EXPLAIN 计划
+ * - ActionScope 标记一次用户操作（如一次 bfsTrace），结束时同一语句执行超过
+ *   n_plus_one_threshold 次记为 N+1 告警
+ *
+ * 诊断浮层（F12）显示摘要，Ctrl+F12 导出 JSON（dumpJson）
+ */
+class QueryProfiler
+{
+public:
+    static QueryProfiler& instance();
+
+    // 一次执行的测量结果（rows/bytes 为 -1 表示本次未统计）
+    struct Execution {
+        qint64 elapsedNs = 0;
+        qint64 rows = -1;
+        qint64 bytes = -1;
+        bool success = true;
+    };
+
+    // 归一化语句的累计统计
+    struct StatementProfile {
+        QString sql;
+        qint64 executions = 0;
+        qint64 errors = 0;
+        double totalMs = 0.0;
+        double maxMs = 0.0;
+        QVector<qint64> histogram;      // 按 bucketBounds() 分桶，末桶为超出上界
+        qint64 rows = 0;                // 已统计行数的执行合计
+        qint64 rowSamples = 0;
+        qint64 bytes = 0;               // 抽样执行读取的字节合计
+        qint64 byteSamples = 0;
+
+        double averageMs() const { return executions > 0 ? totalMs / executions : 0.0; }
+        double averageRows() const { return rowSamples > 0 ? double(rows) / rowSamples : 0.0; }
+        double averageBytes() const { return byteSamples > 0 ? double(bytes) / byteSamples : 0.0; }
+        double percentileMs(double p) const;
+    };
+
+    struct SlowQuery {
+        QDateTime time;
+        QString sql;                    // 原始SQL（压缩空白、截断）
+        QString normalized;
+        QString action;                 // 所在用户操作，无则为空
+        double elapsedMs = 0.0;
+        qint64 rows = -1;
+        QString plan;                   // EXPLAIN 输出，未采集时为空
+    };
+
+    struct NPlusOneWarning {
+        QDateTime time;
+        QString action;
+        QString sql;                    // 归一化SQL
+        int executions = 0;
+        double totalMs = 0.0;
+    };
+
+    /**
+     * @brief 用户操作范围（RAII，按线程）
+     * 范围内当前线程执行的语句按归一化SQL计数，最外层范围析构时检查 N+1；
+     * 嵌套范围并入最外层。提交到其他线程的查询不计入
+     */
+    class ActionScope
+    {
+    public:
+        explicit ActionScope(const QString &name);
+        ~ActionScope();
+
+        ActionScope(const ActionScope&) = delete;
+        ActionScope& operator=(const ActionScope&) = delete;
+
+    private:
+        bool m_outermost;
+    };
+
+    bool isEnabled() const { return m_enabled; }
+    int slowQueryMs() const { return m_slowQueryMs; }
+    int nPlusOneThreshold() const { return m_nPlusOneThreshold; }
+
+    // 本次执行是否预扫描结果集统计行数与字节（调用方在 exec 之前询问）
+    bool shouldSample(const QString &sql);
+
+    // 记录一次执行；返回是否为慢查询
+    bool record(const QString &sql, const Execution &execution);
+
+    // 慢查询是否需要采集 EXPLAIN（SELECT/WITH，同一语句 EXPLAIN_INTERVAL 内一次）
+    bool shouldExplain(const QString &sql);
+    void recordSlowQuery(const QString &sql, const Execution &execution, const QString &plan);
+
+    QVector<StatementProfile> statementProfiles() const;    // 按总耗时降序
+    QVector<SlowQuery> slowQueries() const;                 // 按时间顺序
+    QVector<NPlusOneWarning> nPlusOneWarnings() const;      // 按时间顺序
+    void reset();
+
+    // 归一化SQL（结果按原文缓存）
+    QString normalize(const QString &sql);
+
+    // 结果值的传输字节估算（文本按字符数，定长类型按 8 字节）
+    static qint64 valueBytes(const QVariant &value);
+
+    // 耗时直方图分桶上界（毫秒）
+    static QVector<double> bucketBounds();
+
+    QJsonObject toJson() const;
+
+    /**
+     * @brief 导出 JSON
+     * @param filePath 为空时写入 logs/query_profile_<时间>.json
+     * @return 实际写入的文件路径，失败时为空
+     */
+    QString dumpJson(const QString &filePath = QString()) const;
+
+    QueryProfiler(const QueryProfiler&) = delete;
+    QueryProfiler& operator=(const QueryProfiler&) = delete;
+
+private:
+    QueryProfiler();
+
+    QString normalizeLocked(const QString &sql);    // 调用方已持有 m_mutex
+    void finishAction();                            // 最外层 ActionScope 结束
+
+    mutable QMutex m_mutex;
+    bool m_enabled;
+    int m_slowQueryMs;
+    int m_nPlusOneThreshold;
+    QElapsedTimer m_clock;
+
+    QHash<QString, QString> m_normalized;           // 原始SQL -> 归一化SQL
+    QHash<QString, StatementProfile> m_profiles;    // 归一化SQL -> 统计
+    QHash<QString, qint64> m_lastExplainMs;         // 归一化SQL -> 上次 EXPLAIN 时刻
+    QVector<SlowQuery> m_slowQueries;
+    QVector<NPlusOneWarning> m_nPlusOne;
+
+    static const int SAMPLE_INTERVAL = 16;          // 每隔多少次执行预扫描一次
+    static const int NORMALIZE_CACHE_SIZE = 1024;
+    static const int SLOW_LOG_SIZE = 100;
+    static const int NPLUSONE_LOG_SIZE = 100;
+    static const int EXPLAIN_INTERVAL_MS = 60000;
+    static const int SQL_TEXT_LIMIT = 2000;
+};
+
+#endif // QUERYPROFILER_H
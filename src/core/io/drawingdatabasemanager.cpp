@@ -1,49 +1,55 @@
 #include "core/io/drawingdatabasemanager.h"
+#include "core/io/wkbcodec.h"
 #include "core/database/databasemanager.h"
 #include "core/common/logger.h"
 #include "core/common/entitystate.h"  // 引入实体状态
 #include "dao/pipelinedao.h"
 #include "dao/facilitydao.h"
-#include <QGraphicsPathItem>
-#include <QGraphicsEllipseItem>
+#include "dao/bulkwriter.h"
+#include "dao/sqldialect.h"
+#include "map/layeritemregistry.h"
+#include "map/entitygraphicsitem.h"
 #include <QPainterPath>
+#include <QPolygonF>
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QDateTime>
 #include <QDebug>
 
+namespace {
+// 未编号设施的自动编号计数器
+int s_facilityCounter = 1;
+}
+
 bool DrawingDatabaseManager::saveToDatabase(QGraphicsScene *scene,
-                                            const QHash<QGraphicsItem*, Pipeline> &pipelineHash)
+                                            const QHash<QGraphicsItem*, Pipeline> &pipelineHash,
+                                            LayerItemRegistry *registry)
 {
     if (!scene) {
-        qWarning() << "❌ Scene is null!";
+        Logger::instance().warning("Scene is null");
         return false;
     }
     
     Logger::instance().info("开始增量保存绘制数据到数据库");
     
-    qDebug() << "🔍 场景中总项数:" << scene->items().count();
-    qDebug() << "🔍 pipelineHash大小:" << pipelineHash.size();
-    
-    int insertCount = 0;   // 插入数量
-    int updateCount = 0;   // 更新数量
-    int deleteCount = 0;   // 删除数量
     int unchangedCount = 0;  // 未变更数量
-    int failCount = 0;     // 失败数量
     
-    // 遍历场景中的所有项
-    QList<QGraphicsItem*> items = scene->items();
+    // 1. 按实体状态归类（此阶段不修改场景）
+    QList<QPair<PipelineGraphicsItem*, Pipeline>> addedPipelines;
+    QList<QPair<PipelineGraphicsItem*, Pipeline>> modifiedPipelines;
+    QList<FacilityGraphicsItem*> addedFacilities;
+    QList<FacilityGraphicsItem*> modifiedFacilities;
+    QStringList deletedPipelineIds;
+    QStringList deletedFacilityIds;
+    QList<QGraphicsItem*> deletedItems;
+    
+    // 遍历场景中的实体项（有注册表时只取管线/设施图层，否则扫描整个场景）
+    QList<QGraphicsItem*> items = registry ? registry->entityItems(scene) : scene->items();
     for (QGraphicsItem *item : items) {
-        QString entityType = item->data(0).toString();
+        EntityGraphicsItem *entity = EntityGraphicsItem::fromItem(item);
         
-        // 获取实体状态（存储在data(100)中）
-        QVariant stateVariant = item->data(100);
-        EntityState state = EntityState::Detached;
-        if (stateVariant.isValid()) {
-            state = static_cast<EntityState>(stateVariant.toInt());
-        }
-        
-        qDebug() << "📊 实体:" << entityType << ", 状态:" << entityStateToString(state);
+        // 非实体图形项视为分离态
+        EntityState state = entity ? entity->state() : EntityState::Detached;
         
         // 根据状态进行不同操作
         if (state == EntityState::Unchanged || state == EntityState::Detached) {
@@ -53,92 +59,132 @@ bool DrawingDatabaseManager::saveToDatabase(QGraphicsScene *scene,
         }
         
         // 处理管线
-        if (entityType == "pipeline") {
-            auto pathItem = qgraphicsitem_cast<QGraphicsPathItem*>(item);
-            if (pathItem && pipelineHash.contains(item)) {
+        if (auto pathItem = qgraphicsitem_cast<PipelineGraphicsItem*>(item)) {
+            if (pipelineHash.contains(item)) {
                 Pipeline pipeline = pipelineHash[item];
                 
                 if (state == EntityState::Added) {
-                    // 新增：执行INSERT
-                    if (insertPipelineToDatabase(pathItem, pipeline)) {
-                        insertCount++;
-                        // 更新状态为 Unchanged
-                        item->setData(100, static_cast<int>(EntityState::Unchanged));
-                    } else {
-                        failCount++;
-                    }
+                    addedPipelines.append(qMakePair(pathItem, pipeline));
                 } else if (state == EntityState::Modified) {
-                    // 修改：执行UPDATE
-                    if (updatePipelineToDatabase(pathItem, pipeline)) {
-                        updateCount++;
-                        // 更新状态为 Unchanged
-                        item->setData(100, static_cast<int>(EntityState::Unchanged));
-                    } else {
-                        failCount++;
-                    }
+                    modifiedPipelines.append(qMakePair(pathItem, pipeline));
                 } else if (state == EntityState::Deleted) {
-                    // 删除：执行DELETE
-                    if (deletePipelineFromDatabase(pipeline.pipelineId())) {
-                        deleteCount++;
-                        // 从场景中移除
-                        scene->removeItem(item);
-                        delete item;
-                    } else {
-                        failCount++;
-                    }
+                    deletedPipelineIds.append(pipeline.pipelineId());
+                    deletedItems.append(item);
                 }
             }
         }
         // 处理设施
-        else if (entityType == "facility") {
-            auto ellipseItem = qgraphicsitem_cast<QGraphicsEllipseItem*>(item);
-            if (ellipseItem) {
-                QString facilityId = item->data(10).toString();
-                
-                if (state == EntityState::Added) {
-                    // 新增：执行INSERT
-                    if (insertFacilityToDatabase(ellipseItem)) {
-                        insertCount++;
-                        // 更新状态为 Unchanged
-                        item->setData(100, static_cast<int>(EntityState::Unchanged));
-                    } else {
-                        failCount++;
-                    }
-                } else if (state == EntityState::Modified) {
-                    // 修改：执行UPDATE
-                    if (updateFacilityToDatabase(ellipseItem)) {
-                        updateCount++;
-                        // 更新状态为 Unchanged
-                        item->setData(100, static_cast<int>(EntityState::Unchanged));
-                    } else {
-                        failCount++;
-                    }
-                } else if (state == EntityState::Deleted) {
-                    // 删除：执行DELETE
-                    if (deleteFacilityFromDatabase(facilityId)) {
-                        deleteCount++;
-                        // 从场景中移除
-                        scene->removeItem(item);
-                        delete item;
-                    } else {
-                        failCount++;
-                    }
-                }
+        else if (auto ellipseItem = qgraphicsitem_cast<FacilityGraphicsItem*>(item)) {
+            QString facilityId = ellipseItem->entityId();
+            // 无编号的设施只能新增，更新/删除无从定位
+            if (state == EntityState::Added) {
+                addedFacilities.append(ellipseItem);
+            } else if (!facilityId.isEmpty() && state == EntityState::Modified) {
+                modifiedFacilities.append(ellipseItem);
+            } else if (!facilityId.isEmpty() && state == EntityState::Deleted) {
+                deletedFacilityIds.append(facilityId);
+                deletedItems.append(item);
             }
         }
     }
     
-    QString msg = QString("增量保存完成：新增=%1, 更新=%2, 删除=%3, 未变更=%4, 失败=%5")
-        .arg(insertCount).arg(updateCount).arg(deleteCount).arg(unchangedCount).arg(failCount);
+    const int insertCount = addedPipelines.size() + addedFacilities.size();
+    const int updateCount = modifiedPipelines.size() + modifiedFacilities.size();
+    const int deleteCount = deletedItems.size();
+    if (insertCount + updateCount + deleteCount == 0) {
+        Logger::instance().info(QString("没有需要保存的变更，未变更=%1").arg(unchangedCount));
+        return false;
+    }
+    
+    // 新增设施的编号：绘制时已生成则沿用，否则生成；提交成功后才写回图形项，
+    // 回滚时恢复计数器，失败的保存不会留下未入库的编号
+    const int facilityCounterBefore = s_facilityCounter;
+    QStringList addedFacilityIds;
+    for (FacilityGraphicsItem *facility : addedFacilities) {
+        QString facilityId = facility->entityId();
+        if (facilityId.isEmpty()) {
+            facilityId = QString("FACILITY-%1").arg(s_facilityCounter++, 3, 10, QChar('0'));
+        }
+        addedFacilityIds.append(facilityId);
+    }
+    
+    // 2. 在一个事务中写入：新增逐条插入（需逐项确定编号），修改与删除按批写入
+    DatabaseManager &db = DatabaseManager::instance();
+    if (!db.beginTransaction()) {
+        s_facilityCounter = facilityCounterBefore;
+        return false;
+    }
+    
+    bool success = true;
+    for (const auto &entry : addedPipelines) {
+        success = success && insertPipelineToDatabase(entry.first, entry.second);
+    }
+    for (int i = 0; i < addedFacilities.size(); ++i) {
+        success = success && insertFacilityToDatabase(addedFacilities[i], addedFacilityIds[i]);
+    }
+    success = success && updatePipelinesInDatabase(modifiedPipelines);
+    success = success && updateFacilitiesInDatabase(modifiedFacilities);
+    success = success && deleteFromDatabase("pipelines", "pipeline_id", deletedPipelineIds);
+    success = success && deleteFromDatabase("facilities", "facility_id", deletedFacilityIds);
+    
+    if (!success || !db.commit()) {
+        // 整体回滚，实体保持原状态与编号，可再次保存
+        db.rollback();
+        s_facilityCounter = facilityCounterBefore;
+        QString msg = QString("增量保存失败，已回滚：新增=%1, 更新=%2, 删除=%3, 错误=%4")
+            .arg(insertCount).arg(updateCount).arg(deleteCount).arg(db.lastError());
+        Logger::instance().error(msg);
+        return false;
+    }
+    
+    // 事务内的失效早于提交，提交后再清空实体缓存，避免其他线程在此期间读入旧数据
+    if (updateCount > 0 || deleteCount > 0) {
+        PipelineDAO::cache().invalidateAll();
+        FacilityDAO::cache().invalidateAll();
+    }
+    
+    // 3. 提交成功后同步场景状态
+    for (const auto &entry : addedPipelines) {
+        // 入库后编号/数据库ID可能已变化，刷新注册表索引
+        if (registry) {
+            registry->reindexEntity(entry.first);
+        }
+        entry.first->setState(EntityState::Unchanged);
+    }
+    for (int i = 0; i < addedFacilities.size(); ++i) {
+        FacilityGraphicsItem *facility = addedFacilities[i];
+        facility->setEntityId(addedFacilityIds[i]);
+        if (registry) {
+            registry->reindexEntity(facility);
+        }
+        facility->setState(EntityState::Unchanged);
+    }
+    for (const auto &entry : modifiedPipelines) {
+        entry.first->setState(EntityState::Unchanged);
+    }
+    for (FacilityGraphicsItem *facility : modifiedFacilities) {
+        facility->setState(EntityState::Unchanged);
+    }
+    for (QGraphicsItem *item : deletedItems) {
+        // 从场景中移除
+        if (registry) {
+            registry->removeItem(item);
+        }
+        scene->removeItem(item);
+        delete item;
+    }
+    
+    QString msg = QString("增量保存完成：新增=%1, 更新=%2, 删除=%3, 未变更=%4")
+        .arg(insertCount).arg(updateCount).arg(deleteCount).arg(unchangedCount);
     Logger::instance().info(msg);
-    qDebug() << msg;
     
-    return (insertCount + updateCount + deleteCount > 0);
+    return true;
 }
 
 bool DrawingDatabaseManager::loadFromDatabase(QGraphicsScene *scene,
                                               QHash<QGraphicsItem*, Pipeline> &pipelineHash,
-                                              int &nextId)
+                                              int &nextId,
+                                              LayerItemRegistry *registry)
 {
     if (!scene) {
         qWarning() << "Scene is null!";
@@ -148,10 +194,10 @@ bool DrawingDatabaseManager::loadFromDatabase(QGraphicsScene *scene,
     Logger::instance().info("开始从数据库加载绘制数据");
     
     // 加载管线
-    int pipelineCount = loadPipelinesFromDatabase(scene, pipelineHash);
+    int pipelineCount = loadPipelinesFromDatabase(scene, pipelineHash, registry);
     
     // 加载设施
-    int facilityCount = loadFacilitiesFromDatabase(scene);
+    int facilityCount = loadFacilitiesFromDatabase(scene, registry);
     
     // 更新nextId（查找最大ID）
     int maxId = 0;
@@ -171,7 +217,6 @@ bool DrawingDatabaseManager::loadFromDatabase(QGraphicsScene *scene,
     
     QString msg = QString("加载完成：%1条管线，%2个设施").arg(pipelineCount).arg(facilityCount);
     Logger::instance().info(msg);
-    qDebug() << msg;
     
     return (pipelineCount > 0 || facilityCount > 0);
 }
@@ -188,38 +233,41 @@ bool DrawingDatabaseManager::clearDatabase()
     QString sql2 = "DELETE FROM facilities WHERE created_by = 'user_drawing'";
     bool result2 = DatabaseManager::instance().executeCommand(sql2);
     
+    PipelineDAO::cache().invalidateAll();
+    FacilityDAO::cache().invalidateAll();
+    
     return result1 && result2;
 }
 
-bool DrawingDatabaseManager::insertPipelineToDatabase(QGraphicsPathItem *pathItem, const Pipeline &pipeline)
+bool DrawingDatabaseManager::insertPipelineToDatabase(PipelineGraphicsItem *pathItem, const Pipeline &pipeline)
 {
     if (!pathItem) {
-        qWarning() << "❌ pathItem is null";
+        Logger::instance().warning("pathItem is null");
         return false;
     }
     
-    // 将QPainterPath转换为WKT格式
-    QString wkt = painterPathToWkt(pathItem->path());
-    
-    qDebug() << "➕ INSERT 管线:" << pipeline.pipelineId();
-    
-    // 使用PostGIS的ST_GeomFromText函数
-    QString sql = "INSERT INTO pipelines ("
-                 "pipeline_id, pipeline_name, pipeline_type, geom, "
-                 "diameter_mm, material, status, health_score, "
-                 "created_at, created_by) "
-                 "VALUES ("
-                 ":pipeline_id, :pipeline_name, :pipeline_type, "
-                 "ST_GeomFromText(:geom_wkt, 4326), "
-                 ":diameter_mm, :material, :status, :health_score, "
-                 ":created_at, :created_by)";
+    // 将QPainterPath转换为WKB格式
+    QByteArray wkb = painterPathToWkb(pathItem->path());
+    
+    // 几何以 WKB 字节绑定（PostGIS 经 ST_GeomFromWKB 转换，离线库原样存储）
+    const SqlDialect &dialect = SqlDialect::current();
+    QString sql = QString("INSERT INTO pipelines ("
+                          "pipeline_id, pipeline_name, pipeline_type, geom, "
+                          "diameter_mm, material, status, health_score, "
+                          "created_at, created_by) "
+                          "VALUES ("
+                          ":pipeline_id, :pipeline_name, :pipeline_type, "
+                          "%1, "
+                          ":diameter_mm, :material, :status, :health_score, "
+                          ":created_at, :created_by)")
+                      .arg(dialect.castParameter(":geom_wkb", "geometry"));
     
     QVariantMap params;
     params[":pipeline_id"] = pipeline.pipelineId();
     params[":pipeline_name"] = pipeline.pipelineName();
     params[":pipeline_type"] = pipeline.pipelineType();
-    params[":geom_wkt"] = wkt;
-    params[":diameter_mm"] = pathItem->data(3).toInt();
+    params[":geom_wkb"] = wkb;
+    params[":diameter_mm"] = pathItem->diameterMm();
     params[":material"] = "unknown";
     params[":status"] = "active";
     params[":health_score"] = 100;
@@ -229,87 +277,55 @@ bool DrawingDatabaseManager::insertPipelineToDatabase(QGraphicsPathItem *pathIte
     bool success = DatabaseManager::instance().executeCommand(sql, params);
     
     if (success) {
-        qDebug() << "✅ INSERT 管线成功:" << pipeline.pipelineId();
+        dialect.refreshSpatialIndex("pipelines", "pipeline_id", QVariantList{pipeline.pipelineId()});
     } else {
-        QString error = DatabaseManager::instance().lastError();
-        qWarning() << "❌ INSERT 管线失败:" << pipeline.pipelineId();
-        qWarning() << "❌ 错误:" << error;
+        Logger::instance().error(QString("新增管线失败：%1, 错误=%2")
+            .arg(pipeline.pipelineId(), DatabaseManager::instance().lastError()));
     }
     
     return success;
 }
 
-bool DrawingDatabaseManager::updatePipelineToDatabase(QGraphicsPathItem *pathItem, const Pipeline &pipeline)
+bool DrawingDatabaseManager::updatePipelinesInDatabase(const QList<QPair<PipelineGraphicsItem*, Pipeline>> &pipelines)
 {
-    if (!pathItem) {
-        qWarning() << "❌ pathItem is null";
-        return false;
+    if (pipelines.isEmpty()) {
+        return true;
     }
     
-    // 将QPainterPath转换为WKT格式
-    QString wkt = painterPathToWkt(pathItem->path());
-    
-    qDebug() << "🔄 UPDATE 管线:" << pipeline.pipelineId();
-    
-    QString sql = "UPDATE pipelines SET "
-                 "pipeline_name = :pipeline_name, "
-                 "pipeline_type = :pipeline_type, "
-                 "geom = ST_GeomFromText(:geom_wkt, 4326), "
-                 "diameter_mm = :diameter_mm, "
-                 "updated_at = :updated_at "
-                 "WHERE pipeline_id = :pipeline_id";
-    
-    QVariantMap params;
-    params[":pipeline_id"] = pipeline.pipelineId();
-    params[":pipeline_name"] = pipeline.pipelineName();
-    params[":pipeline_type"] = pipeline.pipelineType();
-    params[":geom_wkt"] = wkt;
-    params[":diameter_mm"] = pathItem->data(3).toInt();
-    params[":updated_at"] = QDateTime::currentDateTime();
-    
-    bool success = DatabaseManager::instance().executeCommand(sql, params);
-    
-    if (success) {
-        qDebug() << "✅ UPDATE 管线成功:" << pipeline.pipelineId();
-    } else {
-        qWarning() << "❌ UPDATE 管线失败:" << pipeline.pipelineId();
+    // 只写入绘制时可变的列；事务由调用方管理
+    BulkWriter writer("pipelines", BulkWriter::Update, {"pipeline_id", "text"},
+                      {{"pipeline_name", "text"},
+                       {"pipeline_type", "text"},
+                       {"geom", "geometry"},
+                       {"diameter_mm", "integer"},
+                       {"updated_at", "timestamp"}},
+                      false);
+    
+    const QDateTime now = QDateTime::currentDateTime();
+    for (const auto &entry : pipelines) {
+        const Pipeline &pipeline = entry.second;
+        writer.add(pipeline.pipelineId(), {pipeline.pipelineName(),
+                                           pipeline.pipelineType(),
+                                           painterPathToWkb(entry.first->path()),
+                                           entry.first->diameterMm(),
+                                           now});
     }
     
-    return success;
-}
-
-bool DrawingDatabaseManager::deletePipelineFromDatabase(const QString &pipelineId)
-{
-    qDebug() << "🗑️ DELETE 管线:" << pipelineId;
-    
-    QString sql = "DELETE FROM pipelines WHERE pipeline_id = :pipeline_id";
-    
-    QVariantMap params;
-    params[":pipeline_id"] = pipelineId;
-    
-    bool success = DatabaseManager::instance().executeCommand(sql, params);
-    
-    if (success) {
-        qDebug() << "✅ DELETE 管线成功:" << pipelineId;
-    } else {
-        qWarning() << "❌ DELETE 管线失败:" << pipelineId;
+    bool success = writer.finish();
+    if (!success) {
+        Logger::instance().error(QString("更新管线失败：%1").arg(writer.lastError()));
     }
-    
     return success;
 }
 
-bool DrawingDatabaseManager::insertFacilityToDatabase(QGraphicsEllipseItem *ellipseItem)
+bool DrawingDatabaseManager::insertFacilityToDatabase(FacilityGraphicsItem *ellipseItem, const QString &facilityId)
 {
     if (!ellipseItem) {
         return false;
     }
     
-    // 生成设施ID
-    static int facilityCounter = 1;
-    QString facilityId = QString("FACILITY-%1").arg(facilityCounter++, 3, 10, QChar('0'));
-    
     // 获取设施类型
-    QString facilityType = ellipseItem->data(1).toString();
+    QString facilityType = ellipseItem->entityType();
     if (facilityType.isEmpty()) {
         facilityType = "unknown";
     }
@@ -318,22 +334,22 @@ bool DrawingDatabaseManager::insertFacilityToDatabase(QGraphicsEllipseItem *elli
     QRectF rect = ellipseItem->rect();
     QPointF center = ellipseItem->pos() + rect.center();
     
-    qDebug() << "➕ INSERT 设施:" << facilityId;
-    
     // 构建SQL语句
-    QString sql = "INSERT INTO facilities ("
-                 "facility_id, facility_name, facility_type, geom, "
-                 "status, health_score, created_at, created_by) "
-                 "VALUES ("
-                 ":facility_id, :facility_name, :facility_type, "
-                 "ST_GeomFromText(:geom_wkt, 4326), "
-                 ":status, :health_score, :created_at, :created_by)";
+    const SqlDialect &dialect = SqlDialect::current();
+    QString sql = QString("INSERT INTO facilities ("
+                          "facility_id, facility_name, facility_type, geom, "
+                          "status, health_score, created_at, created_by) "
+                          "VALUES ("
+                          ":facility_id, :facility_name, :facility_type, "
+                          "%1, "
+                          ":status, :health_score, :created_at, :created_by)")
+                      .arg(dialect.castParameter(":geom_wkb", "geometry"));
     
     QVariantMap params;
     params[":facility_id"] = facilityId;
     params[":facility_name"] = facilityType + " " + facilityId;
     params[":facility_type"] = facilityType;
-    params[":geom_wkt"] = pointToWkt(center);
+    params[":geom_wkb"] = WkbCodec::encodePoint(center);
     params[":status"] = "normal";
     params[":health_score"] = 100;
     params[":created_at"] = QDateTime::currentDateTime();
@@ -342,90 +358,76 @@ bool DrawingDatabaseManager::insertFacilityToDatabase(QGraphicsEllipseItem *elli
     bool success = DatabaseManager::instance().executeCommand(sql, params);
     
     if (success) {
-        // 保存成功后，将ID存储到item中
-        ellipseItem->setData(10, facilityId);
-        qDebug() << "✅ INSERT 设施成功:" << facilityId;
+        dialect.refreshSpatialIndex("facilities", "facility_id", QVariantList{facilityId});
     } else {
-        qWarning() << "❌ INSERT 设施失败:" << facilityId;
+        Logger::instance().error(QString("新增设施失败：%1, 错误=%2")
+            .arg(facilityId, DatabaseManager::instance().lastError()));
     }
     
     return success;
 }
 
-bool DrawingDatabaseManager::updateFacilityToDatabase(QGraphicsEllipseItem *ellipseItem)
+bool DrawingDatabaseManager::updateFacilitiesInDatabase(const QList<FacilityGraphicsItem*> &facilities)
 {
-    if (!ellipseItem) {
-        return false;
+    if (facilities.isEmpty()) {
+        return true;
     }
     
-    QString facilityId = ellipseItem->data(10).toString();
-    QString facilityType = ellipseItem->data(1).toString();
-    
-    // 获取中心点坐标
-    QRectF rect = ellipseItem->rect();
-    QPointF center = ellipseItem->pos() + rect.center();
-    
-    qDebug() << "🔄 UPDATE 设施:" << facilityId;
-    
-    QString sql = "UPDATE facilities SET "
-                 "facility_type = :facility_type, "
-                 "geom = ST_GeomFromText(:geom_wkt, 4326), "
-                 "updated_at = :updated_at "
-                 "WHERE facility_id = :facility_id";
-    
-    QVariantMap params;
-    params[":facility_id"] = facilityId;
-    params[":facility_type"] = facilityType;
-    params[":geom_wkt"] = pointToWkt(center);
-    params[":updated_at"] = QDateTime::currentDateTime();
-    
-    bool success = DatabaseManager::instance().executeCommand(sql, params);
-    
-    if (success) {
-        qDebug() << "✅ UPDATE 设施成功:" << facilityId;
-    } else {
-        qWarning() << "❌ UPDATE 设施失败:" << facilityId;
+    BulkWriter writer("facilities", BulkWriter::Update, {"facility_id", "text"},
+                      {{"facility_type", "text"},
+                       {"geom", "geometry"},
+                       {"updated_at", "timestamp"}},
+                      false);
+    
+    const QDateTime now = QDateTime::currentDateTime();
+    for (FacilityGraphicsItem *ellipseItem : facilities) {
+        // 获取中心点坐标
+        QPointF center = ellipseItem->pos() + ellipseItem->rect().center();
+        writer.add(ellipseItem->entityId(), {ellipseItem->entityType(),
+                                             WkbCodec::encodePoint(center),
+                                             now});
     }
     
+    bool success = writer.finish();
+    if (!success) {
+        Logger::instance().error(QString("更新设施失败：%1").arg(writer.lastError()));
+    }
     return success;
 }
 
-bool DrawingDatabaseManager::deleteFacilityFromDatabase(const QString &facilityId)
+bool DrawingDatabaseManager::deleteFromDatabase(const QString &tableName, const QString &keyColumn,
+                                                const QStringList &ids)
 {
-    qDebug() << "🗑️ DELETE 设施:" << facilityId;
-    
-    QString sql = "DELETE FROM facilities WHERE facility_id = :facility_id";
-    
-    QVariantMap params;
-    params[":facility_id"] = facilityId;
-    
-    bool success = DatabaseManager::instance().executeCommand(sql, params);
+    if (ids.isEmpty()) {
+        return true;
+    }
     
-    if (success) {
-        qDebug() << "✅ DELETE 设施成功:" << facilityId;
-    } else {
-        qWarning() << "❌ DELETE 设施失败:" << facilityId;
+    BulkWriter writer(tableName, BulkWriter::Delete, {keyColumn, "text"}, {}, false);
+    for (const QString &id : ids) {
+        writer.add(id);
     }
     
+    bool success = writer.finish();
+    if (!success) {
+        Logger::instance().error(QString("删除 %1 失败：%2").arg(tableName, writer.lastError()));
+    }
     return success;
 }
 
 int DrawingDatabaseManager::loadPipelinesFromDatabase(QGraphicsScene *scene,
-                                                      QHash<QGraphicsItem*, Pipeline> &pipelineHash)
+                                                      QHash<QGraphicsItem*, Pipeline> &pipelineHash,
+                                                      LayerItemRegistry *registry)
 {
     // 查询所有用户绘制的管线（使用created_by字段）
-    QString sql = "SELECT *, ST_AsText(geom) as geom_text "
+    QString sql = "SELECT *, " + SqlDialect::current().geometryColumn("geom_wkb") + " "
                  "FROM pipelines "
                  "WHERE created_by = 'user_drawing' "
                  "ORDER BY created_at";
     
-    qDebug() << "🔍 执行加载SQL:" << sql;
-    
     QSqlQuery query = DatabaseManager::instance().executeQuery(sql);
     
     if (query.lastError().isValid()) {
-        qWarning() << "❌ 查询失败:" << query.lastError().text();
-        qWarning() << "❌ SQL:" << sql;
+        Logger::instance().error(QString("加载绘制管线失败：%1").arg(query.lastError().text()));
         return 0;
     }
     
@@ -438,20 +440,19 @@ int DrawingDatabaseManager::loadPipelinesFromDatabase(QGraphicsScene *scene,
         pipeline.setPipelineName(query.value("pipeline_name").toString());
         pipeline.setPipelineType(query.value("pipeline_type").toString());
         
-        // 从 ST_AsText(geom) 结果读取WKT
-        QString geomWkt = query.value("geom_text").toString();
-        pipeline.setGeomWkt(geomWkt);
+        // 从 ST_AsBinary(geom) 结果读取WKB
+        QByteArray geomWkb = query.value("geom_wkb").toByteArray();
         
         pipeline.setDiameterMm(query.value("diameter_mm").toInt());
         pipeline.setMaterial(query.value("material").toString());
         pipeline.setStatus(query.value("status").toString());
         pipeline.setHealthScore(query.value("health_score").toInt());
         
-        // 将WKT转换为QPainterPath
-        QPainterPath path = wktToPainterPath(geomWkt);
+        // 将WKB转换为QPainterPath
+        QPainterPath path = wkbToPainterPath(geomWkb);
         
-        // 创建QGraphicsPathItem
-        QGraphicsPathItem *pathItem = new QGraphicsPathItem(path);
+        // 创建管线图形项
+        PipelineGraphicsItem *pathItem = new PipelineGraphicsItem(path);
         
         // 设置样式（根据管线类型设置颜色）
         QColor color = Qt::blue;  // 默认颜色
@@ -476,13 +477,13 @@ int DrawingDatabaseManager::loadPipelinesFromDatabase(QGraphicsScene *scene,
         QPen pen(color, lineWidth);
         pathItem->setPen(pen);
         
-        // 设置数据（与PipelineRenderer保持一致）
-        pathItem->setData(0, "pipeline");  // 实体类型
-        pathItem->setData(1, pipeline.pipelineId());  // 管线编号
-        pathItem->setData(2, pipeline.pipelineType());  // 管线类型（用于图层控制）
-        pathItem->setData(3, lineWidth);  // 线宽
-        pathItem->setData(10, pipeline.id());  // 数据库ID
-        pathItem->setData(100, static_cast<int>(EntityState::Unchanged));  // 实体状态：未变更
+        // 设置实体字段（与PipelineRenderer保持一致）
+        pathItem->setEntityId(pipeline.pipelineId());  // 管线编号
+        pathItem->setEntityType(pipeline.pipelineType());  // 管线类型（用于图层控制）
+        pathItem->setName(pipeline.pipelineName());  // 管线名称
+        pathItem->setDiameterMm(pipeline.diameterMm());  // 管径
+        pathItem->setDatabaseId(pipeline.id());  // 数据库ID
+        pathItem->setState(EntityState::Unchanged);  // 实体状态：未变更
         
         // 设置工具提示
         pathItem->setToolTip(QString("%1\nID: %2\n类型: %3")
@@ -492,6 +493,9 @@ int DrawingDatabaseManager::loadPipelinesFromDatabase(QGraphicsScene *scene,
         
         // 添加到场景
         scene->addItem(pathItem);
+        if (registry) {
+            registry->addEntityItem(pathItem);
+        }
         
         // 添加到哈希表
         pipelineHash[pathItem] = pipeline;
@@ -503,10 +507,11 @@ int DrawingDatabaseManager::loadPipelinesFromDatabase(QGraphicsScene *scene,
     return count;
 }
 
-int DrawingDatabaseManager::loadFacilitiesFromDatabase(QGraphicsScene *scene)
+int DrawingDatabaseManager::loadFacilitiesFromDatabase(QGraphicsScene *scene,
+                                                       LayerItemRegistry *registry)
 {
     // 查询所有用户绘制的设施（使用created_by字段）
-    QString sql = "SELECT *, ST_AsText(geom) as geom_text "
+    QString sql = "SELECT *, " + SqlDialect::current().geometryColumn("geom_wkb") + " "
                  "FROM facilities "
                  "WHERE created_by = 'user_drawing' "
                  "ORDER BY created_at";
@@ -518,16 +523,16 @@ int DrawingDatabaseManager::loadFacilitiesFromDatabase(QGraphicsScene *scene)
         // 解析设施数据
         QString facilityId = query.value("facility_id").toString();
         QString facilityType = query.value("facility_type").toString();
-        QString geomWkt = query.value("geom_text").toString();
         
-        // 将WKT转换为点坐标
-        QPointF center = wktToPoint(geomWkt);
+        // 将WKB转换为点坐标
+        QPointF center;
+        WkbCodec::decodePoint(query.value("geom_wkb").toByteArray(), &center);
         
-        // 创建QGraphicsEllipseItem
+        // 创建设施图形项
         double radius = 5.0;  // 默认半径
-        QGraphicsEllipseItem *ellipseItem = new QGraphicsEllipseItem(
+        FacilityGraphicsItem *ellipseItem = new FacilityGraphicsItem(QRectF(
             -radius, -radius, radius * 2, radius * 2
-        );
+        ));
         
         ellipseItem->setPos(center);
         
@@ -536,12 +541,11 @@ int DrawingDatabaseManager::loadFacilitiesFromDatabase(QGraphicsScene *scene)
         ellipseItem->setBrush(QBrush(color));
         ellipseItem->setPen(QPen(Qt::black, 1));
         
-        // 设置数据（与FacilityRenderer保持一致）
-        ellipseItem->setData(0, "facility");  // 实体类型
-        ellipseItem->setData(1, facilityId);  // 设施编号
-        ellipseItem->setData(2, facilityType);  // 设施类型（用于图层控制）
-        ellipseItem->setData(10, facilityId);  // 设施ID
-        ellipseItem->setData(100, static_cast<int>(EntityState::Unchanged));  // 实体状态：未变更
+        // 设置实体字段（与FacilityRenderer保持一致）
+        ellipseItem->setEntityId(facilityId);  // 设施编号
+        ellipseItem->setEntityType(facilityType);  // 设施类型（用于图层控制）
+        ellipseItem->setDatabaseId(query.value("id").toInt());  // 数据库ID
+        ellipseItem->setState(EntityState::Unchanged);  // 实体状态：未变更
         
         // 设置可选中和可交互标志（重要：使设施可以被点击选中）
         ellipseItem->setFlag(QGraphicsItem::ItemIsSelectable, true);
@@ -556,6 +560,9 @@ int DrawingDatabaseManager::loadFacilitiesFromDatabase(QGraphicsScene *scene)
         
         // 添加到场景
         scene->addItem(ellipseItem);
+        if (registry) {
+            registry->addEntityItem(ellipseItem);
+        }
         
         count++;
     }
@@ -564,73 +571,31 @@ int DrawingDatabaseManager::loadFacilitiesFromDatabase(QGraphicsScene *scene)
     return count;
 }
 
-QString DrawingDatabaseManager::painterPathToWkt(const QPainterPath &path)
+QByteArray DrawingDatabaseManager::painterPathToWkb(const QPainterPath &path)
 {
     if (path.elementCount() == 0) {
-        return QString();
+        return QByteArray();
     }
     
-    QStringList coords;
+    QVector<QPointF> points;
+    points.reserve(path.elementCount());
     for (int i = 0; i < path.elementCount(); ++i) {
-        QPainterPath::Element element = path.elementAt(i);
-        // WKT格式：LINESTRING(x1 y1, x2 y2, ...)
-        coords.append(QString("%1 %2").arg(element.x, 0, 'f', 6).arg(element.y, 0, 'f', 6));
+        const QPainterPath::Element &element = path.elementAt(i);
+        points.append(QPointF(element.x, element.y));
     }
     
-    return QString("LINESTRING(%1)").arg(coords.join(", "));
+    return WkbCodec::encodeLineString(points);
 }
 
-QPainterPath DrawingDatabaseManager::wktToPainterPath(const QString &wkt)
+QPainterPath DrawingDatabaseManager::wkbToPainterPath(const QByteArray &wkb)
 {
     QPainterPath path;
     
-    // 解析WKT格式：LINESTRING(x1 y1, x2 y2, ...)
-    QString coordsStr = wkt;
-    coordsStr.remove("LINESTRING(");
-    coordsStr.remove(")");
-    
-    QStringList coordPairs = coordsStr.split(',', Qt::SkipEmptyParts);
-    
-    bool isFirst = true;
-    for (const QString &coordPair : coordPairs) {
-        QStringList coords = coordPair.trimmed().split(' ', Qt::SkipEmptyParts);
-        if (coords.size() >= 2) {
-            double x = coords[0].toDouble();
-            double y = coords[1].toDouble();
-            
-            if (isFirst) {
-                path.moveTo(x, y);
-                isFirst = false;
-            } else {
-                path.lineTo(x, y);
-            }
-        }
+    // 坐标直接解码到点数组，再整体加入路径（首点 moveTo，其余 lineTo，不闭合）
+    QVector<QPointF> points;
+    if (WkbCodec::decodeLineString(wkb, points) && !points.isEmpty()) {
+        path.addPolygon(QPolygonF(points));
     }
     
     return path;
 }
-
-QString DrawingDatabaseManager::pointToWkt(const QPointF &point)
-{
-    // WKT格式：POINT(x y)
-    return QString("POINT(%1 %2)")
-        .arg(point.x(), 0, 'f', 6)
-        .arg(point.y(), 0, 'f', 6);
-}
-
-QPointF DrawingDatabaseManager::wktToPoint(const QString &wkt)
-{
-    // 解析WKT格式：POINT(x y)
-    QString coordsStr = wkt;
-    coordsStr.remove("POINT(");
-    coordsStr.remove(")");
-    
-    QStringList coords = coordsStr.trimmed().split(' ', Qt::SkipEmptyParts);
-    if (coords.size() >= 2) {
-        double x = coords[0].toDouble();
-        double y = coords[1].toDouble();
-        return QPointF(x, y);
-    }
-    
-    return QPointF();
-}
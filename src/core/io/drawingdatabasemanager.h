@@ -3,9 +3,17 @@
 
 #include <QGraphicsScene>
 #include <QHash>
+#include <QByteArray>
+#include <QList>
+#include <QPair>
+#include <QStringList>
 #include "core/models/pipeline.h"
 #include "core/common/entitystate.h"  // 引入实体状态枚举
 
+class LayerItemRegistry;
+class PipelineGraphicsItem;
+class FacilityGraphicsItem;
+
 /**
  * @brief 绘制数据数据库管理器
  * 将绘制的管线和设施保存到数据库/从数据库加载
@@ -15,23 +23,28 @@ class DrawingDatabaseManager
 public:
     /**
      * @brief 保存绘制数据到数据库
+     * 全部变更在一个事务中写入（修改与删除按批），任一失败整体回滚，实体保持原状态
      * @param scene 场景对象
      * @param pipelineHash 管线哈希表
+     * @param registry 图层图形项注册表（可选，用于只遍历实体项并在删除时注销）
      * @return 保存成功返回true
      */
     static bool saveToDatabase(QGraphicsScene *scene,
-                               const QHash<QGraphicsItem*, Pipeline> &pipelineHash);
+                               const QHash<QGraphicsItem*, Pipeline> &pipelineHash,
+                               LayerItemRegistry *registry = nullptr);
     
     /**
      * @brief 从数据库加载绘制数据
      * @param scene 场景对象
      * @param pipelineHash 管线哈希表（输出参数）
      * @param nextId 下一个管线ID（输出参数）
+     * @param registry 图层图形项注册表（可选，加载的图形项登记到对应图层）
      * @return 加载成功返回true
      */
     static bool loadFromDatabase(QGraphicsScene *scene,
                                  QHash<QGraphicsItem*, Pipeline> &pipelineHash,
-                                 int &nextId);
+                                 int &nextId,
+                                 LayerItemRegistry *registry = nullptr);
     
     /**
      * @brief 清空数据库中的绘制数据
@@ -42,91 +55,75 @@ public:
 private:
     /**
      * @brief 插入管线到数据库 (INSERT)
-     * @param pathItem 路径图形项
+     * @param pathItem 管线图形项
      * @param pipeline 管线对象
      * @return 成功返回true
      */
-    static bool insertPipelineToDatabase(QGraphicsPathItem *pathItem, const Pipeline &pipeline);
+    static bool insertPipelineToDatabase(PipelineGraphicsItem *pathItem, const Pipeline &pipeline);
     
     /**
-     * @brief 更新管线到数据库 (UPDATE)
-     * @param pathItem 路径图形项
-     * @param pipeline 管线对象
-     * @return 成功返回true
-     */
-    static bool updatePipelineToDatabase(QGraphicsPathItem *pathItem, const Pipeline &pipeline);
-    
-    /**
-     * @brief 从数据库删除管线 (DELETE)
-     * @param pipelineId 管线ID
+     * @brief 插入设施到数据库 (INSERT)
+     * @param ellipseItem 设施图形项
+     * @param facilityId 设施编号（由调用方确定，提交成功后再写回图形项）
      * @return 成功返回true
      */
-    static bool deletePipelineFromDatabase(const QString &pipelineId);
+    static bool insertFacilityToDatabase(FacilityGraphicsItem *ellipseItem, const QString &facilityId);
     
     /**
-     * @brief 插入设施到数据库 (INSERT)
-     * @param ellipseItem 椭圆图形项
+     * @brief 批量更新管线 (UPDATE ... FROM VALUES，事务由调用方管理)
+     * @param pipelines 管线图形项及其管线对象
      * @return 成功返回true
      */
-    static bool insertFacilityToDatabase(QGraphicsEllipseItem *ellipseItem);
+    static bool updatePipelinesInDatabase(const QList<QPair<PipelineGraphicsItem*, Pipeline>> &pipelines);
     
     /**
-     * @brief 更新设施到数据库 (UPDATE)
-     * @param ellipseItem 椭圆图形项
+     * @brief 批量更新设施 (UPDATE ... FROM VALUES，事务由调用方管理)
+     * @param facilities 设施图形项
      * @return 成功返回true
      */
-    static bool updateFacilityToDatabase(QGraphicsEllipseItem *ellipseItem);
+    static bool updateFacilitiesInDatabase(const QList<FacilityGraphicsItem*> &facilities);
     
     /**
-     * @brief 从数据库删除设施 (DELETE)
-     * @param facilityId 设施ID
+     * @brief 按编号批量删除 (DELETE ... IN (VALUES ...)，事务由调用方管理)
+     * @param tableName 表名
+     * @param keyColumn 编号列
+     * @param ids 编号列表
      * @return 成功返回true
      */
-    static bool deleteFacilityFromDatabase(const QString &facilityId);
+    static bool deleteFromDatabase(const QString &tableName, const QString &keyColumn, const QStringList &ids);
     
     /**
      * @brief 从数据库加载管线并创建图形项
      * @param scene 场景对象
      * @param pipelineHash 管线哈希表（输出参数）
+     * @param registry 图层图形项注册表（可选）
      * @return 加载的管线数量
      */
     static int loadPipelinesFromDatabase(QGraphicsScene *scene,
-                                        QHash<QGraphicsItem*, Pipeline> &pipelineHash);
+                                        QHash<QGraphicsItem*, Pipeline> &pipelineHash,
+                                        LayerItemRegistry *registry);
     
     /**
      * @brief 从数据库加载设施并创建图形项
      * @param scene 场景对象
+     * @param registry 图层图形项注册表（可选）
      * @return 加载的设施数量
      */
-    static int loadFacilitiesFromDatabase(QGraphicsScene *scene);
+    static int loadFacilitiesFromDatabase(QGraphicsScene *scene, LayerItemRegistry *registry);
     
     /**
-     * @brief 将QPainterPath转换为WKT格式的LINESTRING
+     * @brief 将QPainterPath转换为WKB格式的LINESTRING（配合 ST_GeomFromWKB 绑定）
      * @param path 路径对象
-     * @return WKT字符串
+     * @return WKB字节
      */
-    static QString painterPathToWkt(const QPainterPath &path);
+    static QByteArray painterPathToWkb(const QPainterPath &path);
     
     /**
-     * @brief 将WKT格式的LINESTRING转换为QPainterPath
-     * @param wkt WKT字符串
+     * @brief 将WKB格式的LINESTRING（ST_AsBinary 结果）转换为QPainterPath
+     * @param wkb WKB字节
      * @return 路径对象
      */
-    static QPainterPath wktToPainterPath(const QString &wkt);
-    
-    /**
-     * @brief 将点转换为WKT格式的POINT
-     * @param point 点坐标
-     * @return WKT字符串
-     */
-    static QString pointToWkt(const QPointF &point);
-    
-    /**
-     * @brief 从WKT格式的POINT解析点坐标
-     * @param wkt WKT字符串
-     * @return 点坐标
-     */
-    static QPointF wktToPoint(const QString &wkt);
+    static QPainterPath wkbToPainterPath(const QByteArray &wkb);
 };
 
 #endif // DRAWINGDATABASEMANAGER_H
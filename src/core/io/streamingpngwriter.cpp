@@ -0,0 +1,333 @@
+#include "core/io/streamingpngwriter.h"
+#include <QtMath>
+
+namespace {
+
+const int kIdatFlushSize = 64 * 1024;
+
+// 长度码 257..285 的基础长度与附加位数（RFC 1951 3.2.5）
+const int kLengthBase[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+const int kLengthExtra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+
+struct HuffmanCode {
+    quint16 bits;   // 已按位反转，可直接低位优先写出
+    quint8 length;
+};
+
+quint16 reverseBits(quint16 code, int length)
+{
+    quint16 result = 0;
+    for (int i = 0; i < length; ++i) {
+        result = static_cast<quint16>((result << 1) | (code & 1));
+        code >>= 1;
+    }
+    return result;
+}
+
+// 固定哈夫曼编码表（RFC 1951 3.2.6）
+const HuffmanCode* fixedLiteralCodes()
+{
+    static const auto table = [] {
+        static HuffmanCode codes[288];
+        for (int symbol = 0; symbol < 288; ++symbol) {
+            quint16 code;
+            int length;
+            if (symbol < 144) {
+                code = static_cast<quint16>(0x30 + symbol);
+                length = 8;
+            } else if (symbol < 256) {
+                code = static_cast<quint16>(0x190 + symbol - 144);
+                length = 9;
+            } else if (symbol < 280) {
+                code = static_cast<quint16>(symbol - 256);
+                length = 7;
+            } else {
+                code = static_cast<quint16>(0xC0 + symbol - 280);
+                length = 8;
+            }
+            codes[symbol].bits = reverseBits(code, length);
+            codes[symbol].length = static_cast<quint8>(length);
+        }
+        return codes;
+    }();
+    return table;
+}
+
+const quint32* crcTable()
+{
+    static const auto table = [] {
+        static quint32 crc[256];
+        for (quint32 n = 0; n < 256; ++n) {
+            quint32 c = n;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+            }
+            crc[n] = c;
+        }
+        return crc;
+    }();
+    return table;
+}
+
+quint32 updateCrc(quint32 crc, const char *data, int size)
+{
+    const quint32 *table = crcTable();
+    for (int i = 0; i < size; ++i) {
+        crc = table[(crc ^ static_cast<uchar>(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+void appendUInt32(QByteArray &buffer, quint32 value)
+{
+    buffer.append(static_cast<char>((value >> 24) & 0xFF));
+    buffer.append(static_cast<char>((value >> 16) & 0xFF));
+    buffer.append(static_cast<char>((value >> 8) & 0xFF));
+    buffer.append(static_cast<char>(value & 0xFF));
+}
+
+} // namespace
+
+StreamingPngWriter::StreamingPngWriter(const QString &filePath)
+    : m_file(filePath)
+    , m_width(0)
+    , m_height(0)
+    , m_rowsWritten(0)
+    , m_failed(false)
+    , m_bitBuffer(0)
+    , m_bitCount(0)
+    , m_lastByte(-1)
+    , m_runLength(0)
+    , m_adlerA(1)
+    , m_adlerB(0)
+{
+}
+
+StreamingPngWriter::~StreamingPngWriter()
+{
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+}
+
+bool StreamingPngWriter::open(int width, int height, int dpi)
+{
+    if (width <= 0 || height <= 0) {
+        m_error = QStringLiteral("无效的图像尺寸: %1x%2").arg(width).arg(height);
+        return false;
+    }
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        m_error = QStringLiteral("无法写入文件: %1").arg(m_file.errorString());
+        return false;
+    }
+
+    m_width = width;
+    m_height = height;
+    m_rowsWritten = 0;
+    m_failed = false;
+    m_filteredRow.resize(1 + width * 3);
+
+    static const char signature[8] = { '\x89', 'P', 'N', 'G', '\r', '\n', '\x1A', '\n' };
+    if (m_file.write(signature, 8) != 8) {
+        m_error = m_file.errorString();
+        m_failed = true;
+        return false;
+    }
+
+    QByteArray header;
+    appendUInt32(header, static_cast<quint32>(width));
+    appendUInt32(header, static_cast<quint32>(height));
+    header.append(static_cast<char>(8));   // 位深
+    header.append(static_cast<char>(2));   // 颜色类型：RGB
+    header.append(static_cast<char>(0));   // 压缩方法
+    header.append(static_cast<char>(0));   // 滤波方法
+    header.append(static_cast<char>(0));   // 无隔行
+    if (!writeChunk("IHDR", header)) {
+        return false;
+    }
+
+    if (dpi > 0) {
+        QByteArray phys;
+        quint32 pixelsPerMeter = static_cast<quint32>(qRound(dpi / 0.0254));
+        appendUInt32(phys, pixelsPerMeter);
+        appendUInt32(phys, pixelsPerMeter);
+        phys.append(static_cast<char>(1));  // 单位：米
+        if (!writeChunk("pHYs", phys)) {
+            return false;
+        }
+    }
+
+    // zlib 头（deflate，32K 窗口，无预置字典），随后是单个固定哈夫曼块
+    m_idat.reserve(kIdatFlushSize + 64);
+    m_idat.append(static_cast<char>(0x78));
+    m_idat.append(static_cast<char>(0x01));
+    putBits(1, 1);  // BFINAL
+    putBits(1, 2);  // BTYPE = 01 固定哈夫曼
+    return true;
+}
+
+bool StreamingPngWriter::writeRow(const QRgb *pixels)
+{
+    if (m_failed || !m_file.isOpen()) {
+        return false;
+    }
+    if (m_rowsWritten >= m_height) {
+        m_error = QStringLiteral("写入行数超过图像高度");
+        return false;
+    }
+
+    // Sub 滤波：每个字节减去左侧像素同一通道，纯色区域变为连续的 0
+    uchar *out = reinterpret_cast<uchar*>(m_filteredRow.data());
+    out[0] = 1;
+    uchar prevR = 0, prevG = 0, prevB = 0;
+    for (int x = 0; x < m_width; ++x) {
+        uchar r = static_cast<uchar>(qRed(pixels[x]));
+        uchar g = static_cast<uchar>(qGreen(pixels[x]));
+        uchar b = static_cast<uchar>(qBlue(pixels[x]));
+        out[1 + x * 3] = static_cast<uchar>(r - prevR);
+        out[2 + x * 3] = static_cast<uchar>(g - prevG);
+        out[3 + x * 3] = static_cast<uchar>(b - prevB);
+        prevR = r;
+        prevG = g;
+        prevB = b;
+    }
+
+    updateAdler(out, m_filteredRow.size());
+    deflateBytes(out, m_filteredRow.size());
+    ++m_rowsWritten;
+
+    flushIdat(false);
+    return !m_failed;
+}
+
+bool StreamingPngWriter::finish()
+{
+    if (m_failed || !m_file.isOpen()) {
+        return false;
+    }
+    if (m_rowsWritten != m_height) {
+        m_error = QStringLiteral("图像行数不完整: %1/%2").arg(m_rowsWritten).arg(m_height);
+        m_file.close();
+        return false;
+    }
+
+    flushRun();
+    putSymbol(256);  // 块结束
+    if (m_bitCount > 0) {
+        putBits(0, 8 - m_bitCount);
+    }
+    appendUInt32(m_idat, (m_adlerB << 16) | m_adlerA);
+    flushIdat(true);
+
+    bool ok = !m_failed && writeChunk("IEND", QByteArray());
+    m_file.close();
+    return ok;
+}
+
+void StreamingPngWriter::deflateBytes(const uchar *data, int size)
+{
+    for (int i = 0; i < size; ++i) {
+        int value = data[i];
+        if (value == m_lastByte) {
+            if (m_runLength == 258) {
+                flushRun();
+            }
+            ++m_runLength;
+        } else {
+            flushRun();
+            putSymbol(value);
+            m_lastByte = value;
+        }
+    }
+}
+
+void StreamingPngWriter::flushRun()
+{
+    if (m_runLength >= 3) {
+        putMatch(m_runLength);
+    } else {
+        for (int i = 0; i < m_runLength; ++i) {
+            putSymbol(m_lastByte);
+        }
+    }
+    m_runLength = 0;
+}
+
+void StreamingPngWriter::putSymbol(int symbol)
+{
+    const HuffmanCode &code = fixedLiteralCodes()[symbol];
+    putBits(code.bits, code.length);
+}
+
+void StreamingPngWriter::putMatch(int length)
+{
+    int index = 28;
+    while (kLengthBase[index] > length) {
+        --index;
+    }
+    putSymbol(257 + index);
+    if (kLengthExtra[index] > 0) {
+        putBits(static_cast<quint32>(length - kLengthBase[index]), kLengthExtra[index]);
+    }
+    putBits(0, 5);  // 距离码 0（距离 1），固定编码 00000
+}
+
+void StreamingPngWriter::putBits(quint32 value, int count)
+{
+    m_bitBuffer |= static_cast<quint64>(value) << m_bitCount;
+    m_bitCount += count;
+    while (m_bitCount >= 8) {
+        m_idat.append(static_cast<char>(m_bitBuffer & 0xFF));
+        m_bitBuffer >>= 8;
+        m_bitCount -= 8;
+    }
+}
+
+void StreamingPngWriter::updateAdler(const uchar *data, int size)
+{
+    // 5552 为 b 不溢出 32 位前可累加的最大字节数
+    while (size > 0) {
+        int block = qMin(size, 5552);
+        for (int i = 0; i < block; ++i) {
+            m_adlerA += data[i];
+            m_adlerB += m_adlerA;
+        }
+        m_adlerA %= 65521;
+        m_adlerB %= 65521;
+        data += block;
+        size -= block;
+    }
+}
+
+void StreamingPngWriter::flushIdat(bool force)
+{
+    if (m_idat.isEmpty() || (!force && m_idat.size() < kIdatFlushSize)) {
+        return;
+    }
+    writeChunk("IDAT", m_idat);
+    m_idat.clear();
+}
+
+bool StreamingPngWriter::writeChunk(const char *type, const QByteArray &data)
+{
+    QByteArray chunk;
+    chunk.reserve(data.size() + 12);
+    appendUInt32(chunk, static_cast<quint32>(data.size()));
+    chunk.append(type, 4);
+    chunk.append(data);
+    quint32 crc = updateCrc(0xFFFFFFFFu, chunk.constData() + 4, data.size() + 4) ^ 0xFFFFFFFFu;
+    appendUInt32(chunk, crc);
+
+    if (m_file.write(chunk) != chunk.size()) {
+        m_error = QStringLiteral("写入 PNG 数据失败: %1").arg(m_file.errorString());
+        m_failed = true;
+        return false;
+    }
+    return true;
+}
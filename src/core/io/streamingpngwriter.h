@@ -0,0 +1,68 @@
+#ifndef STREAMINGPNGWRITER_H
+#define STREAMINGPNGWRITER_H
+
+#include <QFile>
+#include <QByteArray>
+#include <QString>
+#include <QRgb>
+
+/**
+ * @brief 逐行写入的 PNG 编码器
+ * 按行接收像素并立即压缩写出，内存占用只与一行宽度有关，用于超大幅面导出
+ *
+ * 压缩采用固定哈夫曼编码的 deflate 流，配合 Sub 行滤波只对重复字节做距离为 1
+ * 的游程匹配：底图与矢量图中的大片同色区域压缩效果接近通用编码器，而无需
+ * 链接 zlib 或持有整幅图像。输出为 8 位 RGB，可被任意 PNG 解码器读取
+ */
+class StreamingPngWriter
+{
+public:
+    explicit StreamingPngWriter(const QString &filePath);
+    ~StreamingPngWriter();
+
+    // 写入文件头（IHDR，dpi > 0 时附带 pHYs 分辨率信息）
+    bool open(int width, int height, int dpi = 0);
+
+    // 写入一行像素（width 个 QRgb，忽略 alpha）
+    bool writeRow(const QRgb *pixels);
+
+    // 写入全部行后结束压缩流并关闭文件
+    bool finish();
+
+    int rowsWritten() const { return m_rowsWritten; }
+    QString errorString() const { return m_error; }
+
+private:
+    void deflateBytes(const uchar *data, int size);
+    void flushRun();
+    void putSymbol(int symbol);
+    void putMatch(int length);
+    void putBits(quint32 value, int count);
+    void updateAdler(const uchar *data, int size);
+    void flushIdat(bool force);
+    bool writeChunk(const char *type, const QByteArray &data);
+
+    QFile m_file;
+    QString m_error;
+    int m_width;
+    int m_height;
+    int m_rowsWritten;
+    bool m_failed;
+
+    QByteArray m_filteredRow;   // 滤波类型字节 + 本行 RGB 差分
+    QByteArray m_idat;          // 待写出的压缩数据
+
+    // 位输出缓冲（deflate 按最低位优先打包）
+    quint64 m_bitBuffer;
+    int m_bitCount;
+
+    // 游程状态：最近一个输出字节及其后尚未输出的重复次数
+    int m_lastByte;
+    int m_runLength;
+
+    // Adler-32 校验
+    quint32 m_adlerA;
+    quint32 m_adlerB;
+};
+
+#endif // STREAMINGPNGWRITER_H
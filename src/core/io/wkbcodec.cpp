@@ -0,0 +1,364 @@
+#include "core/io/wkbcodec.h"
+#include <QString>
+#include <QtEndian>
+#include <cmath>
+#include <cstring>
+
+namespace {
+// EWKB 类型标志位
+const quint32 EWKB_Z_FLAG = 0x80000000;
+const quint32 EWKB_M_FLAG = 0x40000000;
+const quint32 EWKB_SRID_FLAG = 0x20000000;
+
+const quint32 GEOMETRY_POINT = 1;
+const quint32 GEOMETRY_LINESTRING = 2;
+const quint32 GEOMETRY_MULTILINESTRING = 5;
+
+// TWKB 元数据标志位
+const uchar TWKB_BBOX = 0x01;
+const uchar TWKB_SIZE = 0x02;
+const uchar TWKB_IDLIST = 0x04;
+const uchar TWKB_EXTENDED_DIMS = 0x08;
+const uchar TWKB_EMPTY = 0x10;
+
+// WKB 字节流读取，越界后 ok 置为 false 且不再前进
+struct WkbReader {
+    const uchar *pos;
+    const uchar *end;
+    bool littleEndian = true;
+    bool ok = true;
+
+    bool has(qint64 bytes) const { return ok && end - pos >= bytes; }
+
+    quint8 byte()
+    {
+        if (!has(1)) {
+            ok = false;
+            return 0;
+        }
+        return *pos++;
+    }
+
+    quint32 uint32()
+    {
+        if (!has(4)) {
+            ok = false;
+            return 0;
+        }
+        const quint32 value = littleEndian ? qFromLittleEndian<quint32>(pos) : qFromBigEndian<quint32>(pos);
+        pos += 4;
+        return value;
+    }
+
+    // 调用方已用 has() 检查长度
+    double float64()
+    {
+        const quint64 bits = littleEndian ? qFromLittleEndian<quint64>(pos) : qFromBigEndian<quint64>(pos);
+        pos += 8;
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+};
+
+struct WkbHeader {
+    quint32 type = 0;
+    int dims = 2;
+};
+
+bool readWkbHeader(WkbReader &reader, WkbHeader &header)
+{
+    reader.littleEndian = reader.byte() == 1;
+    const quint32 rawType = reader.uint32();
+    if (rawType & EWKB_SRID_FLAG) {
+        reader.uint32();
+    }
+
+    header.dims = 2 + ((rawType & EWKB_Z_FLAG) ? 1 : 0) + ((rawType & EWKB_M_FLAG) ? 1 : 0);
+    const quint32 baseType = rawType & 0x0FFFFFFF;
+    // ISO WKB：1000+ 为 Z，2000+ 为 M，3000+ 为 ZM
+    switch (baseType / 1000) {
+    case 1:
+    case 2:
+        header.dims = 3;
+        break;
+    case 3:
+        header.dims = 4;
+        break;
+    default:
+        break;
+    }
+    header.type = baseType % 1000;
+    return reader.ok;
+}
+
+// 读取点序列并追加到 coordinates（只保留 X/Y）
+bool readWkbPoints(WkbReader &reader, int dims, QVector<QPointF> &coordinates)
+{
+    const quint32 count = reader.uint32();
+    const qint64 stride = qint64(dims) * 8;
+    if (!reader.has(qint64(count) * stride)) {
+        return false;
+    }
+
+    const int offset = coordinates.size();
+    coordinates.resize(offset + int(count));
+    QPointF *out = coordinates.data() + offset;
+    for (quint32 i = 0; i < count; ++i) {
+        const double x = reader.float64();
+        const double y = reader.float64();
+        reader.pos += stride - 16;
+        out[i] = QPointF(x, y);
+    }
+    return true;
+}
+
+// TWKB 字节流读取（变长整数）
+struct TwkbReader {
+    const uchar *pos;
+    const uchar *end;
+    bool ok = true;
+
+    quint64 uvarint()
+    {
+        quint64 value = 0;
+        for (int shift = 0; ; shift += 7) {
+            if (pos >= end || shift > 63) {
+                ok = false;
+                return 0;
+            }
+            const uchar b = *pos++;
+            value |= quint64(b & 0x7F) << shift;
+            if (!(b & 0x80)) {
+                return value;
+            }
+        }
+    }
+
+    qint64 svarint()
+    {
+        const quint64 value = uvarint();
+        return qint64(value >> 1) ^ -qint64(value & 1);
+    }
+};
+
+struct TwkbHeader {
+    quint32 type = 0;
+    int dims = 2;
+    double scale = 1.0;
+    bool empty = false;
+    bool idList = false;
+};
+
+bool readTwkbHeader(TwkbReader &reader, TwkbHeader &header)
+{
+    if (reader.end - reader.pos < 2) {
+        return false;
+    }
+    const uchar typeAndPrecision = *reader.pos++;
+    const uchar metadata = *reader.pos++;
+
+    header.type = typeAndPrecision & 0x0F;
+    // 精度为4位 zigzag 编码，坐标 = 整数 * 10^-precision
+    const int zigzag = typeAndPrecision >> 4;
+    const int precision = (zigzag >> 1) ^ -(zigzag & 1);
+    header.scale = std::pow(10.0, -precision);
+
+    if (metadata & TWKB_EXTENDED_DIMS) {
+        if (reader.pos >= reader.end) {
+            return false;
+        }
+        const uchar dims = *reader.pos++;
+        header.dims += ((dims & 0x01) ? 1 : 0) + ((dims & 0x02) ? 1 : 0);
+    }
+    if (metadata & TWKB_SIZE) {
+        reader.uvarint();
+    }
+    header.empty = metadata & TWKB_EMPTY;
+    header.idList = metadata & TWKB_IDLIST;
+    if ((metadata & TWKB_BBOX) && !header.empty) {
+        for (int i = 0; i < header.dims * 2; ++i) {
+            reader.svarint();
+        }
+    }
+    return reader.ok;
+}
+
+// 读取差分点序列（last 为上一个点的整数坐标，跨子几何延续）
+bool readTwkbPoints(TwkbReader &reader, const TwkbHeader &header, qint64 *last,
+                    QVector<QPointF> &coordinates)
+{
+    const quint64 count = reader.uvarint();
+    // 每个坐标分量至少占一个字节；先按剩余字节数除法比较，count 为异常大值时乘法不会溢出
+    const quint64 remaining = quint64(reader.end - reader.pos);
+    if (!reader.ok || header.dims <= 0 || count > remaining / quint64(header.dims)) {
+        return false;
+    }
+
+    const int offset = coordinates.size();
+    coordinates.resize(offset + int(count));
+    QPointF *out = coordinates.data() + offset;
+    for (quint64 i = 0; i < count; ++i) {
+        for (int d = 0; d < header.dims; ++d) {
+            last[d] += reader.svarint();
+        }
+        out[i] = QPointF(last[0] * header.scale, last[1] * header.scale);
+    }
+    return reader.ok;
+}
+
+void writeUInt32(uchar *&pos, quint32 value)
+{
+    qToLittleEndian<quint32>(value, pos);
+    pos += 4;
+}
+
+void writeDouble(uchar *&pos, double value)
+{
+    quint64 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    qToLittleEndian<quint64>(bits, pos);
+    pos += 8;
+}
+
+uchar *writeHeader(QByteArray &buffer, quint32 type, int srid)
+{
+    uchar *pos = reinterpret_cast<uchar*>(buffer.data());
+    *pos++ = 1;     // 小端
+    writeUInt32(pos, srid > 0 ? (type | EWKB_SRID_FLAG) : type);
+    if (srid > 0) {
+        writeUInt32(pos, quint32(srid));
+    }
+    return pos;
+}
+}
+
+bool WkbCodec::decodeLineString(const QByteArray &wkb, QVector<QPointF> &coordinates)
+{
+    coordinates.clear();
+    WkbReader reader{reinterpret_cast<const uchar*>(wkb.constData()),
+                     reinterpret_cast<const uchar*>(wkb.constData()) + wkb.size()};
+    WkbHeader header;
+    if (!readWkbHeader(reader, header)) {
+        return false;
+    }
+
+    if (header.type == GEOMETRY_LINESTRING) {
+        return readWkbPoints(reader, header.dims, coordinates);
+    }
+    if (header.type == GEOMETRY_MULTILINESTRING) {
+        const quint32 parts = reader.uint32();
+        for (quint32 i = 0; i < parts && reader.ok; ++i) {
+            WkbHeader part;
+            if (!readWkbHeader(reader, part) || part.type != GEOMETRY_LINESTRING
+                || !readWkbPoints(reader, part.dims, coordinates)) {
+                return false;
+            }
+        }
+        return reader.ok;
+    }
+    return false;
+}
+
+bool WkbCodec::decodePoint(const QByteArray &wkb, QPointF *point)
+{
+    WkbReader reader{reinterpret_cast<const uchar*>(wkb.constData()),
+                     reinterpret_cast<const uchar*>(wkb.constData()) + wkb.size()};
+    WkbHeader header;
+    if (!readWkbHeader(reader, header) || header.type != GEOMETRY_POINT
+        || !reader.has(qint64(header.dims) * 8)) {
+        return false;
+    }
+
+    const double x = reader.float64();
+    const double y = reader.float64();
+    // 空点以 NaN 表示
+    if (std::isnan(x) || std::isnan(y)) {
+        return false;
+    }
+    if (point) {
+        *point = QPointF(x, y);
+    }
+    return true;
+}
+
+bool WkbCodec::decodeTwkbLineString(const QByteArray &twkb, QVector<QPointF> &coordinates)
+{
+    coordinates.clear();
+    TwkbReader reader{reinterpret_cast<const uchar*>(twkb.constData()),
+                      reinterpret_cast<const uchar*>(twkb.constData()) + twkb.size()};
+    TwkbHeader header;
+    if (!readTwkbHeader(reader, header)) {
+        return false;
+    }
+    if (header.empty) {
+        return true;
+    }
+
+    qint64 last[4] = {0, 0, 0, 0};
+    if (header.type == GEOMETRY_LINESTRING) {
+        return readTwkbPoints(reader, header, last, coordinates);
+    }
+    if (header.type == GEOMETRY_MULTILINESTRING) {
+        const quint64 parts = reader.uvarint();
+        if (header.idList) {
+            for (quint64 i = 0; i < parts && reader.ok; ++i) {
+                reader.svarint();
+            }
+        }
+        for (quint64 i = 0; i < parts && reader.ok; ++i) {
+            if (!readTwkbPoints(reader, header, last, coordinates)) {
+                return false;
+            }
+        }
+        return reader.ok;
+    }
+    return false;
+}
+
+bool WkbCodec::decodeTwkbPoint(const QByteArray &twkb, QPointF *point)
+{
+    TwkbReader reader{reinterpret_cast<const uchar*>(twkb.constData()),
+                      reinterpret_cast<const uchar*>(twkb.constData()) + twkb.size()};
+    TwkbHeader header;
+    if (!readTwkbHeader(reader, header) || header.empty || header.type != GEOMETRY_POINT) {
+        return false;
+    }
+
+    const qint64 x = reader.svarint();
+    const qint64 y = reader.svarint();
+    if (!reader.ok) {
+        return false;
+    }
+    if (point) {
+        *point = QPointF(x * header.scale, y * header.scale);
+    }
+    return true;
+}
+
+QByteArray WkbCodec::encodeLineString(const QVector<QPointF> &coordinates, int srid)
+{
+    QByteArray buffer(1 + 4 + (srid > 0 ? 4 : 0) + 4 + coordinates.size() * 16, Qt::Uninitialized);
+    uchar *pos = writeHeader(buffer, GEOMETRY_LINESTRING, srid);
+    writeUInt32(pos, quint32(coordinates.size()));
+    for (const QPointF &point : coordinates) {
+        writeDouble(pos, point.x());
+        writeDouble(pos, point.y());
+    }
+    return buffer;
+}
+
+QByteArray WkbCodec::encodePoint(const QPointF &point, int srid)
+{
+    QByteArray buffer(1 + 4 + (srid > 0 ? 4 : 0) + 16, Qt::Uninitialized);
+    uchar *pos = writeHeader(buffer, GEOMETRY_POINT, srid);
+    writeDouble(pos, point.x());
+    writeDouble(pos, point.y());
+    return buffer;
+}
+
+QString WkbCodec::geometryLiteral(const QByteArray &ewkb)
+{
+    // 十六进制只含 [0-9A-F]，无需转义
+    return QLatin1Char('\'') + QString::fromLatin1(ewkb.toHex().toUpper()) + QLatin1String("'::geometry");
+}
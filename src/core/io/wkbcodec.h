@@ -0,0 +1,38 @@
+#ifndef WKBCODEC_H
+#define WKBCODEC_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include <QPointF>
+
+/**
+ * @brief 二进制几何编解码（WKB / EWKB / TWKB）
+ * 替代 ST_AsText + 字符串拆分解析：查询端使用 ST_AsBinary 或 ST_AsTWKB，
+ * 解码直接读取字节缓冲写入坐标数组（除输出数组一次分配外不产生临时对象）；
+ * 写入端生成十六进制 EWKB，可作为 geometry 字面量拼入SQL，或以 bytea 绑定给
+ * ST_GeomFromWKB，免去逐个坐标的浮点格式化
+ *
+ * 支持 Point / LineString / MultiLineString（多段线按顺序拼接），
+ * Z/M 维度（EWKB 标志位或 ISO 类型码）读取时忽略
+ */
+class WkbCodec
+{
+public:
+    // WKB / EWKB（ST_AsBinary、ST_AsEWKB）
+    static bool decodeLineString(const QByteArray &wkb, QVector<QPointF> &coordinates);
+    static bool decodePoint(const QByteArray &wkb, QPointF *point);
+
+    // TWKB（ST_AsTWKB，按精度量化的变长差分编码，体积约为 WKB 的 1/3）
+    static bool decodeTwkbLineString(const QByteArray &twkb, QVector<QPointF> &coordinates);
+    static bool decodeTwkbPoint(const QByteArray &twkb, QPointF *point);
+
+    // 编码为小端 WKB；srid > 0 时生成带 SRID 的 EWKB
+    static QByteArray encodeLineString(const QVector<QPointF> &coordinates, int srid = 0);
+    static QByteArray encodePoint(const QPointF &point, int srid = 0);
+
+    // 十六进制 EWKB 字面量（如 '0102000020E6100000...'::geometry），可安全拼入SQL
+    static QString geometryLiteral(const QByteArray &ewkb);
+};
+
+#endif // WKBCODEC_H
@@ -21,7 +21,7 @@ QString Facility::getDisplayName() const
     return m_facilityId;
 }
 
-QString Facility::getTypeDisplayName() const
+QString Facility::typeDisplayName(const QString &type)
 {
     static QMap<QString, QString> typeMap = {
         {"valve", "阀门"},
@@ -32,6 +32,11 @@ QString Facility::getTypeDisplayName() const
         {"junction_box", "接线盒"}
     };
 
-    return typeMap.value(m_facilityType, m_facilityType);
+    return typeMap.value(type, type);
+}
+
+QString Facility::getTypeDisplayName() const
+{
+    return typeDisplayName(m_facilityType);
 }
 
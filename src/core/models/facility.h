@@ -102,6 +102,7 @@ public:
     bool isValid() const;
     QString getDisplayName() const;
     QString getTypeDisplayName() const;
+    static QString typeDisplayName(const QString &type);
 
 private:
     int m_id;
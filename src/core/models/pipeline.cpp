@@ -24,7 +24,7 @@ QString Pipeline::getDisplayName() const
     return m_pipelineId;
 }
 
-QString Pipeline::getTypeDisplayName() const
+QString Pipeline::typeDisplayName(const QString &type)
 {
     static QMap<QString, QString> typeMap = {
         {"water_supply", "给水管"},
@@ -35,6 +35,11 @@ QString Pipeline::getTypeDisplayName() const
         {"heat", "供热管"}
     };
 
-    return typeMap.value(m_pipelineType, m_pipelineType);
+    return typeMap.value(type, type);
+}
+
+QString Pipeline::getTypeDisplayName() const
+{
+    return typeDisplayName(m_pipelineType);
 }
 
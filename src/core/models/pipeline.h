@@ -93,6 +93,7 @@ public:
     bool isValid() const;
     QString getDisplayName() const;
     QString getTypeDisplayName() const;
+    static QString typeDisplayName(const QString &type);
 
 private:
     // 基础信息
@@ -0,0 +1,87 @@
+#ifndef RENDERRECORD_H
+#define RENDERRECORD_H
+
+#include <QString>
+#include <QVector>
+#include <QPointF>
+#include "core/models/pipeline.h"
+#include "core/models/facility.h"
+
+/**
+ * @brief 管线渲染投影
+ * 地图渲染、专题属性表与导出所需的最小字段集，由 PipelineDAO::findRenderRecords* 按列投影查询填充；
+ * 完整的 Pipeline 对象只在打开属性/编辑对话框时按编号加载
+ */
+struct PipelineRenderRecord
+{
+    int id = 0;
+    QString pipelineId;
+    QString pipelineName;
+    QString pipelineType;
+    int diameterMm = 0;
+    int healthScore = 100;
+    int buildYear = 0;           // 0 表示无建设日期
+    double depthM = 0.0;
+    double lengthM = 0.0;
+    QString material;
+    QString pressureClass;
+    QString status;
+    QVector<QPointF> coordinates;
+
+    bool isValid() const { return id > 0 && !pipelineId.isEmpty() && !pipelineType.isEmpty(); }
+    QString displayName() const { return pipelineName.isEmpty() ? pipelineId : pipelineName; }
+
+    static PipelineRenderRecord fromPipeline(const Pipeline &pipeline)
+    {
+        PipelineRenderRecord record;
+        record.id = pipeline.id();
+        record.pipelineId = pipeline.pipelineId();
+        record.pipelineName = pipeline.pipelineName();
+        record.pipelineType = pipeline.pipelineType();
+        record.diameterMm = pipeline.diameterMm();
+        record.healthScore = pipeline.healthScore();
+        record.buildYear = pipeline.buildDate().isValid() ? pipeline.buildDate().year() : 0;
+        record.depthM = pipeline.depthM();
+        record.lengthM = pipeline.lengthM();
+        record.material = pipeline.material();
+        record.pressureClass = pipeline.pressureClass();
+        record.status = pipeline.status();
+        record.coordinates = pipeline.coordinates();
+        return record;
+    }
+};
+
+/**
+ * @brief 设施渲染投影
+ * 设施图标、工具提示与聚类索引所需的最小字段集
+ */
+struct FacilityRenderRecord
+{
+    int id = 0;
+    QString facilityId;
+    QString facilityName;
+    QString facilityType;
+    QString spec;
+    QString pipelineId;
+    int healthScore = 100;
+    QPointF coordinate;
+
+    bool isValid() const { return id > 0 && !facilityId.isEmpty() && !facilityType.isEmpty(); }
+    QString displayName() const { return facilityName.isEmpty() ? facilityId : facilityName; }
+
+    static FacilityRenderRecord fromFacility(const Facility &facility)
+    {
+        FacilityRenderRecord record;
+        record.id = facility.id();
+        record.facilityId = facility.facilityId();
+        record.facilityName = facility.facilityName();
+        record.facilityType = facility.facilityType();
+        record.spec = facility.spec();
+        record.pipelineId = facility.pipelineId();
+        record.healthScore = facility.healthScore();
+        record.coordinate = facility.coordinate();
+        return record;
+    }
+};
+
+#endif // RENDERRECORD_H
@@ -0,0 +1,170 @@
+#include "dao/assetstatisticsdao.h"
+#include "core/database/databasemanager.h"
+#include "core/common/logger.h"
+#include "dao/sqldialect.h"
+#include <QSqlQuery>
+#include <QAtomicInt>
+#include <QMap>
+
+const QString AssetStatisticsDAO::PIPELINE = "pipeline";
+const QString AssetStatisticsDAO::FACILITY = "facility";
+
+namespace {
+// 汇总表安装状态：-1 未检查，0 未安装，1 已安装
+QAtomicInt g_materialized(-1);
+
+// 年份函数因数据库而异（EXTRACT / strftime）
+QString buildYearExpression(const SqlDialect &dialect)
+{
+    const QString year = dialect.yearOf("build_date");
+    return QString("CASE "
+                   "WHEN build_date IS NULL THEN '未知' "
+                   "WHEN %1 < 1980 THEN '1980年以前' "
+                   "WHEN %1 < 1990 THEN '1980-1989年' "
+                   "WHEN %1 < 2000 THEN '1990-1999年' "
+                   "WHEN %1 < 2010 THEN '2000-2009年' "
+                   "WHEN %1 < 2020 THEN '2010-2019年' "
+                   "ELSE '2020年及以后' END").arg(year);
+}
+
+const char *const HEALTH_LEVEL_EXPRESSION =
+    "CASE "
+    "WHEN COALESCE(health_score, 0) >= 90 THEN '优秀(90-100)' "
+    "WHEN COALESCE(health_score, 0) >= 80 THEN '良好(80-89)' "
+    "WHEN COALESCE(health_score, 0) >= 60 THEN '一般(60-79)' "
+    "WHEN COALESCE(health_score, 0) >= 40 THEN '较差(40-59)' "
+    "ELSE '危险(0-39)' END";
+
+const char *const LENGTH_EXPRESSION =
+    "CASE "
+    "WHEN COALESCE(length_m, 0) < 100 THEN '0-100m' "
+    "WHEN length_m < 500 THEN '100-500m' "
+    "WHEN length_m < 1000 THEN '500-1000m' "
+    "WHEN length_m < 2000 THEN '1000-2000m' "
+    "ELSE '2000m以上' END";
+
+const char *const DIAMETER_EXPRESSION =
+    "CASE "
+    "WHEN COALESCE(diameter_mm, 0) < 50 THEN 'DN50以下' "
+    "WHEN diameter_mm < 100 THEN 'DN50-DN100' "
+    "WHEN diameter_mm < 200 THEN 'DN100-DN200' "
+    "WHEN diameter_mm < 500 THEN 'DN200-DN500' "
+    "ELSE 'DN500以上' END";
+}
+
+bool AssetStatisticsDAO::isMaterialized()
+{
+    int state = g_materialized.loadAcquire();
+    if (state >= 0) {
+        return state == 1;
+    }
+
+    bool exists = false;
+    QVariantMap params;
+    params[":table"] = "asset_statistics";
+    bool ok = DatabaseManager::instance().executePrepared(
+        SqlDialect::current().tableExistsQuery(), params,
+        [&exists](QSqlQuery &query) {
+            if (query.next()) {
+                exists = query.value(0).toBool();
+            }
+        });
+
+    // 查询失败（如尚未连接）时不缓存，下次重新检查
+    if (ok) {
+        g_materialized.storeRelease(exists ? 1 : 0);
+        if (!exists) {
+            LOG_WARNING("asset_statistics summary table not installed, statistics fall back to live aggregation");
+        }
+    }
+    return exists;
+}
+
+QString AssetStatisticsDAO::bucketExpression(const QString &assetKind, const QString &dimension)
+{
+    static const QMap<QString, QString> common = {
+        {"status", "COALESCE(NULLIF(status, ''), '未知')"},
+        {"material", "COALESCE(NULLIF(material, ''), '未知')"},
+        {"health_level", HEALTH_LEVEL_EXPRESSION}
+    };
+
+    if (dimension == "type") {
+        return assetKind == PIPELINE ? "pipeline_type" : "facility_type";
+    }
+    if (dimension == "build_year") {
+        return buildYearExpression(SqlDialect::current());
+    }
+    if (assetKind == PIPELINE) {
+        if (dimension == "length") {
+            return LENGTH_EXPRESSION;
+        }
+        if (dimension == "diameter") {
+            return DIAMETER_EXPRESSION;
+        }
+    }
+    return common.value(dimension);
+}
+
+QVector<AssetStatisticsDAO::Bucket> AssetStatisticsDAO::findByDimension(const QString &assetKind,
+                                                                         const QString &dimension)
+{
+    const QString expression = bucketExpression(assetKind, dimension);
+    if ((assetKind != PIPELINE && assetKind != FACILITY) || expression.isEmpty()) {
+        LOG_WARNING(QString("Unsupported statistics dimension: %1/%2").arg(assetKind, dimension));
+        return QVector<Bucket>();
+    }
+
+    if (isMaterialized()) {
+        QVariantMap params;
+        params[":kind"] = assetKind;
+        params[":dimension"] = dimension;
+        return queryBuckets("SELECT bucket, item_count, length_sum, health_sum FROM asset_statistics "
+                            "WHERE asset_kind = :kind AND dimension = :dimension", params);
+    }
+
+    const bool pipeline = assetKind == PIPELINE;
+    QString sql = QString("SELECT %1 AS bucket, COUNT(*), %2, SUM(COALESCE(health_score, 0)) "
+                          "FROM %3 GROUP BY 1")
+                      .arg(expression,
+                           pipeline ? "SUM(COALESCE(length_m, 0))" : "0",
+                           pipeline ? "pipelines" : "facilities");
+    return queryBuckets(sql, QVariantMap());
+}
+
+QVector<AssetStatisticsDAO::Bucket> AssetStatisticsDAO::queryBuckets(const QString &sql,
+                                                                      const QVariantMap &params)
+{
+    QVector<Bucket> buckets;
+    bool ok = DatabaseManager::instance().executePrepared(sql, params, [&buckets](QSqlQuery &query) {
+        while (query.next()) {
+            Bucket bucket;
+            bucket.name = query.value(0).toString();
+            bucket.count = query.value(1).toLongLong();
+            bucket.lengthSum = query.value(2).toDouble();
+            bucket.healthSum = query.value(3).toLongLong();
+            buckets.append(bucket);
+        }
+    });
+
+    if (!ok) {
+        LOG_ERROR(QString("Asset statistics query failed: %1").arg(DatabaseManager::instance().lastError()));
+        return QVector<Bucket>();
+    }
+    return buckets;
+}
+
+bool AssetStatisticsDAO::refresh()
+{
+    if (!isMaterialized()) {
+        return false;
+    }
+
+    bool ok = DatabaseManager::instance().executePrepared("SELECT refresh_asset_statistics()",
+                                                          QVariantMap(), nullptr);
+    if (!ok) {
+        LOG_ERROR(QString("Asset statistics refresh failed: %1").arg(DatabaseManager::instance().lastError()));
+    } else {
+        LOG_INFO("Asset statistics summary rebuilt");
+    }
+    return ok;
+}
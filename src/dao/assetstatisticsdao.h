@@ -0,0 +1,46 @@
+#ifndef ASSETSTATISTICSDAO_H
+#define ASSETSTATISTICSDAO_H
+
+#include <QString>
+#include <QVector>
+#include <QVariantMap>
+
+/**
+ * @brief 资产统计数据访问对象
+ * 按维度（type、status、material、build_year、health_level、length、diameter）读取
+ * 管线/设施的分类计数。优先读取 asset_statistics 汇总表（database/asset_statistics.sql，
+ * 由触发器增量维护），每次查询只返回几十行，与资产数量无关；
+ * 汇总表未安装时退化为对基础表的 GROUP BY 实时聚合，计数同样精确
+ */
+class AssetStatisticsDAO
+{
+public:
+    // 资产类别
+    static const QString PIPELINE;
+    static const QString FACILITY;
+
+    // 单个分类的聚合结果
+    struct Bucket {
+        QString name;
+        qint64 count = 0;
+        double lengthSum = 0.0;     // 长度合计（米，仅管线）
+        qint64 healthSum = 0;       // 健康度合计，用于计算平均值
+    };
+
+    // 读取某类资产在某一维度下的全部分类，出错时返回空
+    QVector<Bucket> findByDimension(const QString &assetKind, const QString &dimension);
+
+    // 全量重建汇总表（refresh_asset_statistics()），汇总表未安装时返回 false
+    bool refresh();
+
+    // 汇总表是否已安装（首次调用时检查并缓存）
+    static bool isMaterialized();
+
+private:
+    QVector<Bucket> queryBuckets(const QString &sql, const QVariantMap &params);
+
+    // 实时聚合使用的分类表达式，与 asset_statistics.sql 中的分类函数一致
+    static QString bucketExpression(const QString &assetKind, const QString &dimension);
+};
+
+#endif // ASSETSTATISTICSDAO_H
@@ -0,0 +1,22 @@
+#include "dao/asyncdao.h"
+
+AsyncDAO::AsyncDAO(QObject *parent)
+    : QObject(parent)
+    , m_canceled(QSharedPointer<QAtomicInt>::create(0))
+    , m_generation(0)
+    , m_pending(0)
+{
+}
+
+AsyncDAO::~AsyncDAO()
+{
+    // 排队中的查询跳过执行；监视器随本对象析构，不会再回调
+    m_canceled->storeRelease(1);
+}
+
+void AsyncDAO::cancelAll()
+{
+    m_canceled->storeRelease(1);
+    m_canceled = QSharedPointer<QAtomicInt>::create(0);
+    m_generation++;
+}
@@ -0,0 +1,82 @@
+#ifndef ASYNCDAO_H
+#define ASYNCDAO_H
+
+#include <QObject>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QSharedPointer>
+#include <QAtomicInt>
+#include <QtConcurrent/QtConcurrent>
+#include <type_traits>
+#include <utility>
+#include "core/database/databasemanager.h"
+
+/**
+ * @brief 异步数据访问
+ * 将 DAO 调用提交到 DatabaseManager::queryPool()（工作线程各自持有池化连接）执行，
+ * 返回 QFuture；完成回调经 QFutureWatcher 回到本对象所在线程（界面线程）执行，
+ * 事件循环不再等待数据库往返
+ *
+ * 对话框/视图各持有一个实例（以自身为父对象）：
+ * - cancelAll()：重新加载或视图范围变化时调用，尚未开始的查询直接跳过，
+ *   已在执行的查询结果被丢弃，不再回调
+ * - 析构（对话框关闭）等同于 cancelAll()
+ *
+ * 查询函数在工作线程中执行，只能按值捕获参数并在函数内创建 DAO，不得访问界面对象
+ */
+class AsyncDAO : public QObject
+{
+public:
+    explicit AsyncDAO(QObject *parent = nullptr);
+    ~AsyncDAO() override;
+
+    // 在工作线程执行 query，结果交给界面线程的 callback（已取消时不回调）
+    template <typename Query, typename Callback>
+    QFuture<std::invoke_result_t<Query>> run(Query query, Callback callback);
+
+    // 取消已提交的全部查询
+    void cancelAll();
+
+    // 尚未回到界面线程的查询数
+    int pendingCount() const { return m_pending; }
+    bool isBusy() const { return m_pending > 0; }
+
+private:
+    QSharedPointer<QAtomicInt> m_canceled;  // 当前批次的取消标志（工作线程读取）
+    quint64 m_generation;                   // 每次取消递增，回调据此丢弃旧批次结果
+    int m_pending;
+};
+
+template <typename Query, typename Callback>
+QFuture<std::invoke_result_t<Query>> AsyncDAO::run(Query query, Callback callback)
+{
+    using Result = std::invoke_result_t<Query>;
+    static_assert(!std::is_void_v<Result>, "AsyncDAO queries must return a value");
+
+    QSharedPointer<QAtomicInt> canceled = m_canceled;
+    QFuture<Result> future = QtConcurrent::run(DatabaseManager::instance().queryPool(),
+                                               [query = std::move(query), canceled]() -> Result {
+        // 排队期间已取消：不再占用连接
+        if (canceled->loadAcquire()) {
+            return Result();
+        }
+        return query();
+    });
+
+    const quint64 generation = m_generation;
+    m_pending++;
+    auto *watcher = new QFutureWatcher<Result>(this);
+    connect(watcher, &QFutureWatcher<Result>::finished, this,
+            [this, watcher, generation, callback = std::move(callback)]() {
+        watcher->deleteLater();
+        m_pending--;
+        if (generation != m_generation) {
+            return;
+        }
+        callback(watcher->result());
+    });
+    watcher->setFuture(future);
+    return future;
+}
+
+#endif // ASYNCDAO_H
@@ -5,11 +5,14 @@
 #include <QVariantMap>
 #include <QSqlQuery>
 #include <QVector>
+#include <functional>
 #include "core/database/databasemanager.h"
+#include "dao/entitycache.h"
+#include "dao/sqldialect.h"
 
 /**
  * @brief DAO基类
- * 提供通用的数据库操作方法
+ * 提供通用的数据库操作方法；与数据库相关的 SQL 片段由 dialect() 提供
  */
 template <typename T>
 class BaseDAO
@@ -22,14 +25,28 @@ public:
 
     virtual ~BaseDAO() {}
 
+    QString tableName() const { return m_tableName; }
+
+    // 当前数据库的 SQL 方言（PostGIS / 离线 SQLite）
+    const SqlDialect& dialect() const { return SqlDialect::current(); }
+
+    // 流式读取每批行数
+    static const int STREAM_CHUNK_SIZE = 2000;
+
+    // 流式读取的逐行回调，返回 false 时停止读取
+    using RowCallback = std::function<bool(const T &entity)>;
+
     // 纯虚函数，由子类实现
     virtual T fromQuery(QSqlQuery &query) = 0;
     virtual QVariantMap toVariantMap(const T &entity) = 0;
 
+    // 查询列（含几何字段的子类追加 WKB 列）
+    virtual QString selectColumns() const { return "*"; }
+
     // 根据ID查找
     T findById(int id)
     {
-        QString sql = QString("SELECT * FROM %1 WHERE id = :id").arg(m_tableName);
+        QString sql = QString("SELECT %1 FROM %2 WHERE id = :id").arg(selectColumns(), m_tableName);
         QVariantMap params;
         params[":id"] = id;
 
@@ -43,8 +60,9 @@ public:
     // 查找所有记录
     QVector<T> findAll(int limit = 1000, int offset = 0)
     {
-        QString sql = QString("SELECT * FROM %1 LIMIT %2 OFFSET %3")
-                          .arg(m_tableName)
+        // 分页展示用；全量遍历请使用 forEach（OFFSET 越大扫描越多）
+        QString sql = QString("SELECT %1 FROM %2 ORDER BY id LIMIT %3 OFFSET %4")
+                          .arg(selectColumns(), m_tableName)
                           .arg(limit)
                           .arg(offset);
 
@@ -56,6 +74,52 @@ public:
         return results;
     }
 
+    // 流式遍历：按 id 键集分页（id > 上一批末尾 ORDER BY id LIMIT chunkSize），
+    // 内存中只保留一批实体，回调在该批读取完成、语句归还后依次调用（回调内可再访问数据库）。
+    // 与 LIMIT/OFFSET 不同，每批都走主键索引，遍历期间更新已读行也不会跳行或重复。
+    // whereClause 为附加条件，其中的命名参数由 params 绑定；返回处理的行数，查询失败时返回 -1
+    int forEach(const RowCallback &callback,
+                const QString &whereClause = QString(),
+                const QVariantMap &params = QVariantMap(),
+                int chunkSize = STREAM_CHUNK_SIZE)
+    {
+        QString sql = QString("SELECT %1 FROM %2 WHERE id > :stream_last_id%3 ORDER BY id LIMIT :stream_chunk")
+                          .arg(selectColumns(), m_tableName,
+                               whereClause.isEmpty() ? QString() : QString(" AND (%1)").arg(whereClause));
+
+        chunkSize = qMax(1, chunkSize);
+        QVariantMap chunkParams = params;
+        chunkParams[":stream_chunk"] = chunkSize;
+
+        QVector<T> chunk;
+        chunk.reserve(chunkSize);
+        int lastId = 0;
+        int processed = 0;
+        forever {
+            chunk.clear();
+            chunkParams[":stream_last_id"] = lastId;
+            bool ok = DatabaseManager::instance().executePrepared(sql, chunkParams, [this, &chunk, &lastId](QSqlQuery &query) {
+                while (query.next()) {
+                    lastId = query.value("id").toInt();
+                    chunk.append(fromQuery(query));
+                }
+            });
+            if (!ok) {
+                return -1;
+            }
+
+            for (const T &entity : chunk) {
+                processed++;
+                if (!callback(entity)) {
+                    return processed;
+                }
+            }
+            if (chunk.size() < chunkSize) {
+                return processed;
+            }
+        }
+    }
+
     // 统计记录数
     int count(const QString &whereClause = QString())
     {
@@ -106,7 +170,9 @@ public:
                           .arg(setParts.join(", "));
 
         data[":id"] = id;
-        return DatabaseManager::instance().executeCommand(sql, data);
+        bool ok = DatabaseManager::instance().executeCommand(sql, data);
+        EntityCacheBase::invalidateRows(m_tableName, "id", QVariantList{id});
+        return ok;
     }
 
     // 删除记录
@@ -116,7 +182,9 @@ public:
         QVariantMap params;
         params[":id"] = id;
 
-        return DatabaseManager::instance().executeCommand(sql, params);
+        bool ok = DatabaseManager::instance().executeCommand(sql, params);
+        EntityCacheBase::invalidateRows(m_tableName, "id", QVariantList{id});
+        return ok;
     }
 
 protected:
@@ -0,0 +1,219 @@
+#include "dao/bulkwriter.h"
+#include "core/database/databasemanager.h"
+#include "dao/entitycache.h"
+#include "dao/sqldialect.h"
+#include "core/common/config.h"
+#include "core/common/logger.h"
+#include <QStringList>
+#include <QElapsedTimer>
+
+namespace {
+// 单条语句的绑定参数上限（PostgreSQL 协议上限为 65535，留出余量）
+const int MAX_PARAMETERS = 30000;
+
+QString placeholder(int row, int column)
+{
+    return QString(":b%1_%2").arg(row).arg(column);
+}
+
+// 带类型转换的参数表达式
+QString valueExpression(const SqlDialect &dialect, const BulkWriter::Column &column, int row, int index)
+{
+    return dialect.castParameter(placeholder(row, index), column.sqlType);
+}
+}
+
+BulkWriter::BulkWriter(const QString &tableName, Mode mode, const Column &key,
+                       const QVector<Column> &columns, bool ownTransaction)
+    : m_tableName(tableName)
+    , m_mode(mode)
+    , m_key(key)
+    , m_columns(mode == Delete ? QVector<Column>() : columns)
+    , m_ownTransaction(ownTransaction)
+    , m_inTransaction(false)
+    , m_failed(false)
+    , m_rowsWritten(0)
+{
+    const int perRow = m_columns.size() + 1;
+    m_batchSize = qBound(1, Config::instance().getBatchSize(), MAX_PARAMETERS / perRow);
+    m_pending.reserve(m_batchSize);
+}
+
+BulkWriter::~BulkWriter()
+{
+    if (m_inTransaction) {
+        LOG_WARNING(QString("Bulk writer for %1 destroyed without finish, rolling back").arg(m_tableName));
+        cancel();
+    }
+}
+
+bool BulkWriter::add(const QVariant &key, const QVariantList &values)
+{
+    if (m_failed) {
+        return false;
+    }
+    if (values.size() != m_columns.size()) {
+        m_lastError = QString("Expected %1 values, got %2").arg(m_columns.size()).arg(values.size());
+        LOG_ERROR(QString("Bulk write to %1 rejected: %2").arg(m_tableName, m_lastError));
+        return false;
+    }
+
+    QVariantList row;
+    row.reserve(values.size() + 1);
+    row.append(key);
+    row.append(values);
+    m_pending.append(row);
+
+    if (m_pending.size() >= m_batchSize) {
+        return flush();
+    }
+    return true;
+}
+
+bool BulkWriter::finish()
+{
+    if (m_failed) {
+        cancel();
+        return false;
+    }
+    if (!flush()) {
+        cancel();
+        return false;
+    }
+    if (m_inTransaction) {
+        m_inTransaction = false;
+        if (!DatabaseManager::instance().commit()) {
+            m_failed = true;
+            m_lastError = DatabaseManager::instance().lastError();
+            DatabaseManager::instance().rollback();
+            return false;
+        }
+        // 提交前其他连接可能又把旧数据读入缓存，提交后再失效一次
+        EntityCacheBase::invalidateRows(m_tableName, m_key.name, m_writtenKeys);
+    }
+    m_writtenKeys.clear();
+    LOG_INFO(QString("Bulk write to %1 finished: %2 rows").arg(m_tableName).arg(m_rowsWritten));
+    return true;
+}
+
+void BulkWriter::cancel()
+{
+    m_pending.clear();
+    m_writtenKeys.clear();
+    if (m_inTransaction) {
+        m_inTransaction = false;
+        DatabaseManager::instance().rollback();
+    }
+}
+
+bool BulkWriter::flush()
+{
+    if (m_pending.isEmpty()) {
+        return true;
+    }
+
+    if (m_ownTransaction && !m_inTransaction) {
+        if (!DatabaseManager::instance().beginTransaction()) {
+            m_failed = true;
+            m_lastError = DatabaseManager::instance().lastError();
+            return false;
+        }
+        m_inTransaction = true;
+    }
+
+    const int rows = m_pending.size();
+    QVariantMap params;
+    for (int r = 0; r < rows; ++r) {
+        const QVariantList &row = m_pending.at(r);
+        for (int c = 0; c < row.size(); ++c) {
+            params.insert(placeholder(r, c), row.at(c));
+        }
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    const bool ok = DatabaseManager::instance().executePrepared(buildSql(rows), params, nullptr);
+    if (!ok) {
+        m_failed = true;
+        m_lastError = DatabaseManager::instance().lastError();
+        LOG_ERROR(QString("Bulk write to %1 failed after %2 rows: %3")
+                      .arg(m_tableName).arg(m_rowsWritten).arg(m_lastError));
+        return false;
+    }
+
+    m_rowsWritten += rows;
+    QVariantList keys;
+    keys.reserve(rows);
+    for (const QVariantList &row : m_pending) {
+        keys.append(row.first());
+    }
+
+    // 离线库的 R*Tree 索引随几何写入同步（同一事务内）
+    if (writesGeometry() && !SqlDialect::current().refreshSpatialIndex(m_tableName, m_key.name, keys)) {
+        m_failed = true;
+        m_lastError = DatabaseManager::instance().lastError();
+        return false;
+    }
+    EntityCacheBase::invalidateRows(m_tableName, m_key.name, keys);
+    m_writtenKeys.append(keys);
+    m_pending.clear();
+    LOG_DEBUG(QString("Bulk wrote %1 rows to %2 in %3 ms").arg(rows).arg(m_tableName).arg(timer.elapsed()));
+    return true;
+}
+
+bool BulkWriter::writesGeometry() const
+{
+    for (const Column &column : m_columns) {
+        if (column.sqlType == "geometry") {
+            return true;
+        }
+    }
+    return false;
+}
+
+QString BulkWriter::buildSql(int rows) const
+{
+    const SqlDialect &dialect = SqlDialect::current();
+
+    // 每行的值列表：(key, c1, c2, ...)
+    QStringList tuples;
+    tuples.reserve(rows);
+    for (int r = 0; r < rows; ++r) {
+        QStringList values;
+        values.append(valueExpression(dialect, m_key, r, 0));
+        for (int c = 0; c < m_columns.size(); ++c) {
+            values.append(valueExpression(dialect, m_columns.at(c), r, c + 1));
+        }
+        tuples.append("(" + values.join(", ") + ")");
+    }
+    const QString valuesList = tuples.join(", ");
+
+    QStringList columnNames;
+    for (const Column &column : m_columns) {
+        columnNames.append(column.name);
+    }
+
+    switch (m_mode) {
+    case Update: {
+        QStringList assignments;
+        for (const QString &name : columnNames) {
+            assignments.append(QString("%1 = v.%1").arg(name));
+        }
+        return QString("UPDATE %1 AS t SET %2 FROM %3 WHERE t.%4 = v.%4")
+            .arg(m_tableName, assignments.join(", "),
+                 dialect.valuesTable(valuesList, QStringList{m_key.name} + columnNames, "v"), m_key.name);
+    }
+    case Upsert: {
+        QStringList assignments;
+        for (const QString &name : columnNames) {
+            assignments.append(QString("%1 = EXCLUDED.%1").arg(name));
+        }
+        return QString("INSERT INTO %1 (%2) VALUES %3 ON CONFLICT (%4) DO %5")
+            .arg(m_tableName, (QStringList{m_key.name} + columnNames).join(", "), valuesList, m_key.name,
+                 assignments.isEmpty() ? QString("NOTHING") : "UPDATE SET " + assignments.join(", "));
+    }
+    case Delete:
+        return QString("DELETE FROM %1 WHERE %2 IN (VALUES %3)").arg(m_tableName, m_key.name, valuesList);
+    }
+    return QString();
+}
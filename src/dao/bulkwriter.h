@@ -0,0 +1,85 @@
+#ifndef BULKWRITER_H
+#define BULKWRITER_H
+
+#include <QString>
+#include <QVector>
+#include <QVariant>
+#include <QVariantList>
+
+/**
+ * @brief 批量写入器
+ * 将逐行写入缓冲为多行 VALUES 语句，每批一条SQL，整体在一个事务内提交：
+ *   Update  UPDATE t SET c = v.c ... FROM (VALUES ...) AS v(key, c...) WHERE t.key = v.key
+ *   Upsert  INSERT INTO t (key, c...) VALUES ... ON CONFLICT (key) DO UPDATE SET c = EXCLUDED.c
+ *   Delete  DELETE FROM t WHERE key IN (VALUES ...)
+ * 只写入声明的列（部分列更新），参数按列类型转换（SqlDialect::castParameter）；
+ * 类型为 geometry 的列绑定 WKB 字节（WkbCodec 编码，SRID 4326），PostGIS 下经
+ * ST_GeomFromWKB 转换，离线 SQLite 库原样存储并在每批写出后同步 R*Tree 索引
+ *
+ * 写出的行按键失效对应表的实体缓存（EntityCache）
+ *
+ * 批大小取 performance/batch_size，并受单条语句参数上限约束；满批语句文本相同，
+ * 经 executePrepared 复用预编译计划。写入器在当前线程的连接上工作
+ */
+class BulkWriter
+{
+public:
+    enum Mode {
+        Update,
+        Upsert,
+        Delete
+    };
+
+    // 列定义：sqlType 为参数转换的目标类型（integer、text、date、timestamp、geometry 等）
+    struct Column {
+        QString name;
+        QString sqlType;
+    };
+
+    /**
+     * @param ownTransaction 为 true 时首批写出前开启事务、finish() 提交；
+     *        为 false 时由调用方管理事务（多个写入器共用一个事务）
+     */
+    BulkWriter(const QString &tableName, Mode mode, const Column &key,
+               const QVector<Column> &columns = QVector<Column>(),
+               bool ownTransaction = true);
+    ~BulkWriter();
+
+    // 追加一行（values 与列定义一一对应），缓冲满一批时立即写出
+    bool add(const QVariant &key, const QVariantList &values = QVariantList());
+
+    // 写出剩余行并提交事务；出错时回滚并返回 false
+    bool finish();
+
+    // 放弃未写出的行并回滚（析构时未 finish 也会回滚）
+    void cancel();
+
+    int batchSize() const { return m_batchSize; }
+    int rowsWritten() const { return m_rowsWritten; }
+    int pendingRows() const { return m_pending.size(); }
+    bool hasError() const { return m_failed; }
+    QString lastError() const { return m_lastError; }
+
+    BulkWriter(const BulkWriter&) = delete;
+    BulkWriter& operator=(const BulkWriter&) = delete;
+
+private:
+    bool flush();
+    bool writesGeometry() const;
+    QString buildSql(int rows) const;
+
+    QString m_tableName;
+    Mode m_mode;
+    Column m_key;
+    QVector<Column> m_columns;
+    bool m_ownTransaction;
+    bool m_inTransaction;
+    bool m_failed;
+    int m_batchSize;
+    int m_rowsWritten;
+    QVector<QVariantList> m_pending;    // 每行：key + values
+    QVariantList m_writtenKeys;         // 已写出行的键（提交后失效实体缓存）
+    QString m_lastError;
+};
+
+#endif // BULKWRITER_H
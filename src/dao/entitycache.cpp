@@ -0,0 +1,121 @@
+#include "dao/entitycache.h"
+#include "core/common/config.h"
+#include "core/common/logger.h"
+#include <QList>
+
+namespace {
+// 已注册缓存（按表名），由 registryMutex 保护
+QMutex &registryMutex()
+{
+    static QMutex mutex;
+    return mutex;
+}
+
+QMultiHash<QString, EntityCacheBase*> &registry()
+{
+    static QMultiHash<QString, EntityCacheBase*> caches;
+    return caches;
+}
+
+QList<EntityCacheBase*> cachesForTable(const QString &tableName)
+{
+    QMutexLocker locker(&registryMutex());
+    return registry().values(tableName);
+}
+}
+
+EntityCacheBase::EntityCacheBase(const QString &tableName, const QString &keyColumn)
+    : m_generation(0)
+    , m_maxCostKb(qMax(0, Config::instance().getEntityCacheSizeMb()) * 1024)
+    , m_hits(0)
+    , m_misses(0)
+    , m_tableName(tableName)
+    , m_keyColumn(keyColumn)
+{
+    QMutexLocker locker(&registryMutex());
+    registry().insert(tableName, this);
+    LOG_INFO(QString("Entity cache for %1 enabled: %2 MB").arg(tableName).arg(m_maxCostKb / 1024));
+}
+
+EntityCacheBase::~EntityCacheBase()
+{
+    QMutexLocker locker(&registryMutex());
+    registry().remove(m_tableName, this);
+}
+
+quint64 EntityCacheBase::generation() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_generation;
+}
+
+void EntityCacheBase::invalidate(const QString &key)
+{
+    QMutexLocker locker(&m_mutex);
+    m_generation++;
+    removeKeyLocked(key);
+}
+
+void EntityCacheBase::invalidateById(int id)
+{
+    QMutexLocker locker(&m_mutex);
+    m_generation++;
+    removeIdLocked(id);
+}
+
+void EntityCacheBase::invalidateAll()
+{
+    QMutexLocker locker(&m_mutex);
+    m_generation++;
+    clearLocked();
+}
+
+EntityCacheBase::Stats EntityCacheBase::stats() const
+{
+    QMutexLocker locker(&m_mutex);
+    Stats stats;
+    stats.hits = m_hits;
+    stats.misses = m_misses;
+    stats.entries = entryCountLocked();
+    stats.costKb = totalCostLocked();
+    stats.maxCostKb = m_maxCostKb;
+    return stats;
+}
+
+void EntityCacheBase::invalidateRows(const QString &tableName, const QString &column, const QVariantList &keys)
+{
+    for (EntityCacheBase *cache : cachesForTable(tableName)) {
+        QMutexLocker locker(&cache->m_mutex);
+        cache->m_generation++;
+        if (column == "id") {
+            for (const QVariant &key : keys) {
+                cache->removeIdLocked(key.toInt());
+            }
+        } else if (column == cache->m_keyColumn) {
+            for (const QVariant &key : keys) {
+                cache->removeKeyLocked(key.toString());
+            }
+        } else {
+            cache->clearLocked();
+        }
+    }
+}
+
+void EntityCacheBase::invalidateTable(const QString &tableName)
+{
+    for (EntityCacheBase *cache : cachesForTable(tableName)) {
+        cache->invalidateAll();
+    }
+}
+
+void EntityCacheBase::invalidateEntity(const QString &tableName, int id, const QString &key)
+{
+    for (EntityCacheBase *cache : cachesForTable(tableName)) {
+        QMutexLocker locker(&cache->m_mutex);
+        cache->m_generation++;
+        cache->removeIdLocked(id);
+        if (!key.isEmpty()) {
+            cache->removeKeyLocked(key);
+        }
+    }
+}
@@ -0,0 +1,179 @@
+#ifndef ENTITYCACHE_H
+#define ENTITYCACHE_H
+
+#include <QString>
+#include <QHash>
+#include <QCache>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QVariantList>
+
+/**
+ * @brief 实体缓存基类
+ * 进程级、按业务编号索引的实体缓存（identity map），各表一个实例并按表名注册，
+ * 使绕过 DAO 的写入（BulkWriter、直接SQL）也能按表名失效对应条目
+ *
+ * 版本化失效：每次失效都会递增代数（generation）。读取方在查询数据库前记下代数，
+ * 写入缓存时若代数已变化则放弃，避免把并发更新之前读到的旧数据放回缓存
+ */
+class EntityCacheBase
+{
+public:
+    // 命中统计
+    struct Stats {
+        qint64 hits = 0;
+        qint64 misses = 0;
+        int entries = 0;
+        int costKb = 0;
+        int maxCostKb = 0;
+    };
+
+    EntityCacheBase(const QString &tableName, const QString &keyColumn);
+    virtual ~EntityCacheBase();
+
+    QString tableName() const { return m_tableName; }
+    QString keyColumn() const { return m_keyColumn; }
+    bool isEnabled() const { return m_maxCostKb > 0; }
+
+    // 当前代数（读数据库前调用，写回缓存时传入）
+    quint64 generation() const;
+
+    void invalidate(const QString &key);
+    void invalidateById(int id);
+    void invalidateAll();
+
+    Stats stats() const;
+
+    // 按表名失效已注册缓存：column 为 "id" 时按主键，为业务编号列时按编号，其他列时整表失效
+    static void invalidateRows(const QString &tableName, const QString &column, const QVariantList &keys);
+    static void invalidateTable(const QString &tableName);
+    // 按主键和业务编号同时失效单个实体（外部变更通知使用，编号可能已被改写）
+    static void invalidateEntity(const QString &tableName, int id, const QString &key);
+
+protected:
+    // 以下在持有 m_mutex 时调用
+    virtual void removeKeyLocked(const QString &key) = 0;
+    virtual void removeIdLocked(int id) = 0;
+    virtual void clearLocked() = 0;
+    virtual int entryCountLocked() const = 0;
+    virtual int totalCostLocked() const = 0;
+
+    mutable QMutex m_mutex;
+    quint64 m_generation;
+    int m_maxCostKb;
+    mutable qint64 m_hits;
+    mutable qint64 m_misses;
+
+private:
+    QString m_tableName;
+    QString m_keyColumn;
+};
+
+/**
+ * @brief 实体缓存
+ * 条目按估算内存（KB）计入 QCache 成本，超过 performance/cache_size 时按最近最少使用淘汰；
+ * 所有访问经互斥锁保护，分析工作线程可直接读取。命中时返回实体副本（隐式共享，开销很小）
+ */
+template <typename T>
+class EntityCache : public EntityCacheBase
+{
+public:
+    EntityCache(const QString &tableName, const QString &keyColumn)
+        : EntityCacheBase(tableName, keyColumn)
+    {
+        m_entries.setMaxCost(m_maxCostKb);
+    }
+
+    bool find(const QString &key, T *entity) const
+    {
+        if (!isEnabled()) {
+            return false;
+        }
+        QMutexLocker locker(&m_mutex);
+        const T *cached = m_entries.object(key);
+        if (!cached) {
+            m_misses++;
+            return false;
+        }
+        m_hits++;
+        *entity = *cached;
+        return true;
+    }
+
+    bool findById(int id, T *entity) const
+    {
+        if (!isEnabled()) {
+            return false;
+        }
+        QMutexLocker locker(&m_mutex);
+        const T *cached = m_entries.object(m_keysById.value(id));
+        if (!cached) {
+            m_misses++;
+            return false;
+        }
+        m_hits++;
+        *entity = *cached;
+        return true;
+    }
+
+    // 写入缓存；readGeneration 为读取数据库前的代数，期间发生过失效时不写入
+    void insert(const QString &key, int id, const T &entity, int costBytes, quint64 readGeneration)
+    {
+        if (!isEnabled() || key.isEmpty()) {
+            return;
+        }
+        QMutexLocker locker(&m_mutex);
+        if (readGeneration != m_generation) {
+            return;
+        }
+        if (!m_entries.insert(key, new T(entity), qMax(1, costBytes / 1024))) {
+            return;
+        }
+        m_keysById.insert(id, key);
+        pruneIdsLocked();
+    }
+
+protected:
+    void removeKeyLocked(const QString &key) override
+    {
+        m_entries.remove(key);
+    }
+
+    void removeIdLocked(int id) override
+    {
+        const QString key = m_keysById.take(id);
+        if (!key.isEmpty()) {
+            m_entries.remove(key);
+        }
+    }
+
+    void clearLocked() override
+    {
+        m_entries.clear();
+        m_keysById.clear();
+    }
+
+    int entryCountLocked() const override { return m_entries.count(); }
+    int totalCostLocked() const override { return static_cast<int>(m_entries.totalCost()); }
+
+private:
+    // QCache 淘汰条目时不会通知，主键索引过大时清理已淘汰的编号
+    void pruneIdsLocked()
+    {
+        if (m_keysById.size() <= 2 * m_entries.count() + 1024) {
+            return;
+        }
+        for (auto it = m_keysById.begin(); it != m_keysById.end();) {
+            if (m_entries.contains(it.value())) {
+                ++it;
+            } else {
+                it = m_keysById.erase(it);
+            }
+        }
+    }
+
+    QCache<QString, T> m_entries;
+    QHash<int, QString> m_keysById;
+};
+
+#endif // ENTITYCACHE_H
@@ -1,10 +1,82 @@
 #include "dao/facilitydao.h"
 #include "core/common/logger.h"
 #include "core/database/databasemanager.h"
+#include "core/io/wkbcodec.h"
+#include "dao/sqldialect.h"
 #include <QSqlQuery>
 #include <QVariant>
+#include <QStringList>
 #include <QDebug>
 
+namespace {
+// 渲染投影列（按位置读取，顺序与 RenderColumn 一致）
+QString renderColumns(const SqlDialect &dialect)
+{
+    return "id, facility_id, facility_name, facility_type, spec, pipeline_id, health_score, "
+        + dialect.renderGeometryColumn("geom_render");
+}
+
+enum RenderColumn {
+    ColId = 0,
+    ColFacilityId,
+    ColFacilityName,
+    ColFacilityType,
+    ColSpec,
+    ColPipelineId,
+    ColHealthScore,
+    ColGeometry
+};
+
+QVector<FacilityRenderRecord> queryRenderRecords(const QString &sql, const QVariantMap &params)
+{
+    const bool twkb = SqlDialect::current().renderGeometryIsTwkb();
+    QVector<FacilityRenderRecord> results;
+    bool ok = DatabaseManager::instance().executePrepared(sql, params, [&results, twkb](QSqlQuery &query) {
+        while (query.next()) {
+            FacilityRenderRecord record;
+            record.id = query.value(ColId).toInt();
+            record.facilityId = query.value(ColFacilityId).toString();
+            record.facilityName = query.value(ColFacilityName).toString();
+            record.facilityType = query.value(ColFacilityType).toString();
+            record.spec = query.value(ColSpec).toString();
+            record.pipelineId = query.value(ColPipelineId).toString();
+            record.healthScore = query.value(ColHealthScore).toInt();
+            if (twkb) {
+                WkbCodec::decodeTwkbPoint(query.value(ColGeometry).toByteArray(), &record.coordinate);
+            } else {
+                WkbCodec::decodePoint(query.value(ColGeometry).toByteArray(), &record.coordinate);
+            }
+            results.append(record);
+        }
+    });
+
+    if (!ok) {
+        LOG_ERROR(QString("Facility render query failed: %1").arg(DatabaseManager::instance().lastError()));
+    }
+    return results;
+}
+
+// 缓存成本估算：对象本身，字符串字段按 1KB 计
+int cacheCost(const Facility &)
+{
+    return static_cast<int>(sizeof(Facility)) + 1024;
+}
+
+void cacheResults(const QVector<Facility> &facilities, quint64 generation)
+{
+    for (const Facility &facility : facilities) {
+        FacilityDAO::cache().insert(facility.facilityId(), facility.id(), facility,
+                                    cacheCost(facility), generation);
+    }
+}
+}
+
+EntityCache<Facility>& FacilityDAO::cache()
+{
+    static EntityCache<Facility> instance("facilities", "facility_id");
+    return instance;
+}
+
 FacilityDAO::FacilityDAO()
     : BaseDAO<Facility>("facilities")
 {
@@ -19,10 +91,10 @@ Facility FacilityDAO::fromQuery(QSqlQuery &query)
     facility.setFacilityName(query.value("facility_name").toString());
     facility.setFacilityType(query.value("facility_type").toString());
 
-    // 几何信息
-    QString geomWkt = query.value("geom_text").toString();
-    facility.setGeomWkt(geomWkt);
-    facility.setCoordinate(parsePointWkt(geomWkt));
+    // 几何信息 - selectColumns() 中的 WKB 列直接解码
+    QPointF coordinate;
+    WkbCodec::decodePoint(query.value("geom_wkb").toByteArray(), &coordinate);
+    facility.setCoordinate(coordinate);
     facility.setElevationM(query.value("elevation_m").toDouble());
 
     // 物理属性
@@ -69,7 +141,7 @@ QVariantMap FacilityDAO::toVariantMap(const Facility &facility)
 
     // 几何信息
     if (!facility.coordinate().isNull()) {
-        map["geom_wkt"] = toPointWkt(facility.coordinate());
+        map["geom_wkb"] = WkbCodec::encodePoint(facility.coordinate(), 4326);
     }
     map["elevation_m"] = facility.elevationM();
 
@@ -105,17 +177,23 @@ QVariantMap FacilityDAO::toVariantMap(const Facility &facility)
     return map;
 }
 
+QString FacilityDAO::selectColumns() const
+{
+    return "*, " + dialect().geometryColumn("geom_wkb");
+}
+
 QVector<Facility> FacilityDAO::findAll(int limit)
 {
-    QString sql = QString("SELECT *, ST_AsText(geom) as geom_text "
-                          "FROM %1 LIMIT :limit")
-                      .arg(m_tableName);
+    QString sql = QString("SELECT %1 "
+                          "FROM %2 LIMIT :limit")
+                      .arg(selectColumns(), m_tableName);
 
     QVariantMap params;
     params[":limit"] = limit;
 
     qDebug() << "[FacilityDAO] findAll called, limit:" << limit;
 
+    const quint64 generation = cache().generation();
     QVector<Facility> results;
     QSqlQuery query = DatabaseManager::instance().executeQuery(sql, params);
     
@@ -128,6 +206,8 @@ QVector<Facility> FacilityDAO::findAll(int limit)
         results.append(fromQuery(query));
     }
 
+    cacheResults(results, generation);
+
     qDebug() << "[FacilityDAO] Found" << results.size() << "facilities";
     LOG_INFO(QString("Found %1 facilities").arg(results.size()));
     return results;
@@ -135,19 +215,21 @@ QVector<Facility> FacilityDAO::findAll(int limit)
 
 QVector<Facility> FacilityDAO::findByType(const QString &type, int limit)
 {
-    QString sql = QString("SELECT *, ST_AsText(geom) as geom_text "
-                          "FROM %1 WHERE facility_type = :type LIMIT :limit")
-                      .arg(m_tableName);
+    QString sql = QString("SELECT %1 "
+                          "FROM %2 WHERE facility_type = :type LIMIT :limit")
+                      .arg(selectColumns(), m_tableName);
 
     QVariantMap params;
     params[":type"] = type;
     params[":limit"] = limit;
 
+    const quint64 generation = cache().generation();
     QVector<Facility> results;
     QSqlQuery query = DatabaseManager::instance().executeQuery(sql, params);
     while (query.next()) {
         results.append(fromQuery(query));
     }
+    cacheResults(results, generation);
 
     LOG_INFO(QString("Found %1 facilities of type: %2").arg(results.size()).arg(type));
     return results;
@@ -156,69 +238,166 @@ QVector<Facility> FacilityDAO::findByType(const QString &type, int limit)
 QVector<Facility> FacilityDAO::findByBounds(const QRectF &bounds, int limit)
 {
     QString sql = QString(
-        "SELECT *, ST_AsText(geom) as geom_text "
-        "FROM %1 "
-        "WHERE ST_Within(geom, ST_MakeEnvelope(:minX, :minY, :maxX, :maxY, 4326)) "
+        "SELECT %1 "
+        "FROM %2 "
+        "WHERE %3 "
         "LIMIT :limit"
-    ).arg(m_tableName);
+    ).arg(selectColumns(), m_tableName, dialect().withinBoundsFilter(m_tableName));
 
     QVariantMap params;
-    params[":minX"] = bounds.left();
-    params[":minY"] = bounds.bottom();
-    params[":maxX"] = bounds.right();
-    params[":maxY"] = bounds.top();
+    SqlDialect::bindBounds(params, bounds);
     params[":limit"] = limit;
 
+    const quint64 generation = cache().generation();
     QVector<Facility> results;
-    QSqlQuery query = DatabaseManager::instance().executeQuery(sql, params);
-    while (query.next()) {
-        results.append(fromQuery(query));
-    }
+    DatabaseManager::instance().executePrepared(sql, params, [this, &results](QSqlQuery &query) {
+        while (query.next()) {
+            results.append(fromQuery(query));
+        }
+    });
+    cacheResults(results, generation);
 
     LOG_INFO(QString("Found %1 facilities in bounds").arg(results.size()));
     return results;
 }
 
+QVector<FacilityRenderRecord> FacilityDAO::findRenderRecords(int limit)
+{
+    QString sql = QString("SELECT %1 FROM %2 LIMIT :limit").arg(renderColumns(dialect()), m_tableName);
+
+    QVariantMap params;
+    params[":limit"] = limit;
+
+    QVector<FacilityRenderRecord> results = queryRenderRecords(sql, params);
+    LOG_INFO(QString("Found %1 facility render records").arg(results.size()));
+    return results;
+}
+
+QVector<FacilityRenderRecord> FacilityDAO::findRenderRecordsByType(const QString &type, int limit)
+{
+    QString sql = QString("SELECT %1 FROM %2 WHERE facility_type = :type LIMIT :limit")
+                      .arg(renderColumns(dialect()), m_tableName);
+
+    QVariantMap params;
+    params[":type"] = type;
+    params[":limit"] = limit;
+
+    QVector<FacilityRenderRecord> results = queryRenderRecords(sql, params);
+    LOG_INFO(QString("Found %1 facility render records of type: %2").arg(results.size()).arg(type));
+    return results;
+}
+
+QVector<FacilityRenderRecord> FacilityDAO::findRenderRecordsByBounds(const QRectF &bounds, int limit)
+{
+    QString sql = QString(
+        "SELECT %1 FROM %2 "
+        "WHERE %3 "
+        "LIMIT :limit"
+    ).arg(renderColumns(dialect()), m_tableName, dialect().withinBoundsFilter(m_tableName));
+
+    QVariantMap params;
+    SqlDialect::bindBounds(params, bounds);
+    params[":limit"] = limit;
+
+    QVector<FacilityRenderRecord> results = queryRenderRecords(sql, params);
+    LOG_INFO(QString("Found %1 facility render records in bounds").arg(results.size()));
+    return results;
+}
+
+QVector<FacilityRenderRecord> FacilityDAO::findRenderRecordsByIds(const QVector<int> &ids)
+{
+    if (ids.isEmpty()) {
+        return QVector<FacilityRenderRecord>();
+    }
+
+    // 主键列表整体绑定为一个参数，SQL文本固定，可复用预编译语句
+    QString sql = QString("SELECT %1 FROM %2 WHERE %3")
+                      .arg(renderColumns(dialect()), m_tableName, dialect().idListFilter("id"));
+
+    QVariantMap params;
+    params[":ids"] = dialect().idListParameter(ids);
+
+    return queryRenderRecords(sql, params);
+}
+
+QVector<FacilityRenderRecord> FacilityDAO::loadRenderRecords(const QString &whereClause, const QVariantMap &params)
+{
+    const QString sql = QString("SELECT %1 FROM %2 WHERE id > :stream_last_id%3 ORDER BY id LIMIT :stream_chunk")
+                            .arg(renderColumns(dialect()), m_tableName,
+                                 whereClause.isEmpty() ? QString() : QString(" AND (%1)").arg(whereClause));
+
+    QVariantMap chunkParams = params;
+    chunkParams[":stream_chunk"] = STREAM_CHUNK_SIZE;
+
+    QVector<FacilityRenderRecord> results;
+    int lastId = 0;
+    forever {
+        chunkParams[":stream_last_id"] = lastId;
+        const QVector<FacilityRenderRecord> chunk = queryRenderRecords(sql, chunkParams);
+        results += chunk;
+        if (chunk.size() < STREAM_CHUNK_SIZE) {
+            break;
+        }
+        lastId = chunk.last().id;
+    }
+
+    LOG_INFO(QString("Loaded %1 facility render records").arg(results.size()));
+    return results;
+}
+
 Facility FacilityDAO::findByFacilityId(const QString &facilityId)
 {
-    QString sql = QString("SELECT *, ST_AsText(geom) as geom_text "
-                          "FROM %1 WHERE facility_id = :facility_id")
-                      .arg(m_tableName);
+    QString sql = QString("SELECT %1 "
+                          "FROM %2 WHERE facility_id = :facility_id")
+                      .arg(selectColumns(), m_tableName);
 
     QVariantMap params;
     params[":facility_id"] = facilityId;
 
-    QSqlQuery query = DatabaseManager::instance().executeQuery(sql, params);
-    if (query.next()) {
-        return fromQuery(query);
+    Facility facility;
+    if (cache().find(facilityId, &facility)) {
+        return facility;
     }
-    return Facility();
+
+    const quint64 generation = cache().generation();
+    DatabaseManager::instance().executePrepared(sql, params, [this, &facility](QSqlQuery &query) {
+        if (query.next()) {
+            facility = fromQuery(query);
+        }
+    });
+    if (facility.id() > 0) {
+        cache().insert(facilityId, facility.id(), facility, cacheCost(facility), generation);
+    }
+    return facility;
 }
 
 QVector<Facility> FacilityDAO::findByPipelineId(const QString &pipelineId, int limit)
 {
-    QString sql = QString("SELECT *, ST_AsText(geom) as geom_text "
-                          "FROM %1 WHERE pipeline_id = :pipeline_id LIMIT :limit")
-                      .arg(m_tableName);
+    QString sql = QString("SELECT %1 "
+                          "FROM %2 WHERE pipeline_id = :pipeline_id LIMIT :limit")
+                      .arg(selectColumns(), m_tableName);
 
     QVariantMap params;
     params[":pipeline_id"] = pipelineId;
     params[":limit"] = limit;
 
+    const quint64 generation = cache().generation();
     QVector<Facility> results;
-    QSqlQuery query = DatabaseManager::instance().executeQuery(sql, params);
-    while (query.next()) {
-        results.append(fromQuery(query));
-    }
+    DatabaseManager::instance().executePrepared(sql, params, [this, &results](QSqlQuery &query) {
+        while (query.next()) {
+            results.append(fromQuery(query));
+        }
+    });
+    cacheResults(results, generation);
 
     return results;
 }
 
 QVector<Facility> FacilityDAO::findByStatus(const QString &status, int limit)
 {
-    QString sql = QString("SELECT *, ST_AsText(geom) as geom_text "
-                          "FROM %1 WHERE status = :status LIMIT :limit")
-                      .arg(m_tableName);
+    QString sql = QString("SELECT %1 "
+                          "FROM %2 WHERE status = :status LIMIT :limit")
+                      .arg(selectColumns(), m_tableName);
 
     QVariantMap params;
     params[":status"] = status;
@@ -235,10 +414,10 @@ QVector<Facility> FacilityDAO::findByStatus(const QString &status, int limit)
 
 QVector<Facility> FacilityDAO::findByHealthScore(int maxScore, int limit)
 {
-    QString sql = QString("SELECT *, ST_AsText(geom) as geom_text "
-                          "FROM %1 WHERE health_score <= :maxScore "
+    QString sql = QString("SELECT %1 "
+                          "FROM %2 WHERE health_score <= :maxScore "
                           "ORDER BY health_score ASC LIMIT :limit")
-                      .arg(m_tableName);
+                      .arg(selectColumns(), m_tableName);
 
     QVariantMap params;
     params[":maxScore"] = maxScore;
@@ -255,25 +434,23 @@ QVector<Facility> FacilityDAO::findByHealthScore(int maxScore, int limit)
 
 QVector<Facility> FacilityDAO::findNearPoint(double lon, double lat, double radiusMeters, int limit)
 {
-    QString sql = QString(
-        "SELECT *, ST_AsText(geom) as geom_text, "
-        "ST_Distance(geom::geography, ST_SetSRID(ST_MakePoint(:lon, :lat), 4326)::geography) as distance "
-        "FROM %1 "
-        "WHERE ST_DWithin(geom::geography, ST_SetSRID(ST_MakePoint(:lon, :lat), 4326)::geography, :radius) "
-        "ORDER BY distance "
-        "LIMIT :limit"
-    ).arg(m_tableName);
+    // 离线库只返回外接矩形内的候选，按点距离精确过滤并排序
+    QString sql = QString("SELECT %1 FROM %2 %3")
+                      .arg(selectColumns(), m_tableName, dialect().nearPointClause(m_tableName));
 
     QVariantMap params;
-    params[":lon"] = lon;
-    params[":lat"] = lat;
-    params[":radius"] = radiusMeters;
-    params[":limit"] = limit;
+    dialect().bindNearPoint(params, lon, lat, radiusMeters, limit);
 
     QVector<Facility> results;
-    QSqlQuery query = DatabaseManager::instance().executeQuery(sql, params);
-    while (query.next()) {
-        results.append(fromQuery(query));
+    DatabaseManager::instance().executePrepared(sql, params, [this, &results](QSqlQuery &query) {
+        while (query.next()) {
+            results.append(fromQuery(query));
+        }
+    });
+    if (!dialect().filtersDistanceExactly()) {
+        SqlDialect::keepNearest(results, radiusMeters, limit, [lon, lat](const Facility &facility) {
+            return SqlDialect::distanceMeters(lon, lat, facility.coordinate());
+        });
     }
 
     LOG_INFO(QString("Found %1 facilities near point (%2, %3) within %4m")
@@ -297,28 +474,6 @@ QMap<QString, int> FacilityDAO::countByType()
     return counts;
 }
 
-QPointF FacilityDAO::parsePointWkt(const QString &wkt)
-{
-    // WKT格式: POINT(lon lat)
-    QString coordsStr = wkt;
-    coordsStr.remove("POINT(");
-    coordsStr.remove(")");
-
-    QStringList coords = coordsStr.split(' ', Qt::SkipEmptyParts);
-    if (coords.size() == 2) {
-        double lon = coords[0].toDouble();
-        double lat = coords[1].toDouble();
-        return QPointF(lon, lat);
-    }
-
-    return QPointF();
-}
-
-QString FacilityDAO::toPointWkt(const QPointF &coordinate)
-{
-    return QString("POINT(%1 %2)").arg(coordinate.x()).arg(coordinate.y());
-}
-
 // 转义SQL字符串值，防止SQL注入
 static QString escapeSqlString(const QString &str)
 {
@@ -358,13 +513,11 @@ bool FacilityDAO::insert(const Facility &facility)
         values.append(QString("'%1'").arg(escapeSqlString(data.value("facility_type").toString())));
     }
     
-    // 处理几何字段 - 使用ST_GeomFromText
-    QString geomWkt = data.value("geom_wkt").toString();
-    if (!geomWkt.isEmpty()) {
+    // 处理几何字段 - 十六进制 EWKB 几何字面量
+    QByteArray geomWkb = data.value("geom_wkb").toByteArray();
+    if (!geomWkb.isEmpty()) {
         columns.append("geom");
-        QString escaped = geomWkt;
-        escaped.replace("'", "''");
-        values.append(QString("ST_GeomFromText('%1', 4326)").arg(escaped));
+        values.append(dialect().geometryLiteral(geomWkb));
     }
     
     if (data.contains("elevation_m")) {
@@ -486,7 +639,9 @@ bool FacilityDAO::insert(const Facility &facility)
         LOG_ERROR(QString("Facility insert failed: %1").arg(error));
     } else {
         qDebug() << "[FacilityDAO] Insert successful";
+        dialect().refreshSpatialIndex(m_tableName, "facility_id", QVariantList{facility.facilityId()});
     }
+    cache().invalidate(facility.facilityId());
     return result;
 }
 
@@ -562,11 +717,9 @@ bool FacilityDAO::update(const Facility &facility, int id)
     }
     
     // 处理几何字段
-    QString geomWkt = data.value("geom_wkt").toString();
-    if (!geomWkt.isEmpty()) {
-        QString escaped = geomWkt;
-        escaped.replace("'", "''");
-        setParts.append(QString("geom = ST_GeomFromText('%1', 4326)").arg(escaped));
+    QByteArray geomWkb = data.value("geom_wkb").toByteArray();
+    if (!geomWkb.isEmpty()) {
+        setParts.append(QString("geom = %1").arg(dialect().geometryLiteral(geomWkb)));
     }
     
     setParts.append("updated_at = CURRENT_TIMESTAMP");
@@ -588,7 +741,12 @@ bool FacilityDAO::update(const Facility &facility, int id)
     if (!result) {
         QString error = DatabaseManager::instance().lastError();
         qDebug() << "[FacilityDAO] Update failed:" << error;
+    } else if (!geomWkb.isEmpty()) {
+        dialect().refreshSpatialIndex(m_tableName, "id", QVariantList{id});
     }
+    // 编号可能被修改：按主键失效旧编号，再失效新编号
+    cache().invalidateById(id);
+    cache().invalidate(facility.facilityId());
     return result;
 }
 
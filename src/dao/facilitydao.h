@@ -2,7 +2,9 @@
 #define FACILITYDAO_H
 
 #include "dao/basedao.h"
+#include "dao/entitycache.h"
 #include "core/models/facility.h"
+#include "core/models/renderrecord.h"
 #include <QRectF>
 
 /**
@@ -17,6 +19,7 @@ public:
     // 实现基类纯虚函数
     Facility fromQuery(QSqlQuery &query) override;
     QVariantMap toVariantMap(const Facility &facility) override;
+    QString selectColumns() const override;
 
     // 查找所有设施
     QVector<Facility> findAll(int limit = 1000);
@@ -27,12 +30,25 @@ public:
     // 根据边界框查找设施（空间查询）
     QVector<Facility> findByBounds(const QRectF &bounds, int limit = 1000);
 
-    // 根据设施ID查找
+    // 渲染投影查询：只取渲染所需列，几何以 TWKB 传输（地图加载使用，完整对象由 find* 按需加载）
+    QVector<FacilityRenderRecord> findRenderRecords(int limit = 1000);
+    QVector<FacilityRenderRecord> findRenderRecordsByType(const QString &type, int limit = 1000);
+    QVector<FacilityRenderRecord> findRenderRecordsByBounds(const QRectF &bounds, int limit = 1000);
+    // 按主键批量读取（远程变更增量刷新使用）
+    QVector<FacilityRenderRecord> findRenderRecordsByIds(const QVector<int> &ids);
+    // 全量读取渲染投影：按 id 键集分页（不截断），whereClause 为附加条件，其中的命名参数由 params 绑定
+    QVector<FacilityRenderRecord> loadRenderRecords(const QString &whereClause = QString(),
+                                                    const QVariantMap &params = QVariantMap());
+
+    // 根据设施ID查找（优先命中实体缓存）
     Facility findByFacilityId(const QString &facilityId);
 
     // 根据关联管线ID查找设施
     QVector<Facility> findByPipelineId(const QString &pipelineId, int limit = 1000);
 
+    // 进程级设施缓存（按 facility_id），find* 读取的完整实体写入缓存，写入操作使其失效
+    static EntityCache<Facility>& cache();
+
     // 根据状态查找设施
     QVector<Facility> findByStatus(const QString &status, int limit = 1000);
 
@@ -50,13 +66,6 @@ public:
     
     // 重写update方法以处理PostGIS字段
     bool update(const Facility &facility, int id);
-
-private:
-    // 解析WKT格式的POINT为坐标点
-    QPointF parsePointWkt(const QString &wkt);
-
-    // 将坐标点转换为WKT格式
-    QString toPointWkt(const QPointF &coordinate);
 };
 
 #endif // FACILITYDAO_H
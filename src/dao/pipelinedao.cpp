@@ -1,11 +1,84 @@
 #include "dao/pipelinedao.h"
 #include "core/common/logger.h"
 #include "core/database/databasemanager.h"
+#include "core/io/wkbcodec.h"
+#include "dao/sqldialect.h"
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QVariant>
+#include <QStringList>
 #include <QDebug>
 
+namespace {
+// 渲染投影列（按位置读取，顺序与 RenderColumn 一致）
+// PostGIS 下几何为 TWKB（体积约为 WKB 的 1/3），离线库为 WKB
+QString renderColumns(const SqlDialect &dialect)
+{
+    return QString("id, pipeline_id, pipeline_name, pipeline_type, diameter_mm, health_score, "
+                   "%1 AS build_year, depth_m, length_m, material, pressure_class, status, %2")
+        .arg(dialect.yearOf("build_date"), dialect.renderGeometryColumn("geom_render"));
+}
+
+enum RenderColumn {
+    ColId = 0,
+    ColPipelineId,
+    ColPipelineName,
+    ColPipelineType,
+    ColDiameter,
+    ColHealthScore,
+    ColBuildYear,
+    ColDepth,
+    ColLength,
+    ColMaterial,
+    ColPressureClass,
+    ColStatus,
+    ColGeometry
+};
+
+PipelineRenderRecord renderRecordFromQuery(const QSqlQuery &query, bool twkb)
+{
+    PipelineRenderRecord record;
+    record.id = query.value(ColId).toInt();
+    record.pipelineId = query.value(ColPipelineId).toString();
+    record.pipelineName = query.value(ColPipelineName).toString();
+    record.pipelineType = query.value(ColPipelineType).toString();
+    record.diameterMm = query.value(ColDiameter).toInt();
+    record.healthScore = query.value(ColHealthScore).toInt();
+    record.buildYear = query.value(ColBuildYear).toInt();
+    record.depthM = query.value(ColDepth).toDouble();
+    record.lengthM = query.value(ColLength).toDouble();
+    record.material = query.value(ColMaterial).toString();
+    record.pressureClass = query.value(ColPressureClass).toString();
+    record.status = query.value(ColStatus).toString();
+    if (twkb) {
+        WkbCodec::decodeTwkbLineString(query.value(ColGeometry).toByteArray(), record.coordinates);
+    } else {
+        WkbCodec::decodeLineString(query.value(ColGeometry).toByteArray(), record.coordinates);
+    }
+    return record;
+}
+
+// 缓存成本估算：对象本身 + 坐标数组，字符串字段按 1KB 计
+int cacheCost(const Pipeline &pipeline)
+{
+    return static_cast<int>(sizeof(Pipeline) + pipeline.coordinates().size() * sizeof(QPointF)) + 1024;
+}
+
+void cacheResults(const QVector<Pipeline> &pipelines, quint64 generation)
+{
+    for (const Pipeline &pipeline : pipelines) {
+        PipelineDAO::cache().insert(pipeline.pipelineId(), pipeline.id(), pipeline,
+                                    cacheCost(pipeline), generation);
+    }
+}
+}
+
+EntityCache<Pipeline>& PipelineDAO::cache()
+{
+    static EntityCache<Pipeline> instance("pipelines", "pipeline_id");
+    return instance;
+}
+
 PipelineDAO::PipelineDAO()
     : BaseDAO<Pipeline>("pipelines")
 {
@@ -20,10 +93,10 @@ Pipeline PipelineDAO::fromQuery(QSqlQuery &query)
     pipeline.setPipelineName(query.value("pipeline_name").toString());
     pipeline.setPipelineType(query.value("pipeline_type").toString());
 
-    // 几何信息 - 使用ST_AsText获取WKT格式
-    QString geomWkt = query.value("geom_text").toString();
-    pipeline.setGeomWkt(geomWkt);
-    pipeline.setCoordinates(parseLineStringWkt(geomWkt));
+    // 几何信息 - selectColumns() 中的 WKB 列直接解码为坐标
+    QVector<QPointF> coordinates;
+    WkbCodec::decodeLineString(query.value("geom_wkb").toByteArray(), coordinates);
+    pipeline.setCoordinates(coordinates);
     pipeline.setLengthM(query.value("length_m").toDouble());
     pipeline.setDepthM(query.value("depth_m").toDouble());
 
@@ -63,12 +136,9 @@ QVariantMap PipelineDAO::toVariantMap(const Pipeline &pipeline)
     map["pipeline_name"] = pipeline.pipelineName();
     map["pipeline_type"] = pipeline.pipelineType();
 
-    // 几何信息 - 使用ST_GeomFromText创建几何对象
+    // 几何信息 - 编码为 EWKB（SRID 4326），插入/更新时以十六进制几何字面量写入
     if (!pipeline.coordinates().isEmpty()) {
-        QString wkt = toLineStringWkt(pipeline.coordinates());
-        // 注意：这里需要使用PostgreSQL的函数，不能直接作为参数
-        // 实际插入时需要特殊处理
-        map["geom_wkt"] = wkt;
+        map["geom_wkb"] = WkbCodec::encodeLineString(pipeline.coordinates(), 4326);
     }
     map["length_m"] = pipeline.lengthM();
     map["depth_m"] = pipeline.depthM();
@@ -99,17 +169,23 @@ QVariantMap PipelineDAO::toVariantMap(const Pipeline &pipeline)
     return map;
 }
 
+QString PipelineDAO::selectColumns() const
+{
+    return "*, " + dialect().geometryColumn("geom_wkb");
+}
+
 QVector<Pipeline> PipelineDAO::findAll(int limit)
 {
-    QString sql = QString("SELECT *, ST_AsText(geom) as geom_text "
-                          "FROM %1 LIMIT :limit")
-                      .arg(m_tableName);
+    QString sql = QString("SELECT %1 "
+                          "FROM %2 LIMIT :limit")
+                      .arg(selectColumns(), m_tableName);
 
     QVariantMap params;
     params[":limit"] = limit;
 
     qDebug() << "[PipelineDAO] findAll called, limit:" << limit;
 
+    const quint64 generation = cache().generation();
     QVector<Pipeline> results;
     QSqlQuery query = DatabaseManager::instance().executeQuery(sql, params);
     
@@ -122,6 +198,8 @@ QVector<Pipeline> PipelineDAO::findAll(int limit)
         results.append(fromQuery(query));
     }
 
+    cacheResults(results, generation);
+
     qDebug() << "[PipelineDAO] Found" << results.size() << "pipelines";
     LOG_INFO(QString("Found %1 pipelines").arg(results.size()));
     return results;
@@ -129,9 +207,9 @@ QVector<Pipeline> PipelineDAO::findAll(int limit)
 
 QVector<Pipeline> PipelineDAO::findByType(const QString &type, int limit)
 {
-    QString sql = QString("SELECT *, ST_AsText(geom) as geom_text "
-                          "FROM %1 WHERE pipeline_type = :type LIMIT :limit")
-                      .arg(m_tableName);
+    QString sql = QString("SELECT %1 "
+                          "FROM %2 WHERE pipeline_type = :type LIMIT :limit")
+                      .arg(selectColumns(), m_tableName);
 
     QVariantMap params;
     params[":type"] = type;
@@ -140,18 +218,21 @@ QVector<Pipeline> PipelineDAO::findByType(const QString &type, int limit)
     qDebug() << "[PipelineDAO] findByType called:";
     qDebug() << "  Type:" << type << "Limit:" << limit;
 
+    const quint64 generation = cache().generation();
     QVector<Pipeline> results;
-    QSqlQuery query = DatabaseManager::instance().executeQuery(sql, params);
-    
-    if (query.lastError().isValid()) {
-        qDebug() << "[PipelineDAO] Query error:" << query.lastError().text();
-        LOG_ERROR(QString("Pipeline query failed: %1").arg(query.lastError().text()));
-    }
+    bool ok = DatabaseManager::instance().executePrepared(sql, params, [this, &results](QSqlQuery &query) {
+        while (query.next()) {
+            results.append(fromQuery(query));
+        }
+    });
     
-    while (query.next()) {
-        results.append(fromQuery(query));
+    if (!ok) {
+        qDebug() << "[PipelineDAO] Query error:" << DatabaseManager::instance().lastError();
+        LOG_ERROR(QString("Pipeline query failed: %1").arg(DatabaseManager::instance().lastError()));
     }
 
+    cacheResults(results, generation);
+
     qDebug() << "[PipelineDAO] Found" << results.size() << "pipelines of type" << type;
     LOG_INFO(QString("Found %1 pipelines of type: %2").arg(results.size()).arg(type));
     return results;
@@ -159,19 +240,16 @@ QVector<Pipeline> PipelineDAO::findByType(const QString &type, int limit)
 
 QVector<Pipeline> PipelineDAO::findByBounds(const QRectF &bounds, int limit)
 {
-    // 使用PostGIS的ST_MakeEnvelope和ST_Intersects进行空间查询
+    // 与边界框相交（PostGIS：ST_Intersects；离线库：R*Tree 外接矩形）
     QString sql = QString(
-        "SELECT *, ST_AsText(geom) as geom_text "
-        "FROM %1 "
-        "WHERE ST_Intersects(geom, ST_MakeEnvelope(:minX, :minY, :maxX, :maxY, 4326)) "
+        "SELECT %1 "
+        "FROM %2 "
+        "WHERE %3 "
         "LIMIT :limit"
-    ).arg(m_tableName);
+    ).arg(selectColumns(), m_tableName, dialect().intersectsBoundsFilter(m_tableName));
 
     QVariantMap params;
-    params[":minX"] = bounds.left();
-    params[":minY"] = bounds.bottom();
-    params[":maxX"] = bounds.right();
-    params[":maxY"] = bounds.top();
+    SqlDialect::bindBounds(params, bounds);
     params[":limit"] = limit;
 
     // 调试输出
@@ -181,44 +259,172 @@ QVector<Pipeline> PipelineDAO::findByBounds(const QRectF &bounds, int limit)
     qDebug() << "  maxX:" << bounds.right() << "maxY:" << bounds.top();
     qDebug() << "  SQL:" << sql;
 
+    const quint64 generation = cache().generation();
     QVector<Pipeline> results;
-    QSqlQuery query = DatabaseManager::instance().executeQuery(sql, params);
-    
-    if (query.lastError().isValid()) {
-        qDebug() << "[PipelineDAO] Query error:" << query.lastError().text();
-        LOG_ERROR(QString("Pipeline query failed: %1").arg(query.lastError().text()));
-    }
+    bool ok = DatabaseManager::instance().executePrepared(sql, params, [this, &results](QSqlQuery &query) {
+        while (query.next()) {
+            results.append(fromQuery(query));
+        }
+    });
     
-    while (query.next()) {
-        results.append(fromQuery(query));
+    if (!ok) {
+        qDebug() << "[PipelineDAO] Query error:" << DatabaseManager::instance().lastError();
+        LOG_ERROR(QString("Pipeline query failed: %1").arg(DatabaseManager::instance().lastError()));
     }
 
+    cacheResults(results, generation);
+
     qDebug() << "[PipelineDAO] Found" << results.size() << "pipelines in bounds";
     LOG_INFO(QString("Found %1 pipelines in bounds").arg(results.size()));
     return results;
 }
 
+QVector<PipelineRenderRecord> PipelineDAO::findRenderRecordsByType(const QString &type, int limit)
+{
+    QString sql = QString("SELECT %1 FROM %2 WHERE pipeline_type = :type LIMIT :limit")
+                      .arg(renderColumns(dialect()), m_tableName);
+
+    QVariantMap params;
+    params[":type"] = type;
+    params[":limit"] = limit;
+
+    const bool twkb = dialect().renderGeometryIsTwkb();
+    QVector<PipelineRenderRecord> results;
+    bool ok = DatabaseManager::instance().executePrepared(sql, params, [&results, twkb](QSqlQuery &query) {
+        while (query.next()) {
+            results.append(renderRecordFromQuery(query, twkb));
+        }
+    });
+
+    if (!ok) {
+        LOG_ERROR(QString("Pipeline render query failed: %1").arg(DatabaseManager::instance().lastError()));
+    }
+
+    LOG_INFO(QString("Found %1 pipeline render records of type: %2").arg(results.size()).arg(type));
+    return results;
+}
+
+QVector<PipelineRenderRecord> PipelineDAO::findRenderRecordsByBounds(const QRectF &bounds, int limit)
+{
+    QString sql = QString(
+        "SELECT %1 FROM %2 "
+        "WHERE %3 "
+        "LIMIT :limit"
+    ).arg(renderColumns(dialect()), m_tableName, dialect().intersectsBoundsFilter(m_tableName));
+
+    QVariantMap params;
+    SqlDialect::bindBounds(params, bounds);
+    params[":limit"] = limit;
+
+    const bool twkb = dialect().renderGeometryIsTwkb();
+    QVector<PipelineRenderRecord> results;
+    bool ok = DatabaseManager::instance().executePrepared(sql, params, [&results, twkb](QSqlQuery &query) {
+        while (query.next()) {
+            results.append(renderRecordFromQuery(query, twkb));
+        }
+    });
+
+    if (!ok) {
+        LOG_ERROR(QString("Pipeline render query failed: %1").arg(DatabaseManager::instance().lastError()));
+    }
+
+    LOG_INFO(QString("Found %1 pipeline render records in bounds").arg(results.size()));
+    return results;
+}
+
+QVector<PipelineRenderRecord> PipelineDAO::findRenderRecordsByIds(const QVector<int> &ids)
+{
+    QVector<PipelineRenderRecord> results;
+    if (ids.isEmpty()) {
+        return results;
+    }
+
+    // 主键列表整体绑定为一个参数，SQL文本固定，可复用预编译语句
+    QString sql = QString("SELECT %1 FROM %2 WHERE %3")
+                      .arg(renderColumns(dialect()), m_tableName, dialect().idListFilter("id"));
+
+    QVariantMap params;
+    params[":ids"] = dialect().idListParameter(ids);
+
+    const bool twkb = dialect().renderGeometryIsTwkb();
+    bool ok = DatabaseManager::instance().executePrepared(sql, params, [&results, twkb](QSqlQuery &query) {
+        while (query.next()) {
+            results.append(renderRecordFromQuery(query, twkb));
+        }
+    });
+
+    if (!ok) {
+        LOG_ERROR(QString("Pipeline render query failed: %1").arg(DatabaseManager::instance().lastError()));
+    }
+    return results;
+}
+
+QVector<PipelineRenderRecord> PipelineDAO::loadRenderRecords(const QString &whereClause, const QVariantMap &params)
+{
+    const QString sql = QString("SELECT %1 FROM %2 WHERE id > :stream_last_id%3 ORDER BY id LIMIT :stream_chunk")
+                            .arg(renderColumns(dialect()), m_tableName,
+                                 whereClause.isEmpty() ? QString() : QString(" AND (%1)").arg(whereClause));
+
+    QVariantMap chunkParams = params;
+    chunkParams[":stream_chunk"] = STREAM_CHUNK_SIZE;
+
+    const bool twkb = dialect().renderGeometryIsTwkb();
+    QVector<PipelineRenderRecord> results;
+    int lastId = 0;
+    forever {
+        chunkParams[":stream_last_id"] = lastId;
+        int chunkRows = 0;
+        bool ok = DatabaseManager::instance().executePrepared(sql, chunkParams, [&](QSqlQuery &query) {
+            while (query.next()) {
+                results.append(renderRecordFromQuery(query, twkb));
+                lastId = results.last().id;
+                chunkRows++;
+            }
+        });
+        if (!ok) {
+            LOG_ERROR(QString("Pipeline render query failed: %1").arg(DatabaseManager::instance().lastError()));
+            break;
+        }
+        if (chunkRows < STREAM_CHUNK_SIZE) {
+            break;
+        }
+    }
+
+    LOG_INFO(QString("Loaded %1 pipeline render records").arg(results.size()));
+    return results;
+}
+
 Pipeline PipelineDAO::findByPipelineId(const QString &pipelineId)
 {
-    QString sql = QString("SELECT *, ST_AsText(geom) as geom_text "
-                          "FROM %1 WHERE pipeline_id = :pipeline_id")
-                      .arg(m_tableName);
+    QString sql = QString("SELECT %1 "
+                          "FROM %2 WHERE pipeline_id = :pipeline_id")
+                      .arg(selectColumns(), m_tableName);
 
     QVariantMap params;
     params[":pipeline_id"] = pipelineId;
 
-    QSqlQuery query = DatabaseManager::instance().executeQuery(sql, params);
-    if (query.next()) {
-        return fromQuery(query);
+    Pipeline pipeline;
+    if (cache().find(pipelineId, &pipeline)) {
+        return pipeline;
+    }
+
+    const quint64 generation = cache().generation();
+    DatabaseManager::instance().executePrepared(sql, params, [this, &pipeline](QSqlQuery &query) {
+        if (query.next()) {
+            pipeline = fromQuery(query);
+        }
+    });
+    if (pipeline.id() > 0) {
+        cache().insert(pipelineId, pipeline.id(), pipeline, cacheCost(pipeline), generation);
     }
-    return Pipeline();
+    return pipeline;
 }
 
 QVector<Pipeline> PipelineDAO::findByStatus(const QString &status, int limit)
 {
-    QString sql = QString("SELECT *, ST_AsText(geom) as geom_text "
-                          "FROM %1 WHERE status = :status LIMIT :limit")
-                      .arg(m_tableName);
+    QString sql = QString("SELECT %1 "
+                          "FROM %2 WHERE status = :status LIMIT :limit")
+                      .arg(selectColumns(), m_tableName);
 
     QVariantMap params;
     params[":status"] = status;
@@ -235,10 +441,10 @@ QVector<Pipeline> PipelineDAO::findByStatus(const QString &status, int limit)
 
 QVector<Pipeline> PipelineDAO::findByHealthScore(int maxScore, int limit)
 {
-    QString sql = QString("SELECT *, ST_AsText(geom) as geom_text "
-                          "FROM %1 WHERE health_score <= :maxScore "
+    QString sql = QString("SELECT %1 "
+                          "FROM %2 WHERE health_score <= :maxScore "
                           "ORDER BY health_score ASC LIMIT :limit")
-                      .arg(m_tableName);
+                      .arg(selectColumns(), m_tableName);
 
     QVariantMap params;
     params[":maxScore"] = maxScore;
@@ -255,27 +461,24 @@ QVector<Pipeline> PipelineDAO::findByHealthScore(int maxScore, int limit)
 
 QVector<Pipeline> PipelineDAO::findNearPoint(double lon, double lat, double radiusMeters, int limit)
 {
-    // 使用PostGIS的ST_DWithin进行缓冲区查询
-    // ST_DWithin使用地理坐标系，单位为米
-    QString sql = QString(
-        "SELECT *, ST_AsText(geom) as geom_text, "
-        "ST_Distance(geom::geography, ST_SetSRID(ST_MakePoint(:lon, :lat), 4326)::geography) as distance "
-        "FROM %1 "
-        "WHERE ST_DWithin(geom::geography, ST_SetSRID(ST_MakePoint(:lon, :lat), 4326)::geography, :radius) "
-        "ORDER BY distance "
-        "LIMIT :limit"
-    ).arg(m_tableName);
+    // 缓冲区查询：PostGIS 按 geography 计算距离（单位米）并排序；
+    // 离线库由 R*Tree 取半径外接矩形内的候选，再按折线距离精确过滤
+    QString sql = QString("SELECT %1 FROM %2 %3")
+                      .arg(selectColumns(), m_tableName, dialect().nearPointClause(m_tableName));
 
     QVariantMap params;
-    params[":lon"] = lon;
-    params[":lat"] = lat;
-    params[":radius"] = radiusMeters;
-    params[":limit"] = limit;
+    dialect().bindNearPoint(params, lon, lat, radiusMeters, limit);
 
     QVector<Pipeline> results;
-    QSqlQuery query = DatabaseManager::instance().executeQuery(sql, params);
-    while (query.next()) {
-        results.append(fromQuery(query));
+    DatabaseManager::instance().executePrepared(sql, params, [this, &results](QSqlQuery &query) {
+        while (query.next()) {
+            results.append(fromQuery(query));
+        }
+    });
+    if (!dialect().filtersDistanceExactly()) {
+        SqlDialect::keepNearest(results, radiusMeters, limit, [lon, lat](const Pipeline &pipeline) {
+            return SqlDialect::distanceMeters(lon, lat, pipeline.coordinates());
+        });
     }
 
     LOG_INFO(QString("Found %1 pipelines near point (%2, %3) within %4m")
@@ -366,15 +569,13 @@ bool PipelineDAO::insert(const Pipeline &pipeline)
     values.append(formatSqlValue(data.value("pipeline_type")));
     
     // 几何字段（必需）
-    QString geomWkt = data.value("geom_wkt").toString();
-    if (geomWkt.isEmpty()) {
-        qDebug() << "[PipelineDAO] Insert failed: geom_wkt is empty";
+    QByteArray geomWkb = data.value("geom_wkb").toByteArray();
+    if (geomWkb.isEmpty()) {
+        qDebug() << "[PipelineDAO] Insert failed: geom_wkb is empty";
         return false;
     }
-    QString escaped = geomWkt;
-    escaped.replace("'", "''");
     columns.append("geom");
-    values.append(QString("ST_GeomFromText('%1', 4326)").arg(escaped));
+    values.append(dialect().geometryLiteral(geomWkb));
     
     // 可选字段
     if (data.value("length_m").toDouble() > 0) {
@@ -472,7 +673,10 @@ bool PipelineDAO::insert(const Pipeline &pipeline)
     if (!result) {
         QString error = DatabaseManager::instance().lastError();
         qDebug() << "[PipelineDAO] Insert failed:" << error;
+    } else {
+        dialect().refreshSpatialIndex(m_tableName, "pipeline_id", QVariantList{pipeline.pipelineId()});
     }
+    cache().invalidate(pipeline.pipelineId());
     return result;
 }
 
@@ -556,11 +760,9 @@ bool PipelineDAO::update(const Pipeline &pipeline, int id)
     }
     
     // 处理几何字段
-    QString geomWkt = data.value("geom_wkt").toString();
-    if (!geomWkt.isEmpty()) {
-        QString escaped = geomWkt;
-        escaped.replace("'", "''");
-        setParts.append(QString("geom = ST_GeomFromText('%1', 4326)").arg(escaped));
+    QByteArray geomWkb = data.value("geom_wkb").toByteArray();
+    if (!geomWkb.isEmpty()) {
+        setParts.append(QString("geom = %1").arg(dialect().geometryLiteral(geomWkb)));
     }
     
     setParts.append("updated_at = CURRENT_TIMESTAMP");
@@ -582,43 +784,11 @@ bool PipelineDAO::update(const Pipeline &pipeline, int id)
     if (!result) {
         QString error = DatabaseManager::instance().lastError();
         qDebug() << "[PipelineDAO] Update failed:" << error;
+    } else if (!geomWkb.isEmpty()) {
+        dialect().refreshSpatialIndex(m_tableName, "id", QVariantList{id});
     }
+    // 编号可能被修改：按主键失效旧编号，再失效新编号
+    cache().invalidateById(id);
+    cache().invalidate(pipeline.pipelineId());
     return result;
 }
-
-QVector<QPointF> PipelineDAO::parseLineStringWkt(const QString &wkt)
-{
-    QVector<QPointF> coordinates;
-
-    // WKT格式: LINESTRING(lon1 lat1, lon2 lat2, ...)
-    QString coordsStr = wkt;
-    coordsStr.remove("LINESTRING(");
-    coordsStr.remove(")");
-
-    QStringList pairs = coordsStr.split(',', Qt::SkipEmptyParts);
-    for (const QString &pair : pairs) {
-        QStringList coords = pair.trimmed().split(' ', Qt::SkipEmptyParts);
-        if (coords.size() == 2) {
-            double lon = coords[0].toDouble();
-            double lat = coords[1].toDouble();
-            coordinates.append(QPointF(lon, lat));
-        }
-    }
-
-    return coordinates;
-}
-
-QString PipelineDAO::toLineStringWkt(const QVector<QPointF> &coordinates)
-{
-    if (coordinates.isEmpty()) {
-        return QString();
-    }
-
-    QStringList parts;
-    for (const QPointF &point : coordinates) {
-        parts.append(QString("%1 %2").arg(point.x()).arg(point.y()));
-    }
-
-    return QString("LINESTRING(%1)").arg(parts.join(", "));
-}
-
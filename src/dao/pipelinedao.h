@@ -2,7 +2,9 @@
 #define PIPELINEDAO_H
 
 #include "dao/basedao.h"
+#include "dao/entitycache.h"
 #include "core/models/pipeline.h"
+#include "core/models/renderrecord.h"
 #include <QRectF>
 
 /**
@@ -17,6 +19,7 @@ public:
     // 实现基类纯虚函数
     Pipeline fromQuery(QSqlQuery &query) override;
     QVariantMap toVariantMap(const Pipeline &pipeline) override;
+    QString selectColumns() const override;
 
     // 查找所有管线（重写基类方法以处理PostGIS字段）
     QVector<Pipeline> findAll(int limit = 1000);
@@ -27,9 +30,21 @@ public:
     // 根据边界框查找管线（空间查询）
     QVector<Pipeline> findByBounds(const QRectF &bounds, int limit = 1000);
 
-    // 根据管线ID查找
+    // 渲染投影查询：只取渲染所需列，几何以 TWKB 传输（地图加载使用，完整对象由 find* 按需加载）
+    QVector<PipelineRenderRecord> findRenderRecordsByType(const QString &type, int limit = 1000);
+    QVector<PipelineRenderRecord> findRenderRecordsByBounds(const QRectF &bounds, int limit = 1000);
+    // 按主键批量读取（远程变更增量刷新使用）
+    QVector<PipelineRenderRecord> findRenderRecordsByIds(const QVector<int> &ids);
+    // 全量读取渲染投影：按 id 键集分页（不截断），whereClause 为附加条件，其中的命名参数由 params 绑定
+    QVector<PipelineRenderRecord> loadRenderRecords(const QString &whereClause = QString(),
+                                                    const QVariantMap &params = QVariantMap());
+
+    // 根据管线ID查找（优先命中实体缓存）
     Pipeline findByPipelineId(const QString &pipelineId);
 
+    // 进程级管线缓存（按 pipeline_id），find* 读取的完整实体写入缓存，写入操作使其失效
+    static EntityCache<Pipeline>& cache();
+
     // 根据状态查找管线
     QVector<Pipeline> findByStatus(const QString &status, int limit = 1000);
 
@@ -45,13 +60,6 @@ public:
     // 重写insert和update方法以处理PostGIS字段
     bool insert(const Pipeline &pipeline);
     bool update(const Pipeline &pipeline, int id);
-
-private:
-    // 解析WKT格式的LINESTRING为坐标点
-    QVector<QPointF> parseLineStringWkt(const QString &wkt);
-
-    // 将坐标点转换为WKT格式
-    QString toLineStringWkt(const QVector<QPointF> &coordinates);
 };
 
 #endif // PIPELINEDAO_H
@@ -0,0 +1,360 @@
+#include "dao/sqldialect.h"
+#include "core/database/databasemanager.h"
+#include "core/io/wkbcodec.h"
+#include "core/common/logger.h"
+#include <QSqlQuery>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QtMath>
+#include <limits>
+
+namespace {
+// 赤道处每度对应的米数（WGS84 长半轴 6378137 m）
+const double METERS_PER_DEGREE = 111319.49079327357;
+
+// 数值型参数在 SQLite 中需要显式转换，其余类型（日期、文本、WKB）按绑定值原样存储
+bool isIntegerType(const QString &sqlType)
+{
+    return sqlType == "integer" || sqlType == "int" || sqlType == "bigint" || sqlType == "smallint";
+}
+
+bool isRealType(const QString &sqlType)
+{
+    return sqlType == "real" || sqlType == "double precision" || sqlType == "numeric"
+        || sqlType.startsWith("numeric(") || sqlType == "float";
+}
+}
+
+const SqlDialect& SqlDialect::current()
+{
+    static const PostgisDialect postgis;
+    static const SqliteDialect sqlite;
+    if (DatabaseManager::instance().driverName() == "QSQLITE") {
+        return sqlite;
+    }
+    return postgis;
+}
+
+bool SqlDialect::refreshSpatialIndex(const QString &, const QString &, const QVariantList &) const
+{
+    return true;
+}
+
+void SqlDialect::bindBounds(QVariantMap &params, const QRectF &bounds)
+{
+    // 地图坐标系 y 轴向上：bottom 为最小纬度
+    params[":minX"] = bounds.left();
+    params[":minY"] = bounds.bottom();
+    params[":maxX"] = bounds.right();
+    params[":maxY"] = bounds.top();
+}
+
+double SqlDialect::distanceMeters(double lon, double lat, const QPointF &point)
+{
+    const double scale = qCos(qDegreesToRadians(lat));
+    const double dx = (point.x() - lon) * scale * METERS_PER_DEGREE;
+    const double dy = (point.y() - lat) * METERS_PER_DEGREE;
+    return qSqrt(dx * dx + dy * dy);
+}
+
+double SqlDialect::distanceMeters(double lon, double lat, const QVector<QPointF> &line)
+{
+    if (line.isEmpty()) {
+        return std::numeric_limits<double>::max();
+    }
+    if (line.size() == 1) {
+        return distanceMeters(lon, lat, line.first());
+    }
+
+    // 以查询点为原点投影到平面（米），求原点到各线段的最短距离
+    const double scale = qCos(qDegreesToRadians(lat)) * METERS_PER_DEGREE;
+    double best = std::numeric_limits<double>::max();
+    double ax = (line.first().x() - lon) * scale;
+    double ay = (line.first().y() - lat) * METERS_PER_DEGREE;
+    for (int i = 1; i < line.size(); ++i) {
+        const double bx = (line.at(i).x() - lon) * scale;
+        const double by = (line.at(i).y() - lat) * METERS_PER_DEGREE;
+        const double dx = bx - ax;
+        const double dy = by - ay;
+        const double lengthSq = dx * dx + dy * dy;
+        double t = lengthSq > 0.0 ? -(ax * dx + ay * dy) / lengthSq : 0.0;
+        t = qBound(0.0, t, 1.0);
+        const double px = ax + t * dx;
+        const double py = ay + t * dy;
+        best = qMin(best, px * px + py * py);
+        ax = bx;
+        ay = by;
+    }
+    return qSqrt(best);
+}
+
+QRectF SqlDialect::boundsAround(double lon, double lat, double radiusMeters)
+{
+    const double dLat = radiusMeters / METERS_PER_DEGREE;
+    const double dLon = dLat / qMax(qCos(qDegreesToRadians(lat)), 1e-6);
+    // 与 bindBounds 一致：top 为较大纬度
+    return QRectF(QPointF(lon - dLon, lat + dLat), QPointF(lon + dLon, lat - dLat));
+}
+
+// ---------------------------------------------------------------- PostGIS
+
+QString PostgisDialect::geometryColumn(const QString &alias) const
+{
+    return QString("ST_AsBinary(geom) AS %1").arg(alias);
+}
+
+QString PostgisDialect::renderGeometryColumn(const QString &alias) const
+{
+    // 坐标精度 7 位小数（约 1cm），TWKB 差分编码后几何体积约为 WKB 的 1/3
+    return QString("ST_AsTWKB(geom, 7) AS %1").arg(alias);
+}
+
+QString PostgisDialect::intersectsBoundsFilter(const QString &) const
+{
+    return "ST_Intersects(geom, ST_MakeEnvelope(:minX, :minY, :maxX, :maxY, 4326))";
+}
+
+QString PostgisDialect::withinBoundsFilter(const QString &) const
+{
+    return "ST_Within(geom, ST_MakeEnvelope(:minX, :minY, :maxX, :maxY, 4326))";
+}
+
+QString PostgisDialect::nearPointClause(const QString &) const
+{
+    // geography 类型按椭球计算，单位为米
+    return "WHERE ST_DWithin(geom::geography, ST_SetSRID(ST_MakePoint(:lon, :lat), 4326)::geography, :radius) "
+           "ORDER BY ST_Distance(geom::geography, ST_SetSRID(ST_MakePoint(:lon, :lat), 4326)::geography) "
+           "LIMIT :limit";
+}
+
+void PostgisDialect::bindNearPoint(QVariantMap &params, double lon, double lat,
+                                   double radiusMeters, int limit) const
+{
+    params[":lon"] = lon;
+    params[":lat"] = lat;
+    params[":radius"] = radiusMeters;
+    params[":limit"] = limit;
+}
+
+QString PostgisDialect::idListFilter(const QString &column) const
+{
+    return QString("%1 = ANY(CAST(:ids AS INTEGER[]))").arg(column);
+}
+
+QVariant PostgisDialect::idListParameter(const QVector<int> &ids) const
+{
+    QStringList idList;
+    idList.reserve(ids.size());
+    for (int id : ids) {
+        idList << QString::number(id);
+    }
+    return QString("{%1}").arg(idList.join(','));
+}
+
+QString PostgisDialect::geometryLiteral(const QByteArray &ewkb) const
+{
+    return WkbCodec::geometryLiteral(ewkb);
+}
+
+QString PostgisDialect::castParameter(const QString &placeholder, const QString &sqlType) const
+{
+    if (sqlType == "geometry") {
+        return QString("ST_GeomFromWKB(CAST(%1 AS bytea), 4326)").arg(placeholder);
+    }
+    return QString("CAST(%1 AS %2)").arg(placeholder, sqlType);
+}
+
+QString PostgisDialect::valuesTable(const QString &rows, const QStringList &columns,
+                                    const QString &alias) const
+{
+    return QString("(VALUES %1) AS %2(%3)").arg(rows, alias, columns.join(", "));
+}
+
+QString PostgisDialect::yearOf(const QString &column) const
+{
+    return QString("CAST(EXTRACT(YEAR FROM %1) AS INTEGER)").arg(column);
+}
+
+QString PostgisDialect::tableExistsQuery() const
+{
+    return "SELECT to_regclass(:table) IS NOT NULL";
+}
+
+// ---------------------------------------------------------------- SQLite
+
+bool SqliteDialect::hasSpatialIndex(const QString &table)
+{
+    return table == "pipelines" || table == "facilities";
+}
+
+bool SqliteDialect::wkbBounds(const QByteArray &wkb, QRectF *bounds)
+{
+    QPointF point;
+    if (WkbCodec::decodePoint(wkb, &point)) {
+        *bounds = QRectF(point, point);
+        return true;
+    }
+
+    QVector<QPointF> coordinates;
+    if (!WkbCodec::decodeLineString(wkb, coordinates) || coordinates.isEmpty()) {
+        return false;
+    }
+    double minX = coordinates.first().x();
+    double maxX = minX;
+    double minY = coordinates.first().y();
+    double maxY = minY;
+    for (const QPointF &p : coordinates) {
+        minX = qMin(minX, p.x());
+        maxX = qMax(maxX, p.x());
+        minY = qMin(minY, p.y());
+        maxY = qMax(maxY, p.y());
+    }
+    *bounds = QRectF(QPointF(minX, minY), QPointF(maxX, maxY));
+    return true;
+}
+
+QString SqliteDialect::geometryColumn(const QString &alias) const
+{
+    // 离线库的 geom 列即 EWKB
+    return QString("geom AS %1").arg(alias);
+}
+
+QString SqliteDialect::renderGeometryColumn(const QString &alias) const
+{
+    return QString("geom AS %1").arg(alias);
+}
+
+QString SqliteDialect::intersectsBoundsFilter(const QString &table) const
+{
+    return QString("id IN (SELECT id FROM %1 WHERE max_x >= :minX AND min_x <= :maxX "
+                   "AND max_y >= :minY AND min_y <= :maxY)").arg(spatialIndexName(table));
+}
+
+QString SqliteDialect::withinBoundsFilter(const QString &table) const
+{
+    return QString("id IN (SELECT id FROM %1 WHERE min_x >= :minX AND max_x <= :maxX "
+                   "AND min_y >= :minY AND max_y <= :maxY)").arg(spatialIndexName(table));
+}
+
+QString SqliteDialect::nearPointClause(const QString &table) const
+{
+    // 半径外接矩形内的候选，距离过滤与排序由调用方完成（不能在SQL中截断）
+    return "WHERE " + intersectsBoundsFilter(table);
+}
+
+void SqliteDialect::bindNearPoint(QVariantMap &params, double lon, double lat,
+                                  double radiusMeters, int) const
+{
+    bindBounds(params, boundsAround(lon, lat, radiusMeters));
+}
+
+QString SqliteDialect::idListFilter(const QString &column) const
+{
+    return QString("%1 IN (SELECT value FROM json_each(:ids))").arg(column);
+}
+
+QVariant SqliteDialect::idListParameter(const QVector<int> &ids) const
+{
+    QStringList idList;
+    idList.reserve(ids.size());
+    for (int id : ids) {
+        idList << QString::number(id);
+    }
+    return QString("[%1]").arg(idList.join(','));
+}
+
+QString SqliteDialect::geometryLiteral(const QByteArray &ewkb) const
+{
+    return QLatin1String("X'") + QString::fromLatin1(ewkb.toHex().toUpper()) + QLatin1Char('\'');
+}
+
+QString SqliteDialect::castParameter(const QString &placeholder, const QString &sqlType) const
+{
+    // SQLite 的 CAST(... AS date) 会按 NUMERIC 亲和性把 '2024-01-01' 变成 2024，
+    // 日期/时间以 ISO 文本绑定即可
+    if (isIntegerType(sqlType)) {
+        return QString("CAST(%1 AS INTEGER)").arg(placeholder);
+    }
+    if (isRealType(sqlType)) {
+        return QString("CAST(%1 AS REAL)").arg(placeholder);
+    }
+    return placeholder;
+}
+
+QString SqliteDialect::valuesTable(const QString &rows, const QStringList &columns,
+                                   const QString &alias) const
+{
+    // SQLite 的 VALUES 列名固定为 column1, column2...，外包一层子查询命名
+    QStringList named;
+    named.reserve(columns.size());
+    for (int i = 0; i < columns.size(); ++i) {
+        named.append(QString("column%1 AS %2").arg(i + 1).arg(columns.at(i)));
+    }
+    return QString("(SELECT %1 FROM (VALUES %2)) AS %3").arg(named.join(", "), rows, alias);
+}
+
+QString SqliteDialect::yearOf(const QString &column) const
+{
+    return QString("CAST(strftime('%Y', %1) AS INTEGER)").arg(column);
+}
+
+QString SqliteDialect::tableExistsQuery() const
+{
+    return "SELECT EXISTS (SELECT 1 FROM sqlite_master WHERE name = :table)";
+}
+
+bool SqliteDialect::refreshSpatialIndex(const QString &table, const QString &keyColumn,
+                                        const QVariantList &keys) const
+{
+    if (!hasSpatialIndex(table) || keys.isEmpty()) {
+        return true;
+    }
+
+    // 先读出几何计算外接矩形，再逐行写入索引（预编译语句复用）
+    struct Entry {
+        int id;
+        QRectF bounds;
+        bool valid;
+    };
+    QVector<Entry> entries;
+    entries.reserve(keys.size());
+
+    const QString selectSql = QString("SELECT id, geom FROM %1 WHERE %2 IN (SELECT value FROM json_each(:keys))")
+                                  .arg(table, keyColumn);
+    QVariantMap selectParams;
+    selectParams[":keys"] = QString::fromUtf8(
+        QJsonDocument(QJsonArray::fromVariantList(keys)).toJson(QJsonDocument::Compact));
+
+    DatabaseManager &db = DatabaseManager::instance();
+    bool ok = db.executePrepared(selectSql, selectParams, [&entries](QSqlQuery &query) {
+        while (query.next()) {
+            Entry entry;
+            entry.id = query.value(0).toInt();
+            entry.valid = wkbBounds(query.value(1).toByteArray(), &entry.bounds);
+            entries.append(entry);
+        }
+    });
+    if (!ok) {
+        return false;
+    }
+
+    const QString upsertSql = QString("INSERT OR REPLACE INTO %1 (id, min_x, max_x, min_y, max_y) "
+                                      "VALUES (:id, :minX, :maxX, :minY, :maxY)").arg(spatialIndexName(table));
+    const QString removeSql = QString("DELETE FROM %1 WHERE id = :id").arg(spatialIndexName(table));
+    for (const Entry &entry : entries) {
+        QVariantMap params;
+        params[":id"] = entry.id;
+        if (entry.valid) {
+            params[":minX"] = entry.bounds.left();
+            params[":maxX"] = entry.bounds.right();
+            params[":minY"] = entry.bounds.top();
+            params[":maxY"] = entry.bounds.bottom();
+        }
+        if (!db.executePrepared(entry.valid ? upsertSql : removeSql, params, nullptr)) {
+            LOG_ERROR(QString("Failed to update spatial index of %1 for id %2").arg(table).arg(entry.id));
+            return false;
+        }
+    }
+    LOG_DEBUG(QString("Spatial index of %1 refreshed for %2 rows").arg(table).arg(entries.size()));
+    return true;
+}
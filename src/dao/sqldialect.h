@@ -0,0 +1,184 @@
+#ifndef SQLDIALECT_H
+#define SQLDIALECT_H
+
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include <QVariantMap>
+#include <QVariantList>
+#include <QVector>
+#include <QPair>
+#include <QPointF>
+#include <QRectF>
+#include <algorithm>
+
+/**
+ * @brief SQL 方言
+ * DAO 中与数据库相关的 SQL 片段（几何列、空间过滤、主键列表、类型转换、日期函数）
+ * 集中在此，BaseDAO::dialect() 按当前连接的驱动返回对应实现：
+ * - PostgisDialect：PostgreSQL + PostGIS（ST_Intersects / ST_DWithin，geography 精确距离）
+ * - SqliteDialect：离线 SQLite 库（OfflineExporter 从 PostGIS 导出），几何存为 WKB，
+ *   空间索引为 R*Tree 虚表 <表名>_rtree；距离查询先按外接矩形取候选，
+ *   精确距离由调用方用 keepNearest() 在 C++ 中过滤
+ *
+ * 边界框参数统一为 :minX :minY :maxX :maxY，主键列表参数为 :ids
+ */
+class SqlDialect
+{
+public:
+    virtual ~SqlDialect() {}
+
+    // 当前数据库对应的方言（按 DatabaseManager 主连接的驱动）
+    static const SqlDialect& current();
+
+    virtual QString name() const = 0;
+
+    // WKB 几何输出列："<表达式> AS alias"
+    virtual QString geometryColumn(const QString &alias) const = 0;
+
+    // 渲染投影的几何列；isTwkb 为 true 时按 TWKB 解码，否则按 WKB 解码
+    virtual QString renderGeometryColumn(const QString &alias) const = 0;
+    virtual bool renderGeometryIsTwkb() const = 0;
+
+    // 要素与边界框相交 / 要素位于边界框内
+    virtual QString intersectsBoundsFilter(const QString &table) const = 0;
+    virtual QString withinBoundsFilter(const QString &table) const = 0;
+
+    // 距离查询的 WHERE ... [ORDER BY ... LIMIT :limit] 子句及其参数
+    virtual QString nearPointClause(const QString &table) const = 0;
+    virtual void bindNearPoint(QVariantMap &params, double lon, double lat,
+                               double radiusMeters, int limit) const = 0;
+    // 距离条件是否已在SQL中精确计算并排序（否则调用方使用 keepNearest）
+    virtual bool filtersDistanceExactly() const = 0;
+
+    // 主键列表过滤，参数 :ids 由 idListParameter 生成（SQL文本固定，可复用预编译语句）
+    virtual QString idListFilter(const QString &column) const = 0;
+    virtual QVariant idListParameter(const QVector<int> &ids) const = 0;
+
+    // 十六进制 EWKB 几何字面量，可直接拼入 INSERT/UPDATE
+    virtual QString geometryLiteral(const QByteArray &ewkb) const = 0;
+
+    // 绑定参数的类型转换表达式（sqlType: integer、text、date、timestamp、geometry 等）
+    virtual QString castParameter(const QString &placeholder, const QString &sqlType) const = 0;
+
+    // 多行 VALUES 作为带列名的派生表（批量 UPDATE ... FROM 使用）
+    virtual QString valuesTable(const QString &rows, const QStringList &columns,
+                                const QString &alias) const = 0;
+
+    // 日期列的年份（整数）
+    virtual QString yearOf(const QString &column) const = 0;
+
+    // 判断表是否存在的查询（参数 :table，返回一行布尔值）
+    virtual QString tableExistsQuery() const = 0;
+
+    // 几何写入后同步空间索引（keyColumn 取值在 keys 中的行）；PostGIS 的 GiST 索引自动维护
+    virtual bool refreshSpatialIndex(const QString &table, const QString &keyColumn,
+                                     const QVariantList &keys) const;
+
+    // 边界框参数
+    static void bindBounds(QVariantMap &params, const QRectF &bounds);
+
+    // 经纬度点到点 / 折线的距离（米，局部等距投影，适用于数十公里以内）
+    static double distanceMeters(double lon, double lat, const QPointF &point);
+    static double distanceMeters(double lon, double lat, const QVector<QPointF> &line);
+
+    // 半径（米）对应的经纬度外接矩形
+    static QRectF boundsAround(double lon, double lat, double radiusMeters);
+
+    // 按精确距离过滤、升序排序并截断到 limit（distance 返回单个元素的距离，单位米）
+    template <typename T, typename Distance>
+    static void keepNearest(QVector<T> &items, double radiusMeters, int limit, Distance distance);
+};
+
+template <typename T, typename Distance>
+void SqlDialect::keepNearest(QVector<T> &items, double radiusMeters, int limit, Distance distance)
+{
+    QVector<QPair<double, int>> ranked;
+    ranked.reserve(items.size());
+    for (int i = 0; i < items.size(); ++i) {
+        const double d = distance(items.at(i));
+        if (d <= radiusMeters) {
+            ranked.append(qMakePair(d, i));
+        }
+    }
+    std::sort(ranked.begin(), ranked.end());
+    if (limit >= 0 && ranked.size() > limit) {
+        ranked.resize(limit);
+    }
+
+    QVector<T> kept;
+    kept.reserve(ranked.size());
+    for (const auto &entry : ranked) {
+        kept.append(items.at(entry.second));
+    }
+    items.swap(kept);
+}
+
+/**
+ * @brief PostGIS 方言
+ */
+class PostgisDialect : public SqlDialect
+{
+public:
+    QString name() const override { return "postgis"; }
+    QString geometryColumn(const QString &alias) const override;
+    QString renderGeometryColumn(const QString &alias) const override;
+    bool renderGeometryIsTwkb() const override { return true; }
+    QString intersectsBoundsFilter(const QString &table) const override;
+    QString withinBoundsFilter(const QString &table) const override;
+    QString nearPointClause(const QString &table) const override;
+    void bindNearPoint(QVariantMap &params, double lon, double lat,
+                       double radiusMeters, int limit) const override;
+    bool filtersDistanceExactly() const override { return true; }
+    QString idListFilter(const QString &column) const override;
+    QVariant idListParameter(const QVector<int> &ids) const override;
+    QString geometryLiteral(const QByteArray &ewkb) const override;
+    QString castParameter(const QString &placeholder, const QString &sqlType) const override;
+    QString valuesTable(const QString &rows, const QStringList &columns,
+                        const QString &alias) const override;
+    QString yearOf(const QString &column) const override;
+    QString tableExistsQuery() const override;
+};
+
+/**
+ * @brief SQLite 离线库方言
+ * 表结构见 OfflineExporter：几何列 geom 存 WKB（BLOB），pipelines / facilities 各有
+ * R*Tree 虚表 <表名>_rtree(id, min_x, max_x, min_y, max_y)，删除行由触发器同步，
+ * 写入几何后由 refreshSpatialIndex() 按 WKB 计算外接矩形写入索引
+ *
+ * 边界框查询只比较外接矩形（R*Tree 以 32 位浮点向外取整，结果可能多出边界附近的要素），
+ * 距离查询同样只取候选，精确距离在 C++ 中计算
+ */
+class SqliteDialect : public SqlDialect
+{
+public:
+    QString name() const override { return "sqlite"; }
+    QString geometryColumn(const QString &alias) const override;
+    QString renderGeometryColumn(const QString &alias) const override;
+    bool renderGeometryIsTwkb() const override { return false; }
+    QString intersectsBoundsFilter(const QString &table) const override;
+    QString withinBoundsFilter(const QString &table) const override;
+    QString nearPointClause(const QString &table) const override;
+    void bindNearPoint(QVariantMap &params, double lon, double lat,
+                       double radiusMeters, int limit) const override;
+    bool filtersDistanceExactly() const override { return false; }
+    QString idListFilter(const QString &column) const override;
+    QVariant idListParameter(const QVector<int> &ids) const override;
+    QString geometryLiteral(const QByteArray &ewkb) const override;
+    QString castParameter(const QString &placeholder, const QString &sqlType) const override;
+    QString valuesTable(const QString &rows, const QStringList &columns,
+                        const QString &alias) const override;
+    QString yearOf(const QString &column) const override;
+    QString tableExistsQuery() const override;
+    bool refreshSpatialIndex(const QString &table, const QString &keyColumn,
+                             const QVariantList &keys) const override;
+
+    // 带 R*Tree 索引的表
+    static bool hasSpatialIndex(const QString &table);
+    static QString spatialIndexName(const QString &table) { return table + "_rtree"; }
+
+    // WKB（点或线）的外接矩形
+    static bool wkbBounds(const QByteArray &wkb, QRectF *bounds);
+};
+
+#endif // SQLDIALECT_H
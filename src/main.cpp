@@ -7,6 +7,7 @@
 #include <QGuiApplication>
 #include <QDir>
 #include <QFileInfo>
+#include <QCommandLineParser>
 #include "widgets/basewindow.h"
 #include "ui/myform.h"
 #include "widgets/logindialog.h"
@@ -14,6 +15,7 @@
 #include "core/common/config.h"
 #include "core/common/logger.h"
 #include "core/database/databasemanager.h"
+#include "core/database/offlineexporter.h"
 
 int main(int argc, char *argv[]) {
     QApplication app(argc, argv);
@@ -27,6 +29,15 @@ int main(int argc, char *argv[]) {
     app.setApplicationName("UGIMS");
     app.setOrganizationName("MyOrg");
 
+    // 命令行：--export-offline <文件> 从 PostGIS 导出离线 SQLite 库后退出
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption exportOfflineOption("export-offline",
+                                           "Export pipelines/facilities/users to an offline SQLite database and exit.",
+                                           "file");
+    parser.addOption(exportOfflineOption);
+    parser.process(app);
+
     // 设置窗口图标（替换为你的图标路径）
     app.setWindowIcon(QIcon(":/new/prefix1/images/OrangeCat.png")); // 若使用资源文件
 
@@ -88,6 +99,20 @@ int main(int argc, char *argv[]) {
         qDebug() << "Login will still work, but database features will be unavailable";
     }
 
+    if (parser.isSet(exportOfflineOption)) {
+        if (!DatabaseManager::instance().isConnected()) {
+            qCritical() << "Offline export requires a PostgreSQL connection:" << DatabaseManager::instance().lastError();
+            return 1;
+        }
+        OfflineExporter exporter(parser.value(exportOfflineOption));
+        if (!exporter.exportAll()) {
+            qCritical() << "Offline export failed:" << exporter.lastError();
+            return 1;
+        }
+        qDebug() << "Offline database exported:" << exporter.rowsExported() << "rows";
+        return 0;
+    }
+
     // 显示登录对话框
     LoginDialog loginDialog;
     if (loginDialog.exec() != QDialog::Accepted) {
@@ -3,20 +3,21 @@
 
 #include <QObject>
 #include <QGraphicsScene>
-#include <QGraphicsTextItem>
-#include <QGraphicsRectItem>
-#include <QHash>
+#include <QFutureWatcher>
+#include <QFont>
+#include <QColor>
 #include <QRectF>
-#include "core/models/pipeline.h"
-#include "core/models/facility.h"
+#include "map/labelengine.h"
 
 class TileMapManager;
-class PipelineDAO;
-class FacilityDAO;
+class LabelLayerItem;
+class LayerItemRegistry;
 
 /**
  * @brief 标注渲染器
  * 负责在地图上渲染管线编号、设施名称等标注信息
+ * 标注要素取自场景图形项的内存数据（不查询数据库），
+ * 由 LabelEngine 在工作线程中做碰撞避让放置，结果由单个 LabelLayerItem 绘制
  */
 class AnnotationRenderer : public QObject
 {
@@ -32,6 +33,9 @@ public:
     
     // 设置瓦片地图管理器（用于坐标转换）
     void setTileMapManager(TileMapManager *tileMapManager);
+    
+    // 设置图层图形项注册表（用于采集要素，避免扫描整个场景）
+    void setItemRegistry(LayerItemRegistry *registry) { m_itemRegistry = registry; }
 
     // 渲染所有标注
     void renderAllAnnotations(const QRectF &bounds = QRectF());
@@ -65,36 +69,46 @@ public:
     // 设置当前缩放级别
     void setZoom(int zoom) { m_zoom = zoom; }
     int zoom() const { return m_zoom; }
+    
+    // 仅按已有要素重新放置（缩放变化时调用，不重新采集要素）
+    void relayout(double viewScale = -1.0);
+    
+    // 当前已放置的标注数量
+    int labelCount() const;
 
 signals:
     void renderProgress(int current, int total);
     void renderComplete(int count);
 
+private slots:
+    void onPlacementFinished();
+
 private:
-    // 创建管线标注
-    QGraphicsTextItem* createPipelineLabel(const Pipeline &pipeline, const QPointF &scenePos);
+    // 确保标注图层图形项已加入场景
+    void ensureLabelItem();
     
-    // 创建设施标注
-    QGraphicsTextItem* createFacilityLabel(const Facility &facility, const QPointF &scenePos);
+    // 提交后台放置任务
+    void schedulePlacement();
     
-    // 坐标转换
-    QPointF geoToScene(const QPointF &geoPoint) const;
-    
-    // 计算标注位置（避免重叠）
-    QPointF calculateLabelPosition(const QPointF &basePos, const QSizeF &labelSize) const;
-    
-    // 检查标注是否在可视范围内
-    bool isInBounds(const QPointF &pos, const QRectF &bounds) const;
+    // 类型显示名称（无名称、无编号时作为标注文本）
+    static QString pipelineTypeText(const QString &pipelineType);
+    static QString facilityTypeText(const QString &facilityType);
 
 private:
     QGraphicsScene *m_scene;
     TileMapManager *m_tileMapManager;
-    PipelineDAO *m_pipelineDao;
-    FacilityDAO *m_facilityDao;
-    
-    // 标注项缓存
-    QList<QGraphicsTextItem*> m_pipelineLabels;
-    QList<QGraphicsTextItem*> m_facilityLabels;
+    LayerItemRegistry *m_itemRegistry;
+    
+    // 标注要素快照
+    QVector<LabelFeature> m_pipelineFeatures;
+    QVector<LabelFeature> m_facilityFeatures;
+    
+    // 标注图层与后台放置
+    LabelLayerItem *m_labelItem;
+    QFutureWatcher<LabelPlacementResult> *m_placementWatcher;
+    bool m_placementPending;   // 放置进行中又收到新请求
+    int m_generation;          // 请求序号
+    double m_viewScale;        // 放置使用的视图缩放
     
     // 标注样式
     QFont m_labelFont;
@@ -0,0 +1,58 @@
+#include "map/entitygraphicsitem.h"
+
+QString EntityGraphicsItem::kindName() const
+{
+    return entityKind() == PipelineKind ? QStringLiteral("pipeline") : QStringLiteral("facility");
+}
+
+void EntityGraphicsItem::markModified()
+{
+    if (m_state == EntityState::Unchanged) {
+        m_state = EntityState::Modified;
+    }
+}
+
+EntityGraphicsItem* EntityGraphicsItem::fromItem(QGraphicsItem *item)
+{
+    if (!item) {
+        return nullptr;
+    }
+    switch (item->type()) {
+    case PipelineGraphicsItem::Type:
+        return static_cast<PipelineGraphicsItem*>(item);
+    case FacilityGraphicsItem::Type:
+        return static_cast<FacilityGraphicsItem*>(item);
+    default:
+        return nullptr;
+    }
+}
+
+const EntityGraphicsItem* EntityGraphicsItem::fromItem(const QGraphicsItem *item)
+{
+    return fromItem(const_cast<QGraphicsItem*>(item));
+}
+
+bool EntityGraphicsItem::isEntity(const QGraphicsItem *item)
+{
+    return isPipeline(item) || isFacility(item);
+}
+
+bool EntityGraphicsItem::isPipeline(const QGraphicsItem *item)
+{
+    return item && item->type() == PipelineGraphicsItem::Type;
+}
+
+bool EntityGraphicsItem::isFacility(const QGraphicsItem *item)
+{
+    return item && item->type() == FacilityGraphicsItem::Type;
+}
+
+PipelineGraphicsItem::PipelineGraphicsItem(const QPainterPath &path, QGraphicsItem *parent)
+    : QGraphicsPathItem(path, parent)
+{
+}
+
+FacilityGraphicsItem::FacilityGraphicsItem(const QRectF &rect, QGraphicsItem *parent)
+    : QGraphicsEllipseItem(rect, parent)
+{
+}
@@ -0,0 +1,102 @@
+#ifndef ENTITYGRAPHICSITEM_H
+#define ENTITYGRAPHICSITEM_H
+
+#include <QGraphicsPathItem>
+#include <QGraphicsEllipseItem>
+#include <QString>
+#include "core/common/entitystate.h"
+
+/**
+ * @brief 实体图形项公共字段
+ * 管线/设施的业务编号、类型、名称、数据库ID与实体状态以强类型字段保存，
+ * 替代 setData(0/1/2/3/10/100) 的 QVariant 槽位；按 type() 区分实体种类，
+ * 过滤时用 qgraphicsitem_cast 与枚举比较代替字符串比较
+ */
+class EntityGraphicsItem
+{
+public:
+    enum EntityKind {
+        PipelineKind = 0,
+        FacilityKind = 1
+    };
+
+    virtual ~EntityGraphicsItem() = default;
+
+    virtual EntityKind entityKind() const = 0;
+    // 种类标识 "pipeline"/"facility"（与待保存变更、设备树等处的字符串标识一致）
+    QString kindName() const;
+
+    // 业务编号（pipelineId / facilityId）
+    const QString& entityId() const { return m_entityId; }
+    void setEntityId(const QString &id) { m_entityId = id; }
+
+    // 管线类型 / 设施类型
+    const QString& entityType() const { return m_entityType; }
+    void setEntityType(const QString &type) { m_entityType = type; }
+
+    // 名称（用于标注显示）
+    const QString& name() const { return m_name; }
+    void setName(const QString &name) { m_name = name; }
+
+    // 数据库ID（新建未保存时为 0）
+    int databaseId() const { return m_databaseId; }
+    void setDatabaseId(int id) { m_databaseId = id; }
+
+    // 实体状态（增量保存依据）
+    EntityState state() const { return m_state; }
+    void setState(EntityState state) { m_state = state; }
+    // 未变更的实体标记为已修改（新增/删除状态保持不变）
+    void markModified();
+
+    // 从任意图形项取实体字段，非实体返回 nullptr
+    static EntityGraphicsItem* fromItem(QGraphicsItem *item);
+    static const EntityGraphicsItem* fromItem(const QGraphicsItem *item);
+    static bool isEntity(const QGraphicsItem *item);
+    static bool isPipeline(const QGraphicsItem *item);
+    static bool isFacility(const QGraphicsItem *item);
+
+private:
+    QString m_entityId;
+    QString m_entityType;
+    QString m_name;
+    int m_databaseId = 0;
+    EntityState m_state = EntityState::Unchanged;
+};
+
+/**
+ * @brief 管线图形项
+ */
+class PipelineGraphicsItem : public QGraphicsPathItem, public EntityGraphicsItem
+{
+public:
+    enum { Type = QGraphicsItem::UserType + 1 };
+
+    explicit PipelineGraphicsItem(const QPainterPath &path = QPainterPath(),
+                                  QGraphicsItem *parent = nullptr);
+
+    int type() const override { return Type; }
+    EntityKind entityKind() const override { return PipelineKind; }
+
+    // 管径（毫米，用于标注优先级与保存）
+    int diameterMm() const { return m_diameterMm; }
+    void setDiameterMm(int diameter) { m_diameterMm = diameter; }
+
+private:
+    int m_diameterMm = 0;
+};
+
+/**
+ * @brief 设施图形项
+ */
+class FacilityGraphicsItem : public QGraphicsEllipseItem, public EntityGraphicsItem
+{
+public:
+    enum { Type = QGraphicsItem::UserType + 2 };
+
+    explicit FacilityGraphicsItem(const QRectF &rect = QRectF(), QGraphicsItem *parent = nullptr);
+
+    int type() const override { return Type; }
+    EntityKind entityKind() const override { return FacilityKind; }
+};
+
+#endif // ENTITYGRAPHICSITEM_H
@@ -0,0 +1,289 @@
+#include "map/entitypickindex.h"
+#include "map/entitygraphicsitem.h"
+#include <QLineF>
+#include <QtMath>
+#include <algorithm>
+#include <limits>
+
+namespace {
+// R 树节点容量
+const int NODE_CAPACITY = 16;
+// 待合并区/删除标记超过该数量时重建
+const int MAX_PENDING_ENTRIES = 256;
+
+// STR（Sort-Tile-Recursive）排序：先按中心 x 分成竖条，条内按中心 y 排序
+template <typename T, typename CenterX, typename CenterY>
+void strSort(QVector<T> &values, CenterX centerX, CenterY centerY)
+{
+    const int n = values.size();
+    const int leafCount = (n + NODE_CAPACITY - 1) / NODE_CAPACITY;
+    const int sliceCount = qMax(1, qCeil(qSqrt(leafCount)));
+    const int sliceSize = sliceCount * NODE_CAPACITY;
+
+    std::sort(values.begin(), values.end(), [&](const T &a, const T &b) {
+        return centerX(a) < centerX(b);
+    });
+    for (int begin = 0; begin < n; begin += sliceSize) {
+        const int end = qMin(n, begin + sliceSize);
+        std::sort(values.begin() + begin, values.begin() + end, [&](const T &a, const T &b) {
+            return centerY(a) < centerY(b);
+        });
+    }
+}
+}
+
+EntityPickIndex::EntityPickIndex()
+    : m_builtCount(0)
+    , m_deadCount(0)
+    , m_rootIndex(-1)
+{
+}
+
+void EntityPickIndex::insertItem(QGraphicsItem *item, EntityKind kind)
+{
+    if (!item) {
+        return;
+    }
+    markDead(item);
+    m_itemKinds.insert(item, kind);
+    appendEntries(item, kind);
+}
+
+void EntityPickIndex::updateItem(QGraphicsItem *item)
+{
+    auto it = m_itemKinds.constFind(item);
+    if (it == m_itemKinds.constEnd()) {
+        return;
+    }
+    EntityKind kind = it.value();
+    markDead(item);
+    appendEntries(item, kind);
+}
+
+void EntityPickIndex::removeItem(QGraphicsItem *item)
+{
+    markDead(item);
+    m_itemKinds.remove(item);
+}
+
+void EntityPickIndex::clear()
+{
+    m_entries.clear();
+    m_nodes.clear();
+    m_itemEntries.clear();
+    m_itemKinds.clear();
+    m_builtCount = 0;
+    m_deadCount = 0;
+    m_rootIndex = -1;
+}
+
+void EntityPickIndex::appendEntries(QGraphicsItem *item, EntityKind kind)
+{
+    QVector<int> &indexes = m_itemEntries[item];
+
+    auto append = [&](const QPointF &p1, const QPointF &p2, qreal radius) {
+        Entry entry;
+        entry.p1 = p1;
+        entry.p2 = p2;
+        entry.radius = radius;
+        entry.item = item;
+        entry.kind = kind;
+        entry.bounds = {qMin(p1.x(), p2.x()) - radius, qMin(p1.y(), p2.y()) - radius,
+                        qMax(p1.x(), p2.x()) + radius, qMax(p1.y(), p2.y()) + radius};
+        indexes.append(m_entries.size());
+        m_entries.append(entry);
+    };
+
+    if (kind == PipelineEntity) {
+        // 管线：按场景坐标拆分为线段（曲线已展平）
+        auto *pathItem = qgraphicsitem_cast<PipelineGraphicsItem*>(item);
+        if (!pathItem) {
+            return;
+        }
+        const QList<QPolygonF> polygons = pathItem->path().toSubpathPolygons(item->sceneTransform());
+        for (const QPolygonF &polygon : polygons) {
+            if (polygon.size() == 1) {
+                append(polygon.first(), polygon.first(), 0);
+            }
+            for (int i = 1; i < polygon.size(); ++i) {
+                append(polygon.at(i - 1), polygon.at(i), 0);
+            }
+        }
+    } else {
+        // 设施：符号中心点与半径
+        if (auto *ellipseItem = qgraphicsitem_cast<FacilityGraphicsItem*>(item)) {
+            const QRectF rect = item->sceneTransform().mapRect(ellipseItem->rect());
+            append(rect.center(), rect.center(), qMin(rect.width(), rect.height()) / 2.0);
+        } else {
+            const QPointF center = item->sceneBoundingRect().center();
+            append(center, center, 0);
+        }
+    }
+}
+
+void EntityPickIndex::markDead(QGraphicsItem *item)
+{
+    auto it = m_itemEntries.find(item);
+    if (it == m_itemEntries.end()) {
+        return;
+    }
+    for (int index : it.value()) {
+        m_entries[index].item = nullptr;
+        m_deadCount++;
+    }
+    m_itemEntries.erase(it);
+}
+
+void EntityPickIndex::rebuildIfNeeded() const
+{
+    const int pending = m_entries.size() - m_builtCount;
+    if (pending > MAX_PENDING_ENTRIES
+        || m_deadCount > qMax(MAX_PENDING_ENTRIES, m_entries.size() / 4)) {
+        rebuild();
+    }
+}
+
+void EntityPickIndex::rebuild() const
+{
+    // 1. 去除已删除的条目
+    QVector<Entry> entries;
+    entries.reserve(m_entries.size() - m_deadCount);
+    for (const Entry &entry : m_entries) {
+        if (entry.item) {
+            entries.append(entry);
+        }
+    }
+
+    // 2. 条目按 STR 排序，每 NODE_CAPACITY 个组成叶子
+    strSort(entries,
+            [](const Entry &e) { return (e.bounds.minX + e.bounds.maxX) * 0.5; },
+            [](const Entry &e) { return (e.bounds.minY + e.bounds.maxY) * 0.5; });
+
+    m_itemEntries.clear();
+    for (int i = 0; i < entries.size(); ++i) {
+        m_itemEntries[entries[i].item].append(i);
+    }
+
+    auto unite = [](Box &box, const Box &other) {
+        box.minX = qMin(box.minX, other.minX);
+        box.minY = qMin(box.minY, other.minY);
+        box.maxX = qMax(box.maxX, other.maxX);
+        box.maxY = qMax(box.maxY, other.maxY);
+    };
+
+    QVector<Node> level;
+    for (int first = 0; first < entries.size(); first += NODE_CAPACITY) {
+        Node node;
+        node.first = first;
+        node.count = qMin(NODE_CAPACITY, entries.size() - first);
+        node.leaf = true;
+        node.bounds = entries[first].bounds;
+        for (int i = first + 1; i < first + node.count; ++i) {
+            unite(node.bounds, entries[i].bounds);
+        }
+        level.append(node);
+    }
+
+    // 3. 自底向上逐层打包，同层节点连续存放
+    m_nodes.clear();
+    while (level.size() > 1) {
+        strSort(level,
+                [](const Node &n) { return (n.bounds.minX + n.bounds.maxX) * 0.5; },
+                [](const Node &n) { return (n.bounds.minY + n.bounds.maxY) * 0.5; });
+        const int offset = m_nodes.size();
+        m_nodes += level;
+
+        QVector<Node> parents;
+        for (int first = 0; first < level.size(); first += NODE_CAPACITY) {
+            Node parent;
+            parent.first = offset + first;
+            parent.count = qMin(NODE_CAPACITY, level.size() - first);
+            parent.leaf = false;
+            parent.bounds = level[first].bounds;
+            for (int i = first + 1; i < first + parent.count; ++i) {
+                unite(parent.bounds, level[i].bounds);
+            }
+            parents.append(parent);
+        }
+        level = parents;
+    }
+    m_nodes += level;
+
+    m_entries = entries;
+    m_builtCount = m_entries.size();
+    m_deadCount = 0;
+    m_rootIndex = m_nodes.isEmpty() ? -1 : m_nodes.size() - 1;
+}
+
+QGraphicsItem* EntityPickIndex::pickNearest(const QPointF &scenePos, qreal tolerance, EntityKind kind,
+                                            const AcceptFunction &accept, qreal *distance) const
+{
+    rebuildIfNeeded();
+
+    const Box query = {scenePos.x() - tolerance, scenePos.y() - tolerance,
+                       scenePos.x() + tolerance, scenePos.y() + tolerance};
+    auto overlaps = [&query](const Box &box) {
+        return box.minX <= query.maxX && box.maxX >= query.minX
+            && box.minY <= query.maxY && box.maxY >= query.minY;
+    };
+
+    QGraphicsItem *best = nullptr;
+    qreal bestDistance = std::numeric_limits<qreal>::max();
+
+    auto test = [&](const Entry &entry) {
+        if (!entry.item || entry.kind != kind || !overlaps(entry.bounds)) {
+            return;
+        }
+        const qreal d = entryDistance(entry, scenePos);
+        if (d <= tolerance && d < bestDistance && (!accept || accept(entry.item))) {
+            bestDistance = d;
+            best = entry.item;
+        }
+    };
+
+    // 1. R 树
+    if (m_rootIndex >= 0) {
+        QVector<int> stack;
+        stack.append(m_rootIndex);
+        while (!stack.isEmpty()) {
+            const Node &node = m_nodes[stack.takeLast()];
+            if (!overlaps(node.bounds)) {
+                continue;
+            }
+            if (node.leaf) {
+                for (int i = node.first; i < node.first + node.count; ++i) {
+                    test(m_entries[i]);
+                }
+            } else {
+                for (int i = node.first; i < node.first + node.count; ++i) {
+                    stack.append(i);
+                }
+            }
+        }
+    }
+
+    // 2. 待合并区
+    for (int i = m_builtCount; i < m_entries.size(); ++i) {
+        test(m_entries[i]);
+    }
+
+    if (distance) {
+        *distance = bestDistance;
+    }
+    return best;
+}
+
+qreal EntityPickIndex::entryDistance(const Entry &entry, const QPointF &pos)
+{
+    // 设施：到符号边缘的距离
+    if (entry.p1 == entry.p2) {
+        return qMax<qreal>(0.0, QLineF(pos, entry.p1).length() - entry.radius);
+    }
+
+    // 管线：点到线段的精确距离
+    const QPointF v = entry.p2 - entry.p1;
+    const QPointF w = pos - entry.p1;
+    const qreal lengthSquared = QPointF::dotProduct(v, v);
+    const qreal t = qBound<qreal>(0.0, QPointF::dotProduct(w, v) / lengthSquared, 1.0);
+    return QLineF(pos, entry.p1 + t * v).length();
+}
@@ -0,0 +1,86 @@
+#ifndef ENTITYPICKINDEX_H
+#define ENTITYPICKINDEX_H
+
+#include <QHash>
+#include <QVector>
+#include <QPointF>
+#include <functional>
+
+class QGraphicsItem;
+
+/**
+ * @brief 实体点选索引
+ * 只收录管线线段与设施点（场景坐标），使用 STR 打包的 R 树按容差矩形查询，
+ * 对候选做精确的点到线段距离计算，不经过场景 BSP、不做 QPainterPath 描边求交
+ *
+ * 新增图形项先放入待合并区（线性扫描），删除只做标记，积累到一定数量后在
+ * 下次查询时整体重建；图形项几何变化（移动）后调用 updateItem()
+ */
+class EntityPickIndex
+{
+public:
+    enum EntityKind {
+        PipelineEntity = 0,
+        FacilityEntity = 1
+    };
+
+    // 候选过滤（如是否可见、是否仍在场景中），返回 false 时跳过
+    using AcceptFunction = std::function<bool(QGraphicsItem*)>;
+
+    EntityPickIndex();
+
+    // 按图形项当前几何登记（已登记时替换）
+    void insertItem(QGraphicsItem *item, EntityKind kind);
+    void updateItem(QGraphicsItem *item);
+    void removeItem(QGraphicsItem *item);
+    void clear();
+
+    bool contains(QGraphicsItem *item) const { return m_itemEntries.contains(item); }
+    int entryCount() const { return m_entries.size() - m_deadCount; }
+
+    // 查找距离场景点最近、且在容差内的实体；distance 返回精确距离
+    QGraphicsItem* pickNearest(const QPointF &scenePos, qreal tolerance, EntityKind kind,
+                               const AcceptFunction &accept = AcceptFunction(),
+                               qreal *distance = nullptr) const;
+
+private:
+    struct Box {
+        qreal minX, minY, maxX, maxY;
+    };
+
+    struct Entry {
+        Box bounds;
+        QPointF p1;             // 线段起点 / 设施中心
+        QPointF p2;             // 线段终点（设施与起点相同）
+        qreal radius;           // 设施符号半径
+        QGraphicsItem *item;    // 已删除时为 nullptr
+        EntityKind kind;
+    };
+
+    struct Node {
+        Box bounds;
+        int first;              // 叶子：条目起始下标；内部：子节点起始下标
+        int count;
+        bool leaf;
+    };
+
+    void appendEntries(QGraphicsItem *item, EntityKind kind);
+    void markDead(QGraphicsItem *item);
+    void rebuildIfNeeded() const;
+    void rebuild() const;
+
+    static qreal entryDistance(const Entry &entry, const QPointF &pos);
+
+    // 条目：[0, m_builtCount) 已打包进 R 树，其后为待合并区
+    mutable QVector<Entry> m_entries;
+    mutable QVector<Node> m_nodes;
+    mutable int m_builtCount;
+    mutable int m_deadCount;
+    mutable int m_rootIndex;
+
+    // 图形项 -> 条目下标
+    mutable QHash<QGraphicsItem*, QVector<int>> m_itemEntries;
+    QHash<QGraphicsItem*, EntityKind> m_itemKinds;
+};
+
+#endif // ENTITYPICKINDEX_H
@@ -0,0 +1,459 @@
+#include "map/facilityclusterindex.h"
+#include <QtMath>
+#include <limits>
+#include <cmath>
+
+// ==========================================
+// KD树（kdbush 风格）
+// ==========================================
+
+void FacilityClusterIndex::KdTree::build(const QVector<int> &ids, const QVector<Node> &nodes)
+{
+    m_ids = ids;
+    m_coords.resize(ids.size() * 2);
+    for (int i = 0; i < ids.size(); i++) {
+        const Node &node = nodes[ids[i]];
+        m_coords[2 * i] = node.x;
+        m_coords[2 * i + 1] = node.y;
+    }
+    if (!m_ids.isEmpty()) {
+        sortKd(0, m_ids.size() - 1, 0);
+    }
+}
+
+void FacilityClusterIndex::KdTree::sortKd(int left, int right, int axis)
+{
+    if (right - left <= NODE_SIZE) {
+        return;
+    }
+    int m = (left + right) >> 1;
+    select(m, left, right, axis);
+    sortKd(left, m - 1, 1 - axis);
+    sortKd(m + 1, right, 1 - axis);
+}
+
+void FacilityClusterIndex::KdTree::select(int k, int left, int right, int axis)
+{
+    // 快速选择：使第k个元素就位，左侧 <= 它，右侧 >= 它
+    while (right > left) {
+        double t = m_coords[2 * k + axis];
+        int i = left;
+        int j = right;
+
+        swapItem(left, k);
+        if (m_coords[2 * right + axis] > t) {
+            swapItem(left, right);
+        }
+
+        while (i < j) {
+            swapItem(i, j);
+            i++;
+            j--;
+            while (m_coords[2 * i + axis] < t) i++;
+            while (m_coords[2 * j + axis] > t) j--;
+        }
+
+        if (m_coords[2 * left + axis] == t) {
+            swapItem(left, j);
+        } else {
+            j++;
+            swapItem(j, right);
+        }
+
+        if (j <= k) left = j + 1;
+        if (k <= j) right = j - 1;
+    }
+}
+
+void FacilityClusterIndex::KdTree::swapItem(int i, int j)
+{
+    qSwap(m_ids[i], m_ids[j]);
+    qSwap(m_coords[2 * i], m_coords[2 * j]);
+    qSwap(m_coords[2 * i + 1], m_coords[2 * j + 1]);
+}
+
+void FacilityClusterIndex::KdTree::range(double minX, double minY, double maxX, double maxY,
+                                         QVector<int> &out) const
+{
+    if (m_ids.isEmpty()) {
+        return;
+    }
+
+    // 显式栈：left, right, axis
+    QVector<int> stack = {0, m_ids.size() - 1, 0};
+    while (!stack.isEmpty()) {
+        int axis = stack.takeLast();
+        int right = stack.takeLast();
+        int left = stack.takeLast();
+
+        if (right - left <= NODE_SIZE) {
+            for (int i = left; i <= right; i++) {
+                double x = m_coords[2 * i];
+                double y = m_coords[2 * i + 1];
+                if (x >= minX && x <= maxX && y >= minY && y <= maxY) {
+                    out.append(m_ids[i]);
+                }
+            }
+            continue;
+        }
+
+        int m = (left + right) >> 1;
+        double x = m_coords[2 * m];
+        double y = m_coords[2 * m + 1];
+        if (x >= minX && x <= maxX && y >= minY && y <= maxY) {
+            out.append(m_ids[m]);
+        }
+
+        if (axis == 0 ? minX <= x : minY <= y) {
+            stack << left << (m - 1) << (1 - axis);
+        }
+        if (axis == 0 ? maxX >= x : maxY >= y) {
+            stack << (m + 1) << right << (1 - axis);
+        }
+    }
+}
+
+void FacilityClusterIndex::KdTree::within(double qx, double qy, double r, QVector<int> &out) const
+{
+    if (m_ids.isEmpty()) {
+        return;
+    }
+
+    const double r2 = r * r;
+    QVector<int> stack = {0, m_ids.size() - 1, 0};
+    while (!stack.isEmpty()) {
+        int axis = stack.takeLast();
+        int right = stack.takeLast();
+        int left = stack.takeLast();
+
+        if (right - left <= NODE_SIZE) {
+            for (int i = left; i <= right; i++) {
+                double dx = m_coords[2 * i] - qx;
+                double dy = m_coords[2 * i + 1] - qy;
+                if (dx * dx + dy * dy <= r2) {
+                    out.append(m_ids[i]);
+                }
+            }
+            continue;
+        }
+
+        int m = (left + right) >> 1;
+        double x = m_coords[2 * m];
+        double y = m_coords[2 * m + 1];
+        double dx = x - qx;
+        double dy = y - qy;
+        if (dx * dx + dy * dy <= r2) {
+            out.append(m_ids[m]);
+        }
+
+        if (axis == 0 ? qx - r <= x : qy - r <= y) {
+            stack << left << (m - 1) << (1 - axis);
+        }
+        if (axis == 0 ? qx + r >= x : qy + r >= y) {
+            stack << (m + 1) << right << (1 - axis);
+        }
+    }
+}
+
+// ==========================================
+// 聚类索引
+// ==========================================
+
+FacilityClusterIndex::FacilityClusterIndex(int minZoom, int maxZoom, double radiusPx, int extentPx)
+    : m_minZoom(minZoom)
+    , m_maxZoom(maxZoom)
+    , m_radiusPx(radiusPx)
+    , m_extentPx(extentPx)
+    , m_leafCount(0)
+    , m_overflowCount(0)
+{
+    m_trees.resize(m_maxZoom + 2);
+    m_overflow.resize(m_maxZoom + 2);
+}
+
+QPointF FacilityClusterIndex::lonLatToNorm(const QPointF &lonLat)
+{
+    double x = lonLat.x() / 360.0 + 0.5;
+    double sinLat = qSin(qDegreesToRadians(lonLat.y()));
+    double y = 0.5 - 0.25 * qLn((1.0 + sinLat) / (1.0 - sinLat)) / M_PI;
+    return QPointF(qBound(0.0, x, 1.0), qBound(0.0, y, 1.0));
+}
+
+QPointF FacilityClusterIndex::normToLonLat(const QPointF &norm)
+{
+    double lon = (norm.x() - 0.5) * 360.0;
+    double y2 = (180.0 - norm.y() * 360.0) * M_PI / 180.0;
+    double lat = 360.0 * qAtan(qExp(y2)) / M_PI - 90.0;
+    return QPointF(lon, lat);
+}
+
+double FacilityClusterIndex::zoomRadius(int zoom) const
+{
+    return m_radiusPx / (m_extentPx * std::pow(2.0, zoom));
+}
+
+void FacilityClusterIndex::build(const QVector<FacilityRenderRecord> &facilities)
+{
+    m_nodes.clear();
+    m_facilityIds.clear();
+    m_facilityTypes.clear();
+    m_trees = QVector<KdTree>(m_maxZoom + 2);
+    m_overflow = QVector<QVector<int>>(m_maxZoom + 2);
+    m_overflowCount = 0;
+
+    m_nodes.reserve(facilities.size() * 2);
+    m_facilityIds.reserve(facilities.size());
+    m_facilityTypes.reserve(facilities.size());
+
+    // 1. 叶子节点
+    QVector<int> leaves;
+    leaves.reserve(facilities.size());
+    for (const FacilityRenderRecord &facility : facilities) {
+        if (facility.coordinate.isNull()) {
+            continue;
+        }
+        QPointF norm = lonLatToNorm(facility.coordinate);
+
+        Node leaf;
+        leaf.x = norm.x();
+        leaf.y = norm.y();
+        leaf.count = 1;
+        leaf.parent = -1;
+        leaf.zoom = std::numeric_limits<int>::max();
+        leaf.createdZoom = m_maxZoom + 1;
+        leaf.facility = m_facilityIds.size();
+
+        m_facilityIds.append(facility.facilityId);
+        m_facilityTypes.append(facility.facilityType);
+        leaves.append(m_nodes.size());
+        m_nodes.append(leaf);
+    }
+    m_leafCount = leaves.size();
+
+    // 2. 自高层级向低层级逐级聚类
+    m_trees[m_maxZoom + 1].build(leaves, m_nodes);
+    QVector<int> current = leaves;
+    for (int z = m_maxZoom; z >= m_minZoom; z--) {
+        current = clusterZoom(current, z);
+        m_trees[z].build(current, m_nodes);
+    }
+}
+
+QVector<int> FacilityClusterIndex::clusterZoom(const QVector<int> &points, int zoom)
+{
+    const double r = zoomRadius(zoom);
+    const KdTree &tree = m_trees[zoom + 1];
+
+    QVector<int> clusters;
+    QVector<int> neighbors;
+    for (int id : points) {
+        if (m_nodes[id].zoom <= zoom) {
+            continue;  // 已被其他聚类吸收
+        }
+        m_nodes[id].zoom = zoom;
+
+        neighbors.clear();
+        tree.within(m_nodes[id].x, m_nodes[id].y, r, neighbors);
+
+        int numPoints = m_nodes[id].count;
+        double wx = m_nodes[id].x * numPoints;
+        double wy = m_nodes[id].y * numPoints;
+        QVector<int> members = {id};
+
+        for (int nb : neighbors) {
+            Node &b = m_nodes[nb];
+            if (b.zoom <= zoom) {
+                continue;
+            }
+            b.zoom = zoom;
+            wx += b.x * b.count;
+            wy += b.y * b.count;
+            numPoints += b.count;
+            members.append(nb);
+        }
+
+        if (members.size() == 1) {
+            clusters.append(id);
+            continue;
+        }
+
+        Node cluster;
+        cluster.x = wx / numPoints;
+        cluster.y = wy / numPoints;
+        cluster.count = numPoints;
+        cluster.parent = -1;
+        cluster.zoom = std::numeric_limits<int>::max();
+        cluster.createdZoom = zoom;
+        cluster.facility = -1;
+        cluster.children = members;
+
+        int clusterId = m_nodes.size();
+        m_nodes.append(cluster);  // 注意：append 之后不能再使用此前取得的引用
+        for (int member : members) {
+            m_nodes[member].parent = clusterId;
+        }
+        clusters.append(clusterId);
+    }
+    return clusters;
+}
+
+void FacilityClusterIndex::insert(const FacilityRenderRecord &facility)
+{
+    if (facility.coordinate.isNull()) {
+        return;
+    }
+    QPointF norm = lonLatToNorm(facility.coordinate);
+
+    Node leaf;
+    leaf.x = norm.x();
+    leaf.y = norm.y();
+    leaf.count = 1;
+    leaf.parent = -1;
+    leaf.zoom = std::numeric_limits<int>::max();
+    leaf.createdZoom = m_maxZoom + 1;
+    leaf.facility = m_facilityIds.size();
+
+    m_facilityIds.append(facility.facilityId);
+    m_facilityTypes.append(facility.facilityType);
+    int id = m_nodes.size();
+    m_nodes.append(leaf);
+    m_leafCount++;
+
+    m_overflow[m_maxZoom + 1].append(id);
+    m_overflowCount++;
+
+    // 自高层级向下：并入半径内最近的已有聚类，之后的低层级由祖先聚类计数体现
+    QVector<int> candidates;
+    for (int z = m_maxZoom; z >= m_minZoom; z--) {
+        const double r = zoomRadius(z);
+        candidates.clear();
+        m_trees[z].within(norm.x(), norm.y(), r, candidates);
+        candidates += m_overflow[z];
+
+        int best = -1;
+        double bestDist = r * r;
+        for (int c : candidates) {
+            const Node &node = m_nodes[c];
+            if (node.facility >= 0 || c == id) {
+                continue;  // 只并入聚类，不与单点合并
+            }
+            double dx = node.x - norm.x();
+            double dy = node.y - norm.y();
+            double d2 = dx * dx + dy * dy;
+            if (d2 <= bestDist) {
+                bestDist = d2;
+                best = c;
+            }
+        }
+
+        if (best >= 0) {
+            m_nodes[id].parent = best;
+            m_nodes[best].children.append(id);
+            // 祖先聚类的计数与加权中心一并更新（KD树中的坐标保持构建时的值，
+            // 范围查询略有偏差，由 needsRebuild() 触发的后台重建修正）
+            for (int a = best; a >= 0; a = m_nodes[a].parent) {
+                Node &ancestor = m_nodes[a];
+                ancestor.x = (ancestor.x * ancestor.count + norm.x()) / (ancestor.count + 1);
+                ancestor.y = (ancestor.y * ancestor.count + norm.y()) / (ancestor.count + 1);
+                ancestor.count++;
+            }
+            return;
+        }
+
+        m_overflow[z].append(id);
+        m_overflowCount++;
+    }
+}
+
+bool FacilityClusterIndex::needsRebuild() const
+{
+    return m_overflowCount > qMax(64, m_leafCount / 20);
+}
+
+void FacilityClusterIndex::collectVisible(const QRectF &normBounds, int zoom, QVector<int> &out) const
+{
+    int z = qBound(m_minZoom, zoom, m_maxZoom + 1);
+    m_trees[z].range(normBounds.left(), normBounds.top(),
+                     normBounds.right(), normBounds.bottom(), out);
+    for (int id : m_overflow[z]) {
+        const Node &node = m_nodes[id];
+        if (normBounds.contains(node.x, node.y)) {
+            out.append(id);
+        }
+    }
+}
+
+FacilityClusterIndex::Cluster FacilityClusterIndex::makeCluster(int nodeId) const
+{
+    const Node &node = m_nodes[nodeId];
+    Cluster cluster;
+    cluster.x = node.x;
+    cluster.y = node.y;
+    cluster.count = node.count;
+    cluster.nodeId = nodeId;
+    if (node.facility >= 0) {
+        cluster.facilityId = m_facilityIds[node.facility];
+        cluster.facilityType = m_facilityTypes[node.facility];
+    }
+    return cluster;
+}
+
+QVector<FacilityClusterIndex::Cluster> FacilityClusterIndex::getClusters(const QRectF &normBounds, int zoom) const
+{
+    QVector<int> ids;
+    collectVisible(normBounds, zoom, ids);
+
+    QVector<Cluster> result;
+    result.reserve(ids.size());
+    for (int id : ids) {
+        result.append(makeCluster(id));
+    }
+    return result;
+}
+
+FacilityClusterIndex::Cluster FacilityClusterIndex::clusterAt(const QPointF &normPos,
+                                                              double normTolerance, int zoom) const
+{
+    QRectF box(normPos.x() - normTolerance, normPos.y() - normTolerance,
+               normTolerance * 2, normTolerance * 2);
+    QVector<int> ids;
+    collectVisible(box, zoom, ids);
+
+    int best = -1;
+    double bestDist = normTolerance * normTolerance;
+    for (int id : ids) {
+        double dx = m_nodes[id].x - normPos.x();
+        double dy = m_nodes[id].y - normPos.y();
+        double d2 = dx * dx + dy * dy;
+        if (d2 <= bestDist) {
+            bestDist = d2;
+            best = id;
+        }
+    }
+
+    if (best < 0) {
+        Cluster none;
+        none.x = 0;
+        none.y = 0;
+        none.count = 0;
+        none.nodeId = -1;
+        return none;
+    }
+    return makeCluster(best);
+}
+
+int FacilityClusterIndex::expansionZoom(int nodeId) const
+{
+    if (nodeId < 0 || nodeId >= m_nodes.size()) {
+        return m_maxZoom + 1;
+    }
+
+    // 沿单子节点链向下，直到聚类真正拆分
+    int id = nodeId;
+    int zoom = m_nodes[id].createdZoom + 1;
+    while (m_nodes[id].facility < 0 && m_nodes[id].children.size() == 1) {
+        id = m_nodes[id].children.first();
+        zoom = m_nodes[id].createdZoom + 1;
+    }
+    return qMin(zoom, m_maxZoom + 1);
+}
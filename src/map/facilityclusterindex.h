@@ -0,0 +1,107 @@
+#ifndef FACILITYCLUSTERINDEX_H
+#define FACILITYCLUSTERINDEX_H
+
+#include <QVector>
+#include <QString>
+#include <QRectF>
+#include <QPointF>
+#include "core/models/renderrecord.h"
+
+/**
+ * @brief 设施层次聚类索引
+ * supercluster 风格：每个缩放级别一棵静态KD树，自高层级向低层级逐级合并
+ * 坐标统一使用归一化墨卡托坐标 [0,1]，与具体瓦片层级和场景尺寸无关
+ */
+class FacilityClusterIndex
+{
+public:
+    // 聚类查询结果（单个设施也以 count == 1 的形式返回）
+    struct Cluster {
+        double x;            // 归一化墨卡托X
+        double y;            // 归一化墨卡托Y
+        int count;           // 包含的设施数量
+        int nodeId;          // 节点ID（用于展开查询）
+        QString facilityId;  // 单个设施时的设施编号
+        QString facilityType;// 单个设施时的设施类型
+    };
+
+    FacilityClusterIndex(int minZoom = 3, int maxZoom = 16,
+                         double radiusPx = 60.0, int extentPx = 256);
+
+    // 全量构建（可在工作线程中执行）
+    void build(const QVector<FacilityRenderRecord> &facilities);
+
+    // 增量插入一个设施（GUI线程，构建完成后调用）
+    // 只并入已有聚类并更新其计数与中心，不重新合并，结果为近似值，needsRebuild() 后应全量重建
+    void insert(const FacilityRenderRecord &facility);
+
+    // 查询指定层级、指定归一化范围内的聚类
+    QVector<Cluster> getClusters(const QRectF &normBounds, int zoom) const;
+
+    // 点选：返回距离最近且在容差范围内的聚类，未命中时返回 nodeId == -1
+    Cluster clusterAt(const QPointF &normPos, double normTolerance, int zoom) const;
+
+    // 获取聚类展开时需要放大到的层级
+    int expansionZoom(int nodeId) const;
+
+    // 增量插入后是否建议后台重建（溢出点过多时聚类质量下降）
+    bool needsRebuild() const;
+
+    int size() const { return m_leafCount; }
+    int minZoom() const { return m_minZoom; }
+    int maxZoom() const { return m_maxZoom; }
+
+    // 坐标转换：经纬度 -> 归一化墨卡托
+    static QPointF lonLatToNorm(const QPointF &lonLat);
+    static QPointF normToLonLat(const QPointF &norm);
+
+private:
+    // 聚类树节点（叶子与聚类共用）
+    struct Node {
+        double x;
+        double y;
+        int count;
+        int parent;          // 上一级（更低层级）所属聚类，-1 表示无
+        int zoom;            // 构建时的处理标记
+        int createdZoom;     // 聚类所在层级（叶子为 maxZoom + 1）
+        int facility;        // 叶子对应的设施下标，聚类为 -1
+        QVector<int> children;
+    };
+
+    // 静态KD树（kdbush 风格，按坐标交替排序）
+    class KdTree {
+    public:
+        void build(const QVector<int> &ids, const QVector<Node> &nodes);
+        void range(double minX, double minY, double maxX, double maxY, QVector<int> &out) const;
+        void within(double qx, double qy, double r, QVector<int> &out) const;
+        int size() const { return m_ids.size(); }
+    private:
+        void sortKd(int left, int right, int axis);
+        void select(int k, int left, int right, int axis);
+        void swapItem(int i, int j);
+
+        QVector<int> m_ids;
+        QVector<double> m_coords;  // x0, y0, x1, y1, ...
+        static const int NODE_SIZE = 64;
+    };
+
+    QVector<int> clusterZoom(const QVector<int> &points, int zoom);
+    double zoomRadius(int zoom) const;
+    void collectVisible(const QRectF &normBounds, int zoom, QVector<int> &out) const;
+    Cluster makeCluster(int nodeId) const;
+
+    int m_minZoom;
+    int m_maxZoom;
+    double m_radiusPx;
+    int m_extentPx;
+
+    QVector<Node> m_nodes;
+    QVector<QString> m_facilityIds;       // 叶子只保留聚类显示所需的最少字段
+    QVector<QString> m_facilityTypes;
+    QVector<KdTree> m_trees;              // 下标为 zoom，大小 maxZoom + 2
+    QVector<QVector<int>> m_overflow;     // 增量插入但尚未进入KD树的节点（按层级）
+    int m_leafCount;
+    int m_overflowCount;
+};
+
+#endif // FACILITYCLUSTERINDEX_H
@@ -0,0 +1,135 @@
+#include "map/facilityclusteritem.h"
+#include "map/symbolmanager.h"
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+#include <QtMath>
+
+FacilityClusterItem::FacilityClusterItem(SymbolManager *symbolManager, QGraphicsItem *parent)
+    : QGraphicsItem(parent)
+    , m_index(nullptr)
+    , m_symbolManager(symbolManager)
+    , m_zoom(10)
+    , m_tileSize(256)
+{
+    // 需要 exposedRect 才能只查询可见范围
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption, true);
+    setData(0, "facility_cluster");  // 不属于实体，点选/编辑逻辑会忽略
+    setZValue(20);
+}
+
+void FacilityClusterItem::setIndex(const FacilityClusterIndex *index)
+{
+    m_index = index;
+    update();
+}
+
+void FacilityClusterItem::setZoom(int zoom, int tileSize)
+{
+    if (zoom == m_zoom && tileSize == m_tileSize) {
+        return;
+    }
+    prepareGeometryChange();
+    m_zoom = zoom;
+    m_tileSize = tileSize;
+}
+
+double FacilityClusterItem::worldSize() const
+{
+    return double(m_tileSize) * (1 << m_zoom);
+}
+
+double FacilityClusterItem::markerRadius(int count) const
+{
+    if (count <= 1) {
+        return 5.0;
+    }
+    // 对数增长，避免大聚类遮挡整片区域
+    return qMin(MAX_MARKER_RADIUS, 10.0 + 6.0 * std::log10(double(count)));
+}
+
+QRectF FacilityClusterItem::boundingRect() const
+{
+    double size = worldSize();
+    return QRectF(-MAX_MARKER_RADIUS, -MAX_MARKER_RADIUS,
+                  size + 2 * MAX_MARKER_RADIUS, size + 2 * MAX_MARKER_RADIUS);
+}
+
+QPointF FacilityClusterItem::clusterScenePos(const FacilityClusterIndex::Cluster &cluster) const
+{
+    double size = worldSize();
+    return QPointF(cluster.x * size, cluster.y * size);
+}
+
+FacilityClusterIndex::Cluster FacilityClusterItem::clusterAt(const QPointF &scenePos) const
+{
+    if (!m_index) {
+        FacilityClusterIndex::Cluster none;
+        none.x = 0;
+        none.y = 0;
+        none.count = 0;
+        none.nodeId = -1;
+        return none;
+    }
+
+    double size = worldSize();
+    QPointF norm(scenePos.x() / size, scenePos.y() / size);
+    return m_index->clusterAt(norm, MAX_MARKER_RADIUS / size, m_zoom);
+}
+
+void FacilityClusterItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
+                                QWidget *widget)
+{
+    Q_UNUSED(widget);
+
+    if (!m_index || m_index->size() == 0) {
+        return;
+    }
+
+    // 1. 暴露区域 -> 归一化范围（外扩一个标记半径，避免边缘裁切）
+    double size = worldSize();
+    QRectF exposed = option->exposedRect.adjusted(-MAX_MARKER_RADIUS, -MAX_MARKER_RADIUS,
+                                                  MAX_MARKER_RADIUS, MAX_MARKER_RADIUS);
+    QRectF normBounds(exposed.left() / size, exposed.top() / size,
+                      exposed.width() / size, exposed.height() / size);
+
+    // 2. 只绘制可见聚类
+    const QVector<FacilityClusterIndex::Cluster> clusters = m_index->getClusters(normBounds, m_zoom);
+
+    painter->setRenderHint(QPainter::Antialiasing, true);
+    QFont font = painter->font();
+    font.setPixelSize(11);
+    font.setBold(true);
+    painter->setFont(font);
+
+    for (const FacilityClusterIndex::Cluster &cluster : clusters) {
+        QPointF center(cluster.x * size, cluster.y * size);
+        double radius = markerRadius(cluster.count);
+
+        if (cluster.count == 1) {
+            // 单个设施：使用设施类型颜色的小圆点
+            QBrush brush = m_symbolManager ? m_symbolManager->getFacilityBrush(cluster.facilityType)
+                                           : QBrush(Qt::gray);
+            painter->setPen(QPen(Qt::black, 1.0));
+            painter->setBrush(brush);
+            painter->drawEllipse(center, radius, radius);
+            continue;
+        }
+
+        // 聚类：半透明外圈 + 实心内圈 + 数量
+        QColor color = cluster.count < 10 ? QColor("#51BBD6")
+                     : cluster.count < 100 ? QColor("#F1A33C")
+                                           : QColor("#E0515B");
+        QColor halo = color;
+        halo.setAlpha(90);
+
+        painter->setPen(Qt::NoPen);
+        painter->setBrush(halo);
+        painter->drawEllipse(center, radius, radius);
+        painter->setBrush(color);
+        painter->drawEllipse(center, radius - 4, radius - 4);
+
+        painter->setPen(Qt::white);
+        QRectF textRect(center.x() - radius, center.y() - radius, radius * 2, radius * 2);
+        painter->drawText(textRect, Qt::AlignCenter, QString::number(cluster.count));
+    }
+}
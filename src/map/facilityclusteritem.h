@@ -0,0 +1,47 @@
+#ifndef FACILITYCLUSTERITEM_H
+#define FACILITYCLUSTERITEM_H
+
+#include <QGraphicsItem>
+#include "map/facilityclusterindex.h"
+
+class SymbolManager;
+
+/**
+ * @brief 设施聚类图层图形项
+ * 单个图形项绘制当前层级下所有可见聚类，绘制与点选只访问可见范围内的聚类
+ */
+class FacilityClusterItem : public QGraphicsItem
+{
+public:
+    explicit FacilityClusterItem(SymbolManager *symbolManager, QGraphicsItem *parent = nullptr);
+
+    // 设置聚类索引（不持有所有权）
+    void setIndex(const FacilityClusterIndex *index);
+
+    // 设置当前瓦片层级（场景尺寸随层级变化）
+    void setZoom(int zoom, int tileSize);
+    int zoom() const { return m_zoom; }
+
+    // 点选：返回场景坐标处的聚类，未命中时 nodeId == -1
+    FacilityClusterIndex::Cluster clusterAt(const QPointF &scenePos) const;
+
+    // 聚类中心的场景坐标
+    QPointF clusterScenePos(const FacilityClusterIndex::Cluster &cluster) const;
+
+    QRectF boundingRect() const override;
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
+               QWidget *widget = nullptr) override;
+
+private:
+    double worldSize() const;
+    double markerRadius(int count) const;
+
+    const FacilityClusterIndex *m_index;
+    SymbolManager *m_symbolManager;
+    int m_zoom;
+    int m_tileSize;
+
+    static constexpr double MAX_MARKER_RADIUS = 24.0;
+};
+
+#endif // FACILITYCLUSTERITEM_H
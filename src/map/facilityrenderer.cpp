@@ -1,31 +1,237 @@
 #include "map/facilityrenderer.h"
+#include "map/entitygraphicsitem.h"
 #include "map/symbolmanager.h"
 #include "map/pipelinerenderer.h"
+#include "map/facilityclusterindex.h"
+#include "map/facilityclusteritem.h"
+#include "map/layeritemregistry.h"
 #include "dao/facilitydao.h"
+#include "dao/asyncdao.h"
+#include "dao/sqldialect.h"
 #include "tilemap/tilemapmanager.h"
 #include "core/common/logger.h"
 #include "core/common/entitystate.h"  // 实体状态枚举
+#include "core/common/config.h"
 #include <QPen>
 #include <QBrush>
 #include <QtMath>
+#include <QtConcurrent/QtConcurrent>
+#include <algorithm>
 
 FacilityRenderer::FacilityRenderer(QObject *parent)
     : QObject(parent)
     , m_symbolManager(new SymbolManager(this))
-    , m_facilityDao(new FacilityDAO())
+    , m_loader(new AsyncDAO(this))
+    , m_loadRequest(0)
+    , m_loaded(false)
     , m_tileMapManager(nullptr)
+    , m_itemRegistry(nullptr)
     , m_zoom(10)          // 默认缩放级别
     , m_tileSize(256)     // 默认瓦片大小
     , m_mapWidth(0)
     , m_mapHeight(0)
+    , m_clusterIndex(nullptr)
+    , m_clusterItem(nullptr)
+    , m_clusterWatcher(new QFutureWatcher<FacilityClusterIndex*>(this))
+    , m_rebuildQueued(false)
+    , m_layerShown(true)
+    , m_clusterMaxZoom(Config::instance().getInt("Map/cluster_max_zoom", 8))
 {
+    connect(m_clusterWatcher, &QFutureWatcher<FacilityClusterIndex*>::finished,
+            this, &FacilityRenderer::onClusterIndexBuilt);
     updateTileSize();
     LOG_INFO("FacilityRenderer initialized");
 }
 
 FacilityRenderer::~FacilityRenderer()
 {
-    delete m_facilityDao;
+    // 等待后台构建结束，释放其结果
+    if (m_clusterWatcher->isRunning()) {
+        m_clusterWatcher->waitForFinished();
+        delete m_clusterWatcher->result();
+    }
+    // 聚类图形项由场景持有，这里只断开索引引用
+    if (m_clusterItem) {
+        m_clusterItem->setIndex(nullptr);
+    }
+    delete m_clusterIndex;
+}
+
+void FacilityRenderer::setZoom(int zoom)
+{
+    m_zoom = zoom;
+    updateTileSize();
+    
+    if (m_clusterItem) {
+        m_clusterItem->setZoom(zoom, m_tileSize);
+    }
+    applyClusterVisibility();
+}
+
+void FacilityRenderer::showLayer()
+{
+    m_layerShown = true;
+    applyClusterVisibility();
+}
+
+bool FacilityRenderer::isClustered() const
+{
+    return m_clusterIndex && m_zoom <= m_clusterMaxZoom;
+}
+
+int FacilityRenderer::expansionZoom(int nodeId) const
+{
+    return m_clusterIndex ? m_clusterIndex->expansionZoom(nodeId) : m_clusterMaxZoom + 1;
+}
+
+void FacilityRenderer::applyClusterVisibility()
+{
+    bool clustered = isClustered();
+    
+    // 低层级：只显示聚类图层，隐藏单体设施；高层级反之
+    if (m_clusterItem) {
+        m_clusterItem->setVisible(m_layerShown && clustered);
+    }
+    // 有注册表时包含用户新绘制的设施（它们同样进入了聚类索引）
+    const QList<QGraphicsItem*> items = m_itemRegistry
+        ? m_itemRegistry->items(LayerManager::Facilities)
+        : m_itemsCache;
+    for (QGraphicsItem *item : items) {
+        if (item) {
+            item->setVisible(m_layerShown && !clustered);
+        }
+    }
+}
+
+void FacilityRenderer::buildClusterIndexAsync()
+{
+    if (m_clusterWatcher->isRunning()) {
+        // 当前构建完成后再以最新数据重建
+        m_rebuildQueued = true;
+        return;
+    }
+    
+    m_rebuildQueued = false;
+    m_pendingInserts.clear();
+    
+    const QVector<FacilityRenderRecord> facilities = m_clusterSource;
+    const int minZoom = 3;
+    const int maxZoom = m_clusterMaxZoom;
+    m_clusterWatcher->setFuture(QtConcurrent::run([facilities, minZoom, maxZoom]() {
+        FacilityClusterIndex *index = new FacilityClusterIndex(minZoom, maxZoom);
+        index->build(facilities);
+        return index;
+    }));
+    
+    LOG_DEBUG(QString("Building facility cluster index in background: %1 facilities").arg(facilities.size()));
+}
+
+void FacilityRenderer::onClusterIndexBuilt()
+{
+    FacilityClusterIndex *index = m_clusterWatcher->result();
+    
+    if (m_rebuildQueued) {
+        // 数据已变化，丢弃本次结果
+        delete index;
+        buildClusterIndexAsync();
+        return;
+    }
+    
+    if (m_clusterItem) {
+        m_clusterItem->setIndex(index);
+    }
+    delete m_clusterIndex;
+    m_clusterIndex = index;
+    
+    // 应用构建期间到达的增量插入
+    for (const FacilityRenderRecord &facility : m_pendingInserts) {
+        m_clusterIndex->insert(facility);
+    }
+    m_pendingInserts.clear();
+    
+    LOG_INFO(QString("Facility cluster index built: %1 facilities").arg(m_clusterIndex->size()));
+    
+    applyClusterVisibility();
+    if (m_clusterItem) {
+        m_clusterItem->update();
+    }
+}
+
+void FacilityRenderer::insertFacility(const FacilityRenderRecord &facility)
+{
+    if (facility.coordinate.isNull()) {
+        return;
+    }
+    
+    m_clusterSource.append(facility);
+    
+    if (m_clusterWatcher->isRunning()) {
+        m_pendingInserts.append(facility);
+        return;
+    }
+    if (!m_clusterIndex) {
+        return;  // 尚未加载设施数据，首次渲染时会一并构建
+    }
+    
+    m_clusterIndex->insert(facility);
+    if (m_clusterItem) {
+        m_clusterItem->update();
+    }
+    
+    // 增量插入过多时聚类质量下降，后台重建
+    if (m_clusterIndex->needsRebuild()) {
+        buildClusterIndexAsync();
+    }
+}
+
+QGraphicsEllipseItem* FacilityRenderer::insertFacilityItem(QGraphicsScene *scene,
+                                                           const FacilityRenderRecord &facility)
+{
+    QGraphicsEllipseItem *item = renderFacility(scene, facility);
+    if (!item) {
+        return nullptr;
+    }
+    
+    m_itemsCache.append(item);
+    item->setVisible(m_layerShown && !isClustered());
+    insertFacility(facility);
+    return item;
+}
+
+void FacilityRenderer::removeFacilityItem(QGraphicsScene *scene, QGraphicsItem *item)
+{
+    if (!item) {
+        return;
+    }
+    
+    const EntityGraphicsItem *entity = EntityGraphicsItem::fromItem(item);
+    const int databaseId = entity ? entity->databaseId() : 0;
+    
+    m_itemsCache.removeOne(item);
+    if (m_itemRegistry) {
+        m_itemRegistry->removeItem(item);
+    }
+    if (scene) {
+        scene->removeItem(item);
+    }
+    delete item;
+    
+    if (databaseId <= 0) {
+        return;
+    }
+    auto removed = std::remove_if(m_clusterSource.begin(), m_clusterSource.end(),
+                                  [databaseId](const FacilityRenderRecord &record) {
+                                      return record.id == databaseId;
+                                  });
+    if (removed == m_clusterSource.end()) {
+        return;
+    }
+    m_clusterSource.erase(removed, m_clusterSource.end());
+    
+    // 已构建过索引时才重建（首次渲染会以全量数据构建）
+    if (m_clusterIndex || m_clusterWatcher->isRunning()) {
+        buildClusterIndexAsync();
+    }
 }
 
 void FacilityRenderer::renderFacilities(QGraphicsScene *scene, const QRectF &bounds)
@@ -39,11 +245,41 @@ void FacilityRenderer::renderFacilities(QGraphicsScene *scene, const QRectF &bou
     qDebug() << "[FacilityRenderer] renderFacilities called";
     qDebug() << "[FacilityRenderer] Bounds:" << bounds;
     
+    // 1. 后台加载设施渲染投影（只取渲染所需列），完成后在界面线程渲染
+    // 重复请求时只渲染最后一次的结果
+    const quint64 request = ++m_loadRequest;
+    
+    // 加载全部设施（按 id 键集分页，不截断）：图形项在平移缩放时保留在场景中，
+    // 聚类索引也需要全量设施才能得到正确的聚类计数
+    m_loader->run([]() {
+        return FacilityDAO().loadRenderRecords();
+    }, [this, scene, request](const QVector<FacilityRenderRecord> &facilities) {
+        if (request == m_loadRequest) {
+            renderRecords(scene, facilities);
+        }
+    });
+}
+
+bool FacilityRenderer::isLoading() const
+{
+    return m_loader->isBusy();
+}
+
+void FacilityRenderer::renderRecords(QGraphicsScene *scene, const QVector<FacilityRenderRecord> &facilities)
+{
+    LOG_INFO(QString("Loaded %1 facilities").arg(facilities.size()));
+    qDebug() << "[FacilityRenderer] Found" << facilities.size() << "facilities";
+    
+    m_loaded = true;
+    
     // 如果缓存中已有项，先清除（避免重复）
     if (!m_itemsCache.isEmpty()) {
         qDebug() << "[FacilityRenderer] Clearing existing cache before re-rendering";
         for (QGraphicsItem *item : m_itemsCache) {
             if (item && scene) {
+                if (m_itemRegistry) {
+                    m_itemRegistry->removeItem(item);
+                }
                 scene->removeItem(item);
                 delete item;
             }
@@ -51,24 +287,16 @@ void FacilityRenderer::renderFacilities(QGraphicsScene *scene, const QRectF &bou
         m_itemsCache.clear();
     }
     
-    // 1. 从数据库加载设施数据
-    QVector<Facility> facilities;
-    
-    // 临时：先不使用 bounds 查询，直接查询所有设施来测试
-    qDebug() << "[FacilityRenderer] Querying all facilities (ignore bounds for now)...";
-    facilities = m_facilityDao->findAll(1000);
-    LOG_INFO(QString("Loaded %1 facilities").arg(facilities.size()));
-    qDebug() << "[FacilityRenderer] Found" << facilities.size() << "facilities";
-    
     if (facilities.isEmpty()) {
         LOG_WARNING("No facilities found");
+        emit renderComplete(0);
         return;
     }
     
     // 2. 渲染每个设施
     int rendered = 0;
     for (int i = 0; i < facilities.size(); i++) {
-        const Facility &facility = facilities[i];
+        const FacilityRenderRecord &facility = facilities[i];
         
         QGraphicsEllipseItem *item = renderFacility(scene, facility);
         if (item) {
@@ -86,6 +314,20 @@ void FacilityRenderer::renderFacilities(QGraphicsScene *scene, const QRectF &bou
     emit renderComplete(rendered);
     
     LOG_INFO(QString("Rendered %1 facilities successfully").arg(rendered));
+    
+    // 3. 聚类图层（低层级时替代单体设施显示）
+    if (!m_clusterItem) {
+        m_clusterItem = new FacilityClusterItem(m_symbolManager);
+        m_clusterItem->setIndex(m_clusterIndex);
+        m_clusterItem->setVisible(false);
+        scene->addItem(m_clusterItem);
+    }
+    m_clusterItem->setZoom(m_zoom, m_tileSize);
+    m_layerShown = true;
+    
+    m_clusterSource = facilities;
+    buildClusterIndexAsync();
+    applyClusterVisibility();
 }
 
 void FacilityRenderer::renderFacilitiesByType(QGraphicsScene *scene,
@@ -99,45 +341,49 @@ void FacilityRenderer::renderFacilitiesByType(QGraphicsScene *scene,
     
     LOG_INFO(QString("Rendering facilities of type: %1").arg(facilityType));
     
-    // 1. 从数据库加载指定类型的设施
-    QVector<Facility> facilities;
+    // 1. 从数据库加载指定类型的设施（给定边界时同时按边界过滤，不截断）
+    QString whereClause = "facility_type = :type";
+    QVariantMap params;
+    params[":type"] = facilityType;
     
     if (bounds.isValid() && !bounds.isEmpty()) {
-        // 先按边界查询，再过滤类型
-        facilities = m_facilityDao->findByBounds(bounds);
-    } else {
-        facilities = m_facilityDao->findByType(facilityType);
+        whereClause += " AND " + SqlDialect::current().withinBoundsFilter("facilities");
+        SqlDialect::bindBounds(params, bounds);
     }
     
-    // 2. 渲染
-    int rendered = 0;
-    for (const Facility &facility : facilities) {
-        if (facility.facilityType() == facilityType) {
-            QGraphicsEllipseItem *item = renderFacility(scene, facility);
-            if (item) {
-                m_itemsCache.append(item);
-                rendered++;
+    // 2. 后台查询，完成后在界面线程渲染
+    m_loader->run([whereClause, params]() {
+        return FacilityDAO().loadRenderRecords(whereClause, params);
+    }, [this, scene, facilityType](const QVector<FacilityRenderRecord> &facilities) {
+        int rendered = 0;
+        for (const FacilityRenderRecord &facility : facilities) {
+            if (facility.facilityType == facilityType) {
+                QGraphicsEllipseItem *item = renderFacility(scene, facility);
+                if (item) {
+                    m_itemsCache.append(item);
+                    rendered++;
+                }
             }
         }
-    }
-    
-    emit renderComplete(rendered);
-    LOG_INFO(QString("Rendered %1 facilities of type %2")
-                 .arg(rendered).arg(facilityType));
+        
+        emit renderComplete(rendered);
+        LOG_INFO(QString("Rendered %1 facilities of type %2")
+                     .arg(rendered).arg(facilityType));
+    });
 }
 
 QGraphicsEllipseItem* FacilityRenderer::renderFacility(QGraphicsScene *scene,
-                                                       const Facility &facility)
+                                                       const FacilityRenderRecord &facility)
 {
     if (!scene || !facility.isValid()) {
         return nullptr;
     }
     
     // 检查坐标是否有效
-    QPointF geoCoord = facility.coordinate();
+    QPointF geoCoord = facility.coordinate;
     if (geoCoord.isNull()) {
         LOG_WARNING(QString("Facility %1 has null coordinates")
-                        .arg(facility.facilityId()));
+                        .arg(facility.facilityId));
         return nullptr;
     }
     
@@ -145,45 +391,51 @@ QGraphicsEllipseItem* FacilityRenderer::renderFacility(QGraphicsScene *scene,
     QPointF scenePos = geoToScene(geoCoord);
     
     // 2. 获取样式
-    int size = m_symbolManager->getFacilityIconSize(facility.facilityType());
-    QBrush brush = m_symbolManager->getFacilityBrush(facility.facilityType());
+    int size = m_symbolManager->getFacilityIconSize(facility.facilityType);
+    QBrush brush = m_symbolManager->getFacilityBrush(facility.facilityType);
     QPen pen(Qt::black, 1.5);
     
     // 根据健康度调整外框颜色
-    if (facility.healthScore() < 60) {
+    if (facility.healthScore < 60) {
         pen.setColor(Qt::red);
         pen.setWidth(2);
-    } else if (facility.healthScore() < 80) {
+    } else if (facility.healthScore < 80) {
         pen.setColor(Qt::darkYellow);
     }
     
     // 3. 创建圆形图标
     qreal radius = size / 2.0;
-    QGraphicsEllipseItem *item = scene->addEllipse(
+    FacilityGraphicsItem *item = new FacilityGraphicsItem(QRectF(
         scenePos.x() - radius,
         scenePos.y() - radius,
         size,
-        size,
-        pen,
-        brush
-    );
-    
-    // 4. 设置数据（与 DrawingDatabaseManager 保持一致）
-    item->setData(0, "facility");  // 类型标记
-    item->setData(1, facility.facilityId());  // 设施编号（与 DrawingDatabaseManager 保持一致）
-    item->setData(2, facility.facilityType());  // 设施类型
-    item->setData(10, facility.id());  // 数据库ID（存储在 data(10)）
-    item->setData(100, static_cast<int>(EntityState::Unchanged));  // 实体状态：未变更
+        size
+    ));
+    item->setPen(pen);
+    item->setBrush(brush);
+    scene->addItem(item);
+    
+    // 4. 设置实体字段（与 DrawingDatabaseManager 保持一致）
+    item->setEntityId(facility.facilityId);  // 设施编号
+    item->setEntityType(facility.facilityType);  // 设施类型
+    item->setName(facility.facilityName);  // 设施名称（用于标注显示）
+    item->setDatabaseId(facility.id);  // 数据库ID
+    item->setState(EntityState::Unchanged);  // 实体状态：未变更
+    
+    // 登记到图层注册表
+    if (m_itemRegistry) {
+        m_itemRegistry->addItem(LayerManager::Facilities, item);
+    }
     
     // 5. 设置工具提示
     QString tooltip = QString("%1\n类型: %2\n规格: %3\n健康度: %4分")
-                          .arg(facility.getDisplayName())
-                          .arg(facility.getTypeDisplayName())
-                          .arg(facility.spec())
-                          .arg(facility.healthScore());
+                          .arg(facility.displayName())
+                          .arg(Facility::typeDisplayName(facility.facilityType))
+                          .arg(facility.spec)
+                          .arg(facility.healthScore);
     
-    if (!facility.pipelineId().isEmpty()) {
-        tooltip += QString("\n关联管线: %1").arg(facility.pipelineId());
+    if (!facility.pipelineId.isEmpty()) {
+        tooltip += QString("\n关联管线: %1").arg(facility.pipelineId);
     }
     
     item->setToolTip(tooltip);
@@ -210,11 +462,15 @@ void FacilityRenderer::clear(QGraphicsScene *scene)
     }
     
     // 只隐藏图形项，不删除（保留在缓存中，以便后续显示）
+    m_layerShown = false;
     for (QGraphicsItem *item : m_itemsCache) {
         if (item) {
             item->setVisible(false);
         }
     }
+    if (m_clusterItem) {
+        m_clusterItem->setVisible(false);
+    }
     
     // 不清除缓存，保留项以便后续显示
     // m_itemsCache.clear();
@@ -6,11 +6,15 @@
 #include <QGraphicsEllipseItem>
 #include <QRectF>
 #include <QVector>
-#include "core/models/facility.h"
+#include <QFutureWatcher>
+#include "core/models/renderrecord.h"
 
 class SymbolManager;
-class FacilityDAO;
+class AsyncDAO;
 class TileMapManager;
+class LayerItemRegistry;
+class FacilityClusterIndex;
+class FacilityClusterItem;
 
 /**
  * @brief 设施渲染器
@@ -24,17 +28,17 @@ public:
     explicit FacilityRenderer(QObject *parent = nullptr);
     ~FacilityRenderer();
 
-    // 渲染所有设施
+    // 渲染所有设施（后台查询，结果返回后在界面线程渲染并发出 renderComplete）
     void renderFacilities(QGraphicsScene *scene, const QRectF &bounds = QRectF());
     
-    // 渲染指定类型的设施
+    // 渲染指定类型的设施（后台查询，结果返回后在界面线程渲染并发出 renderComplete）
     void renderFacilitiesByType(QGraphicsScene *scene, 
                                const QString &facilityType,
                                const QRectF &bounds = QRectF());
     
-    // 渲染单个设施
+    // 渲染单个设施（渲染投影记录）
     QGraphicsEllipseItem* renderFacility(QGraphicsScene *scene, 
-                                        const Facility &facility);
+                                        const FacilityRenderRecord &facility);
     
     // 清除所有设施
     void clear(QGraphicsScene *scene);
@@ -42,24 +46,60 @@ public:
     // 获取缓存中的图形项
     QList<QGraphicsItem*> getCachedItems() const;
     
+    // 是否有尚未完成的后台加载
+    bool isLoading() const;
+    
+    // 是否已完成过整层加载（结果为空也算已加载）
+    bool isLoaded() const { return m_loaded; }
+    
     // 设置瓦片地图管理器（用于坐标转换）
     void setTileMapManager(TileMapManager *tileMapManager) { m_tileMapManager = tileMapManager; }
     
-    // 设置缩放级别（用于坐标转换）
-    void setZoom(int zoom) { m_zoom = zoom; updateTileSize(); }
+    // 设置图层图形项注册表（创建/删除图形项时同步登记）
+    void setItemRegistry(LayerItemRegistry *registry) { m_itemRegistry = registry; }
+    
+    // 设置缩放级别（用于坐标转换，同时切换聚类/单体显示）
+    void setZoom(int zoom);
     int getZoom() const { return m_zoom; }
     
     // 设置瓦片大小
     void setTileSize(int tileSize) { m_tileSize = tileSize; }
+    
+    // 增量加入一个新设施到聚类索引（如新绘制的设施）
+    void insertFacility(const FacilityRenderRecord &facility);
+    
+    // 增量插入一个设施图形项（远程变更）：渲染、登记缓存并加入聚类索引
+    QGraphicsEllipseItem* insertFacilityItem(QGraphicsScene *scene, const FacilityRenderRecord &facility);
+    
+    // 增量删除设施图形项，同时从聚类数据中移除（聚类索引不支持删除，后台重建）
+    void removeFacilityItem(QGraphicsScene *scene, QGraphicsItem *item);
+    
+    // 显示设施图层（按当前层级在聚类与单体设施之间切换）
+    void showLayer();
+    
+    // 获取聚类图层图形项（用于点选聚类）
+    FacilityClusterItem* clusterItem() const { return m_clusterItem; }
+    
+    // 当前层级是否以聚类方式显示
+    bool isClustered() const;
+    
+    // 聚类展开所需的层级
+    int expansionZoom(int nodeId) const;
 
 signals:
     void renderProgress(int current, int total);
     void renderComplete(int count);
 
+private slots:
+    void onClusterIndexBuilt();
+
 private:
     SymbolManager *m_symbolManager;
-    FacilityDAO *m_facilityDao;
+    AsyncDAO *m_loader;
+    quint64 m_loadRequest;    // 最近一次加载请求的序号（旧请求的结果不再渲染）
+    bool m_loaded;            // 是否已完成过整层加载
     TileMapManager *m_tileMapManager;
+    LayerItemRegistry *m_itemRegistry;
     
     // 图形项缓存
     QList<QGraphicsItem*> m_itemsCache;
@@ -70,9 +110,28 @@ private:
     int m_mapWidth;       // 地图总宽度（像素）
     int m_mapHeight;      // 地图总高度（像素）
     
+    // 聚类索引
+    FacilityClusterIndex *m_clusterIndex;
+    FacilityClusterItem *m_clusterItem;
+    QFutureWatcher<FacilityClusterIndex*> *m_clusterWatcher;
+    QVector<FacilityRenderRecord> m_clusterSource;   // 索引的全量数据（用于重建）
+    QVector<FacilityRenderRecord> m_pendingInserts;  // 构建期间到达的增量插入
+    bool m_rebuildQueued;                     // 构建期间收到新的重建请求
+    bool m_layerShown;                        // 设施图层是否显示
+    int m_clusterMaxZoom;                     // 不高于该层级时显示聚类
+    
     // 更新地图尺寸
     void updateTileSize();
     
+    // 渲染一批查询结果（替换已有设施图形项并重建聚类索引）
+    void renderRecords(QGraphicsScene *scene, const QVector<FacilityRenderRecord> &facilities);
+    
+    // 后台构建聚类索引
+    void buildClusterIndexAsync();
+    
+    // 按当前层级应用聚类/单体显示
+    void applyClusterVisibility();
+    
     // 坐标转换
     QPointF geoToScene(const QPointF &geoPoint) const;
 };
@@ -0,0 +1,51 @@
+#include "map/heatmaplayeritem.h"
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+
+HeatmapLayerItem::HeatmapLayerItem(QGraphicsItem *parent)
+    : QGraphicsItem(parent)
+{
+    setAcceptedMouseButtons(Qt::NoButton);
+    setAcceptHoverEvents(false);
+    setData(0, "heatmap");
+    // 位于管线之上、设施聚类与标注之下
+    setZValue(15);
+}
+
+void HeatmapLayerItem::setRaster(const QImage &image, const QRectF &sceneRect)
+{
+    prepareGeometryChange();
+    m_image = image;
+    m_sceneRect = sceneRect;
+    update();
+}
+
+void HeatmapLayerItem::clearRaster()
+{
+    prepareGeometryChange();
+    m_image = QImage();
+    m_sceneRect = QRectF();
+}
+
+QRectF HeatmapLayerItem::boundingRect() const
+{
+    return m_sceneRect;
+}
+
+QPainterPath HeatmapLayerItem::shape() const
+{
+    return QPainterPath();
+}
+
+void HeatmapLayerItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
+                             QWidget *widget)
+{
+    Q_UNUSED(option);
+    Q_UNUSED(widget);
+
+    if (m_image.isNull()) {
+        return;
+    }
+    painter->setRenderHint(QPainter::SmoothPixmapTransform, true);
+    painter->drawImage(m_sceneRect, m_image);
+}
@@ -0,0 +1,29 @@
+#ifndef HEATMAPLAYERITEM_H
+#define HEATMAPLAYERITEM_H
+
+#include <QGraphicsItem>
+#include <QImage>
+
+/**
+ * @brief 热力图图层图形项
+ * 将密度栅格拉伸绘制到其覆盖的场景范围，不参与点选
+ */
+class HeatmapLayerItem : public QGraphicsItem
+{
+public:
+    explicit HeatmapLayerItem(QGraphicsItem *parent = nullptr);
+
+    void setRaster(const QImage &image, const QRectF &sceneRect);
+    void clearRaster();
+
+    QRectF boundingRect() const override;
+    QPainterPath shape() const override;  // 空形状：不参与点选
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
+               QWidget *widget = nullptr) override;
+
+private:
+    QImage m_image;
+    QRectF m_sceneRect;
+};
+
+#endif // HEATMAPLAYERITEM_H
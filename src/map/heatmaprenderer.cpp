@@ -0,0 +1,538 @@
+#include "map/heatmaprenderer.h"
+#include "map/heatmaplayeritem.h"
+#include "map/layeritemregistry.h"
+#include "map/layermanager.h"
+#include "dao/pipelinedao.h"
+#include "dao/asyncdao.h"
+#include "core/database/databasemanager.h"
+#include "core/common/logger.h"
+#include "core/common/config.h"
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QThreadPool>
+#include <QtMath>
+#include <QtConcurrent/QtConcurrent>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace {
+// 密度网格最大边长（格）
+const int MAX_GRID_SIZE = 1024;
+// 并行分段的最小行数
+const int MIN_BAND_ROWS = 32;
+
+// 经纬度 -> 归一化墨卡托坐标（与 TileMapManager::geoToScene 一致，乘以 256·2^z 即场景坐标）
+QPointF geoToNormalized(double lon, double lat)
+{
+    lat = qBound(-85.05112878, lat, 85.05112878);
+    double x = (lon + 180.0) / 360.0;
+    double latRad = lat * M_PI / 180.0;
+    double y = (1.0 - std::log(std::tan(latRad) + 1.0 / std::cos(latRad)) / M_PI) / 2.0;
+    return QPointF(x, y);
+}
+
+// 故障严重程度权重
+float severityWeight(const QString &severity)
+{
+    if (severity == "critical") {
+        return 4.0f;
+    } else if (severity == "high") {
+        return 3.0f;
+    } else if (severity == "low") {
+        return 1.0f;
+    }
+    return 2.0f;  // medium / 未填写
+}
+
+// 按行划分并行分段
+QVector<QPair<int, int>> rowBands(int rows)
+{
+    int bands = qBound(1, rows / MIN_BAND_ROWS, QThreadPool::globalInstance()->maxThreadCount());
+    QVector<QPair<int, int>> ranges;
+    int step = (rows + bands - 1) / bands;
+    for (int begin = 0; begin < rows; begin += step) {
+        ranges.append(qMakePair(begin, qMin(rows, begin + step)));
+    }
+    return ranges;
+}
+
+// 热力色带（透明 -> 蓝 -> 青 -> 绿 -> 黄 -> 红），预乘 alpha
+const QVector<QRgb> &heatPalette()
+{
+    static const QVector<QRgb> palette = []() {
+        const QVector<QPair<double, QColor>> stops = {
+            {0.00, QColor(0, 0, 255, 0)},
+            {0.15, QColor(0, 0, 255, 120)},
+            {0.35, QColor(0, 255, 255, 160)},
+            {0.55, QColor(0, 255, 0, 180)},
+            {0.75, QColor(255, 255, 0, 200)},
+            {1.00, QColor(255, 0, 0, 220)}
+        };
+        QVector<QRgb> lut(256);
+        for (int i = 0; i < 256; ++i) {
+            double t = i / 255.0;
+            int s = 1;
+            while (s < stops.size() - 1 && stops[s].first < t) {
+                ++s;
+            }
+            const QColor &a = stops[s - 1].second;
+            const QColor &b = stops[s].second;
+            double f = (t - stops[s - 1].first) / (stops[s].first - stops[s - 1].first);
+            QColor c = QColor::fromRgbF(a.redF() + (b.redF() - a.redF()) * f,
+                                        a.greenF() + (b.greenF() - a.greenF()) * f,
+                                        a.blueF() + (b.blueF() - a.blueF()) * f,
+                                        a.alphaF() + (b.alphaF() - a.alphaF()) * f);
+            lut[i] = qPremultiply(c.rgba());
+        }
+        return lut;
+    }();
+    return palette;
+}
+}
+
+HeatmapRenderer::HeatmapRenderer(QObject *parent)
+    : QObject(parent)
+    , m_scene(nullptr)
+    , m_itemRegistry(nullptr)
+    , m_layerItem(nullptr)
+    , m_loader(new AsyncDAO(this))
+    , m_sourceProbe(0)
+    , m_sourceLoaded(false)
+    , m_dataVersion(0)
+    , m_sampleCount(0)
+    , m_watcher(new QFutureWatcher<HeatmapRaster>(this))
+    , m_rasterPending(false)
+    , m_zoom(10)
+    , m_radius(Config::instance().getInt("Map/heatmap_radius_px", 32))
+    , m_healthThreshold(Config::instance().getInt("Map/heatmap_health_threshold", 60))
+    , m_visible(false)
+{
+    // 每级约 4MB，保留最近几个缩放级别
+    m_rasters.setMaxCost(32 * 1024);
+    connect(m_watcher, &QFutureWatcher<HeatmapRaster>::finished,
+            this, &HeatmapRenderer::onRasterFinished);
+    LOG_INFO("HeatmapRenderer initialized");
+}
+
+HeatmapRenderer::~HeatmapRenderer()
+{
+    if (m_watcher->isRunning()) {
+        m_watcher->waitForFinished();
+    }
+    if (m_layerItem && m_scene) {
+        m_scene->removeItem(m_layerItem);
+    }
+    if (m_layerItem && m_itemRegistry) {
+        m_itemRegistry->removeItem(m_layerItem);
+    }
+    delete m_layerItem;
+}
+
+void HeatmapRenderer::setScene(QGraphicsScene *scene)
+{
+    if (m_scene == scene) {
+        return;
+    }
+    if (m_layerItem && m_scene) {
+        m_scene->removeItem(m_layerItem);
+    }
+    m_scene = scene;
+    if (m_layerItem && m_scene) {
+        m_scene->addItem(m_layerItem);
+    }
+}
+
+void HeatmapRenderer::ensureLayerItem()
+{
+    if (m_layerItem || !m_scene) {
+        return;
+    }
+    m_layerItem = new HeatmapLayerItem();
+    m_scene->addItem(m_layerItem);
+    if (m_itemRegistry) {
+        m_itemRegistry->addItem(LayerManager::Heatmap, m_layerItem);
+    }
+}
+
+void HeatmapRenderer::setZoom(int zoom)
+{
+    if (m_zoom == zoom) {
+        return;
+    }
+    m_zoom = zoom;
+    if (m_visible) {
+        scheduleRaster();
+    }
+}
+
+void HeatmapRenderer::setRadius(double radius)
+{
+    radius = qMax(1.0, radius);
+    if (qFuzzyCompare(m_radius, radius)) {
+        return;
+    }
+    m_radius = radius;
+    if (m_visible) {
+        scheduleRaster();
+    }
+}
+
+void HeatmapRenderer::renderHeatmap()
+{
+    if (!m_scene) {
+        LOG_WARNING("Cannot render heatmap: scene is null");
+        return;
+    }
+
+    ensureLayerItem();
+    m_visible = true;
+    if (m_layerItem) {
+        m_layerItem->setVisible(true);
+    }
+
+    // 已有数据源时先显示（缓存命中时无需等待），再在后台探测数据是否变化
+    scheduleRaster();
+    requestSource();
+}
+
+void HeatmapRenderer::clear()
+{
+    m_visible = false;
+    m_rasterPending = false;
+    if (m_layerItem) {
+        m_layerItem->setVisible(false);
+    }
+}
+
+void HeatmapRenderer::requestSource()
+{
+    const int threshold = m_healthThreshold;
+    const quint64 generation = PipelineDAO::cache().generation();
+    const quint64 knownProbe = m_sourceProbe;
+
+    // 只保留最近一次请求
+    m_loader->cancelAll();
+    m_loader->run([threshold, generation, knownProbe]() {
+        HeatmapSourceLoad load;
+        load.probe = probeSource(threshold, generation);
+        if (load.probe == 0 || load.probe != knownProbe) {
+            load.source = loadSource(threshold);
+            load.dataVersion = sourceVersion(load.source);
+            load.loaded = true;
+        }
+        return load;
+    }, [this](const HeatmapSourceLoad &load) {
+        onSourceLoaded(load);
+    });
+}
+
+void HeatmapRenderer::onSourceLoaded(const HeatmapSourceLoad &load)
+{
+    m_sourceProbe = load.probe;
+    if (!load.loaded) {
+        return;
+    }
+
+    const bool firstLoad = !m_sourceLoaded;
+    m_sourceLoaded = true;
+    m_sampleCount = load.source.points.size() + load.source.lines.size();
+    if (!firstLoad && load.dataVersion == m_dataVersion) {
+        return;
+    }
+
+    m_dataVersion = load.dataVersion;
+    m_source = load.source;
+    LOG_INFO(QString("Heatmap data reloaded: %1 fault points, %2 pipelines below health %3")
+                 .arg(m_source.points.size()).arg(m_source.lines.size()).arg(m_healthThreshold));
+    scheduleRaster();
+}
+
+quint64 HeatmapRenderer::probeSource(int healthThreshold, quint64 pipelineGeneration)
+{
+    // 故障报修不在变更通知范围内，按数量与最大更新时间探测（删除改变数量，更新由触发器刷新 updated_at）；
+    // 管线的本地写入与远程变更均递增实体缓存代数
+    QString faults;
+    bool ok = DatabaseManager::instance().executePrepared(
+        "SELECT COUNT(*), MAX(updated_at) FROM fault_reports WHERE location IS NOT NULL",
+        QVariantMap(), [&faults](QSqlQuery &query) {
+        if (query.next()) {
+            faults = QString("%1|%2").arg(query.value(0).toLongLong())
+                                     .arg(query.value(1).toDateTime().toString(Qt::ISODateWithMs));
+        }
+    });
+    if (!ok) {
+        LOG_WARNING(QString("Heatmap version probe failed: %1").arg(DatabaseManager::instance().lastError()));
+        return 0;
+    }
+
+    const QString key = QString("%1|%2|%3").arg(faults).arg(pipelineGeneration).arg(healthThreshold);
+    return qMax<quint64>(1, quint64(qHash(key)));
+}
+
+HeatmapSource HeatmapRenderer::loadSource(int healthThreshold)
+{
+    HeatmapSource source;
+
+    // 1. 故障报修点（按严重程度加权）
+    bool ok = DatabaseManager::instance().executePrepared(
+        "SELECT ST_X(location) AS lon, ST_Y(location) AS lat, severity "
+        "FROM fault_reports WHERE location IS NOT NULL",
+        QVariantMap(), [&source](QSqlQuery &query) {
+        while (query.next()) {
+            source.points.append(geoToNormalized(query.value(0).toDouble(), query.value(1).toDouble()));
+            source.pointWeights.append(severityWeight(query.value(2).toString()));
+        }
+    });
+    if (!ok) {
+        LOG_ERROR(QString("Heatmap fault query failed: %1").arg(DatabaseManager::instance().lastError()));
+    }
+
+    // 2. 低健康度管线（渲染投影，按 id 键集分页全量读取；健康度越低权重越大）
+    QVariantMap params;
+    params[":threshold"] = healthThreshold;
+    const QVector<PipelineRenderRecord> pipelines =
+        PipelineDAO().loadRenderRecords("health_score <= :threshold", params);
+    for (const PipelineRenderRecord &pipeline : pipelines) {
+        if (pipeline.coordinates.size() < 2) {
+            continue;
+        }
+        QVector<QPointF> line;
+        line.reserve(pipeline.coordinates.size());
+        for (const QPointF &coord : pipeline.coordinates) {
+            line.append(geoToNormalized(coord.x(), coord.y()));
+        }
+        source.lines.append(line);
+        float deficit = float(healthThreshold - pipeline.healthScore + 1) / float(healthThreshold + 1);
+        source.lineWeights.append(qMax(0.1f, deficit));
+    }
+    return source;
+}
+
+quint64 HeatmapRenderer::sourceVersion(const HeatmapSource &source)
+{
+    // 数据版本：内容不变时沿用缓存栅格
+    size_t hash = qHashBits(source.points.constData(), size_t(source.points.size()) * sizeof(QPointF));
+    hash = hash * 31 + qHashBits(source.pointWeights.constData(), size_t(source.pointWeights.size()) * sizeof(float));
+    hash = hash * 31 + qHashBits(source.lineWeights.constData(), size_t(source.lineWeights.size()) * sizeof(float));
+    for (const QVector<QPointF> &line : source.lines) {
+        hash = hash * 31 + qHashBits(line.constData(), size_t(line.size()) * sizeof(QPointF));
+    }
+    return quint64(hash) ^ (quint64(source.points.size()) << 32) ^ quint64(source.lines.size());
+}
+
+void HeatmapRenderer::scheduleRaster()
+{
+    if (!m_visible || !m_sourceLoaded) {
+        return;
+    }
+
+    // 缓存命中：数据版本与核半径均未变化
+    if (HeatmapRaster *cached = m_rasters.object(m_zoom)) {
+        if (cached->dataVersion == m_dataVersion && qFuzzyCompare(cached->radius, m_radius)) {
+            showRaster(*cached);
+            emit renderComplete(m_sampleCount);
+            return;
+        }
+    }
+
+    if (m_watcher->isRunning()) {
+        // 当前计算完成后再按最新参数重新计算
+        m_rasterPending = true;
+        return;
+    }
+    m_rasterPending = false;
+
+    m_watcher->setFuture(QtConcurrent::run(&HeatmapRenderer::computeRaster,
+                                           m_source, m_zoom, m_radius, m_dataVersion));
+}
+
+void HeatmapRenderer::onRasterFinished()
+{
+    const HeatmapRaster raster = m_watcher->result();
+
+    int cost = qMax(1, int(raster.image.sizeInBytes() / 1024));
+    m_rasters.insert(raster.zoom, new HeatmapRaster(raster), cost);
+
+    LOG_INFO(QString("Heatmap raster computed: zoom %1, %2x%3 cells, %4 ms")
+                 .arg(raster.zoom).arg(raster.image.width()).arg(raster.image.height())
+                 .arg(raster.elapsedMs));
+
+    if (m_rasterPending) {
+        m_rasterPending = false;
+        scheduleRaster();
+        return;
+    }
+
+    if (m_visible && raster.zoom == m_zoom && raster.dataVersion == m_dataVersion) {
+        showRaster(raster);
+        emit renderComplete(m_sampleCount);
+    }
+}
+
+void HeatmapRenderer::showRaster(const HeatmapRaster &raster)
+{
+    ensureLayerItem();
+    if (m_layerItem) {
+        m_layerItem->setRaster(raster.image, raster.sceneRect);
+        m_layerItem->setVisible(m_visible);
+    }
+}
+
+HeatmapRaster HeatmapRenderer::computeRaster(HeatmapSource source, int zoom, double radius, quint64 dataVersion)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    HeatmapRaster raster;
+    raster.zoom = zoom;
+    raster.dataVersion = dataVersion;
+    raster.radius = radius;
+
+    if (source.points.isEmpty() && source.lines.isEmpty()) {
+        return raster;
+    }
+
+    // 1. 数据范围（场景坐标），外扩一个核半径
+    const double worldSize = 256.0 * (1 << zoom);
+    double minX = 1.0, minY = 1.0, maxX = 0.0, maxY = 0.0;
+    auto extend = [&](const QPointF &p) {
+        minX = qMin(minX, p.x());
+        minY = qMin(minY, p.y());
+        maxX = qMax(maxX, p.x());
+        maxY = qMax(maxY, p.y());
+    };
+    for (const QPointF &p : source.points) {
+        extend(p);
+    }
+    for (const QVector<QPointF> &line : source.lines) {
+        for (const QPointF &p : line) {
+            extend(p);
+        }
+    }
+    QRectF sceneRect(minX * worldSize - radius, minY * worldSize - radius,
+                     (maxX - minX) * worldSize + 2 * radius,
+                     (maxY - minY) * worldSize + 2 * radius);
+
+    // 2. 网格尺寸：单元不小于 1 场景像素，边长不超过上限
+    const double cellSize = qMax(1.0, qMax(sceneRect.width(), sceneRect.height()) / MAX_GRID_SIZE);
+    const int width = qMax(1, qCeil(sceneRect.width() / cellSize));
+    const int height = qMax(1, qCeil(sceneRect.height() / cellSize));
+    sceneRect.setSize(QSizeF(width * cellSize, height * cellSize));
+
+    // 3. 累积：点按权重计入所在单元，管线段按单元长度采样（密度与长度成正比）
+    QVector<float> grid(width * height, 0.0f);
+    auto deposit = [&](double sx, double sy, float weight) {
+        int cx = int((sx - sceneRect.left()) / cellSize);
+        int cy = int((sy - sceneRect.top()) / cellSize);
+        if (cx >= 0 && cx < width && cy >= 0 && cy < height) {
+            grid[cy * width + cx] += weight;
+        }
+    };
+    for (int i = 0; i < source.points.size(); ++i) {
+        deposit(source.points[i].x() * worldSize, source.points[i].y() * worldSize, source.pointWeights[i]);
+    }
+    for (int i = 0; i < source.lines.size(); ++i) {
+        const QVector<QPointF> &line = source.lines[i];
+        for (int j = 1; j < line.size(); ++j) {
+            const QPointF a = line[j - 1] * worldSize;
+            const QPointF b = line[j] * worldSize;
+            const double length = std::hypot(b.x() - a.x(), b.y() - a.y());
+            const int steps = qMax(1, qCeil(length / cellSize));
+            const float weight = source.lineWeights[i] * float(length / cellSize / steps);
+            for (int s = 0; s < steps; ++s) {
+                const double t = (s + 0.5) / steps;
+                deposit(a.x() + (b.x() - a.x()) * t, a.y() + (b.y() - a.y()) * t, weight);
+            }
+        }
+    }
+
+    // 4. 可分离高斯核（核半径覆盖 3σ）
+    const double sigma = qMax(0.75, radius / cellSize / 3.0);
+    const int kernelRadius = qMax(1, qCeil(sigma * 3.0));
+    QVector<float> kernel(2 * kernelRadius + 1);
+    double kernelSum = 0.0;
+    for (int i = -kernelRadius; i <= kernelRadius; ++i) {
+        double value = std::exp(-(i * i) / (2.0 * sigma * sigma));
+        kernel[i + kernelRadius] = float(value);
+        kernelSum += value;
+    }
+    for (float &value : kernel) {
+        value = float(value / kernelSum);
+    }
+
+    // 5. 先行后列两次一维卷积，按行分段并行
+    QVector<QPair<int, int>> bands = rowBands(height);
+    QVector<float> temp(width * height, 0.0f);
+    QtConcurrent::blockingMap(bands, [&](const QPair<int, int> &band) {
+        blurRows(grid.constData(), temp.data(), width, band.first, band.second, kernel);
+    });
+    QtConcurrent::blockingMap(bands, [&](const QPair<int, int> &band) {
+        blurColumns(temp.constData(), grid.data(), width, height, band.first, band.second, kernel);
+    });
+
+    // 6. 归一化并着色（平方根拉伸，弱热点也可见）
+    const float maxDensity = *std::max_element(grid.constBegin(), grid.constEnd());
+    QImage image(width, height, QImage::Format_ARGB32_Premultiplied);
+    const QVector<QRgb> &palette = heatPalette();
+    if (maxDensity > 0.0f) {
+        const float scale = 1.0f / maxDensity;
+        QtConcurrent::blockingMap(bands, [&](const QPair<int, int> &band) {
+            for (int y = band.first; y < band.second; ++y) {
+                const float *row = grid.constData() + y * width;
+                QRgb *line = reinterpret_cast<QRgb*>(image.scanLine(y));
+                for (int x = 0; x < width; ++x) {
+                    int index = int(std::sqrt(row[x] * scale) * 255.0f);
+                    line[x] = palette[qBound(0, index, 255)];
+                }
+            }
+        });
+    } else {
+        image.fill(Qt::transparent);
+    }
+
+    raster.image = image;
+    raster.sceneRect = sceneRect;
+    raster.elapsedMs = timer.elapsed();
+    return raster;
+}
+
+void HeatmapRenderer::blurRows(const float *input, float *output, int width, int rowBegin, int rowEnd,
+                               const QVector<float> &kernel)
+{
+    const int kernelRadius = kernel.size() / 2;
+    // 行两端补零，内层循环无边界判断
+    QVector<float> padded(width + 2 * kernelRadius, 0.0f);
+    for (int y = rowBegin; y < rowEnd; ++y) {
+        std::copy(input + y * width, input + (y + 1) * width, padded.begin() + kernelRadius);
+        float *out = output + y * width;
+        std::fill(out, out + width, 0.0f);
+        for (int k = 0; k < kernel.size(); ++k) {
+            const float weight = kernel[k];
+            const float *src = padded.constData() + k;
+            for (int x = 0; x < width; ++x) {
+                out[x] += weight * src[x];
+            }
+        }
+    }
+}
+
+void HeatmapRenderer::blurColumns(const float *input, float *output, int width, int height,
+                                  int rowBegin, int rowEnd, const QVector<float> &kernel)
+{
+    const int kernelRadius = kernel.size() / 2;
+    for (int y = rowBegin; y < rowEnd; ++y) {
+        float *out = output + y * width;
+        std::fill(out, out + width, 0.0f);
+        // 按整行累加，内层循环连续访问
+        const int kBegin = qMax(0, kernelRadius - y);
+        const int kEnd = qMin(kernel.size(), height - y + kernelRadius);
+        for (int k = kBegin; k < kEnd; ++k) {
+            const float weight = kernel[k];
+            const float *src = input + (y + k - kernelRadius) * width;
+            for (int x = 0; x < width; ++x) {
+                out[x] += weight * src[x];
+            }
+        }
+    }
+}
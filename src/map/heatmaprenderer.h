@@ -0,0 +1,136 @@
+#ifndef HEATMAPRENDERER_H
+#define HEATMAPRENDERER_H
+
+#include <QObject>
+#include <QGraphicsScene>
+#include <QCache>
+#include <QFutureWatcher>
+#include <QImage>
+#include <QVector>
+#include <QPointF>
+
+class LayerItemRegistry;
+class HeatmapLayerItem;
+class AsyncDAO;
+
+/**
+ * @brief 热力图数据源（归一化墨卡托坐标，取值 0~1，与缩放级别无关）
+ */
+struct HeatmapSource {
+    QVector<QPointF> points;            // 故障点
+    QVector<float> pointWeights;
+    QVector<QVector<QPointF>> lines;    // 低健康度管线
+    QVector<float> lineWeights;
+};
+
+/**
+ * @brief 热力图数据源加载结果（工作线程）
+ * 版本探测值与上次相同时不读取明细，loaded 为 false
+ */
+struct HeatmapSourceLoad {
+    quint64 probe = 0;
+    bool loaded = false;
+    quint64 dataVersion = 0;
+    HeatmapSource source;
+};
+
+/**
+ * @brief 热力图栅格（某一缩放级别的计算结果）
+ */
+struct HeatmapRaster {
+    int zoom = 0;
+    quint64 dataVersion = 0;
+    double radius = 0;
+    QImage image;           // 着色后的密度栅格
+    QRectF sceneRect;       // 栅格覆盖的场景范围
+    qint64 elapsedMs = 0;
+};
+
+/**
+ * @brief 核密度热力图渲染器
+ * 将故障报修点与低健康度管线段累积到密度网格，用可分离高斯核（先行后列）平滑，
+ * 按色带着色为栅格图像并按缩放级别缓存；只有数据版本或核半径变化时才重新计算
+ *
+ * 数据源在 queryPool 中加载：先以廉价查询探测版本（故障报修的数量与最大 updated_at、
+ * 管线实体缓存代数、健康度阈值），与上次相同时不再读取明细；
+ * 低健康度管线按渲染投影键集分页全量读取
+ *
+ * 网格计算在工作线程中按行分段并行，卷积内层循环按连续内存访问，便于编译器向量化
+ */
+class HeatmapRenderer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit HeatmapRenderer(QObject *parent = nullptr);
+    ~HeatmapRenderer();
+
+    void setScene(QGraphicsScene *scene);
+    void setItemRegistry(LayerItemRegistry *registry) { m_itemRegistry = registry; }
+
+    // 设置图形项场景坐标对应的缩放级别
+    void setZoom(int zoom);
+    int getZoom() const { return m_zoom; }
+
+    // 核半径（场景像素）
+    void setRadius(double radius);
+    double radius() const { return m_radius; }
+
+    // 健康度不高于该阈值的管线参与热力统计
+    void setHealthThreshold(int threshold) { m_healthThreshold = threshold; }
+    int healthThreshold() const { return m_healthThreshold; }
+
+    // 显示当前缩放级别的热力图，并在后台探测数据版本（变化时重新加载，未变化时直接使用缓存栅格）
+    void renderHeatmap();
+    // 隐藏热力图（保留缓存）
+    void clear();
+
+    quint64 dataVersion() const { return m_dataVersion; }
+
+signals:
+    void renderComplete(int sampleCount);
+
+private:
+    void ensureLayerItem();
+    void requestSource();
+    void onSourceLoaded(const HeatmapSourceLoad &load);
+    void scheduleRaster();
+    void onRasterFinished();
+    void showRaster(const HeatmapRaster &raster);
+
+    // 工作线程：版本探测（失败时返回 0）与数据源读取
+    static quint64 probeSource(int healthThreshold, quint64 pipelineGeneration);
+    static HeatmapSource loadSource(int healthThreshold);
+    static quint64 sourceVersion(const HeatmapSource &source);
+
+    // 工作线程：累积 -> 高斯平滑 -> 着色
+    static HeatmapRaster computeRaster(HeatmapSource source, int zoom, double radius, quint64 dataVersion);
+    static void blurRows(const float *input, float *output, int width, int rowBegin, int rowEnd,
+                         const QVector<float> &kernel);
+    static void blurColumns(const float *input, float *output, int width, int height,
+                            int rowBegin, int rowEnd, const QVector<float> &kernel);
+
+private:
+    QGraphicsScene *m_scene;
+    LayerItemRegistry *m_itemRegistry;
+    HeatmapLayerItem *m_layerItem;
+
+    AsyncDAO *m_loader;
+    HeatmapSource m_source;
+    quint64 m_sourceProbe;      // 最近一次加载对应的版本探测值
+    bool m_sourceLoaded;
+    quint64 m_dataVersion;
+    int m_sampleCount;
+
+    // 按缩放级别缓存的栅格（成本单位 KB）
+    QCache<int, HeatmapRaster> m_rasters;
+    QFutureWatcher<HeatmapRaster> *m_watcher;
+    bool m_rasterPending;
+
+    int m_zoom;
+    double m_radius;
+    int m_healthThreshold;
+    bool m_visible;
+};
+
+#endif // HEATMAPRENDERER_H
@@ -0,0 +1,176 @@
+#include "map/labelengine.h"
+#include <QFontMetricsF>
+#include <QHash>
+#include <QtMath>
+#include <algorithm>
+
+namespace {
+
+// 网格单元键
+inline quint64 cellKey(int cx, int cy)
+{
+    return (quint64(quint32(cx)) << 32) | quint64(quint32(cy));
+}
+
+// 均匀网格碰撞检测
+class CollisionGrid
+{
+public:
+    explicit CollisionGrid(int cellSize) : m_cellSize(cellSize) {}
+
+    bool collides(const QRectF &rect) const
+    {
+        int x0 = qFloor(rect.left() / m_cellSize);
+        int x1 = qFloor(rect.right() / m_cellSize);
+        int y0 = qFloor(rect.top() / m_cellSize);
+        int y1 = qFloor(rect.bottom() / m_cellSize);
+        for (int cx = x0; cx <= x1; cx++) {
+            for (int cy = y0; cy <= y1; cy++) {
+                auto it = m_cells.constFind(cellKey(cx, cy));
+                if (it == m_cells.constEnd()) {
+                    continue;
+                }
+                for (const QRectF &placed : it.value()) {
+                    if (placed.intersects(rect)) {
+                        return true;
+                    }
+                }
+            }
+        }
+        return false;
+    }
+
+    void insert(const QRectF &rect)
+    {
+        int x0 = qFloor(rect.left() / m_cellSize);
+        int x1 = qFloor(rect.right() / m_cellSize);
+        int y0 = qFloor(rect.top() / m_cellSize);
+        int y1 = qFloor(rect.bottom() / m_cellSize);
+        for (int cx = x0; cx <= x1; cx++) {
+            for (int cy = y0; cy <= y1; cy++) {
+                m_cells[cellKey(cx, cy)].append(rect);
+            }
+        }
+    }
+
+private:
+    int m_cellSize;
+    QHash<quint64, QVector<QRectF>> m_cells;
+};
+
+} // namespace
+
+LabelPlacementResult LabelEngine::place(QVector<LabelFeature> features,
+                                        const QFont &font,
+                                        double viewScale,
+                                        int generation)
+{
+    LabelPlacementResult result;
+    result.viewScale = viewScale > 0 ? viewScale : 1.0;
+    result.generation = generation;
+    result.candidates = features.size();
+
+    // 1. 按优先级降序（同优先级保持采集顺序，结果稳定）
+    std::stable_sort(features.begin(), features.end(),
+                     [](const LabelFeature &a, const LabelFeature &b) {
+                         return a.priority > b.priority;
+                     });
+
+    QFontMetricsF metrics(font);
+    const double padding = LABEL_PADDING_PX;
+    const double textPadding = 3.0;   // 文本背景内边距
+    CollisionGrid grid(GRID_CELL_PX);
+    QHash<QString, QSizeF> sizeCache; // 同名标注只测量一次
+
+    result.labels.reserve(features.size());
+
+    for (const LabelFeature &feature : features) {
+        if (feature.text.isEmpty() || qIsNaN(feature.anchor.x()) || qIsNaN(feature.anchor.y())) {
+            continue;
+        }
+
+        QSizeF size = sizeCache.value(feature.text);
+        if (size.isEmpty()) {
+            size = QSizeF(metrics.horizontalAdvance(feature.text) + textPadding * 2,
+                          metrics.height() + textPadding);
+            sizeCache.insert(feature.text, size);
+        }
+        const double w = size.width();
+        const double h = size.height();
+
+        // 2. 候选位置（相对锚点的像素偏移）
+        QVector<QPointF> offsets;
+        if (feature.kind == LabelFeature::Facility) {
+            // 设施：上、右、左、下、四角
+            offsets = {
+                QPointF(-w / 2, -h - 10), QPointF(10, -h / 2),
+                QPointF(-w - 10, -h / 2), QPointF(-w / 2, 10),
+                QPointF(8, -h - 8),       QPointF(-w - 8, -h - 8),
+                QPointF(8, 8),            QPointF(-w - 8, 8)
+            };
+        } else {
+            // 管线：中点居中、上方、下方
+            offsets = {
+                QPointF(-w / 2, -h / 2), QPointF(-w / 2, -h - 6), QPointF(-w / 2, 6)
+            };
+        }
+
+        // 3. 屏幕像素空间碰撞检测
+        QPointF anchorPx = feature.anchor * result.viewScale;
+        for (const QPointF &offset : offsets) {
+            QRectF rel(offset, size);
+            QRectF abs = rel.translated(anchorPx).adjusted(-padding, -padding, padding, padding);
+            if (grid.collides(abs)) {
+                continue;
+            }
+            grid.insert(abs);
+
+            PlacedLabel label;
+            label.text = feature.text;
+            label.anchor = feature.anchor;
+            label.rect = rel;
+            label.kind = feature.kind;
+            result.labels.append(label);
+
+            // 零尺寸矩形会被 QRectF::united 忽略，手动扩展范围
+            if (result.labels.size() == 1) {
+                result.sceneBounds = QRectF(feature.anchor, feature.anchor);
+            } else {
+                result.sceneBounds.setLeft(qMin(result.sceneBounds.left(), feature.anchor.x()));
+                result.sceneBounds.setRight(qMax(result.sceneBounds.right(), feature.anchor.x()));
+                result.sceneBounds.setTop(qMin(result.sceneBounds.top(), feature.anchor.y()));
+                result.sceneBounds.setBottom(qMax(result.sceneBounds.bottom(), feature.anchor.y()));
+            }
+            break;
+        }
+    }
+
+    return result;
+}
+
+double LabelEngine::pipelinePriority(const QString &pipelineType, int diameterMm)
+{
+    // 类型权重：主干能源管线优先
+    int typeWeight = 1;
+    if (pipelineType == "gas" || pipelineType == "electric") {
+        typeWeight = 3;
+    } else if (pipelineType == "water_supply" || pipelineType == "heat") {
+        typeWeight = 2;
+    }
+    return typeWeight * 10000.0 + qMax(0, diameterMm);
+}
+
+double LabelEngine::facilityPriority(const QString &facilityType)
+{
+    // 站点类设施优先于井盖、接线盒等小型设施
+    if (facilityType == "pump_station" || facilityType == "transformer") {
+        return 40000.0;
+    }
+    if (facilityType == "regulator" || facilityType == "pressure_station") {
+        return 35000.0;
+    }
+    if (facilityType == "valve") {
+        return 15000.0;
+    }
+    return 5000.0;
+}
@@ -0,0 +1,67 @@
+#ifndef LABELENGINE_H
+#define LABELENGINE_H
+
+#include <QVector>
+#include <QString>
+#include <QPointF>
+#include <QRectF>
+#include <QFont>
+
+/**
+ * @brief 标注要素（从场景图形项采集的内存快照，不访问数据库）
+ */
+struct LabelFeature {
+    enum Kind { Pipeline = 0, Facility = 1 };
+
+    QString text;        // 标注文本
+    QPointF anchor;      // 锚点（场景坐标）
+    Kind kind;           // 要素类别
+    double priority;     // 优先级，越大越先放置
+};
+
+/**
+ * @brief 已放置的标注
+ * rect 为相对锚点的屏幕像素矩形（不随视图缩放变化）
+ */
+struct PlacedLabel {
+    QString text;
+    QPointF anchor;      // 锚点（场景坐标）
+    QRectF rect;         // 相对锚点的像素矩形
+    LabelFeature::Kind kind;
+};
+
+/**
+ * @brief 标注放置结果
+ */
+struct LabelPlacementResult {
+    QVector<PlacedLabel> labels;
+    QRectF sceneBounds;  // 所有锚点的场景范围
+    double viewScale = 1.0;  // 放置时使用的视图缩放（像素/场景单位）
+    int generation = 0;      // 请求序号，用于丢弃过期结果
+    int candidates = 0;      // 参与放置的要素数量
+};
+
+/**
+ * @brief 标注放置引擎
+ * 纯计算、无场景/数据库依赖，可在工作线程中执行
+ * 在屏幕像素空间使用均匀网格做碰撞检测，按优先级贪心放置
+ */
+class LabelEngine
+{
+public:
+    // 放置标注：features 按优先级排序后依次尝试候选位置
+    static LabelPlacementResult place(QVector<LabelFeature> features,
+                                      const QFont &font,
+                                      double viewScale,
+                                      int generation);
+
+    // 计算要素优先级（管线按管径，设施按类型）
+    static double pipelinePriority(const QString &pipelineType, int diameterMm);
+    static double facilityPriority(const QString &facilityType);
+
+private:
+    static const int GRID_CELL_PX = 64;    // 碰撞网格单元大小（像素）
+    static const int LABEL_PADDING_PX = 2; // 标注之间的最小间距
+};
+
+#endif // LABELENGINE_H
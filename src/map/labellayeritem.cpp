@@ -0,0 +1,142 @@
+#include "map/labellayeritem.h"
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+#include <QtMath>
+
+namespace {
+// 视图缩放相对放置缩放的偏离阈值（log2），超过后重新放置
+const double RELAYOUT_THRESHOLD = 0.25;
+// 标注像素矩形换算到场景时预留的最大视图缩小倍数
+const double MIN_VIEW_SCALE = 0.1;
+}
+
+LabelLayerItem::LabelLayerItem(QGraphicsItem *parent)
+    : QGraphicsItem(parent)
+    , m_labelFont("Arial", 10)
+    , m_labelColor(Qt::black)
+    , m_backgroundColor(Qt::white)
+    , m_relayoutRequested(false)
+{
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption, true);
+    setAcceptedMouseButtons(Qt::NoButton);
+    setAcceptHoverEvents(false);
+    setData(0, "annotation");
+    setData(1, "layer");
+    setZValue(250);
+}
+
+void LabelLayerItem::setPlacement(const LabelPlacementResult &result)
+{
+    prepareGeometryChange();
+    m_placement = result;
+    m_relayoutRequested = false;
+
+    // 像素矩形需换算为场景单位：按允许的最小视图缩放预留边距
+    double marginPx = 0;
+    for (const PlacedLabel &label : m_placement.labels) {
+        marginPx = qMax(marginPx, qMax(qAbs(label.rect.left()), qAbs(label.rect.right())));
+        marginPx = qMax(marginPx, qMax(qAbs(label.rect.top()), qAbs(label.rect.bottom())));
+    }
+    double margin = marginPx / MIN_VIEW_SCALE;
+    m_bounds = m_placement.sceneBounds.adjusted(-margin, -margin, margin, margin);
+
+    // 文本缓存只保留当前用到的条目
+    QHash<QString, QStaticText> kept;
+    for (const PlacedLabel &label : m_placement.labels) {
+        auto it = m_textCache.constFind(label.text);
+        if (it != m_textCache.constEnd()) {
+            kept.insert(label.text, it.value());
+        }
+    }
+    m_textCache.swap(kept);
+}
+
+void LabelLayerItem::clearPlacement()
+{
+    prepareGeometryChange();
+    m_placement.labels.clear();
+    m_placement.sceneBounds = QRectF();
+    m_bounds = QRectF();
+    m_relayoutRequested = false;
+}
+
+void LabelLayerItem::setLabelFont(const QFont &font)
+{
+    m_labelFont = font;
+    m_textCache.clear();
+    update();
+}
+
+QRectF LabelLayerItem::boundingRect() const
+{
+    return m_bounds;
+}
+
+QPainterPath LabelLayerItem::shape() const
+{
+    return QPainterPath();
+}
+
+const QStaticText &LabelLayerItem::staticText(const QString &text)
+{
+    auto it = m_textCache.find(text);
+    if (it == m_textCache.end()) {
+        QStaticText staticText(text);
+        staticText.setTextFormat(Qt::PlainText);
+        staticText.setPerformanceHint(QStaticText::AggressiveCaching);
+        staticText.prepare(QTransform(), m_labelFont);
+        it = m_textCache.insert(text, staticText);
+    }
+    return it.value();
+}
+
+void LabelLayerItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
+                           QWidget *widget)
+{
+    Q_UNUSED(widget);
+
+    if (m_placement.labels.isEmpty()) {
+        return;
+    }
+
+    // 1. 当前视图缩放，偏离放置缩放过多时请求重新放置（本帧仍按旧结果绘制）
+    const QTransform world = painter->worldTransform();
+    double viewScale = qSqrt(qAbs(world.determinant()));
+    if (viewScale > 0 && m_relayoutCallback && !m_relayoutRequested
+        && qAbs(std::log2(viewScale / m_placement.viewScale)) > RELAYOUT_THRESHOLD) {
+        m_relayoutRequested = true;
+        m_relayoutCallback(viewScale);
+    }
+
+    // 2. 在设备坐标中以固定像素大小绘制
+    const QRectF exposed = option->exposedRect;
+    const double scale = viewScale > 0 ? viewScale : 1.0;
+
+    painter->save();
+    painter->resetTransform();
+    painter->setFont(m_labelFont);
+    painter->setRenderHint(QPainter::TextAntialiasing, true);
+
+    QColor background = m_backgroundColor;
+    background.setAlphaF(0.8);
+
+    for (const PlacedLabel &label : m_placement.labels) {
+        // 粗裁剪：标注的场景范围与暴露区域不相交时跳过
+        QRectF sceneRect(label.anchor + label.rect.topLeft() / scale, label.rect.size() / scale);
+        if (!exposed.intersects(sceneRect)) {
+            continue;
+        }
+
+        QPointF device = world.map(label.anchor);
+        QRectF rect = label.rect.translated(device);
+
+        painter->setPen(Qt::NoPen);
+        painter->setBrush(background);
+        painter->drawRect(rect);
+
+        painter->setPen(m_labelColor);
+        painter->drawStaticText(rect.topLeft() + QPointF(3.0, 1.5), staticText(label.text));
+    }
+
+    painter->restore();
+}
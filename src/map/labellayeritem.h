@@ -0,0 +1,55 @@
+#ifndef LABELLAYERITEM_H
+#define LABELLAYERITEM_H
+
+#include <QGraphicsItem>
+#include <QStaticText>
+#include <QHash>
+#include <QFont>
+#include <QColor>
+#include <functional>
+#include "map/labelengine.h"
+
+/**
+ * @brief 标注图层图形项
+ * 单个图形项绘制全部已放置的标注，文本使用 QStaticText 缓存字形排版
+ * 标注按固定像素大小绘制，视图缩放变化较大时通过回调请求重新放置
+ */
+class LabelLayerItem : public QGraphicsItem
+{
+public:
+    explicit LabelLayerItem(QGraphicsItem *parent = nullptr);
+
+    // 设置放置结果（GUI线程）
+    void setPlacement(const LabelPlacementResult &result);
+    void clearPlacement();
+    int labelCount() const { return m_placement.labels.size(); }
+
+    // 样式
+    void setLabelFont(const QFont &font);
+    void setLabelColor(const QColor &color) { m_labelColor = color; update(); }
+    void setBackgroundColor(const QColor &color) { m_backgroundColor = color; update(); }
+
+    // 视图缩放偏离放置时缩放过多时回调（参数为当前缩放）
+    void setRelayoutCallback(const std::function<void(double)> &callback) { m_relayoutCallback = callback; }
+    // 请求的放置结果被丢弃时调用，允许再次请求
+    void resetRelayoutRequest() { m_relayoutRequested = false; }
+
+    QRectF boundingRect() const override;
+    QPainterPath shape() const override;  // 空形状：不参与点选
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
+               QWidget *widget = nullptr) override;
+
+private:
+    const QStaticText &staticText(const QString &text);
+
+    LabelPlacementResult m_placement;
+    QRectF m_bounds;
+    QHash<QString, QStaticText> m_textCache;
+    QFont m_labelFont;
+    QColor m_labelColor;
+    QColor m_backgroundColor;
+    std::function<void(double)> m_relayoutCallback;
+    bool m_relayoutRequested;
+};
+
+#endif // LABELLAYERITEM_H
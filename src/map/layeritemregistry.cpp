@@ -0,0 +1,278 @@
+#include "map/layeritemregistry.h"
+#include "map/entitygraphicsitem.h"
+#include <QGraphicsItem>
+#include <QGraphicsScene>
+
+namespace {
+const LayerManager::LayerType kPipelineLayers[] = {
+    LayerManager::WaterPipeline,
+    LayerManager::SewagePipeline,
+    LayerManager::GasPipeline,
+    LayerManager::ElectricPipeline,
+    LayerManager::TelecomPipeline,
+    LayerManager::HeatPipeline
+};
+}
+
+void LayerItemRegistry::addItem(LayerManager::LayerType layer, QGraphicsItem *item)
+{
+    if (!item) {
+        return;
+    }
+
+    // 已在其他图层（如类型被修改）时先移出
+    auto it = m_itemLayers.find(item);
+    if (it != m_itemLayers.end()) {
+        if (it.value() == layer) {
+            return;
+        }
+        m_layerItems[it.value()].remove(item);
+        it.value() = layer;
+    } else {
+        m_itemLayers.insert(item, layer);
+    }
+    m_layerItems[layer].insert(item);
+    indexEntity(item);
+
+    for (const ItemCallback &callback : m_itemAdded) {
+        callback(layer, item);
+    }
+}
+
+bool LayerItemRegistry::addEntityItem(QGraphicsItem *item)
+{
+    if (!item) {
+        return false;
+    }
+
+    if (auto *pipelineItem = qgraphicsitem_cast<PipelineGraphicsItem*>(item)) {
+        addItem(layerForPipelineType(pipelineItem->entityType()), item);
+        return true;
+    }
+    if (EntityGraphicsItem::isFacility(item)) {
+        addItem(LayerManager::Facilities, item);
+        return true;
+    }
+    return false;
+}
+
+void LayerItemRegistry::removeItem(QGraphicsItem *item)
+{
+    auto it = m_itemLayers.find(item);
+    if (it == m_itemLayers.end()) {
+        return;
+    }
+    const LayerManager::LayerType layer = it.value();
+    m_layerItems[layer].remove(item);
+    m_itemLayers.erase(it);
+    unindexEntity(item);
+
+    for (const ItemCallback &callback : m_itemRemoved) {
+        callback(layer, item);
+    }
+}
+
+void LayerItemRegistry::removeItems(const QList<QGraphicsItem*> &items)
+{
+    for (QGraphicsItem *item : items) {
+        removeItem(item);
+    }
+}
+
+bool LayerItemRegistry::containsInScene(QGraphicsItem *item, const QGraphicsScene *scene) const
+{
+    return m_itemLayers.contains(item) && item->scene() == scene;
+}
+
+bool LayerItemRegistry::layerOf(QGraphicsItem *item, LayerManager::LayerType *layer) const
+{
+    auto it = m_itemLayers.constFind(item);
+    if (it == m_itemLayers.constEnd()) {
+        return false;
+    }
+    if (layer) {
+        *layer = it.value();
+    }
+    return true;
+}
+
+QList<QGraphicsItem*> LayerItemRegistry::items(LayerManager::LayerType layer, const QGraphicsScene *scene) const
+{
+    QList<QGraphicsItem*> result;
+    auto it = m_layerItems.constFind(layer);
+    if (it == m_layerItems.constEnd()) {
+        return result;
+    }
+
+    result.reserve(it.value().size());
+    for (QGraphicsItem *item : it.value()) {
+        if (!scene || item->scene() == scene) {
+            result.append(item);
+        }
+    }
+    return result;
+}
+
+int LayerItemRegistry::count(LayerManager::LayerType layer, const QGraphicsScene *scene) const
+{
+    auto it = m_layerItems.constFind(layer);
+    if (it == m_layerItems.constEnd()) {
+        return 0;
+    }
+    if (!scene) {
+        return it.value().size();
+    }
+
+    int n = 0;
+    for (QGraphicsItem *item : it.value()) {
+        if (item->scene() == scene) {
+            n++;
+        }
+    }
+    return n;
+}
+
+QList<QGraphicsItem*> LayerItemRegistry::pipelineItems(const QGraphicsScene *scene) const
+{
+    QList<QGraphicsItem*> result;
+    for (LayerManager::LayerType layer : kPipelineLayers) {
+        result.append(items(layer, scene));
+    }
+    return result;
+}
+
+QList<QGraphicsItem*> LayerItemRegistry::entityItems(const QGraphicsScene *scene) const
+{
+    QList<QGraphicsItem*> result = pipelineItems(scene);
+    result.append(items(LayerManager::Facilities, scene));
+    return result;
+}
+
+QGraphicsItem* LayerItemRegistry::findEntity(const QString &entityType, const QString &entityId,
+                                             const QGraphicsScene *scene) const
+{
+    if (entityType == "pipeline") {
+        return lookupEntity(m_pipelineIndex, entityId, scene);
+    } else if (entityType == "facility") {
+        return lookupEntity(m_facilityIndex, entityId, scene);
+    }
+    return nullptr;
+}
+
+PipelineGraphicsItem* LayerItemRegistry::findPipeline(const QString &pipelineId, const QGraphicsScene *scene) const
+{
+    return qgraphicsitem_cast<PipelineGraphicsItem*>(lookupEntity(m_pipelineIndex, pipelineId, scene));
+}
+
+FacilityGraphicsItem* LayerItemRegistry::findFacility(const QString &facilityId, const QGraphicsScene *scene) const
+{
+    return qgraphicsitem_cast<FacilityGraphicsItem*>(lookupEntity(m_facilityIndex, facilityId, scene));
+}
+
+void LayerItemRegistry::reindexEntity(QGraphicsItem *item)
+{
+    if (m_itemLayers.contains(item)) {
+        indexEntity(item);
+    }
+}
+
+void LayerItemRegistry::indexEntity(QGraphicsItem *item)
+{
+    const EntityGraphicsItem *entity = EntityGraphicsItem::fromItem(item);
+    if (!entity) {
+        return;
+    }
+    unindexEntity(item);
+    if (entity->entityId().isEmpty()) {
+        return;
+    }
+    if (entity->entityKind() == EntityGraphicsItem::PipelineKind) {
+        m_pipelineIndex.insert(entity->entityId(), item);
+    } else {
+        m_facilityIndex.insert(entity->entityId(), item);
+    }
+    m_indexedIds.insert(item, entity->entityId());
+}
+
+void LayerItemRegistry::unindexEntity(QGraphicsItem *item)
+{
+    auto it = m_indexedIds.find(item);
+    if (it == m_indexedIds.end()) {
+        return;
+    }
+    // 注销时图形项仍有效，但编号可能已变化，按登记时的编号移除
+    m_pipelineIndex.remove(it.value(), item);
+    m_facilityIndex.remove(it.value(), item);
+    m_indexedIds.erase(it);
+}
+
+QGraphicsItem* LayerItemRegistry::lookupEntity(const QMultiHash<QString, QGraphicsItem*> &index,
+                                               const QString &entityId,
+                                               const QGraphicsScene *scene) const
+{
+    if (entityId.isEmpty()) {
+        return nullptr;
+    }
+    // 同号时优先返回已入库的图形项（粘贴副本尚未入库）
+    QGraphicsItem *fallback = nullptr;
+    for (auto it = index.constFind(entityId); it != index.constEnd() && it.key() == entityId; ++it) {
+        QGraphicsItem *item = it.value();
+        if (scene && item->scene() != scene) {
+            continue;
+        }
+        if (EntityGraphicsItem::fromItem(item)->databaseId() > 0) {
+            return item;
+        }
+        if (!fallback) {
+            fallback = item;
+        }
+    }
+    return fallback;
+}
+
+int LayerItemRegistry::setLayerVisible(LayerManager::LayerType layer, bool visible)
+{
+    auto it = m_layerItems.constFind(layer);
+    if (it == m_layerItems.constEnd()) {
+        return 0;
+    }
+    for (QGraphicsItem *item : it.value()) {
+        item->setVisible(visible);
+    }
+    return it.value().size();
+}
+
+void LayerItemRegistry::clear()
+{
+    m_layerItems.clear();
+    m_itemLayers.clear();
+    m_pipelineIndex.clear();
+    m_facilityIndex.clear();
+    m_indexedIds.clear();
+}
+
+LayerManager::LayerType LayerItemRegistry::layerForPipelineType(const QString &pipelineType)
+{
+    if (pipelineType == "sewage") {
+        return LayerManager::SewagePipeline;
+    } else if (pipelineType == "gas") {
+        return LayerManager::GasPipeline;
+    } else if (pipelineType == "electric") {
+        return LayerManager::ElectricPipeline;
+    } else if (pipelineType == "telecom") {
+        return LayerManager::TelecomPipeline;
+    } else if (pipelineType == "heat") {
+        return LayerManager::HeatPipeline;
+    }
+    return LayerManager::WaterPipeline;  // 默认（含 water_supply）
+}
+
+bool LayerItemRegistry::isPipelineLayer(LayerManager::LayerType layer)
+{
+    for (LayerManager::LayerType pipelineLayer : kPipelineLayers) {
+        if (pipelineLayer == layer) {
+            return true;
+        }
+    }
+    return false;
+}
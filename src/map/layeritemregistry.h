@@ -0,0 +1,100 @@
+#ifndef LAYERITEMREGISTRY_H
+#define LAYERITEMREGISTRY_H
+
+#include <QHash>
+#include <QSet>
+#include <QList>
+#include <QString>
+#include <functional>
+#include "map/layermanager.h"
+
+class QGraphicsItem;
+class QGraphicsScene;
+class PipelineGraphicsItem;
+class FacilityGraphicsItem;
+
+/**
+ * @brief 图层图形项注册表
+ * 按图层记录图形项集合，由渲染器、绘制/加载流程在创建与删除图形项时维护
+ * 图层显隐与按图层查询只访问该图层的图形项，不再扫描整个场景、不做字符串比较
+ *
+ * 实体图形项同时按业务编号建立索引，高亮、定位与结果集渲染直接复用场景中的
+ * 图形项几何，无需查询数据库或重新投影
+ *
+ * 注意：被撤销命令移出场景的图形项仍保留在注册表中（指针仍有效），
+ * 查询时按 scene() 过滤；真正 delete 图形项前必须调用 removeItem()
+ */
+class LayerItemRegistry
+{
+public:
+    // 图形项登记/注销通知（注销回调在图形项删除前调用，图形项仍有效）
+    using ItemCallback = std::function<void(LayerManager::LayerType, QGraphicsItem*)>;
+
+    LayerItemRegistry() = default;
+
+    // 注册到指定图层
+    void addItem(LayerManager::LayerType layer, QGraphicsItem *item);
+
+    // 注册实体图形项，按实体种类与管线类型归类（仅在注册时比较一次）
+    bool addEntityItem(QGraphicsItem *item);
+
+    // 注销（删除图形项前调用）
+    void removeItem(QGraphicsItem *item);
+    void removeItems(const QList<QGraphicsItem*> &items);
+
+    bool contains(QGraphicsItem *item) const { return m_itemLayers.contains(item); }
+
+    // 已登记且当前位于指定场景中（先查表再访问图形项，已注销的指针不会被解引用）
+    bool containsInScene(QGraphicsItem *item, const QGraphicsScene *scene) const;
+
+    // 图形项所属图层，未注册时返回 false
+    bool layerOf(QGraphicsItem *item, LayerManager::LayerType *layer) const;
+
+    // 图层中的图形项（scene 非空时只返回仍在该场景中的项）
+    QList<QGraphicsItem*> items(LayerManager::LayerType layer, const QGraphicsScene *scene = nullptr) const;
+    int count(LayerManager::LayerType layer, const QGraphicsScene *scene = nullptr) const;
+
+    // 所有管线/设施实体图形项
+    QList<QGraphicsItem*> entityItems(const QGraphicsScene *scene = nullptr) const;
+    QList<QGraphicsItem*> pipelineItems(const QGraphicsScene *scene = nullptr) const;
+
+    // 按实体类型与编号查找（编号索引）
+    QGraphicsItem* findEntity(const QString &entityType, const QString &entityId,
+                              const QGraphicsScene *scene = nullptr) const;
+    PipelineGraphicsItem* findPipeline(const QString &pipelineId, const QGraphicsScene *scene = nullptr) const;
+    FacilityGraphicsItem* findFacility(const QString &facilityId, const QGraphicsScene *scene = nullptr) const;
+
+    // 已登记实体的编号被修改后（如保存时重新分配编号）更新索引
+    void reindexEntity(QGraphicsItem *item);
+
+    // 设置图层内所有图形项的可见性，返回处理的数量
+    int setLayerVisible(LayerManager::LayerType layer, bool visible);
+
+    void clear();
+    
+    // 登记/注销通知可有多个订阅者（栅格瓦片缓存、点选索引等）
+    void addItemAddedCallback(const ItemCallback &callback) { m_itemAdded.append(callback); }
+    void addItemRemovedCallback(const ItemCallback &callback) { m_itemRemoved.append(callback); }
+    void clearCallbacks() { m_itemAdded.clear(); m_itemRemoved.clear(); }
+
+    // 管线类型 -> 图层
+    static LayerManager::LayerType layerForPipelineType(const QString &pipelineType);
+    static bool isPipelineLayer(LayerManager::LayerType layer);
+
+private:
+    void indexEntity(QGraphicsItem *item);
+    void unindexEntity(QGraphicsItem *item);
+    QGraphicsItem* lookupEntity(const QMultiHash<QString, QGraphicsItem*> &index, const QString &entityId,
+                                const QGraphicsScene *scene) const;
+
+    QHash<LayerManager::LayerType, QSet<QGraphicsItem*>> m_layerItems;
+    QHash<QGraphicsItem*, LayerManager::LayerType> m_itemLayers;
+    // 编号 -> 图形项（撤销移出场景的副本与粘贴副本可能同号，故为多值）
+    QMultiHash<QString, QGraphicsItem*> m_pipelineIndex;
+    QMultiHash<QString, QGraphicsItem*> m_facilityIndex;
+    QHash<QGraphicsItem*, QString> m_indexedIds;    // 图形项登记时的编号（用于注销与重建索引）
+    QList<ItemCallback> m_itemAdded;
+    QList<ItemCallback> m_itemRemoved;
+};
+
+#endif // LAYERITEMREGISTRY_H
@@ -2,9 +2,32 @@
 #include "map/pipelinerenderer.h"
 #include "map/facilityrenderer.h"
 #include "map/annotationrenderer.h"
+#include "map/heatmaprenderer.h"
+#include "map/layeritemregistry.h"
+#include "map/vectortilecache.h"
+#include "map/entitypickindex.h"
+#include "map/thematicattributetable.h"
+#include "map/thematicrenderer.h"
+#include "map/entitygraphicsitem.h"
+#include "dao/pipelinedao.h"
+#include "dao/facilitydao.h"
+#include "dao/asyncdao.h"
 #include "tilemap/tilemapmanager.h"
 #include "core/common/logger.h"
 
+namespace {
+// 远程变更实体的最新渲染记录（后台读取）
+struct EntityChangeRecords {
+    QVector<PipelineRenderRecord> pipelines;
+    QVector<FacilityRenderRecord> facilities;
+};
+
+QString changeKey(const QString &table, int id)
+{
+    return QString("%1:%2").arg(table).arg(id);
+}
+}
+
 // 初始化静态成员
 QHash<LayerManager::LayerType, QString> LayerManager::s_layerNames = {
     {BaseMap, "底图"},
@@ -15,7 +38,8 @@ QHash<LayerManager::LayerType, QString> LayerManager::s_layerNames = {
     {TelecomPipeline, "通信光缆"},
     {HeatPipeline, "供热管线"},
     {Facilities, "设施点"},
-    {Labels, "标注"}
+    {Labels, "标注"},
+    {Heatmap, "热力图"}
 };
 
 LayerManager::LayerManager(QGraphicsScene *scene, QObject *parent)
@@ -25,11 +49,64 @@ LayerManager::LayerManager(QGraphicsScene *scene, QObject *parent)
     , m_pipelineRenderer(nullptr)
     , m_facilityRenderer(nullptr)
     , m_annotationRenderer(nullptr)
+    , m_heatmapRenderer(nullptr)
+    , m_itemRegistry(new LayerItemRegistry())
+    , m_vectorTileCache(nullptr)
+    , m_pickIndex(new EntityPickIndex())
+    , m_attributeTable(new ThematicAttributeTable())
+    , m_thematicRenderer(nullptr)
+    , m_changeLoader(new AsyncDAO(this))
+    , m_changeCounter(0)
 {
     // 创建渲染器
     m_pipelineRenderer = new PipelineRenderer(this);
     m_facilityRenderer = new FacilityRenderer(this);
     m_annotationRenderer = new AnnotationRenderer(this);
+    m_heatmapRenderer = new HeatmapRenderer(this);
+    
+    // 渲染器创建/删除图形项时同步维护图层注册表
+    m_pipelineRenderer->setItemRegistry(m_itemRegistry);
+    m_facilityRenderer->setItemRegistry(m_itemRegistry);
+    m_annotationRenderer->setItemRegistry(m_itemRegistry);
+    m_heatmapRenderer->setItemRegistry(m_itemRegistry);
+    m_heatmapRenderer->setScene(m_scene);
+    
+    // 矢量图层栅格瓦片缓存（可选模式，依赖注册表跟踪图形项增删）
+    m_vectorTileCache = new VectorTileCache(m_itemRegistry, this);
+    m_vectorTileCache->setScene(m_scene);
+    
+    // 实体点选索引：只收录管线与设施图层的图形项
+    m_itemRegistry->addItemAddedCallback([this](LayerType layer, QGraphicsItem *item) {
+        if (LayerItemRegistry::isPipelineLayer(layer)) {
+            m_pickIndex->insertItem(item, EntityPickIndex::PipelineEntity);
+        } else if (layer == Facilities) {
+            m_pickIndex->insertItem(item, EntityPickIndex::FacilityEntity);
+        }
+    });
+    m_itemRegistry->addItemRemovedCallback([this](LayerType, QGraphicsItem *item) {
+        m_pickIndex->removeItem(item);
+    });
+    
+    // 专题渲染：管线渲染器登记属性列，专题渲染器按列分级后就地修改样式
+    m_pipelineRenderer->setAttributeTable(m_attributeTable);
+    m_thematicRenderer = new ThematicRenderer(m_attributeTable, m_itemRegistry, this);
+    connect(m_thematicRenderer, &ThematicRenderer::themeApplied, this, [this](int) {
+        m_vectorTileCache->invalidateAll();
+    });
+    connect(m_thematicRenderer, &ThematicRenderer::themeCleared, this, [this]() {
+        m_vectorTileCache->invalidateAll();
+    });
+    
+    // 要素图层在后台加载，渲染完成后（合并多个图层）刷新专题与标注
+    m_derivedRefreshTimer.setSingleShot(true);
+    m_derivedRefreshTimer.setInterval(50);
+    connect(&m_derivedRefreshTimer, &QTimer::timeout, this, &LayerManager::refreshDerivedLayers);
+    connect(m_pipelineRenderer, &PipelineRenderer::renderComplete, this, [this](int) {
+        m_derivedRefreshTimer.start();
+    });
+    connect(m_facilityRenderer, &FacilityRenderer::renderComplete, this, [this](int) {
+        m_derivedRefreshTimer.start();
+    });
     
     // 立即设置场景到标注渲染器
     if (m_annotationRenderer && m_scene) {
@@ -44,12 +121,30 @@ LayerManager::LayerManager(QGraphicsScene *scene, QObject *parent)
 
 LayerManager::~LayerManager()
 {
+    // 清空图层时不再通知瓦片缓存与点选索引
+    m_itemRegistry->clearCallbacks();
     clearAllLayers();
+    
+    // 渲染器作为子对象在本析构函数之后才销毁，先断开注册表
+    m_pipelineRenderer->setItemRegistry(nullptr);
+    m_facilityRenderer->setItemRegistry(nullptr);
+    m_annotationRenderer->setItemRegistry(nullptr);
+    m_heatmapRenderer->setItemRegistry(nullptr);
+    m_pipelineRenderer->setAttributeTable(nullptr);
+    delete m_itemRegistry;
+    delete m_attributeTable;
+    delete m_pickIndex;
 }
 
 void LayerManager::setScene(QGraphicsScene *scene)
 {
     m_scene = scene;
+    if (m_vectorTileCache) {
+        m_vectorTileCache->setScene(scene);
+    }
+    if (m_heatmapRenderer) {
+        m_heatmapRenderer->setScene(scene);
+    }
     LOG_INFO("Scene set for LayerManager");
 }
 
@@ -82,6 +177,7 @@ void LayerManager::initializeLayers()
     m_layerVisibility[HeatPipeline] = true;
     m_layerVisibility[Facilities] = true;
     m_layerVisibility[Labels] = true;  // 标注默认打开
+    m_layerVisibility[Heatmap] = false;  // 热力图按需打开
 }
 
 void LayerManager::setLayerVisible(LayerType type, bool visible)
@@ -103,6 +199,11 @@ void LayerManager::setLayerVisible(LayerType type, bool visible)
     } else {
         clearLayer(type);
     }
+    
+    // 显隐不经过注册表增删，栅格瓦片需全部重新校验
+    if (m_vectorTileCache && type != BaseMap && type != Labels && type != Heatmap) {
+        m_vectorTileCache->invalidateAll();
+    }
 }
 
 bool LayerManager::isLayerVisible(LayerType type) const
@@ -139,84 +240,9 @@ void LayerManager::refreshLayer(LayerType type)
     LOG_INFO(QString("Refreshing layer: %1").arg(getLayerName(type)));
     qDebug() << "[LayerManager] Refreshing layer:" << getLayerName(type);
     
-    // 先显示该图层的所有图形项
-    QString targetType;
-    switch (type) {
-    case WaterPipeline:
-        targetType = "water_supply";
-        break;
-    case SewagePipeline:
-        targetType = "sewage";
-        break;
-    case GasPipeline:
-        targetType = "gas";
-        break;
-    case ElectricPipeline:
-        targetType = "electric";
-        break;
-    case TelecomPipeline:
-        targetType = "telecom";
-        break;
-    case HeatPipeline:
-        targetType = "heat";
-        break;
-    case Facilities:
-        targetType = "facility";
-        break;
-    case Labels:
-        targetType = "annotation";
-        break;
-    default:
-        break;
-    }
-    
-    // 显示场景中属于该图层的所有图形项
-    QList<QGraphicsItem*> allItems = m_scene->items();
-    int shownCount = 0;
-    
-    qDebug() << "[LayerManager] ========== refreshLayer START ==========";
-    qDebug() << "[LayerManager] Layer type:" << getLayerName(type) << "targetType:" << targetType;
-    qDebug() << "[LayerManager] Total items in scene:" << allItems.size();
-    
-    for (QGraphicsItem *item : allItems) {
-        if (!item) continue;
-        
-        QString itemType = item->data(0).toString();
-        QString itemSubType = item->data(2).toString();
-        
-        bool shouldShow = false;
-        
-        if (type == Labels) {
-            // 标注图层：显示所有标注（包括背景项）
-            shouldShow = (itemType == "annotation");
-            // 如果父项是标注，也要显示
-            if (!shouldShow && item->parentItem()) {
-                QString parentType = item->parentItem()->data(0).toString();
-                shouldShow = (parentType == "annotation");
-            }
-        } else if (type == Facilities) {
-            shouldShow = (itemType == "facility");
-        } else {
-            shouldShow = (itemType == "pipeline" && itemSubType == targetType);
-        }
-        
-        if (shouldShow) {
-            item->setVisible(true);
-            shownCount++;
-            qDebug() << "[LayerManager] ✓ Shown item: type=" << itemType << "subType=" << itemSubType << "visible=" << item->isVisible();
-        }
-        
-        // 调试：输出所有管线项的信息
-        if (itemType == "pipeline") {
-            qDebug() << "[LayerManager] Pipeline item: subType=" << itemSubType 
-                     << "targetType=" << targetType 
-                     << "match=" << (itemSubType == targetType)
-                     << "visible=" << item->isVisible();
-        }
-    }
-    
-    qDebug() << "[LayerManager] Shown" << shownCount << "existing items for layer" << getLayerName(type);
-    qDebug() << "[LayerManager] ========== refreshLayer MIDDLE ==========";
+    // 先显示注册表中属于该图层的所有图形项（只访问本图层，不扫描整个场景）
+    int shownCount = m_itemRegistry->setLayerVisible(type, true);
+    LOG_DEBUG(QString("Shown %1 registered items for layer %2").arg(shownCount).arg(getLayerName(type)));
     
     // 检查缓存中是否已有项，如果有则只显示它们，不重新渲染
     bool hasCachedItems = false;
@@ -237,7 +263,7 @@ void LayerManager::refreshLayer(LayerType type)
                         item->setVisible(true);
                     }
                 }
-                qDebug() << "[LayerManager] Shown" << cached.size() << "cached items for layer" << getLayerName(type);
+                LOG_DEBUG(QString("Shown %1 cached items for layer %2").arg(cached.size()).arg(getLayerName(type)));
             }
         }
         break;
@@ -251,7 +277,9 @@ void LayerManager::refreshLayer(LayerType type)
                         item->setVisible(true);
                     }
                 }
-                qDebug() << "[LayerManager] Shown" << cached.size() << "cached facility items";
+                LOG_DEBUG(QString("Shown %1 cached facility items").arg(cached.size()));
+                // 低层级时改为显示聚类
+                m_facilityRenderer->showLayer();
             }
         }
         break;
@@ -259,6 +287,10 @@ void LayerManager::refreshLayer(LayerType type)
         // 标注总是重新渲染（因为可能数据有变化）
         hasCachedItems = false;
         break;
+    case Heatmap:
+        // 热力图按数据版本判断是否需要重新计算，由渲染器自行复用缓存栅格
+        hasCachedItems = false;
+        break;
     default:
         break;
     }
@@ -313,6 +345,11 @@ void LayerManager::refreshLayer(LayerType type)
                 m_annotationRenderer->renderAllAnnotations(m_visibleBounds);
             }
             break;
+        case Heatmap:
+            if (m_heatmapRenderer) {
+                m_heatmapRenderer->renderHeatmap();
+            }
+            break;
         default:
             break;
         }
@@ -321,6 +358,21 @@ void LayerManager::refreshLayer(LayerType type)
     emit layerRefreshed(type);
 }
 
+void LayerManager::refreshDerivedLayers()
+{
+    // 新渲染的管线按当前专题重新分级
+    if (m_thematicRenderer->isActive()) {
+        m_thematicRenderer->reapply();
+    }
+    if (isLayerVisible(Labels) && m_annotationRenderer) {
+        m_annotationRenderer->renderAllAnnotations(m_visibleBounds);
+    }
+    
+    if (!m_pipelineRenderer->isLoading() && !m_facilityRenderer->isLoading()) {
+        emit layersLoaded();
+    }
+}
+
 void LayerManager::refreshAllLayers()
 {
     LOG_INFO("Refreshing all visible layers");
@@ -332,105 +384,161 @@ void LayerManager::refreshAllLayers()
     }
 }
 
-void LayerManager::clearLayer(LayerType type)
+void LayerManager::applyEntityChanges(const QVector<EntityChange> &changes)
 {
-    if (!m_scene) {
+    if (!m_scene || changes.isEmpty()) {
         return;
     }
     
-    LOG_DEBUG(QString("Clearing layer: %1").arg(getLayerName(type)));
-    qDebug() << "[LayerManager] Clearing layer:" << getLayerName(type);
+    // 1. 移除变更实体的现有图形项（新增与更新之后按数据库最新记录重建）
+    QVector<int> pipelineIds;
+    QVector<int> facilityIds;
+    QHash<QString, quint64> sequences;
+    bool pipelinesChanged = false;
+    bool facilitiesChanged = false;
+    int applied = 0;
     
-    // 先遍历场景中的所有图形项，隐藏属于该图层的项
-    QList<QGraphicsItem*> allItems = m_scene->items();
-    QString targetType;
+    for (const EntityChange &change : changes) {
+        const bool isPipeline = change.table == "pipelines";
+        if (!isPipeline && change.table != "facilities") {
+            continue;
+        }
+        
+        QGraphicsItem *item = isPipeline
+            ? static_cast<QGraphicsItem*>(m_itemRegistry->findPipeline(change.key, m_scene))
+            : static_cast<QGraphicsItem*>(m_itemRegistry->findFacility(change.key, m_scene));
+        if (!removeEntityItem(item, isPipeline)) {
+            LOG_WARNING(QString("Remote change to %1 %2 ignored: local edits pending")
+                            .arg(change.table, change.key));
+            continue;
+        }
+        
+        // 同一实体的后续变更使仍在读取的旧结果作废（删除直接移除序号）
+        const QString key = changeKey(change.table, change.id);
+        if (change.op == EntityChange::Delete) {
+            m_changeSequence.remove(key);
+        } else {
+            m_changeSequence[key] = ++m_changeCounter;
+            sequences[key] = m_changeCounter;
+            (isPipeline ? pipelineIds : facilityIds).append(change.id);
+        }
+        if (isPipeline) {
+            pipelinesChanged = true;
+        } else {
+            facilitiesChanged = true;
+        }
+        applied++;
+    }
     
-    // 根据图层类型确定要隐藏的图形项类型
-    switch (type) {
-    case WaterPipeline:
-        targetType = "water_supply";
-        break;
-    case SewagePipeline:
-        targetType = "sewage";
-        break;
-    case GasPipeline:
-        targetType = "gas";
-        break;
-    case ElectricPipeline:
-        targetType = "electric";
-        break;
-    case TelecomPipeline:
-        targetType = "telecom";
-        break;
-    case HeatPipeline:
-        targetType = "heat";
-        break;
-    case Facilities:
-        targetType = "facility";
-        break;
-    case Labels:
-        targetType = "annotation";
-        break;
-    default:
+    if (pipelineIds.isEmpty() && facilityIds.isEmpty()) {
+        finishEntityChanges(pipelinesChanged, facilitiesChanged, applied, 0);
         return;
     }
     
-    int hiddenCount = 0;
-    int checkedCount = 0;
-    int pipelineCount = 0;
-    int facilityCount = 0;
-    
-    qDebug() << "[LayerManager] ========== clearLayer START ==========";
-    qDebug() << "[LayerManager] Layer type:" << getLayerName(type) << "targetType:" << targetType;
-    qDebug() << "[LayerManager] Total items in scene:" << allItems.size();
-    
-    for (QGraphicsItem *item : allItems) {
-        if (!item) continue;
-        
-        QString itemType = item->data(0).toString();  // 实体类型：pipeline, facility, annotation
-        QString itemSubType = item->data(2).toString();  // 管线类型或设施类型
-        
-        // 统计不同类型的项
-        if (itemType == "pipeline") pipelineCount++;
-        if (itemType == "facility") facilityCount++;
-        
-        bool shouldHide = false;
+    // 2. 后台按主键批量读取最新渲染记录，返回后在界面线程插入
+    m_changeLoader->run([pipelineIds, facilityIds]() {
+        EntityChangeRecords records;
+        if (!pipelineIds.isEmpty()) {
+            records.pipelines = PipelineDAO().findRenderRecordsByIds(pipelineIds);
+        }
+        if (!facilityIds.isEmpty()) {
+            records.facilities = FacilityDAO().findRenderRecordsByIds(facilityIds);
+        }
+        return records;
+    }, [this, sequences, pipelinesChanged, facilitiesChanged, applied](const EntityChangeRecords &records) {
+        // 读取期间同一实体又有变更时丢弃本次结果
+        auto isCurrent = [this, &sequences](const QString &table, int id) {
+            const QString key = changeKey(table, id);
+            return sequences.contains(key) && m_changeSequence.value(key) == sequences.value(key);
+        };
         
-        if (type == Labels) {
-            // 标注图层：隐藏所有标注（包括背景项）
-            shouldHide = (itemType == "annotation");
-            // 如果父项是标注，也要隐藏
-            if (!shouldHide && item->parentItem()) {
-                QString parentType = item->parentItem()->data(0).toString();
-                shouldHide = (parentType == "annotation");
+        // 尚未加载过的图层不插入：显示时会整层加载，其结果已包含本次变更
+        int reloaded = 0;
+        for (const PipelineRenderRecord &record : records.pipelines) {
+            const LayerType layer = LayerItemRegistry::layerForPipelineType(record.pipelineType);
+            if (!isCurrent("pipelines", record.id) || !m_pipelineRenderer->isLayerLoaded(layer)) {
+                continue;
             }
-        } else if (type == Facilities) {
-            // 设施图层：隐藏所有设施
-            shouldHide = (itemType == "facility");
-        } else {
-            // 管线图层：隐藏对应类型的管线
-            shouldHide = (itemType == "pipeline" && itemSubType == targetType);
+            // 读取期间整层重新加载过时已有图形项，先移除避免重复
+            if (!removeEntityItem(m_itemRegistry->findPipeline(record.pipelineId, m_scene), true)) {
+                continue;
+            }
+            m_pipelineRenderer->insertPipeline(m_scene, record, isLayerVisible(layer));
+            reloaded++;
         }
-        
-        if (shouldHide) {
-            item->setVisible(false);
-            hiddenCount++;
-            qDebug() << "[LayerManager] ✓ Hidden item: type=" << itemType << "subType=" << itemSubType << "visible=" << item->isVisible();
+        for (const FacilityRenderRecord &record : records.facilities) {
+            if (!isCurrent("facilities", record.id) || !m_facilityRenderer->isLoaded()) {
+                continue;
+            }
+            if (!removeEntityItem(m_itemRegistry->findFacility(record.facilityId, m_scene), false)) {
+                continue;
+            }
+            m_facilityRenderer->insertFacilityItem(m_scene, record);
+            reloaded++;
         }
         
-        // 调试：输出所有管线项的信息
-        if (itemType == "pipeline") {
-            qDebug() << "[LayerManager] Pipeline item: subType=" << itemSubType 
-                     << "targetType=" << targetType 
-                     << "match=" << (itemSubType == targetType)
-                     << "visible=" << item->isVisible();
+        for (auto it = sequences.constBegin(); it != sequences.constEnd(); ++it) {
+            if (m_changeSequence.value(it.key()) == it.value()) {
+                m_changeSequence.remove(it.key());
+            }
         }
-        checkedCount++;
+        
+        finishEntityChanges(pipelinesChanged, facilitiesChanged, applied, reloaded);
+    });
+}
+
+bool LayerManager::removeEntityItem(QGraphicsItem *item, bool isPipeline)
+{
+    if (!item) {
+        return true;
+    }
+    
+    const EntityGraphicsItem *entity = EntityGraphicsItem::fromItem(item);
+    if (entity && entity->state() != EntityState::Unchanged) {
+        return false;
+    }
+    
+    emit entityItemAboutToBeRemoved(item);
+    if (isPipeline) {
+        m_pipelineRenderer->removePipelineItem(m_scene, item);
+    } else {
+        m_facilityRenderer->removeFacilityItem(m_scene, item);
+    }
+    return true;
+}
+
+void LayerManager::finishEntityChanges(bool pipelinesChanged, bool facilitiesChanged, int applied, int reloaded)
+{
+    // 3. 依赖要素数据的派生图层
+    if (pipelinesChanged && m_thematicRenderer->isActive()) {
+        m_thematicRenderer->reapply();
+    }
+    if ((pipelinesChanged || facilitiesChanged) && isLayerVisible(Labels) && m_annotationRenderer) {
+        m_annotationRenderer->renderAllAnnotations(m_visibleBounds);
+    }
+    if (applied > 0 && isLayerVisible(Heatmap) && m_heatmapRenderer) {
+        m_heatmapRenderer->renderHeatmap();
     }
     
-    qDebug() << "[LayerManager] Statistics: pipelines=" << pipelineCount << "facilities=" << facilityCount;
-    qDebug() << "[LayerManager] Checked" << checkedCount << "items, hidden" << hiddenCount << "items for layer" << getLayerName(type);
-    qDebug() << "[LayerManager] ========== clearLayer END ==========";
+    LOG_INFO(QString("Applied %1 remote entity changes (%2 items reloaded)").arg(applied).arg(reloaded));
+    emit entityChangesApplied(applied);
+}
+
+void LayerManager::clearLayer(LayerType type)
+{
+    if (!m_scene) {
+        return;
+    }
+    
+    LOG_DEBUG(QString("Clearing layer: %1").arg(getLayerName(type)));
+    qDebug() << "[LayerManager] Clearing layer:" << getLayerName(type);
+    
+    if (type == BaseMap) {
+        return;
+    }
+    
+    // 先隐藏注册表中属于该图层的图形项
+    int hiddenCount = m_itemRegistry->setLayerVisible(type, false);
     LOG_DEBUG(QString("Hidden %1 items for layer %2").arg(hiddenCount).arg(getLayerName(type)));
     
     // 然后调用渲染器的 clear 方法（隐藏缓存中的项）
@@ -455,6 +563,11 @@ void LayerManager::clearLayer(LayerType type)
             m_annotationRenderer->clearAll();
         }
         break;
+    case Heatmap:
+        if (m_heatmapRenderer) {
+            m_heatmapRenderer->clear();
+        }
+        break;
     default:
         break;
     }
@@ -487,6 +600,10 @@ void LayerManager::onDataChanged()
 
 void LayerManager::setZoom(int zoom)
 {
+    if (m_vectorTileCache) {
+        m_vectorTileCache->setZoom(zoom);
+    }
+    
     // 同步缩放级别到所有渲染器
     if (m_pipelineRenderer) {
         m_pipelineRenderer->setZoom(zoom);
@@ -500,11 +617,16 @@ void LayerManager::setZoom(int zoom)
     
     if (m_annotationRenderer) {
         m_annotationRenderer->setZoom(zoom);
-        // 如果缩放级别变化，可能需要重新渲染标注
+        // 缩放变化只需重新放置标注（后台计算），要素数据未变化无需重新采集
         if (isLayerVisible(Labels)) {
-            refreshLayer(Labels);
+            m_annotationRenderer->relayout();
         }
     }
+    
+    if (m_heatmapRenderer) {
+        // 热力图按缩放级别缓存栅格，可见时才计算
+        m_heatmapRenderer->setZoom(zoom);
+    }
 }
 
 void LayerManager::setTileSize(int tileSize)
@@ -5,11 +5,22 @@
 #include <QGraphicsScene>
 #include <QHash>
 #include <QString>
+#include <QVector>
+#include <QTimer>
+#include "core/database/changelistener.h"
 
+class QGraphicsItem;
 class PipelineRenderer;
 class FacilityRenderer;
 class AnnotationRenderer;
+class HeatmapRenderer;
 class TileMapManager;
+class LayerItemRegistry;
+class VectorTileCache;
+class EntityPickIndex;
+class ThematicAttributeTable;
+class ThematicRenderer;
+class AsyncDAO;
 
 /**
  * @brief 图层管理器
@@ -30,7 +41,8 @@ public:
         TelecomPipeline,    // 通信光缆
         HeatPipeline,       // 供热管线
         Facilities,         // 设施点层
-        Labels              // 标注层
+        Labels,             // 标注层
+        Heatmap             // 热力图层（故障点与低健康度管线密度）
     };
 
     explicit LayerManager(QGraphicsScene *scene, QObject *parent = nullptr);
@@ -55,6 +67,11 @@ public:
     void refreshLayer(LayerType type);
     void refreshAllLayers();
 
+    // 增量应用其他客户端的数据变更：只重建变更的图形项，不重载整层
+    // 本地有未保存修改（状态非 Unchanged）的实体保持本地版本，保存时再以本地为准
+    // 新增与更新的渲染记录在后台读取，返回后插入并发出 entityChangesApplied
+    void applyEntityChanges(const QVector<EntityChange> &changes);
+
     // 清空图层
     void clearLayer(LayerType type);
     void clearAllLayers();
@@ -63,6 +80,19 @@ public:
     PipelineRenderer* getPipelineRenderer() const { return m_pipelineRenderer; }
     FacilityRenderer* getFacilityRenderer() const { return m_facilityRenderer; }
     AnnotationRenderer* getAnnotationRenderer() const { return m_annotationRenderer; }
+    HeatmapRenderer* getHeatmapRenderer() const { return m_heatmapRenderer; }
+    
+    // 图层图形项注册表（按图层查询/显隐图形项，替代全场景扫描）
+    LayerItemRegistry* itemRegistry() const { return m_itemRegistry; }
+    
+    // 矢量图层栅格瓦片缓存
+    VectorTileCache* vectorTileCache() const { return m_vectorTileCache; }
+    
+    // 实体点选索引（管线线段与设施点，随注册表增删同步）
+    EntityPickIndex* entityPickIndex() const { return m_pickIndex; }
+    
+    // 专题渲染器（按专题字段分级着色，就地修改管线样式）
+    ThematicRenderer* getThematicRenderer() const { return m_thematicRenderer; }
 
     // 设置可视区域（用于按需加载）
     void setVisibleBounds(const QRectF &bounds);
@@ -79,8 +109,17 @@ signals:
     // 图层刷新信号
     void layerRefreshed(LayerType type);
     
+    // 管线/设施图层的后台加载全部完成（派生图层已刷新）
+    void layersLoaded();
+    
     // 数据加载进度信号
     void loadProgress(int current, int total);
+    
+    // 实体图形项即将被删除（增量更新时），持有图形项指针的一方须在此释放引用
+    void entityItemAboutToBeRemoved(QGraphicsItem *item);
+    
+    // 增量更新完成，changed 为实际处理的变更数
+    void entityChangesApplied(int changed);
 
 public slots:
     // 响应数据变化
@@ -94,6 +133,20 @@ private:
     PipelineRenderer *m_pipelineRenderer;
     FacilityRenderer *m_facilityRenderer;
     AnnotationRenderer *m_annotationRenderer;
+    HeatmapRenderer *m_heatmapRenderer;
+    
+    // 图层图形项注册表
+    LayerItemRegistry *m_itemRegistry;
+    
+    // 矢量图层栅格瓦片缓存
+    VectorTileCache *m_vectorTileCache;
+    
+    // 实体点选索引
+    EntityPickIndex *m_pickIndex;
+    
+    // 专题属性表与专题渲染器
+    ThematicAttributeTable *m_attributeTable;
+    ThematicRenderer *m_thematicRenderer;
     
     // 图层可见性状态
     QHash<LayerType, bool> m_layerVisibility;
@@ -101,6 +154,20 @@ private:
     // 当前可视区域
     QRectF m_visibleBounds;
     
+    // 要素图层后台加载完成后，合并刷新专题与标注等派生图层
+    QTimer m_derivedRefreshTimer;
+    void refreshDerivedLayers();
+    
+    // 远程变更的后台读取；按实体（表:主键）记录最近一次变更序号，旧读取结果不再插入
+    AsyncDAO *m_changeLoader;
+    QHash<QString, quint64> m_changeSequence;
+    quint64 m_changeCounter;
+    
+    // 移除实体图形项；本地有未保存修改时不移除并返回 false（item 为空时返回 true）
+    bool removeEntityItem(QGraphicsItem *item, bool isPipeline);
+    // 增量变更插入完成后刷新派生图层并发出 entityChangesApplied
+    void finishEntityChanges(bool pipelinesChanged, bool facilitiesChanged, int applied, int reloaded);
+    
     // 初始化图层
     void initializeLayers();
     
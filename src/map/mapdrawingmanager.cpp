@@ -1,5 +1,6 @@
 #include "map/mapdrawingmanager.h"
 #include "dao/facilitydao.h"
+#include "dao/asyncdao.h"
 #include <QPainterPath>
 #include <QDebug>
 #include <QtMath>
@@ -20,6 +21,8 @@ MapDrawingManager::MapDrawingManager(QGraphicsScene *scene,
     , m_previewLine(nullptr)
     , m_previewPoint(nullptr)
     , m_facilitySnapIndicator(nullptr)
+    , m_snapLoader(new AsyncDAO(this))
+    , m_snapZoom(-1)
     , m_drawingColor(QColor("#1890ff"))  // 默认蓝色
     , m_lineWidth(3)                      // 默认3px
 {
@@ -38,6 +41,9 @@ void MapDrawingManager::startDrawingPipeline(const QString &pipelineType)
     // 清除之前的绘制状态
     cancelDrawing();
     
+    // 上次绘制后可能新增了设施，吸附候选重新查询
+    resetSnapCandidates();
+    
     m_mode = DrawingPolyline;
     m_currentType = pipelineType;
     m_points.clear();
@@ -425,10 +431,12 @@ MapDrawingManager::NearbyFacility MapDrawingManager::findNearbyFacility(const QP
     double metersPerPixel = 156543.03392 * cos(qDegreesToRadians(geoPos.y())) / qPow(2.0, zoom);
     double toleranceMeters = tolerancePixels * metersPerPixel;
     
-    // 查找附近的设施
-    FacilityDAO facilityDao;
-    QVector<Facility> facilities = facilityDao.findNearPoint(geoPos.x(), geoPos.y(), toleranceMeters, 10);
+    // 光标移出已预取范围（或缩放变化）时后台查询新的候选，本次先用已有候选
+    if (zoom != m_snapZoom || !m_snapRegion.contains(geoPos)) {
+        requestSnapCandidates(geoPos, toleranceMeters, zoom);
+    }
     
+    const QVector<Facility> &facilities = m_snapCandidates;
     if (facilities.isEmpty()) {
         return result;
     }
@@ -449,6 +457,47 @@ MapDrawingManager::NearbyFacility MapDrawingManager::findNearbyFacility(const QP
     return result;
 }
 
+void MapDrawingManager::requestSnapCandidates(const QPointF &geoPos, double toleranceMeters, int zoom)
+{
+    if (zoom == m_snapZoom && m_snapPendingRegion.contains(geoPos)) {
+        return;
+    }
+    
+    // 预取半径内再留出一个容差，光标在内接正方形内移动时候选都完整
+    const double radiusMeters = toleranceMeters * SNAP_PREFETCH_FACTOR;
+    const double halfMeters = (radiusMeters - toleranceMeters) / M_SQRT2;
+    const double halfLat = halfMeters / 111320.0;
+    const double halfLon = halfMeters / (111320.0 * qMax(0.01, cos(qDegreesToRadians(geoPos.y()))));
+    const QRectF region(geoPos.x() - halfLon, geoPos.y() - halfLat, halfLon * 2, halfLat * 2);
+    
+    m_snapLoader->cancelAll();
+    m_snapPendingRegion = region;
+    if (zoom != m_snapZoom) {
+        m_snapCandidates.clear();
+        m_snapRegion = QRectF();
+        m_snapZoom = zoom;
+    }
+    
+    const double lon = geoPos.x();
+    const double lat = geoPos.y();
+    m_snapLoader->run([lon, lat, radiusMeters]() {
+        return FacilityDAO().findNearPoint(lon, lat, radiusMeters, 200);
+    }, [this, region](const QVector<Facility> &facilities) {
+        m_snapCandidates = facilities;
+        m_snapRegion = region;
+        m_snapPendingRegion = QRectF();
+    });
+}
+
+void MapDrawingManager::resetSnapCandidates()
+{
+    m_snapLoader->cancelAll();
+    m_snapCandidates.clear();
+    m_snapRegion = QRectF();
+    m_snapPendingRegion = QRectF();
+    m_snapZoom = -1;
+}
+
 void MapDrawingManager::updateFacilitySnapIndicator(const QPointF &facilityPos)
 {
     // 清除旧的指示器
@@ -15,6 +15,8 @@
 #include "tilemap/tilemapmanager.h"
 #include "core/models/facility.h"
 
+class AsyncDAO;
+
 /**
  * @brief 地图绘制管理器
  * 
@@ -149,6 +151,8 @@ private:
         double distance;
     };
     NearbyFacility findNearbyFacility(const QPointF &scenePos, double tolerancePixels = 20.0);
+    void requestSnapCandidates(const QPointF &geoPos, double toleranceMeters, int zoom);
+    void resetSnapCandidates();
     void updateFacilitySnapIndicator(const QPointF &facilityPos);
     void clearFacilitySnapIndicator();
     
@@ -171,6 +175,14 @@ private:
     // 设施连接信息
     QVector<QString> m_connectedFacilityIds;  // 已连接的设施ID（按点顺序）
     
+    // 吸附候选设施：后台按光标周边范围预取，鼠标移动时只在内存中查找
+    AsyncDAO *m_snapLoader;
+    QVector<Facility> m_snapCandidates;
+    QRectF m_snapRegion;            // 候选覆盖的地理范围（光标在此范围内无需重新查询）
+    QRectF m_snapPendingRegion;     // 查询中的范围
+    int m_snapZoom;                 // 候选对应的缩放级别（容差随缩放变化）
+    static const int SNAP_PREFETCH_FACTOR = 10;     // 预取半径 = 容差 × 该倍数
+    
     // 样式配置
     static const int POINT_MARKER_SIZE = 8;         // 点标记大小
     static const int PREVIEW_POINT_SIZE = 12;       // 预览点大小
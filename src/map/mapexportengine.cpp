@@ -0,0 +1,444 @@
+#include "map/mapexportengine.h"
+#include "map/layeritemregistry.h"
+#include "map/layermanager.h"
+#include "map/entitygraphicsitem.h"
+#include "map/symbolmanager.h"
+#include "core/io/streamingpngwriter.h"
+#include "core/common/logger.h"
+#include "core/common/entitystate.h"
+#include "dao/pipelinedao.h"
+#include "dao/facilitydao.h"
+#include <QGraphicsScene>
+#include <QPainter>
+#include <QPdfWriter>
+#include <QPageSize>
+#include <QFile>
+#include <QFileInfo>
+#include <QThread>
+#include <QThreadPool>
+#include <QElapsedTimer>
+#include <QScopedPointer>
+#include <QtMath>
+#include <QtConcurrent/QtConcurrent>
+#include <cmath>
+#include <cstring>
+
+namespace {
+// 底图瓦片尺寸
+const int BASEMAP_TILE_SIZE = 256;
+// 缺少瓦片时向上回退的最大层级数
+const int MAX_BASEMAP_FALLBACK = 3;
+// 条带高度范围（像素）
+const int MIN_BAND_HEIGHT = 16;
+const int MAX_BAND_HEIGHT = 512;
+}
+
+MapExportSpec::Format MapExportSpec::formatForPath(const QString &path)
+{
+    return QFileInfo(path).suffix().compare("pdf", Qt::CaseInsensitive) == 0 ? Pdf : Png;
+}
+
+MapExportEngine::MapExportEngine(QObject *parent)
+    : QObject(parent)
+    , m_watcher(nullptr)
+    , m_cancelled(0)
+{
+}
+
+MapExportEngine::~MapExportEngine()
+{
+    if (m_watcher) {
+        m_cancelled.storeRelaxed(1);
+        m_watcher->waitForFinished();
+    }
+}
+
+bool MapExportEngine::start(const MapExportSpec &spec, const QVector<MapExportFeature> &features)
+{
+    if (isRunning()) {
+        return false;
+    }
+    m_cancelled.storeRelaxed(0);
+
+    m_watcher = new QFutureWatcher<ExportResult>(this);
+    connect(m_watcher, &QFutureWatcher<ExportResult>::finished, this, [this]() {
+        ExportResult result = m_watcher->result();
+        m_watcher->deleteLater();
+        m_watcher = nullptr;
+        emit finished(result.success, result.message);
+    });
+
+    // 工作线程中发出的 progress 信号按队列方式投递给界面
+    m_watcher->setFuture(QtConcurrent::run([this, spec, features]() {
+        QString error;
+        bool ok = exportMap(spec, features, [this](int done, int total) {
+            emit progress(done, total);
+            return m_cancelled.loadRelaxed() == 0;
+        }, &error);
+        return ExportResult{ok, ok ? spec.outputPath : error};
+    }));
+    return true;
+}
+
+void MapExportEngine::cancel()
+{
+    m_cancelled.storeRelaxed(1);
+}
+
+bool MapExportEngine::isRunning() const
+{
+    return m_watcher && m_watcher->isRunning();
+}
+
+QPointF MapExportEngine::geoToPixel(double lon, double lat, int zoom)
+{
+    // 与 TileMapManager::geoToScene 相同的 Web 墨卡托像素坐标
+    double n = std::ldexp(1.0, zoom);
+    double latRad = qDegreesToRadians(lat);
+    double x = (lon + 180.0) / 360.0 * n;
+    double y = (1.0 - std::log(std::tan(latRad) + 1.0 / std::cos(latRad)) / M_PI) / 2.0 * n;
+    return QPointF(x * BASEMAP_TILE_SIZE, y * BASEMAP_TILE_SIZE);
+}
+
+QRect MapExportEngine::pixelRect(const MapExportSpec &spec)
+{
+    const QRectF geo = spec.geoBounds.normalized();
+    QPointF topLeft = geoToPixel(geo.left(), geo.bottom(), spec.zoom);
+    QPointF bottomRight = geoToPixel(geo.right(), geo.top(), spec.zoom);
+    int left = qFloor(topLeft.x());
+    int top = qFloor(topLeft.y());
+    int right = qCeil(bottomRight.x());
+    int bottom = qCeil(bottomRight.y());
+    return QRect(left, top, right - left, bottom - top);
+}
+
+bool MapExportEngine::exportMap(const MapExportSpec &spec,
+                                const QVector<MapExportFeature> &features,
+                                const ProgressCallback &progress,
+                                QString *errorMessage)
+{
+    auto fail = [errorMessage](const QString &message) {
+        LOG_WARNING(QString("Map export failed: %1").arg(message));
+        if (errorMessage) {
+            *errorMessage = message;
+        }
+        return false;
+    };
+
+    if (spec.outputPath.isEmpty()) {
+        return fail("未指定输出文件");
+    }
+    if (spec.zoom < 0 || spec.zoom > 24 || spec.geoBounds.isEmpty()) {
+        return fail("导出范围或缩放级别无效");
+    }
+    const QRect outputRect = pixelRect(spec);
+    if (outputRect.width() <= 0 || outputRect.height() <= 0) {
+        return fail("导出范围为空");
+    }
+    if (outputRect.width() > MAX_OUTPUT_SIZE || outputRect.height() > MAX_OUTPUT_SIZE) {
+        return fail(QString("输出尺寸过大: %1x%2，请降低缩放级别或缩小范围")
+                        .arg(outputRect.width()).arg(outputRect.height()));
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // 条带高度：一个条带内所有瓦片的像素总量不超过内存预算
+    const qint64 budgetBytes = qint64(qMax(1, spec.memoryBudgetMb)) * 1024 * 1024;
+    const int bandHeight = int(qBound<qint64>(MIN_BAND_HEIGHT,
+                                              budgetBytes / (qint64(outputRect.width()) * 4),
+                                              MAX_BAND_HEIGHT));
+    const int bandCount = (outputRect.height() + bandHeight - 1) / bandHeight;
+
+    // 要素按条带分桶（只保存索引）
+    QVector<QVector<int>> bandFeatures(spec.includeVectors ? bandCount : 0);
+    if (spec.includeVectors) {
+        for (int i = 0; i < features.size(); ++i) {
+            const QRectF bounds = features[i].bounds.intersected(outputRect);
+            if (bounds.isEmpty()) {
+                continue;
+            }
+            int first = qMax(0, int((bounds.top() - outputRect.top()) / bandHeight));
+            int last = qMin(bandCount - 1, int((bounds.bottom() - outputRect.top()) / bandHeight));
+            for (int band = first; band <= last; ++band) {
+                bandFeatures[band].append(i);
+            }
+        }
+    }
+
+    // 输出目标
+    QScopedPointer<StreamingPngWriter> pngWriter;
+    QScopedPointer<QPdfWriter> pdfWriter;
+    QPainter pdfPainter;
+    if (spec.format == MapExportSpec::Pdf) {
+        pdfWriter.reset(new QPdfWriter(spec.outputPath));
+        pdfWriter->setResolution(spec.dpi);
+        pdfWriter->setPageSize(QPageSize(QSizeF(outputRect.width() * 25.4 / spec.dpi,
+                                                outputRect.height() * 25.4 / spec.dpi),
+                                         QPageSize::Millimeter));
+        pdfWriter->setPageMargins(QMarginsF(0, 0, 0, 0));
+        if (!pdfPainter.begin(pdfWriter.data())) {
+            return fail(QString("无法写入文件: %1").arg(spec.outputPath));
+        }
+    } else {
+        pngWriter.reset(new StreamingPngWriter(spec.outputPath));
+        if (!pngWriter->open(outputRect.width(), outputRect.height(), spec.dpi)) {
+            return fail(pngWriter->errorString());
+        }
+    }
+
+    auto abort = [&](const QString &message) {
+        if (pdfPainter.isActive()) {
+            pdfPainter.end();
+        }
+        pdfWriter.reset();
+        pngWriter.reset();
+        QFile::remove(spec.outputPath);
+        return fail(message);
+    };
+
+    // 独立线程池，避免占满全局线程池影响界面中的瓦片加载
+    QThreadPool pool;
+    pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount()));
+
+    QVector<QRgb> row(outputRect.width());
+    const QVector<int> noFeatures;
+    for (int band = 0; band < bandCount; ++band) {
+        if (progress && !progress(band, bandCount)) {
+            return abort("导出已取消");
+        }
+
+        const int bandTop = outputRect.top() + band * bandHeight;
+        const int height = qMin(bandHeight, outputRect.bottom() + 1 - bandTop);
+        QVector<QRect> tiles;
+        for (int x = outputRect.left(); x <= outputRect.right(); x += TILE_WIDTH) {
+            tiles.append(QRect(x, bandTop, qMin(TILE_WIDTH, outputRect.right() + 1 - x), height));
+        }
+
+        const QVector<int> &indices = spec.includeVectors ? bandFeatures[band] : noFeatures;
+        const QVector<QImage> images = QtConcurrent::blockingMapped<QVector<QImage>>(
+            &pool, tiles, [&spec, &features, &indices](const QRect &tileRect) {
+                return renderTile(tileRect, spec, features, indices);
+            });
+
+        if (pngWriter) {
+            for (int y = 0; y < height; ++y) {
+                for (int i = 0; i < tiles.size(); ++i) {
+                    std::memcpy(row.data() + (tiles[i].left() - outputRect.left()),
+                                images[i].constScanLine(y),
+                                size_t(tiles[i].width()) * sizeof(QRgb));
+                }
+                if (!pngWriter->writeRow(row.constData())) {
+                    return abort(pngWriter->errorString());
+                }
+            }
+        } else {
+            for (int i = 0; i < tiles.size(); ++i) {
+                pdfPainter.drawImage(tiles[i].topLeft() - outputRect.topLeft(), images[i]);
+            }
+        }
+    }
+
+    if (pngWriter) {
+        if (!pngWriter->finish()) {
+            return abort(pngWriter->errorString());
+        }
+    } else {
+        pdfPainter.end();
+    }
+    if (progress) {
+        progress(bandCount, bandCount);
+    }
+
+    LOG_INFO(QString("Map exported: %1 (%2x%3 px, zoom %4, %5 bands, %6 ms)")
+                 .arg(spec.outputPath)
+                 .arg(outputRect.width()).arg(outputRect.height())
+                 .arg(spec.zoom).arg(bandCount).arg(timer.elapsed()));
+    return true;
+}
+
+QImage MapExportEngine::renderTile(const QRect &tileRect,
+                                   const MapExportSpec &spec,
+                                   const QVector<MapExportFeature> &features,
+                                   const QVector<int> &featureIndices)
+{
+    QImage image(tileRect.size(), QImage::Format_RGB32);
+    image.fill(spec.background);
+
+    QPainter painter(&image);
+    if (spec.includeBasemap && !spec.basemapDir.isEmpty()) {
+        drawBasemap(painter, tileRect, spec);
+    }
+
+    if (!featureIndices.isEmpty()) {
+        painter.setRenderHint(QPainter::Antialiasing, true);
+        painter.translate(-tileRect.topLeft());
+        for (int index : featureIndices) {
+            const MapExportFeature &feature = features[index];
+            if (!feature.bounds.intersects(tileRect)) {
+                continue;
+            }
+            painter.setPen(feature.pen);
+            painter.setBrush(feature.brush);
+            if (feature.kind == MapExportFeature::Point) {
+                painter.drawEllipse(feature.center, feature.radius, feature.radius);
+            } else {
+                painter.drawPath(feature.path);
+            }
+        }
+    }
+    painter.end();
+    return image;
+}
+
+void MapExportEngine::drawBasemap(QPainter &painter, const QRect &tileRect, const MapExportSpec &spec)
+{
+    painter.setRenderHint(QPainter::SmoothPixmapTransform, true);
+
+    const int maxIndex = (1 << spec.zoom) - 1;
+    const int firstX = qMax(0, tileRect.left() / BASEMAP_TILE_SIZE);
+    const int lastX = qMin(maxIndex, tileRect.right() / BASEMAP_TILE_SIZE);
+    const int firstY = qMax(0, tileRect.top() / BASEMAP_TILE_SIZE);
+    const int lastY = qMin(maxIndex, tileRect.bottom() / BASEMAP_TILE_SIZE);
+
+    for (int ty = firstY; ty <= lastY; ++ty) {
+        for (int tx = firstX; tx <= lastX; ++tx) {
+            const QRect target(tx * BASEMAP_TILE_SIZE - tileRect.left(),
+                               ty * BASEMAP_TILE_SIZE - tileRect.top(),
+                               BASEMAP_TILE_SIZE, BASEMAP_TILE_SIZE);
+
+            // 本级瓦片缺失时取上级瓦片的对应子区域放大
+            for (int up = 0; up <= MAX_BASEMAP_FALLBACK && up <= spec.zoom; ++up) {
+                const QString path = QString("%1/%2/%3/%4.png").arg(spec.basemapDir)
+                                         .arg(spec.zoom - up).arg(tx >> up).arg(ty >> up);
+                QImage tile;
+                if (!QFile::exists(path) || !tile.load(path)) {
+                    continue;
+                }
+                const int subSize = BASEMAP_TILE_SIZE >> up;
+                const int mask = (1 << up) - 1;
+                const QRect source((tx & mask) * subSize, (ty & mask) * subSize, subSize, subSize);
+                painter.drawImage(target, tile, source);
+                break;
+            }
+        }
+    }
+}
+
+QVector<MapExportFeature> MapExportEngine::snapshotScene(const QGraphicsScene *scene,
+                                                         const LayerItemRegistry *registry,
+                                                         const LayerManager *layerManager,
+                                                         int itemZoom,
+                                                         const MapExportSpec &spec)
+{
+    QVector<MapExportFeature> features;
+    if (!scene || !registry) {
+        return features;
+    }
+
+    // 场景坐标（itemZoom 级像素）-> 导出级像素；线宽与符号按打印分辨率放大
+    const qreal zoomScale = std::ldexp(1.0, spec.zoom - itemZoom);
+    const qreal symbolScale = spec.dpi / 96.0;
+    const QTransform toExport = QTransform::fromScale(zoomScale, zoomScale);
+
+    // 低层级下被聚类隐藏的设施仍需导出，因此按图层显隐而不是图形项可见性过滤
+    const QList<QGraphicsItem*> items = registry->entityItems(scene);
+    features.reserve(items.size());
+    for (QGraphicsItem *item : items) {
+        LayerManager::LayerType layer;
+        if (!registry->layerOf(item, &layer)) {
+            continue;
+        }
+        if (layerManager ? !layerManager->isLayerVisible(layer) : !item->isVisible()) {
+            continue;
+        }
+        const EntityGraphicsItem *entity = EntityGraphicsItem::fromItem(item);
+        if (!entity || entity->state() == EntityState::Deleted) {
+            continue;
+        }
+
+        MapExportFeature feature;
+        if (auto *pipeline = qgraphicsitem_cast<PipelineGraphicsItem*>(item)) {
+            feature.kind = MapExportFeature::Line;
+            feature.path = (item->sceneTransform() * toExport).map(pipeline->path());
+            feature.pen = pipeline->pen();
+            feature.pen.setCosmetic(false);
+            feature.pen.setWidthF(qMax<qreal>(1.0, feature.pen.widthF()) * symbolScale);
+            feature.bounds = feature.path.boundingRect().adjusted(
+                -feature.pen.widthF(), -feature.pen.widthF(), feature.pen.widthF(), feature.pen.widthF());
+        } else if (auto *facility = qgraphicsitem_cast<FacilityGraphicsItem*>(item)) {
+            const QRectF rect = facility->rect();
+            feature.kind = MapExportFeature::Point;
+            feature.center = (item->sceneTransform() * toExport).map(rect.center());
+            feature.pen = facility->pen();
+            feature.pen.setCosmetic(false);
+            feature.pen.setWidthF(feature.pen.widthF() * symbolScale);
+            feature.brush = facility->brush();
+            feature.radius = rect.width() / 2.0 * symbolScale;
+            const qreal extent = feature.radius + feature.pen.widthF();
+            feature.bounds = QRectF(feature.center - QPointF(extent, extent),
+                                    QSizeF(extent * 2, extent * 2));
+        } else {
+            continue;
+        }
+        features.append(feature);
+    }
+    return features;
+}
+
+QVector<MapExportFeature> MapExportEngine::loadFeatures(const MapExportSpec &spec)
+{
+    QVector<MapExportFeature> features;
+    SymbolManager symbols;
+    const qreal symbolScale = spec.dpi / 96.0;
+
+    // 按 id 键集分页读取范围内的全部要素，不截断
+    QVariantMap boundsParams;
+    SqlDialect::bindBounds(boundsParams, spec.geoBounds);
+
+    PipelineDAO pipelineDao;
+    const QVector<PipelineRenderRecord> pipelines = pipelineDao.loadRenderRecords(
+        pipelineDao.dialect().intersectsBoundsFilter(pipelineDao.tableName()), boundsParams);
+    for (const PipelineRenderRecord &pipeline : pipelines) {
+        const QVector<QPointF> &coords = pipeline.coordinates;
+        if (coords.size() < 2) {
+            continue;
+        }
+        MapExportFeature feature;
+        feature.kind = MapExportFeature::Line;
+        feature.path.moveTo(geoToPixel(coords[0].x(), coords[0].y(), spec.zoom));
+        for (int i = 1; i < coords.size(); ++i) {
+            feature.path.lineTo(geoToPixel(coords[i].x(), coords[i].y(), spec.zoom));
+        }
+        feature.pen = symbols.getPipelinePen(pipeline.pipelineType, pipeline.diameterMm);
+        feature.pen.setWidthF(feature.pen.widthF() * symbolScale);
+        const qreal width = feature.pen.widthF();
+        feature.bounds = feature.path.boundingRect().adjusted(-width, -width, width, width);
+        features.append(feature);
+    }
+
+    FacilityDAO facilityDao;
+    const QVector<FacilityRenderRecord> facilities = facilityDao.loadRenderRecords(
+        facilityDao.dialect().withinBoundsFilter(facilityDao.tableName()), boundsParams);
+    for (const FacilityRenderRecord &facility : facilities) {
+        MapExportFeature feature;
+        feature.kind = MapExportFeature::Point;
+        feature.center = geoToPixel(facility.coordinate.x(), facility.coordinate.y(), spec.zoom);
+        feature.radius = symbols.getFacilityIconSize(facility.facilityType) / 2.0 * symbolScale;
+        feature.brush = symbols.getFacilityBrush(facility.facilityType);
+        // 外框颜色与 FacilityRenderer 一致：按健康度区分
+        feature.pen = QPen(Qt::black, 1.5 * symbolScale);
+        if (facility.healthScore < 60) {
+            feature.pen = QPen(Qt::red, 2 * symbolScale);
+        } else if (facility.healthScore < 80) {
+            feature.pen.setColor(Qt::darkYellow);
+        }
+        const qreal extent = feature.radius + feature.pen.widthF();
+        feature.bounds = QRectF(feature.center - QPointF(extent, extent), QSizeF(extent * 2, extent * 2));
+        features.append(feature);
+    }
+
+    LOG_INFO(QString("Map export features loaded: %1 pipelines, %2 facilities")
+                 .arg(pipelines.size()).arg(facilities.size()));
+    return features;
+}
@@ -0,0 +1,126 @@
+#ifndef MAPEXPORTENGINE_H
+#define MAPEXPORTENGINE_H
+
+#include <QObject>
+#include <QRectF>
+#include <QRect>
+#include <QColor>
+#include <QPen>
+#include <QBrush>
+#include <QPainterPath>
+#include <QVector>
+#include <QImage>
+#include <QFutureWatcher>
+#include <QAtomicInt>
+#include <functional>
+
+class QGraphicsScene;
+class LayerItemRegistry;
+class LayerManager;
+
+/**
+ * @brief 地图导出参数（区域 + 缩放级别，可脱离界面使用）
+ */
+struct MapExportSpec {
+    enum Format { Png = 0, Pdf = 1 };
+
+    QRectF geoBounds;           // 经纬度范围（x=最小经度，y=最小纬度）
+    int zoom = 18;              // 导出像素网格对应的瓦片缩放级别
+    QString outputPath;
+    Format format = Png;
+    int dpi = 300;              // 线宽/符号按 dpi/96 放大，并写入输出文件分辨率
+    QString basemapDir;         // 底图瓦片目录（z/x/y.png），为空时不绘制底图
+    bool includeBasemap = true;
+    bool includeVectors = true;
+    int memoryBudgetMb = 64;    // 单个条带的像素内存上限
+    QColor background = Qt::white;
+
+    // 按文件后缀确定格式（.pdf 为 PDF，其余为 PNG）
+    static Format formatForPath(const QString &path);
+};
+
+/**
+ * @brief 导出要素（导出缩放级别全局像素坐标下的几何与样式快照）
+ */
+struct MapExportFeature {
+    enum Kind { Line = 0, Point = 1 };
+
+    Kind kind = Line;
+    QPainterPath path;
+    QPointF center;
+    qreal radius = 0;
+    QPen pen;
+    QBrush brush;
+    QRectF bounds;              // 含线宽/半径的外包矩形
+};
+
+/**
+ * @brief 高分辨率地图导出引擎
+ * 输出图像按水平条带逐段生成，每个条带再切成固定宽度的瓦片，由独立线程池中的
+ * 离屏 QPainter 并行绘制底图与矢量要素；条带完成后立即写入流式 PNG 或 PDF，
+ * 随即释放，峰值内存只取决于条带大小而与输出幅面无关
+ *
+ * 要素需事先采集：界面中用 snapshotScene() 取当前场景，无界面时用
+ * loadFeatures() 直接查询数据库（须在持有数据库连接的线程中调用）
+ */
+class MapExportEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    // 进度回调：返回 false 时取消导出
+    using ProgressCallback = std::function<bool(int done, int total)>;
+
+    static const int TILE_WIDTH = 512;
+    static const int MAX_OUTPUT_SIZE = 200000;
+
+    explicit MapExportEngine(QObject *parent = nullptr);
+    ~MapExportEngine();
+
+    // 在后台线程执行导出，通过 progress()/finished() 信号报告
+    bool start(const MapExportSpec &spec, const QVector<MapExportFeature> &features);
+    void cancel();
+    bool isRunning() const;
+
+    // 同步导出（命令行、批处理等无界面场景）
+    static bool exportMap(const MapExportSpec &spec,
+                          const QVector<MapExportFeature> &features,
+                          const ProgressCallback &progress = ProgressCallback(),
+                          QString *errorMessage = nullptr);
+
+    // 采集场景中可见图层的实体图形项（GUI线程），itemZoom 为图形项场景坐标对应的缩放级别
+    static QVector<MapExportFeature> snapshotScene(const QGraphicsScene *scene,
+                                                   const LayerItemRegistry *registry,
+                                                   const LayerManager *layerManager,
+                                                   int itemZoom,
+                                                   const MapExportSpec &spec);
+
+    // 从数据库查询导出范围内的管线与设施并符号化
+    static QVector<MapExportFeature> loadFeatures(const MapExportSpec &spec);
+
+    // 导出范围在导出缩放级别下的全局像素矩形
+    static QRect pixelRect(const MapExportSpec &spec);
+    static QPointF geoToPixel(double lon, double lat, int zoom);
+
+signals:
+    void progress(int done, int total);
+    void finished(bool success, const QString &pathOrError);
+
+private:
+    struct ExportResult {
+        bool success;
+        QString message;
+    };
+
+    // 渲染一个瓦片（工作线程）
+    static QImage renderTile(const QRect &tileRect,
+                             const MapExportSpec &spec,
+                             const QVector<MapExportFeature> &features,
+                             const QVector<int> &featureIndices);
+    static void drawBasemap(QPainter &painter, const QRect &tileRect, const MapExportSpec &spec);
+
+    QFutureWatcher<ExportResult> *m_watcher;
+    QAtomicInt m_cancelled;
+};
+
+#endif // MAPEXPORTENGINE_H
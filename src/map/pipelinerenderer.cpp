@@ -1,6 +1,10 @@
 #include "map/pipelinerenderer.h"
+#include "map/entitygraphicsitem.h"
 #include "map/symbolmanager.h"
+#include "map/layeritemregistry.h"
+#include "map/thematicattributetable.h"
 #include "dao/pipelinedao.h"
+#include "dao/asyncdao.h"
 #include "tilemap/tilemapmanager.h"
 #include "core/common/logger.h"
 #include "core/common/entitystate.h"  // 实体状态枚举
@@ -11,8 +15,10 @@
 PipelineRenderer::PipelineRenderer(QObject *parent)
     : QObject(parent)
     , m_symbolManager(new SymbolManager(this))
-    , m_pipelineDao(new PipelineDAO())
+    , m_loader(new AsyncDAO(this))
     , m_tileMapManager(nullptr)
+    , m_itemRegistry(nullptr)
+    , m_attributeTable(nullptr)
     , m_scale(1.0)
     , m_zoom(10)          // 默认缩放级别
     , m_tileSize(256)     // 默认瓦片大小
@@ -25,7 +31,6 @@ PipelineRenderer::PipelineRenderer(QObject *parent)
 
 PipelineRenderer::~PipelineRenderer()
 {
-    delete m_pipelineDao;
 }
 
 void PipelineRenderer::renderPipelines(QGraphicsScene *scene, 
@@ -43,19 +48,44 @@ void PipelineRenderer::renderPipelines(QGraphicsScene *scene,
     qDebug() << "[PipelineRenderer] TileMapManager:" << (m_tileMapManager ? "SET" : "NULL");
     qDebug() << "[PipelineRenderer] Current zoom:" << m_zoom;
     
-    // 1. 从数据库加载管线数据
-    QVector<Pipeline> pipelines;
-    
-    // 临时：先不使用 bounds 查询，直接查询所有类型的管线来测试
-    qDebug() << "[PipelineRenderer] Querying by type (ignore bounds for now)...";
-    pipelines = m_pipelineDao->findByType(pipelineType, 1000);
+    // 1. 后台加载管线渲染投影（只取渲染所需列），完成后在界面线程渲染
+    // 同一图层重复请求时只渲染最后一次的结果
+    LayerManager::LayerType layerType = getLayerTypeFromPipelineType(pipelineType);
+    const quint64 request = ++m_loadRequests[layerType];
+    
+    // 加载该类型的全部管线（按 id 键集分页，不截断）：图形项在平移缩放时保留在场景中，
+    // 不随视口重新查询
+    m_loader->run([pipelineType]() {
+        QVariantMap params;
+        params[":type"] = pipelineType;
+        return PipelineDAO().loadRenderRecords("pipeline_type = :type", params);
+    }, [this, scene, pipelineType, layerType, request](const QVector<PipelineRenderRecord> &pipelines) {
+        if (m_loadRequests.value(layerType) != request) {
+            return;
+        }
+        renderRecords(scene, pipelineType, pipelines);
+    });
+}
+
+bool PipelineRenderer::isLoading() const
+{
+    return m_loader->isBusy();
+}
+
+void PipelineRenderer::renderRecords(QGraphicsScene *scene,
+                                     const QString &pipelineType,
+                                     const QVector<PipelineRenderRecord> &pipelines)
+{
     LOG_INFO(QString("Loaded %1 pipelines of type %2")
                  .arg(pipelines.size()).arg(pipelineType));
     qDebug() << "[PipelineRenderer] Found" << pipelines.size() << "pipelines of type" << pipelineType;
     
+    m_loadedLayers.insert(getLayerTypeFromPipelineType(pipelineType));
+    
     if (pipelines.isEmpty()) {
         LOG_WARNING(QString("No pipelines found for type: %1").arg(pipelineType));
         qDebug() << "[PipelineRenderer] ⚠️  No data found in database!";
+        emit renderComplete(0);
         return;
     }
     
@@ -69,6 +99,12 @@ void PipelineRenderer::renderPipelines(QGraphicsScene *scene,
         // 从场景中移除旧项
         for (QGraphicsItem *item : m_itemsCache[layerType]) {
             if (item && scene) {
+                if (m_itemRegistry) {
+                    m_itemRegistry->removeItem(item);
+                }
+                if (m_attributeTable) {
+                    m_attributeTable->removeItem(static_cast<QGraphicsPathItem*>(item));
+                }
                 scene->removeItem(item);
                 delete item;
             }
@@ -77,10 +113,10 @@ void PipelineRenderer::renderPipelines(QGraphicsScene *scene,
     }
     
     for (int i = 0; i < pipelines.size(); i++) {
-        const Pipeline &pipeline = pipelines[i];
+        const PipelineRenderRecord &pipeline = pipelines[i];
         
         // 只渲染指定类型的管线
-        if (pipeline.pipelineType() == pipelineType) {
+        if (pipeline.pipelineType == pipelineType) {
             QGraphicsPathItem *item = renderPipeline(scene, pipeline);
             if (item) {
                 // 缓存图形项
@@ -102,17 +138,17 @@ void PipelineRenderer::renderPipelines(QGraphicsScene *scene,
 }
 
 QGraphicsPathItem* PipelineRenderer::renderPipeline(QGraphicsScene *scene, 
-                                                    const Pipeline &pipeline)
+                                                    const PipelineRenderRecord &pipeline)
 {
     if (!scene || !pipeline.isValid()) {
         return nullptr;
     }
     
     // 获取管线坐标
-    QVector<QPointF> coords = pipeline.coordinates();
+    const QVector<QPointF> &coords = pipeline.coordinates;
     if (coords.size() < 2) {
         LOG_WARNING(QString("Pipeline %1 has insufficient coordinates")
-                        .arg(pipeline.pipelineId()));
+                        .arg(pipeline.pipelineId));
         return nullptr;
     }
     
@@ -124,7 +160,7 @@ QGraphicsPathItem* PipelineRenderer::renderPipeline(QGraphicsScene *scene,
     // 调试：输出第一个坐标的转换结果（只输出第一条管线）
     static bool firstPipeline = true;
     if (firstPipeline) {
-        qDebug() << "[PipelineRenderer] Pipeline" << pipeline.pipelineId() 
+        qDebug() << "[PipelineRenderer] Pipeline" << pipeline.pipelineId 
                  << "geo:" << coords[0] << "-> scene:" << firstPoint;
         firstPipeline = false;
     }
@@ -136,33 +172,46 @@ QGraphicsPathItem* PipelineRenderer::renderPipeline(QGraphicsScene *scene,
     
     // 2. 获取样式
     QPen pen = m_symbolManager->getPipelinePen(
-        pipeline.pipelineType(),
-        pipeline.diameterMm()
+        pipeline.pipelineType,
+        pipeline.diameterMm
     );
     
     // 根据健康度调整透明度
-    if (pipeline.healthScore() < 60) {
+    if (pipeline.healthScore < 60) {
         QColor color = pen.color();
         color.setAlpha(180);  // 不健康的管线半透明
         pen.setColor(color);
     }
     
     // 3. 创建图形项并添加到场景
-    QGraphicsPathItem *item = scene->addPath(path, pen);
+    PipelineGraphicsItem *item = new PipelineGraphicsItem(path);
+    item->setPen(pen);
+    scene->addItem(item);
+    
+    // 4. 设置实体字段（用于后续查询和删除）
+    item->setEntityId(pipeline.pipelineId);  // 管线编号（与 DrawingDatabaseManager 保持一致）
+    item->setEntityType(pipeline.pipelineType);  // 管线类型
+    item->setName(pipeline.pipelineName);  // 管线名称（用于标注显示）
+    item->setDiameterMm(pipeline.diameterMm);  // 管径（用于标注优先级）
+    item->setDatabaseId(pipeline.id);  // 数据库ID
+    item->setState(EntityState::Unchanged);  // 实体状态：未变更
+    
+    // 登记到图层注册表
+    if (m_itemRegistry) {
+        m_itemRegistry->addItem(getLayerTypeFromPipelineType(pipeline.pipelineType), item);
+    }
     
-    // 4. 设置数据（用于后续查询和删除）
-    item->setData(0, "pipeline");  // 类型标记
-    item->setData(1, pipeline.pipelineId());  // 管线编号（与 DrawingDatabaseManager 保持一致）
-    item->setData(2, pipeline.pipelineType());  // 管线类型
-    item->setData(10, pipeline.id());  // 数据库ID（存储在 data(10)）
-    item->setData(100, static_cast<int>(EntityState::Unchanged));  // 实体状态：未变更
+    // 登记专题字段（切换专题时按列读取，无需回查数据库）
+    if (m_attributeTable) {
+        m_attributeTable->appendPipeline(item, pipeline);
+    }
     
     // 5. 设置工具提示
     QString tooltip = QString("%1\n类型: %2\n管径: DN%3\n健康度: %4分")
-                          .arg(pipeline.getDisplayName())
-                          .arg(pipeline.getTypeDisplayName())
-                          .arg(pipeline.diameterMm())
-                          .arg(pipeline.healthScore());
+                          .arg(pipeline.displayName())
+                          .arg(Pipeline::typeDisplayName(pipeline.pipelineType))
+                          .arg(pipeline.diameterMm)
+                          .arg(pipeline.healthScore);
     item->setToolTip(tooltip);
     
     // 6. 设置Z值（确保在底图之上）
@@ -171,6 +220,43 @@ QGraphicsPathItem* PipelineRenderer::renderPipeline(QGraphicsScene *scene,
     return item;
 }
 
+QGraphicsPathItem* PipelineRenderer::insertPipeline(QGraphicsScene *scene,
+                                                    const PipelineRenderRecord &pipeline,
+                                                    bool visible)
+{
+    QGraphicsPathItem *item = renderPipeline(scene, pipeline);
+    if (!item) {
+        return nullptr;
+    }
+    
+    item->setVisible(visible);
+    m_itemsCache[getLayerTypeFromPipelineType(pipeline.pipelineType)].append(item);
+    return item;
+}
+
+void PipelineRenderer::removePipelineItem(QGraphicsScene *scene, QGraphicsItem *item)
+{
+    if (!item) {
+        return;
+    }
+    
+    for (auto it = m_itemsCache.begin(); it != m_itemsCache.end(); ++it) {
+        if (it.value().removeOne(item)) {
+            break;
+        }
+    }
+    if (m_itemRegistry) {
+        m_itemRegistry->removeItem(item);
+    }
+    if (m_attributeTable) {
+        m_attributeTable->removeItem(static_cast<QGraphicsPathItem*>(item));
+    }
+    if (scene) {
+        scene->removeItem(item);
+    }
+    delete item;
+}
+
 void PipelineRenderer::clear(QGraphicsScene *scene, LayerManager::LayerType type)
 {
     if (!scene) {
@@ -6,12 +6,15 @@
 #include <QGraphicsPathItem>
 #include <QRectF>
 #include <QVector>
-#include "core/models/pipeline.h"
+#include <QSet>
+#include "core/models/renderrecord.h"
 #include "map/layermanager.h"
 
 class SymbolManager;
-class PipelineDAO;
+class AsyncDAO;
 class TileMapManager;
+class LayerItemRegistry;
+class ThematicAttributeTable;
 
 /**
  * @brief 管线渲染器
@@ -25,14 +28,22 @@ public:
     explicit PipelineRenderer(QObject *parent = nullptr);
     ~PipelineRenderer();
 
-    // 渲染指定类型的管线
+    // 渲染指定类型的管线（后台查询，结果返回后在界面线程渲染并发出 renderComplete）
     void renderPipelines(QGraphicsScene *scene, 
                         const QString &pipelineType,
                         const QRectF &bounds = QRectF());
     
-    // 渲染单条管线
+    // 渲染单条管线（渲染投影记录）
     QGraphicsPathItem* renderPipeline(QGraphicsScene *scene, 
-                                      const Pipeline &pipeline);
+                                      const PipelineRenderRecord &pipeline);
+    
+    // 增量插入一条管线（远程变更），登记到图层缓存，visible 为所属图层的可见性
+    QGraphicsPathItem* insertPipeline(QGraphicsScene *scene,
+                                      const PipelineRenderRecord &pipeline,
+                                      bool visible);
+    
+    // 增量删除图形项：从缓存、注册表、专题属性表与场景中移除后释放
+    void removePipelineItem(QGraphicsScene *scene, QGraphicsItem *item);
     
     // 清除指定类型的管线
     void clear(QGraphicsScene *scene, LayerManager::LayerType type);
@@ -40,9 +51,21 @@ public:
     // 获取缓存中的图形项
     QList<QGraphicsItem*> getCachedItems(LayerManager::LayerType type) const;
     
+    // 是否有尚未完成的后台加载
+    bool isLoading() const;
+    
+    // 图层是否已完成过整层加载（结果为空也算已加载）
+    bool isLayerLoaded(LayerManager::LayerType type) const { return m_loadedLayers.contains(type); }
+    
     // 设置瓦片地图管理器（用于坐标转换）
     void setTileMapManager(TileMapManager *tileMapManager) { m_tileMapManager = tileMapManager; }
     
+    // 设置图层图形项注册表（创建/删除图形项时同步登记）
+    void setItemRegistry(LayerItemRegistry *registry) { m_itemRegistry = registry; }
+    
+    // 设置专题属性表（渲染时按列登记专题字段）
+    void setAttributeTable(ThematicAttributeTable *table) { m_attributeTable = table; }
+    
     // 坐标转换：经纬度 -> 场景坐标
     QPointF geoToScene(const QPointF &geoPoint) const;
     QPointF sceneToGeo(const QPointF &scenePoint) const;
@@ -64,12 +87,20 @@ signals:
 
 private:
     SymbolManager *m_symbolManager;
-    PipelineDAO *m_pipelineDao;
+    AsyncDAO *m_loader;
     TileMapManager *m_tileMapManager;
+    LayerItemRegistry *m_itemRegistry;
+    ThematicAttributeTable *m_attributeTable;
     
     // 图形项缓存（按图层类型）
     QHash<LayerManager::LayerType, QList<QGraphicsItem*>> m_itemsCache;
     
+    // 各图层最近一次加载请求的序号（旧请求的结果不再渲染）
+    QHash<LayerManager::LayerType, quint64> m_loadRequests;
+    
+    // 已完成整层加载的图层
+    QSet<LayerManager::LayerType> m_loadedLayers;
+    
     // 缩放比例
     qreal m_scale;
     
@@ -86,6 +117,10 @@ private:
     // 更新地图尺寸（基于当前zoom）
     void updateTileSize();
     
+    // 渲染一批查询结果（替换该图层已有图形项）
+    void renderRecords(QGraphicsScene *scene, const QString &pipelineType,
+                       const QVector<PipelineRenderRecord> &pipelines);
+    
     // 获取图层类型
     LayerManager::LayerType getLayerTypeFromPipelineType(const QString &pipelineType) const;
 };
@@ -0,0 +1,167 @@
+#include "map/thematicattributetable.h"
+#include "core/models/renderrecord.h"
+#include <QGraphicsPathItem>
+#include <limits>
+
+ThematicAttributeTable::ThematicAttributeTable()
+    : m_generation(0)
+{
+}
+
+void ThematicAttributeTable::appendPipeline(QGraphicsPathItem *item, const PipelineRenderRecord &pipeline)
+{
+    if (!item) {
+        return;
+    }
+
+    auto it = m_rowOf.constFind(item);
+    if (it != m_rowOf.constEnd()) {
+        writeRow(it.value(), item, pipeline);
+        m_generation++;
+        return;
+    }
+
+    int row = m_items.size();
+    m_items.append(item);
+    m_basePens.append(QPen());
+    for (QVector<double> &column : m_numeric) {
+        column.append(0.0);
+    }
+    for (QVector<int> &column : m_codes) {
+        column.append(-1);
+    }
+    m_rowOf.insert(item, row);
+    writeRow(row, item, pipeline);
+    m_generation++;
+}
+
+void ThematicAttributeTable::writeRow(int row, QGraphicsPathItem *item, const PipelineRenderRecord &pipeline)
+{
+    m_basePens[row] = item->pen();
+
+    m_numeric[BuildYear][row] = numericValue(BuildYear, pipeline.buildYear);
+    m_numeric[Diameter][row] = numericValue(Diameter, pipeline.diameterMm);
+    m_numeric[Depth][row] = numericValue(Depth, pipeline.depthM);
+    m_numeric[Length][row] = numericValue(Length, pipeline.lengthM);
+    m_numeric[HealthScore][row] = numericValue(HealthScore, pipeline.healthScore);
+
+    m_codes[Material - NUMERIC_FIELD_COUNT][row] = categoryCode(Material - NUMERIC_FIELD_COUNT, pipeline.material);
+    m_codes[PressureClass - NUMERIC_FIELD_COUNT][row] = categoryCode(PressureClass - NUMERIC_FIELD_COUNT, pipeline.pressureClass);
+    m_codes[Status - NUMERIC_FIELD_COUNT][row] = categoryCode(Status - NUMERIC_FIELD_COUNT, pipeline.status);
+}
+
+void ThematicAttributeTable::removeItem(QGraphicsPathItem *item)
+{
+    auto it = m_rowOf.find(item);
+    if (it == m_rowOf.end()) {
+        return;
+    }
+
+    int row = it.value();
+    int last = m_items.size() - 1;
+    m_rowOf.erase(it);
+
+    // 末行移入空位，保持各列连续
+    if (row != last) {
+        m_items[row] = m_items[last];
+        m_basePens[row] = m_basePens[last];
+        for (QVector<double> &column : m_numeric) {
+            column[row] = column[last];
+        }
+        for (QVector<int> &column : m_codes) {
+            column[row] = column[last];
+        }
+        m_rowOf[m_items[row]] = row;
+    }
+
+    m_items.removeLast();
+    m_basePens.removeLast();
+    for (QVector<double> &column : m_numeric) {
+        column.removeLast();
+    }
+    for (QVector<int> &column : m_codes) {
+        column.removeLast();
+    }
+    m_generation++;
+}
+
+void ThematicAttributeTable::clear()
+{
+    m_items.clear();
+    m_rowOf.clear();
+    m_basePens.clear();
+    for (QVector<double> &column : m_numeric) {
+        column.clear();
+    }
+    for (QVector<int> &column : m_codes) {
+        column.clear();
+    }
+    for (int i = 0; i < CATEGORY_FIELD_COUNT; ++i) {
+        m_dictionaries[i].clear();
+        m_dictionaryIndex[i].clear();
+    }
+    m_generation++;
+}
+
+QVector<double> ThematicAttributeTable::numericColumn(Field field) const
+{
+    if (isCategorical(field)) {
+        return QVector<double>();
+    }
+    return m_numeric[field];
+}
+
+QVector<int> ThematicAttributeTable::categoryColumn(Field field) const
+{
+    if (!isCategorical(field)) {
+        return QVector<int>();
+    }
+    return m_codes[field - NUMERIC_FIELD_COUNT];
+}
+
+QStringList ThematicAttributeTable::categoryDictionary(Field field) const
+{
+    if (!isCategorical(field)) {
+        return QStringList();
+    }
+    return m_dictionaries[field - NUMERIC_FIELD_COUNT];
+}
+
+int ThematicAttributeTable::categoryCode(int column, const QString &value)
+{
+    if (value.isEmpty()) {
+        return -1;
+    }
+    auto it = m_dictionaryIndex[column].constFind(value);
+    if (it != m_dictionaryIndex[column].constEnd()) {
+        return it.value();
+    }
+    int code = m_dictionaries[column].size();
+    m_dictionaries[column].append(value);
+    m_dictionaryIndex[column].insert(value, code);
+    return code;
+}
+
+QString ThematicAttributeTable::fieldName(Field field)
+{
+    switch (field) {
+    case BuildYear:     return "建设年代";
+    case Diameter:      return "管径";
+    case Depth:         return "埋深";
+    case Length:        return "长度";
+    case HealthScore:   return "健康度";
+    case Material:      return "材质";
+    case PressureClass: return "压力等级";
+    case Status:        return "运行状态";
+    }
+    return "Unknown";
+}
+
+double ThematicAttributeTable::numericValue(Field field, double raw)
+{
+    // 健康度 0 为有效值，其余字段非正数视为未录入
+    if (field == HealthScore || raw > 0) {
+        return raw;
+    }
+    return std::numeric_limits<double>::quiet_NaN();
+}
@@ -0,0 +1,81 @@
+#ifndef THEMATICATTRIBUTETABLE_H
+#define THEMATICATTRIBUTETABLE_H
+
+#include <QVector>
+#include <QHash>
+#include <QStringList>
+#include <QPen>
+
+class QGraphicsPathItem;
+struct PipelineRenderRecord;
+
+/**
+ * @brief 专题渲染属性表（列式存储）
+ * 管线渲染时按行登记图形项及其专题字段，数值字段与分类字段分别按列连续存放，
+ * 切换专题时直接读取整列数据，无需回查数据库或逐项解析 data()
+ *
+ * 分类字段采用字典编码（编码为 -1 表示无数据），数值字段无数据时为 NaN
+ */
+class ThematicAttributeTable
+{
+public:
+    // 专题字段
+    enum Field {
+        BuildYear = 0,      // 建设年代
+        Diameter,           // 管径
+        Depth,              // 埋深
+        Length,             // 长度
+        HealthScore,        // 健康度
+        Material,           // 材质（分类）
+        PressureClass,      // 压力等级（分类）
+        Status              // 运行状态（分类）
+    };
+
+    static const int NUMERIC_FIELD_COUNT = 5;
+    static const int CATEGORY_FIELD_COUNT = 3;
+
+    ThematicAttributeTable();
+
+    // 登记管线图形项（已登记时更新该行）
+    void appendPipeline(QGraphicsPathItem *item, const PipelineRenderRecord &pipeline);
+    // 注销图形项（末行移入空位）
+    void removeItem(QGraphicsPathItem *item);
+    void clear();
+
+    int rowCount() const { return m_items.size(); }
+    QGraphicsPathItem* item(int row) const { return m_items.at(row); }
+    bool contains(QGraphicsPathItem *item) const { return m_rowOf.contains(item); }
+
+    // 登记时的原始画笔（清除专题时恢复）
+    const QPen &basePen(int row) const { return m_basePens.at(row); }
+
+    // 列数据（返回隐式共享副本，可交给工作线程只读访问）
+    QVector<double> numericColumn(Field field) const;
+    QVector<int> categoryColumn(Field field) const;
+    QStringList categoryDictionary(Field field) const;
+
+    // 每次行数据变化递增，用于判断分级结果是否过期
+    quint64 generation() const { return m_generation; }
+
+    static bool isCategorical(Field field) { return field >= Material; }
+    static QString fieldName(Field field);
+    // 数值字段的原始值转换为列值（无数据为 NaN）
+    static double numericValue(Field field, double raw);
+
+private:
+    int categoryCode(int column, const QString &value);
+    void writeRow(int row, QGraphicsPathItem *item, const PipelineRenderRecord &pipeline);
+
+    QVector<QGraphicsPathItem*> m_items;
+    QHash<QGraphicsPathItem*, int> m_rowOf;
+    QVector<QPen> m_basePens;
+
+    QVector<double> m_numeric[NUMERIC_FIELD_COUNT];
+    QVector<int> m_codes[CATEGORY_FIELD_COUNT];
+    QStringList m_dictionaries[CATEGORY_FIELD_COUNT];
+    QHash<QString, int> m_dictionaryIndex[CATEGORY_FIELD_COUNT];
+
+    quint64 m_generation;
+};
+
+#endif // THEMATICATTRIBUTETABLE_H
@@ -0,0 +1,559 @@
+#include "map/thematicrenderer.h"
+#include "map/layeritemregistry.h"
+#include "core/common/logger.h"
+#include <QGraphicsPathItem>
+#include <QElapsedTimer>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrent>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace {
+// 自然断点采样上限（Jenks 为 O(k·n²)，对升序数据等距采样后计算）
+const int NATURAL_BREAKS_SAMPLE = 1000;
+// 并行分段的最小行数
+const int MIN_CHUNK_ROWS = 8192;
+// 最大分级数
+const int MAX_CLASS_COUNT = 12;
+
+// 默认顺序色带（蓝 -> 黄 -> 红）
+const QVector<QColor> &defaultRamp()
+{
+    static const QVector<QColor> ramp = {
+        QColor("#2b83ba"), QColor("#abdda4"), QColor("#ffffbf"),
+        QColor("#fdae61"), QColor("#d7191c")
+    };
+    return ramp;
+}
+
+// 唯一值调色板
+const QVector<QColor> &categoryPalette()
+{
+    static const QVector<QColor> palette = {
+        QColor("#1f77b4"), QColor("#ff7f0e"), QColor("#2ca02c"), QColor("#d62728"),
+        QColor("#9467bd"), QColor("#8c564b"), QColor("#e377c2"), QColor("#7f7f7f"),
+        QColor("#bcbd22"), QColor("#17becf")
+    };
+    return palette;
+}
+
+// 按行数划分并行分段
+QVector<QPair<int, int>> chunkRanges(int rows)
+{
+    int chunks = qBound(1, rows / MIN_CHUNK_ROWS, QThreadPool::globalInstance()->maxThreadCount());
+    QVector<QPair<int, int>> ranges;
+    int step = (rows + chunks - 1) / chunks;
+    for (int begin = 0; begin < rows; begin += step) {
+        ranges.append(qMakePair(begin, qMin(rows, begin + step)));
+    }
+    return ranges;
+}
+
+// 合并重复断点
+QVector<double> uniqueBreaks(QVector<double> breaks)
+{
+    breaks.erase(std::unique(breaks.begin(), breaks.end()), breaks.end());
+    if (breaks.size() == 1) {
+        breaks.append(breaks.first());
+    }
+    return breaks;
+}
+}
+
+ThematicRenderer::ThematicRenderer(ThematicAttributeTable *table,
+                                   LayerItemRegistry *registry,
+                                   QObject *parent)
+    : QObject(parent)
+    , m_table(table)
+    , m_registry(registry)
+    , m_watcher(new QFutureWatcher<ThematicClassification>(this))
+    , m_applyPending(false)
+    , m_generation(0)
+    , m_active(false)
+    , m_noDataColor(160, 160, 160)
+{
+    connect(m_watcher, &QFutureWatcher<ThematicClassification>::finished,
+            this, &ThematicRenderer::onClassificationFinished);
+    LOG_INFO("ThematicRenderer initialized");
+}
+
+ThematicRenderer::~ThematicRenderer()
+{
+    if (m_watcher->isRunning()) {
+        m_watcher->waitForFinished();
+    }
+}
+
+void ThematicRenderer::applyTheme(const ThematicTheme &theme)
+{
+    m_theme = theme;
+    m_theme.classCount = qBound(1, theme.classCount, MAX_CLASS_COUNT);
+    // 分类字段只能按唯一值分级
+    if (ThematicAttributeTable::isCategorical(m_theme.field)) {
+        m_theme.method = ThematicTheme::UniqueValues;
+    } else if (m_theme.method == ThematicTheme::UniqueValues) {
+        m_theme.method = ThematicTheme::Quantile;
+    }
+    m_active = true;
+    startClassification();
+}
+
+void ThematicRenderer::reapply()
+{
+    if (m_active) {
+        startClassification();
+    }
+}
+
+void ThematicRenderer::clearTheme()
+{
+    if (!m_active) {
+        return;
+    }
+    m_active = false;
+    m_applyPending = false;
+    m_generation++;  // 丢弃进行中的计算结果
+
+    int restored = 0;
+    for (int row = 0; row < m_table->rowCount(); ++row) {
+        QGraphicsPathItem *item = m_table->item(row);
+        if (m_registry && !m_registry->contains(item)) {
+            continue;
+        }
+        item->setPen(m_table->basePen(row));
+        restored++;
+    }
+    m_classification = ThematicClassification();
+
+    LOG_INFO(QString("Thematic style cleared, %1 pipelines restored").arg(restored));
+    emit themeCleared();
+}
+
+void ThematicRenderer::startClassification()
+{
+    if (!m_table) {
+        return;
+    }
+
+    if (m_watcher->isRunning()) {
+        // 当前计算完成后再按最新专题重新分级
+        m_applyPending = true;
+        return;
+    }
+    m_applyPending = false;
+
+    const ThematicTheme theme = m_theme;
+    const quint64 generation = ++m_generation;
+    const quint64 tableGeneration = m_table->generation();
+
+    // 列统计缓存：属性表版本一致时直接使用，否则由工作线程重新计算
+    ThematicColumnStats stats = m_columnStats.value(theme.field);
+    if (stats.tableGeneration != tableGeneration) {
+        stats = ThematicColumnStats();
+    }
+
+    // 列数据为隐式共享副本，工作线程只读
+    if (ThematicAttributeTable::isCategorical(theme.field)) {
+        const QVector<int> codes = m_table->categoryColumn(theme.field);
+        const QStringList dictionary = m_table->categoryDictionary(theme.field);
+        m_watcher->setFuture(QtConcurrent::run(&ThematicRenderer::classifyCategories,
+                                               theme, codes, dictionary, stats,
+                                               generation, tableGeneration));
+    } else {
+        const QVector<double> values = m_table->numericColumn(theme.field);
+        m_watcher->setFuture(QtConcurrent::run(&ThematicRenderer::classifyNumeric,
+                                               theme, values, stats,
+                                               generation, tableGeneration));
+    }
+}
+
+void ThematicRenderer::onClassificationFinished()
+{
+    const ThematicClassification result = m_watcher->result();
+
+    if (result.field >= 0) {
+        m_columnStats.insert(result.field, result.stats);
+    }
+
+    if (m_applyPending) {
+        m_applyPending = false;
+        startClassification();
+        return;
+    }
+
+    // 已被清除或替换的请求结果直接丢弃
+    if (!m_active || result.generation != m_generation) {
+        return;
+    }
+
+    // 计算期间属性表行序发生变化，分级结果无法按行对应，重新计算
+    if (result.tableGeneration != m_table->generation()) {
+        startClassification();
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    m_classification = result;
+    int styled = restyleItems(result);
+
+    LOG_INFO(QString("Thematic '%1' applied: %2 classes, %3 pipelines (classify %4 ms, restyle %5 ms)")
+                 .arg(ThematicAttributeTable::fieldName(m_theme.field))
+                 .arg(result.classes.size())
+                 .arg(styled)
+                 .arg(result.elapsedMs)
+                 .arg(timer.elapsed()));
+    emit themeApplied(styled);
+}
+
+int ThematicRenderer::restyleItems(const ThematicClassification &classification)
+{
+    int styled = 0;
+    const int rows = qMin(m_table->rowCount(), classification.classOfRow.size());
+    for (int row = 0; row < rows; ++row) {
+        QGraphicsPathItem *item = m_table->item(row);
+        // 已删除的图形项不再访问
+        if (m_registry && !m_registry->contains(item)) {
+            continue;
+        }
+
+        qint16 cls = classification.classOfRow.at(row);
+        QPen pen = m_table->basePen(row);
+        QColor color = cls >= 0 ? classification.classes.at(cls).color : m_noDataColor;
+        // 保留原画笔透明度（低健康度管线半透明）
+        color.setAlpha(pen.color().alpha());
+        pen.setColor(color);
+        if (item->pen() != pen) {
+            item->setPen(pen);
+        }
+        styled++;
+    }
+    return styled;
+}
+
+ThematicClassification ThematicRenderer::classifyNumeric(ThematicTheme theme,
+                                                         QVector<double> values,
+                                                         ThematicColumnStats stats,
+                                                         quint64 generation,
+                                                         quint64 tableGeneration)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    ThematicClassification result;
+    result.generation = generation;
+    result.tableGeneration = tableGeneration;
+    result.field = theme.field;
+    result.classOfRow.resize(values.size());
+
+    // 1. 排除无数据的行并排序（缓存有效时沿用上次的排序结果）
+    if (stats.tableGeneration != tableGeneration || stats.sortedValues.isEmpty()) {
+        QVector<double> valid;
+        valid.reserve(values.size());
+        for (double value : values) {
+            if (std::isfinite(value)) {
+                valid.append(value);
+            }
+        }
+        stats.tableGeneration = tableGeneration;
+        stats.sortedValues = parallelSorted(valid);
+    }
+    result.stats = stats;
+    const QVector<double> &sorted = stats.sortedValues;
+
+    // 2. 计算断点
+    QVector<double> breaks;
+    if (!sorted.isEmpty()) {
+        switch (theme.method) {
+        case ThematicTheme::EqualInterval:
+            breaks = equalIntervalBreaks(sorted, theme.classCount);
+            break;
+        case ThematicTheme::NaturalBreaks:
+            breaks = naturalBreaks(sorted, theme.classCount);
+            break;
+        case ThematicTheme::Quantile:
+        default:
+            breaks = quantileBreaks(sorted, theme.classCount);
+            break;
+        }
+    }
+
+    const int classCount = qMax(0, breaks.size() - 1);
+    const QVector<QColor> colors = rampColors(theme.colorRamp, classCount);
+    for (int i = 0; i < classCount; ++i) {
+        ThematicClass cls;
+        cls.lower = breaks[i];
+        cls.upper = breaks[i + 1];
+        cls.color = colors[i];
+        cls.label = QString("%1 - %2")
+                        .arg(formatValue(theme.field, cls.lower))
+                        .arg(formatValue(theme.field, cls.upper));
+        result.classes.append(cls);
+    }
+
+    // 3. 并行逐行分级（值等于断点时归入较低的一级）
+    const QVector<double> innerBreaks = classCount > 1 ? breaks.mid(1, classCount - 1) : QVector<double>();
+    const QVector<QPair<int, int>> ranges = chunkRanges(values.size());
+    QVector<QVector<int>> chunkCounts(ranges.size(), QVector<int>(classCount, 0));
+    QVector<int> chunkIndexes(ranges.size());
+    std::iota(chunkIndexes.begin(), chunkIndexes.end(), 0);
+
+    QtConcurrent::blockingMap(chunkIndexes, [&](int chunk) {
+        QVector<int> &counts = chunkCounts[chunk];
+        for (int row = ranges[chunk].first; row < ranges[chunk].second; ++row) {
+            double value = values.at(row);
+            if (!std::isfinite(value) || classCount == 0) {
+                result.classOfRow[row] = -1;
+                continue;
+            }
+            int cls = int(std::lower_bound(innerBreaks.constBegin(), innerBreaks.constEnd(), value)
+                          - innerBreaks.constBegin());
+            result.classOfRow[row] = qint16(cls);
+            counts[cls]++;
+        }
+    });
+
+    // 4. 合并各分段的图例计数
+    for (const QVector<int> &counts : chunkCounts) {
+        for (int i = 0; i < classCount; ++i) {
+            result.classes[i].count += counts[i];
+        }
+    }
+
+    result.elapsedMs = timer.elapsed();
+    return result;
+}
+
+ThematicClassification ThematicRenderer::classifyCategories(ThematicTheme theme,
+                                                            QVector<int> codes,
+                                                            QStringList dictionary,
+                                                            ThematicColumnStats stats,
+                                                            quint64 generation,
+                                                            quint64 tableGeneration)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    ThematicClassification result;
+    result.generation = generation;
+    result.tableGeneration = tableGeneration;
+    result.field = theme.field;
+
+    // 唯一值：每个字典项一级，颜色循环使用调色板
+    const QVector<QColor> &palette = categoryPalette();
+    const int classCount = qMin(dictionary.size(), int(std::numeric_limits<qint16>::max()));
+    for (int i = 0; i < classCount; ++i) {
+        ThematicClass cls;
+        cls.lower = i;
+        cls.upper = i;
+        cls.label = dictionary.at(i);
+        cls.color = palette.at(i % palette.size());
+        result.classes.append(cls);
+    }
+
+    // 各编码的行数（缓存有效时沿用）
+    const bool countsCached = stats.tableGeneration == tableGeneration
+                              && stats.categoryCounts.size() == dictionary.size();
+    if (!countsCached) {
+        stats.tableGeneration = tableGeneration;
+        stats.categoryCounts = QVector<int>(dictionary.size(), 0);
+    }
+
+    result.classOfRow.resize(codes.size());
+    for (int row = 0; row < codes.size(); ++row) {
+        int code = codes.at(row);
+        if (code < 0 || code >= classCount) {
+            result.classOfRow[row] = -1;
+            continue;
+        }
+        result.classOfRow[row] = qint16(code);
+        if (!countsCached) {
+            stats.categoryCounts[code]++;
+        }
+    }
+    for (int i = 0; i < classCount; ++i) {
+        result.classes[i].count = stats.categoryCounts.at(i);
+    }
+    result.stats = stats;
+
+    // 丢弃当前数据中已不存在的分类
+    QVector<int> remap(classCount, -1);
+    QVector<ThematicClass> used;
+    for (int i = 0; i < classCount; ++i) {
+        if (result.classes[i].count > 0) {
+            remap[i] = used.size();
+            used.append(result.classes[i]);
+        }
+    }
+    if (used.size() != classCount) {
+        for (qint16 &cls : result.classOfRow) {
+            if (cls >= 0) {
+                cls = qint16(remap[cls]);
+            }
+        }
+        result.classes = used;
+    }
+
+    result.elapsedMs = timer.elapsed();
+    return result;
+}
+
+QVector<double> ThematicRenderer::quantileBreaks(const QVector<double> &sorted, int classCount)
+{
+    if (sorted.isEmpty()) {
+        return QVector<double>();
+    }
+
+    const int n = sorted.size();
+    QVector<double> breaks;
+    breaks.append(sorted.first());
+    for (int i = 1; i < classCount; ++i) {
+        int index = qMin(n - 1, int(qint64(i) * n / classCount));
+        breaks.append(sorted.at(index));
+    }
+    breaks.append(sorted.last());
+    return uniqueBreaks(breaks);
+}
+
+QVector<double> ThematicRenderer::equalIntervalBreaks(const QVector<double> &sorted, int classCount)
+{
+    if (sorted.isEmpty()) {
+        return QVector<double>();
+    }
+
+    const double minValue = sorted.first();
+    const double maxValue = sorted.last();
+    const double step = (maxValue - minValue) / classCount;
+    QVector<double> breaks;
+    breaks.append(minValue);
+    for (int i = 1; i < classCount; ++i) {
+        breaks.append(minValue + step * i);
+    }
+    breaks.append(maxValue);
+    return uniqueBreaks(breaks);
+}
+
+QVector<double> ThematicRenderer::naturalBreaks(const QVector<double> &sorted, int classCount)
+{
+    if (sorted.isEmpty()) {
+        return QVector<double>();
+    }
+
+    // 1. 等距采样（保留首尾）
+    QVector<double> data;
+    if (sorted.size() > NATURAL_BREAKS_SAMPLE) {
+        data.reserve(NATURAL_BREAKS_SAMPLE);
+        for (int i = 0; i < NATURAL_BREAKS_SAMPLE; ++i) {
+            qint64 index = qint64(i) * (sorted.size() - 1) / (NATURAL_BREAKS_SAMPLE - 1);
+            data.append(sorted.at(int(index)));
+        }
+    } else {
+        data = sorted;
+    }
+
+    const int n = data.size();
+    const int k = qMin(classCount, n);
+    if (k <= 1) {
+        return uniqueBreaks({sorted.first(), sorted.last()});
+    }
+
+    // 2. Jenks 动态规划：lower[l][j] 为前 l 个值分 j 级时最后一级的起始位置（1 基）
+    const int stride = k + 1;
+    QVector<int> lower((n + 1) * stride, 0);
+    QVector<double> variance((n + 1) * stride, std::numeric_limits<double>::infinity());
+    for (int j = 1; j <= k; ++j) {
+        lower[1 * stride + j] = 1;
+        variance[1 * stride + j] = 0.0;
+    }
+
+    for (int l = 2; l <= n; ++l) {
+        double sum = 0.0;
+        double sumSquares = 0.0;
+        double v = 0.0;
+        for (int m = 1; m <= l; ++m) {
+            const int start = l - m + 1;
+            const double value = data.at(start - 1);
+            sum += value;
+            sumSquares += value * value;
+            v = sumSquares - sum * sum / m;
+            const int prev = start - 1;
+            if (prev != 0) {
+                for (int j = 2; j <= k; ++j) {
+                    const double candidate = v + variance[prev * stride + j - 1];
+                    if (variance[l * stride + j] >= candidate) {
+                        lower[l * stride + j] = start;
+                        variance[l * stride + j] = candidate;
+                    }
+                }
+            }
+        }
+        lower[l * stride + 1] = 1;
+        variance[l * stride + 1] = v;
+    }
+
+    // 3. 回溯断点
+    QVector<double> breaks(k + 1);
+    breaks[0] = sorted.first();
+    breaks[k] = sorted.last();
+    int end = n;
+    for (int j = k; j >= 2; --j) {
+        const int start = lower[end * stride + j];
+        breaks[j - 1] = data.at(qMax(0, start - 2));
+        end = start - 1;
+    }
+    return uniqueBreaks(breaks);
+}
+
+QVector<double> ThematicRenderer::parallelSorted(const QVector<double> &values)
+{
+    QVector<double> sorted = values;
+    const QVector<QPair<int, int>> ranges = chunkRanges(sorted.size());
+    if (ranges.size() <= 1) {
+        std::sort(sorted.begin(), sorted.end());
+        return sorted;
+    }
+
+    // 分段并行排序后逐段归并
+    QVector<QPair<int, int>> pending = ranges;
+    QtConcurrent::blockingMap(pending, [&sorted](const QPair<int, int> &range) {
+        std::sort(sorted.begin() + range.first, sorted.begin() + range.second);
+    });
+    for (int i = 1; i < ranges.size(); ++i) {
+        std::inplace_merge(sorted.begin(), sorted.begin() + ranges[i].first,
+                           sorted.begin() + ranges[i].second);
+    }
+    return sorted;
+}
+
+QVector<QColor> ThematicRenderer::rampColors(const QVector<QColor> &ramp, int count)
+{
+    const QVector<QColor> &stops = ramp.size() >= 2 ? ramp : defaultRamp();
+    QVector<QColor> colors;
+    for (int i = 0; i < count; ++i) {
+        // 在色带控制色之间线性插值
+        double t = count > 1 ? double(i) / (count - 1) : 0.5;
+        double position = t * (stops.size() - 1);
+        int index = qMin(int(position), stops.size() - 2);
+        double f = position - index;
+        const QColor &a = stops.at(index);
+        const QColor &b = stops.at(index + 1);
+        colors.append(QColor::fromRgbF(a.redF() + (b.redF() - a.redF()) * f,
+                                       a.greenF() + (b.greenF() - a.greenF()) * f,
+                                       a.blueF() + (b.blueF() - a.blueF()) * f));
+    }
+    return colors;
+}
+
+QString ThematicRenderer::formatValue(ThematicAttributeTable::Field field, double value)
+{
+    switch (field) {
+    case ThematicAttributeTable::BuildYear:
+    case ThematicAttributeTable::Diameter:
+    case ThematicAttributeTable::HealthScore:
+        return QString::number(qRound(value));
+    default:
+        return QString::number(value, 'f', 1);
+    }
+}
@@ -0,0 +1,150 @@
+#ifndef THEMATICRENDERER_H
+#define THEMATICRENDERER_H
+
+#include <QObject>
+#include <QColor>
+#include <QVector>
+#include <QStringList>
+#include <QFutureWatcher>
+#include <QHash>
+#include "map/thematicattributetable.h"
+
+class LayerItemRegistry;
+
+/**
+ * @brief 专题配置
+ */
+struct ThematicTheme {
+    enum Method {
+        Quantile = 0,       // 分位数
+        EqualInterval,      // 等间距
+        NaturalBreaks,      // 自然断点（Jenks）
+        UniqueValues        // 唯一值（分类字段）
+    };
+
+    ThematicAttributeTable::Field field = ThematicAttributeTable::BuildYear;
+    Method method = Quantile;
+    int classCount = 5;
+    QVector<QColor> colorRamp;  // 色带控制色，为空时使用默认色带
+};
+
+/**
+ * @brief 专题分级（图例项）
+ */
+struct ThematicClass {
+    double lower = 0;
+    double upper = 0;
+    QString label;
+    QColor color;
+    int count = 0;          // 已加载管线中属于该级的数量
+};
+
+/**
+ * @brief 专题字段的列统计（工作线程由属性表列数据计算）
+ */
+struct ThematicColumnStats {
+    quint64 tableGeneration = 0;   // 计算时属性表的版本
+    QVector<double> sortedValues;  // 数值字段：有效值升序
+    QVector<int> categoryCounts;   // 分类字段：各字典编码的行数
+};
+
+/**
+ * @brief 分级计算结果（工作线程产出）
+ */
+struct ThematicClassification {
+    quint64 generation = 0;        // 请求序号
+    quint64 tableGeneration = 0;   // 采样时属性表的版本
+    QVector<ThematicClass> classes;
+    QVector<qint16> classOfRow;    // 每行所属分级，-1 表示无数据
+    qint64 elapsedMs = 0;
+
+    // 本次使用的列统计，回到GUI线程后按字段缓存
+    int field = -1;
+    ThematicColumnStats stats;
+};
+
+/**
+ * @brief 专题渲染器
+ * 专题值从列式属性表读取（管线图层整层加载，属性表即全部已加载管线），
+ * 工作线程计算断点并并行逐行分级，不访问数据库；回到GUI线程后只修改已有图形项的
+ * 画笔颜色，不重建几何
+ *
+ * 列统计（有效值升序、分类计数）按字段缓存，属性表版本未变化时切换分级方法或色带
+ * 不再重新排序
+ */
+class ThematicRenderer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ThematicRenderer(ThematicAttributeTable *table,
+                              LayerItemRegistry *registry,
+                              QObject *parent = nullptr);
+    ~ThematicRenderer();
+
+    // 应用专题（异步计算分级，完成后就地修改样式）
+    void applyTheme(const ThematicTheme &theme);
+    // 管线数据变化后按当前专题重新分级
+    void reapply();
+    // 清除专题，恢复原始样式
+    void clearTheme();
+
+    bool isActive() const { return m_active; }
+    ThematicTheme currentTheme() const { return m_theme; }
+
+    // 当前图例
+    QVector<ThematicClass> classes() const { return m_classification.classes; }
+
+    // 无数据要素的颜色
+    void setNoDataColor(const QColor &color) { m_noDataColor = color; }
+    QColor noDataColor() const { return m_noDataColor; }
+
+    // 断点计算（输入为升序数值，返回包含最小值和最大值在内的 k+1 个断点，重复断点已合并）
+    static QVector<double> quantileBreaks(const QVector<double> &sorted, int classCount);
+    static QVector<double> equalIntervalBreaks(const QVector<double> &sorted, int classCount);
+    static QVector<double> naturalBreaks(const QVector<double> &sorted, int classCount);
+
+signals:
+    void themeApplied(int styledCount);
+    void themeCleared();
+
+private:
+    void startClassification();
+    void onClassificationFinished();
+    int restyleItems(const ThematicClassification &classification);
+
+    // 工作线程：分级计算
+    static ThematicClassification classifyNumeric(ThematicTheme theme,
+                                                  QVector<double> values,
+                                                  ThematicColumnStats stats,
+                                                  quint64 generation,
+                                                  quint64 tableGeneration);
+    static ThematicClassification classifyCategories(ThematicTheme theme,
+                                                     QVector<int> codes,
+                                                     QStringList dictionary,
+                                                     ThematicColumnStats stats,
+                                                     quint64 generation,
+                                                     quint64 tableGeneration);
+
+    static QVector<double> parallelSorted(const QVector<double> &values);
+    static QVector<QColor> rampColors(const QVector<QColor> &ramp, int count);
+    static QString formatValue(ThematicAttributeTable::Field field, double value);
+
+private:
+    ThematicAttributeTable *m_table;
+    LayerItemRegistry *m_registry;
+
+    QFutureWatcher<ThematicClassification> *m_watcher;
+    bool m_applyPending;           // 计算进行中又收到新请求
+    quint64 m_generation;
+
+    ThematicTheme m_theme;
+    ThematicClassification m_classification;
+    bool m_active;
+
+    // 列统计缓存（按专题字段，见类说明）
+    QHash<int, ThematicColumnStats> m_columnStats;
+    QColor m_noDataColor;
+};
+
+#endif // THEMATICRENDERER_H
@@ -0,0 +1,540 @@
+#include "map/vectortilecache.h"
+#include "map/vectortilelayeritem.h"
+#include "map/layeritemregistry.h"
+#include "map/entitygraphicsitem.h"
+#include "core/common/logger.h"
+#include "core/common/config.h"
+#include "core/common/entitystate.h"
+#include <QPainter>
+#include <QDir>
+#include <QFile>
+#include <QTimer>
+#include <QThreadPool>
+#include <QtMath>
+#include <QtConcurrent/QtConcurrent>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// 等待队列上限（超出时丢弃最早的请求，通常已移出视口）
+const int MAX_QUEUED_TILES = 256;
+// 失效区域合并阈值
+const int MAX_DIRTY_RECTS = 64;
+}
+
+uint qHash(const VectorTileKey &key, uint /*seed*/)
+{
+    return qHash(key.x) ^ (qHash(key.y) << 1) ^ qHash(key.z * 8 + key.level + 2);
+}
+
+VectorTileCache::VectorTileCache(LayerItemRegistry *registry, QObject *parent)
+    : QObject(parent)
+    , m_scene(nullptr)
+    , m_registry(registry)
+    , m_layerItem(nullptr)
+    , m_maxRunning(qMax(2, QThreadPool::globalInstance()->maxThreadCount() - 1))
+    , m_processingScheduled(false)
+    , m_zoom(10)
+    , m_enabled(Config::instance().getBool("Map/vector_raster_tiles", false))
+    , m_editing(false)
+    , m_applied(false)
+{
+    m_tiles.setMaxCost(qMax(16, Config::instance().getInt("Map/vector_tile_cache_mb", 128)) * 1024);
+
+    // 磁盘缓存放在项目根目录下，与底图瓦片目录并列
+    if (Config::instance().getBool("Map/vector_tile_disk_cache", true)) {
+        QDir dir(QDir::currentPath());
+        while (!dir.exists("UGIMS.pro") && !dir.isRoot()) {
+            dir.cdUp();
+        }
+        m_diskDir = dir.absolutePath() + "/tilemap_vector";
+    }
+
+    // 实体图形项增删时同步透明度并使相关瓦片过期
+    if (m_registry) {
+        m_registry->addItemAddedCallback([this](LayerManager::LayerType layer, QGraphicsItem *item) {
+            if (!m_applied || !isEntityLayer(layer)) {
+                return;
+            }
+            item->setOpacity(0.0);
+            invalidateRect(item->sceneBoundingRect());
+        });
+        m_registry->addItemRemovedCallback([this](LayerManager::LayerType layer, QGraphicsItem *item) {
+            if (!m_applied || !isEntityLayer(layer)) {
+                return;
+            }
+            item->setOpacity(1.0);
+            invalidateRect(item->sceneBoundingRect());
+        });
+    }
+
+    LOG_INFO(QString("VectorTileCache initialized (enabled=%1, disk=%2)")
+                 .arg(m_enabled ? "true" : "false")
+                 .arg(m_diskDir.isEmpty() ? "off" : m_diskDir));
+}
+
+VectorTileCache::~VectorTileCache()
+{
+    for (QFutureWatcher<VectorTileResult> *watcher : m_watchers) {
+        watcher->disconnect(this);
+        watcher->waitForFinished();
+    }
+    if (m_layerItem && m_scene) {
+        m_scene->removeItem(m_layerItem);
+    }
+    delete m_layerItem;
+}
+
+void VectorTileCache::setScene(QGraphicsScene *scene)
+{
+    if (m_scene == scene) {
+        return;
+    }
+
+    // 瓦片图层跟随场景迁移
+    if (m_layerItem && m_scene) {
+        m_scene->removeItem(m_layerItem);
+    }
+    m_scene = scene;
+    if (m_layerItem && m_scene) {
+        m_scene->addItem(m_layerItem);
+    }
+    applyMode();
+}
+
+void VectorTileCache::setZoom(int zoom)
+{
+    m_zoom = zoom;
+    if (m_layerItem) {
+        double worldSize = double(TILE_SIZE) * (1 << zoom);
+        m_layerItem->setWorldRect(QRectF(0, 0, worldSize, worldSize));
+    }
+}
+
+void VectorTileCache::setEnabled(bool enabled)
+{
+    if (m_enabled == enabled) {
+        return;
+    }
+    m_enabled = enabled;
+    applyMode();
+}
+
+void VectorTileCache::setEditingActive(bool editing)
+{
+    if (m_editing == editing) {
+        return;
+    }
+    m_editing = editing;
+    applyMode();
+}
+
+void VectorTileCache::applyMode()
+{
+    bool active = isActive();
+    if (active == m_applied) {
+        return;
+    }
+    m_applied = active;
+
+    if (active) {
+        ensureLayerItem();
+    }
+
+    // 栅格模式下实体图形项保持可见、可点选，但透明度为0不再参与绘制
+    setEntityItemsOpacity(active ? 0.0 : 1.0);
+    if (m_layerItem) {
+        m_layerItem->setVisible(active);
+    }
+
+    if (active) {
+        // 编辑期间的修改未跟踪到具体瓦片：全部标记过期，按指纹复用未变化的瓦片
+        invalidateAll();
+    } else {
+        m_queue.clear();
+        m_queued.clear();
+    }
+
+    LOG_INFO(QString("Vector layers switched to %1 rendering")
+                 .arg(active ? "raster tile" : "live vector"));
+}
+
+void VectorTileCache::ensureLayerItem()
+{
+    if (m_layerItem || !m_scene) {
+        return;
+    }
+
+    m_layerItem = new VectorTileLayerItem(this);
+    m_layerItem->setVisible(false);
+    double worldSize = double(TILE_SIZE) * (1 << m_zoom);
+    m_layerItem->setWorldRect(QRectF(0, 0, worldSize, worldSize));
+    m_scene->addItem(m_layerItem);
+}
+
+void VectorTileCache::setEntityItemsOpacity(qreal opacity)
+{
+    if (!m_registry) {
+        return;
+    }
+    const QList<QGraphicsItem*> items = m_registry->entityItems();
+    for (QGraphicsItem *item : items) {
+        item->setOpacity(opacity);
+    }
+}
+
+void VectorTileCache::invalidateRect(const QRectF &sceneRect)
+{
+    // 外扩1个单位，避免零宽高的矩形相交判断失效
+    m_dirtyRects.append(sceneRect.adjusted(-1, -1, 1, 1));
+    scheduleProcessing();
+}
+
+void VectorTileCache::invalidateAll()
+{
+    m_dirtyRects.clear();
+    const QList<VectorTileKey> keys = m_tiles.keys();
+    for (const VectorTileKey &key : keys) {
+        m_tiles.object(key)->stale = true;
+    }
+    for (const VectorTileKey &key : m_running) {
+        m_staleRunning.insert(key);
+    }
+    if (m_layerItem) {
+        m_layerItem->update();
+    }
+}
+
+const QImage *VectorTileCache::tileImage(const VectorTileKey &key, bool *stale) const
+{
+    TileEntry *entry = m_tiles.object(key);
+    if (!entry) {
+        return nullptr;
+    }
+    if (stale) {
+        *stale = entry->stale;
+    }
+    return &entry->image;
+}
+
+void VectorTileCache::requestTiles(const QList<VectorTileKey> &keys)
+{
+    if (!isActive()) {
+        return;
+    }
+
+    for (const VectorTileKey &key : keys) {
+        if (m_running.contains(key)) {
+            continue;
+        }
+        TileEntry *entry = m_tiles.object(key);
+        if (entry && !entry->stale) {
+            continue;
+        }
+        // 已在队列中的移到队尾（最近请求的优先处理）
+        if (m_queued.contains(key)) {
+            m_queue.removeOne(key);
+        } else {
+            m_queued.insert(key);
+        }
+        m_queue.append(key);
+    }
+
+    while (m_queue.size() > MAX_QUEUED_TILES) {
+        m_queued.remove(m_queue.takeFirst());
+    }
+
+    scheduleProcessing();
+}
+
+void VectorTileCache::scheduleProcessing()
+{
+    if (m_processingScheduled) {
+        return;
+    }
+    m_processingScheduled = true;
+    // 合并同一轮事件中的请求与失效，不在 paint 中启动任务
+    QTimer::singleShot(0, this, [this]() {
+        processQueue();
+    });
+}
+
+void VectorTileCache::processQueue()
+{
+    m_processingScheduled = false;
+
+    if (!m_dirtyRects.isEmpty()) {
+        processDirtyRects();
+    }
+
+    if (!isActive()) {
+        m_queue.clear();
+        m_queued.clear();
+        return;
+    }
+
+    while (m_running.size() < m_maxRunning && !m_queue.isEmpty()) {
+        VectorTileKey key = m_queue.takeLast();
+        m_queued.remove(key);
+        if (m_running.contains(key)) {
+            continue;
+        }
+
+        // 1. 在GUI线程采集要素快照
+        uint fingerprint = 0;
+        QVector<VectorTileFeature> features = collectFeatures(tileSceneRect(key), &fingerprint);
+
+        // 2. 指纹未变化：直接复用已有瓦片
+        TileEntry *entry = m_tiles.object(key);
+        if (entry && entry->fingerprint == fingerprint) {
+            entry->stale = false;
+            continue;
+        }
+
+        // 3. 空瓦片不渲染
+        if (features.isEmpty()) {
+            m_tiles.insert(key, new TileEntry{QImage(), 0, false}, 1);
+            if (m_layerItem) {
+                m_layerItem->update(tileSceneRect(key));
+            }
+            continue;
+        }
+
+        // 4. 提交到线程池
+        m_running.insert(key);
+        auto *watcher = new QFutureWatcher<VectorTileResult>(this);
+        m_watchers.insert(watcher);
+        connect(watcher, &QFutureWatcher<VectorTileResult>::finished, this, [this, watcher]() {
+            m_watchers.remove(watcher);
+            onTileFinished(watcher->result());
+            watcher->deleteLater();
+        });
+        watcher->setFuture(QtConcurrent::run(&VectorTileCache::renderTile,
+                                             key, features, fingerprint, tileDirectory(key)));
+    }
+}
+
+void VectorTileCache::processDirtyRects()
+{
+    // 失效区域过多时合并为一个外包矩形
+    if (m_dirtyRects.size() > MAX_DIRTY_RECTS) {
+        QRectF united = m_dirtyRects.first();
+        for (const QRectF &rect : m_dirtyRects) {
+            united |= rect;
+        }
+        m_dirtyRects = {united};
+    }
+
+    auto touched = [this](const VectorTileKey &key) {
+        const QRectF tileRect = tileSceneRect(key);
+        for (const QRectF &rect : m_dirtyRects) {
+            if (tileRect.intersects(rect)) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    int staleCount = 0;
+    const QList<VectorTileKey> keys = m_tiles.keys();
+    for (const VectorTileKey &key : keys) {
+        if (touched(key)) {
+            m_tiles.object(key)->stale = true;
+            staleCount++;
+        }
+    }
+    for (const VectorTileKey &key : m_running) {
+        if (touched(key)) {
+            m_staleRunning.insert(key);
+        }
+    }
+    m_dirtyRects.clear();
+
+    LOG_DEBUG(QString("Vector tiles invalidated: %1").arg(staleCount));
+    if (staleCount > 0 && m_layerItem) {
+        m_layerItem->update();
+    }
+}
+
+void VectorTileCache::onTileFinished(const VectorTileResult &result)
+{
+    m_running.remove(result.key);
+
+    if (m_staleRunning.remove(result.key)) {
+        // 渲染期间要素已变化：丢弃结果，下次绘制时重新请求
+        if (TileEntry *entry = m_tiles.object(result.key)) {
+            entry->stale = true;
+        }
+    } else {
+        int cost = qMax(1, int(result.image.sizeInBytes() / 1024));
+        m_tiles.insert(result.key, new TileEntry{result.image, result.fingerprint, false}, cost);
+    }
+
+    if (m_layerItem) {
+        m_layerItem->update(tileSceneRect(result.key));
+    }
+    if (!m_queue.isEmpty()) {
+        scheduleProcessing();
+    }
+}
+
+QVector<VectorTileFeature> VectorTileCache::collectFeatures(const QRectF &sceneRect, uint *fingerprint) const
+{
+    QVector<VectorTileFeature> features;
+    QVector<uint> hashes;
+
+    // 场景空间索引查询，按堆叠顺序自下而上
+    const QList<QGraphicsItem*> items = m_scene->items(sceneRect, Qt::IntersectsItemBoundingRect,
+                                                       Qt::AscendingOrder);
+    for (QGraphicsItem *item : items) {
+        LayerManager::LayerType layer;
+        if (!m_registry || !m_registry->layerOf(item, &layer) || !isEntityLayer(layer)) {
+            continue;
+        }
+        // 隐藏的图层、低层级被聚类替代的设施不进入瓦片
+        if (!item->isVisible()) {
+            continue;
+        }
+        const EntityGraphicsItem *entity = EntityGraphicsItem::fromItem(item);
+        if (entity && entity->state() == EntityState::Deleted) {
+            continue;
+        }
+
+        VectorTileFeature feature;
+        feature.transform = item->sceneTransform();
+        if (auto *pathItem = qgraphicsitem_cast<PipelineGraphicsItem*>(item)) {
+            feature.kind = VectorTileFeature::Path;
+            feature.path = pathItem->path();
+            feature.pen = pathItem->pen();
+            feature.brush = pathItem->brush();
+        } else if (auto *ellipseItem = qgraphicsitem_cast<FacilityGraphicsItem*>(item)) {
+            feature.kind = VectorTileFeature::Ellipse;
+            feature.rect = ellipseItem->rect();
+            feature.pen = ellipseItem->pen();
+            feature.brush = ellipseItem->brush();
+        } else if (auto *shapeItem = dynamic_cast<QAbstractGraphicsShapeItem*>(item)) {
+            feature.kind = VectorTileFeature::Path;
+            feature.path = shapeItem->shape();
+            feature.pen = shapeItem->pen();
+            feature.brush = shapeItem->brush();
+        } else {
+            continue;
+        }
+        features.append(feature);
+
+        // 要素指纹：编号 + 场景范围 + 样式
+        const QRectF bounds = item->sceneBoundingRect();
+        uint h = entity ? qHash(entity->entityId()) : 0u;
+        h = h * 31 + uint(qRound64(bounds.left() * 100));
+        h = h * 31 + uint(qRound64(bounds.top() * 100));
+        h = h * 31 + uint(qRound64(bounds.width() * 100));
+        h = h * 31 + uint(qRound64(bounds.height() * 100));
+        h = h * 31 + uint(feature.path.elementCount());
+        h = h * 31 + feature.pen.color().rgba();
+        h = h * 31 + uint(qRound(feature.pen.widthF() * 100));
+        h = h * 31 + uint(feature.pen.style());
+        h = h * 31 + feature.brush.color().rgba();
+        h = h * 31 + uint(feature.brush.style());
+        hashes.append(h);
+    }
+
+    std::sort(hashes.begin(), hashes.end());
+    *fingerprint = hashes.isEmpty()
+        ? 0u
+        : uint(qHashBits(hashes.constData(), size_t(hashes.size()) * sizeof(uint)));
+    return features;
+}
+
+QString VectorTileCache::tileDirectory(const VectorTileKey &key) const
+{
+    if (m_diskDir.isEmpty()) {
+        return QString();
+    }
+    return QString("%1/%2/L%3/%4").arg(m_diskDir).arg(key.z).arg(key.level).arg(key.x);
+}
+
+VectorTileResult VectorTileCache::renderTile(VectorTileKey key,
+                                             QVector<VectorTileFeature> features,
+                                             uint fingerprint,
+                                             QString tileDir)
+{
+    VectorTileResult result;
+    result.key = key;
+    result.fingerprint = fingerprint;
+
+    const QString fileName = QString("%1_%2.png").arg(key.y).arg(fingerprint, 8, 16, QChar('0'));
+
+    // 1. 磁盘缓存命中（文件名包含指纹，数据变化后自然失效）
+    if (!tileDir.isEmpty()) {
+        const QString path = tileDir + "/" + fileName;
+        if (QFile::exists(path) && result.image.load(path, "PNG")) {
+            result.fromDisk = true;
+            return result;
+        }
+    }
+
+    // 2. 渲染瓦片：场景坐标 -> 瓦片像素坐标
+    const QRectF tileRect = tileSceneRect(key);
+    const double scale = TILE_SIZE / tileSceneSize(key.level);
+    QTransform tileTransform;
+    tileTransform.scale(scale, scale);
+    tileTransform.translate(-tileRect.left(), -tileRect.top());
+
+    QImage image(TILE_SIZE, TILE_SIZE, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    {
+        QPainter painter(&image);
+        painter.setRenderHint(QPainter::Antialiasing, true);
+        for (const VectorTileFeature &feature : features) {
+            painter.setTransform(feature.transform * tileTransform);
+            painter.setPen(feature.pen);
+            painter.setBrush(feature.brush);
+            if (feature.kind == VectorTileFeature::Ellipse) {
+                painter.drawEllipse(feature.rect);
+            } else {
+                painter.drawPath(feature.path);
+            }
+        }
+    }
+    result.image = image;
+
+    // 3. 写入磁盘缓存，并删除该瓦片旧指纹的文件
+    if (!tileDir.isEmpty()) {
+        QDir dir(tileDir);
+        if (dir.exists() || dir.mkpath(".")) {
+            const QStringList oldFiles = dir.entryList({QString("%1_*.png").arg(key.y)}, QDir::Files);
+            for (const QString &oldFile : oldFiles) {
+                if (oldFile != fileName) {
+                    dir.remove(oldFile);
+                }
+            }
+            image.save(dir.filePath(fileName), "PNG");
+        }
+    }
+
+    return result;
+}
+
+int VectorTileCache::levelForScale(double viewScale)
+{
+    if (viewScale <= 0) {
+        return 0;
+    }
+    return qBound(-2, qRound(std::log2(viewScale)), 2);
+}
+
+double VectorTileCache::tileSceneSize(int level)
+{
+    return std::ldexp(double(TILE_SIZE), -level);
+}
+
+QRectF VectorTileCache::tileSceneRect(const VectorTileKey &key)
+{
+    const double size = tileSceneSize(key.level);
+    return QRectF(key.x * size, key.y * size, size, size);
+}
+
+bool VectorTileCache::isEntityLayer(LayerManager::LayerType layer)
+{
+    return layer == LayerManager::Facilities || LayerItemRegistry::isPipelineLayer(layer);
+}
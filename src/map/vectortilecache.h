@@ -0,0 +1,166 @@
+#ifndef VECTORTILECACHE_H
+#define VECTORTILECACHE_H
+
+#include <QObject>
+#include <QGraphicsScene>
+#include <QCache>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QSet>
+#include <QList>
+#include <QVector>
+#include <QImage>
+#include <QPainterPath>
+#include <QTransform>
+#include <QPen>
+#include <QBrush>
+#include "map/layermanager.h"
+
+class LayerItemRegistry;
+class VectorTileLayerItem;
+
+// 矢量瓦片键值
+struct VectorTileKey {
+    int z;      // 图形项场景坐标对应的缩放级别
+    int level;  // 像素密度级别（log2 视图缩放）
+    int x, y;
+
+    bool operator==(const VectorTileKey &other) const {
+        return z == other.z && level == other.level && x == other.x && y == other.y;
+    }
+};
+
+uint qHash(const VectorTileKey &key, uint seed = 0);
+
+/**
+ * @brief 瓦片绘制要素（图形项的几何与样式快照，可在工作线程中绘制）
+ */
+struct VectorTileFeature {
+    enum Kind { Path = 0, Ellipse = 1 };
+
+    Kind kind;
+    QPainterPath path;
+    QRectF rect;
+    QTransform transform;  // 图形项到场景的变换
+    QPen pen;
+    QBrush brush;
+};
+
+/**
+ * @brief 瓦片渲染结果
+ */
+struct VectorTileResult {
+    VectorTileKey key;
+    QImage image;           // 空瓦片时为空图像
+    uint fingerprint = 0;   // 要素指纹
+    bool fromDisk = false;
+};
+
+/**
+ * @brief 矢量图层栅格瓦片缓存
+ * 只读浏览时将管线、设施图层按 256 像素瓦片预渲染为 QImage（工作线程池），
+ * 缓存在内存与磁盘中，平移时只需贴图；编辑期间自动回退为矢量图形项实时绘制
+ *
+ * 每个瓦片记录其要素指纹（编号、范围、样式），图形项增删或编辑结束时只把
+ * 受影响的瓦片标记为过期，重新采集后指纹不变的瓦片直接复用，不会重新渲染
+ */
+class VectorTileCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const int TILE_SIZE = 256;
+
+    explicit VectorTileCache(LayerItemRegistry *registry, QObject *parent = nullptr);
+    ~VectorTileCache();
+
+    void setScene(QGraphicsScene *scene);
+
+    // 设置图形项场景坐标对应的缩放级别
+    void setZoom(int zoom);
+    int zoom() const { return m_zoom; }
+
+    // 栅格瓦片模式开关（可选模式，默认取配置 Map/vector_raster_tiles）
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return m_enabled; }
+
+    // 编辑状态：编辑期间回退为矢量实时绘制
+    void setEditingActive(bool editing);
+    bool isEditingActive() const { return m_editing; }
+
+    // 当前是否以栅格瓦片显示
+    bool isActive() const { return m_enabled && !m_editing && m_scene; }
+
+    // 将与场景矩形相交的瓦片标记为过期（合并到下一次事件循环处理）
+    void invalidateRect(const QRectF &sceneRect);
+    // 将所有瓦片标记为过期（如图层显隐变化）
+    void invalidateAll();
+
+    // 供瓦片图层图形项查询/请求（GUI线程）
+    const QImage *tileImage(const VectorTileKey &key, bool *stale = nullptr) const;
+    void requestTiles(const QList<VectorTileKey> &keys);
+
+    // 瓦片几何
+    static int levelForScale(double viewScale);
+    static double tileSceneSize(int level);
+    static QRectF tileSceneRect(const VectorTileKey &key);
+
+private:
+    struct TileEntry {
+        QImage image;
+        uint fingerprint;
+        bool stale;
+    };
+
+    // 切换矢量/栅格显示
+    void applyMode();
+    void ensureLayerItem();
+    void setEntityItemsOpacity(qreal opacity);
+
+    // 采集瓦片范围内可见的实体图形项快照，并计算要素指纹
+    QVector<VectorTileFeature> collectFeatures(const QRectF &sceneRect, uint *fingerprint) const;
+
+    // 调度后台任务
+    void scheduleProcessing();
+    void processQueue();
+    void processDirtyRects();
+    void onTileFinished(const VectorTileResult &result);
+
+    QString tileDirectory(const VectorTileKey &key) const;
+
+    // 工作线程：先读磁盘缓存，未命中时渲染并写入磁盘
+    static VectorTileResult renderTile(VectorTileKey key,
+                                       QVector<VectorTileFeature> features,
+                                       uint fingerprint,
+                                       QString tileDir);
+
+    static bool isEntityLayer(LayerManager::LayerType layer);
+
+private:
+    QGraphicsScene *m_scene;
+    LayerItemRegistry *m_registry;
+    VectorTileLayerItem *m_layerItem;
+
+    // 内存缓存（成本单位 KB）
+    QCache<VectorTileKey, TileEntry> m_tiles;
+
+    // 待渲染队列（后请求的优先）与运行中的任务
+    QList<VectorTileKey> m_queue;
+    QSet<VectorTileKey> m_queued;
+    QSet<VectorTileKey> m_running;
+    QSet<VectorTileKey> m_staleRunning;  // 运行期间被标记过期的任务，结果丢弃
+    QSet<QFutureWatcher<VectorTileResult>*> m_watchers;
+    int m_maxRunning;
+
+    // 待处理的失效区域
+    QVector<QRectF> m_dirtyRects;
+    bool m_processingScheduled;
+
+    QString m_diskDir;    // 为空时不使用磁盘缓存
+    int m_zoom;
+    bool m_enabled;
+    bool m_editing;
+    bool m_applied;       // 当前是否已切换为栅格显示
+};
+
+#endif // VECTORTILECACHE_H
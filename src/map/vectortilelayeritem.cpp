@@ -0,0 +1,101 @@
+#include "map/vectortilelayeritem.h"
+#include "map/vectortilecache.h"
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+#include <QtMath>
+
+VectorTileLayerItem::VectorTileLayerItem(VectorTileCache *cache, QGraphicsItem *parent)
+    : QGraphicsItem(parent)
+    , m_cache(cache)
+{
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption, true);
+    setAcceptedMouseButtons(Qt::NoButton);
+    setAcceptHoverEvents(false);
+    setData(0, "vector_tiles");
+    // 与管线图形项同层，位于设施聚类、标注之下
+    setZValue(10);
+}
+
+void VectorTileLayerItem::setWorldRect(const QRectF &rect)
+{
+    if (rect == m_worldRect) {
+        return;
+    }
+    prepareGeometryChange();
+    m_worldRect = rect;
+}
+
+QRectF VectorTileLayerItem::boundingRect() const
+{
+    return m_worldRect;
+}
+
+QPainterPath VectorTileLayerItem::shape() const
+{
+    return QPainterPath();
+}
+
+void VectorTileLayerItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
+                                QWidget *widget)
+{
+    Q_UNUSED(widget);
+
+    if (!m_cache || !m_cache->isActive()) {
+        return;
+    }
+
+    const QRectF exposed = option->exposedRect.intersected(m_worldRect);
+    if (exposed.isEmpty()) {
+        return;
+    }
+
+    // 按视图缩放选择像素密度级别，使瓦片像素与屏幕像素接近 1:1
+    const double viewScale = qSqrt(qAbs(painter->worldTransform().determinant()));
+    const int level = VectorTileCache::levelForScale(viewScale);
+    const double tileSize = VectorTileCache::tileSceneSize(level);
+    const int z = m_cache->zoom();
+
+    const int minX = qFloor(exposed.left() / tileSize);
+    const int maxX = qFloor((exposed.right() - 1e-6) / tileSize);
+    const int minY = qFloor(exposed.top() / tileSize);
+    const int maxY = qFloor((exposed.bottom() - 1e-6) / tileSize);
+
+    painter->setRenderHint(QPainter::SmoothPixmapTransform, true);
+
+    QList<VectorTileKey> missing;
+    for (int y = minY; y <= maxY; ++y) {
+        for (int x = minX; x <= maxX; ++x) {
+            VectorTileKey key{z, level, x, y};
+            const QRectF target = VectorTileCache::tileSceneRect(key);
+
+            bool stale = false;
+            const QImage *image = m_cache->tileImage(key, &stale);
+            if (image) {
+                // 过期瓦片继续显示，直到新瓦片就绪
+                if (!image->isNull()) {
+                    painter->drawImage(target, *image);
+                }
+                if (stale) {
+                    missing.append(key);
+                }
+                continue;
+            }
+
+            missing.append(key);
+
+            // 上一级瓦片放大替代（对应四分之一区域）
+            VectorTileKey parentKey{z, level - 1, x >> 1, y >> 1};
+            const QImage *parentImage = m_cache->tileImage(parentKey);
+            if (parentImage && !parentImage->isNull()) {
+                const int half = VectorTileCache::TILE_SIZE / 2;
+                QRectF source((x & 1) * half, (y & 1) * half, half, half);
+                painter->drawImage(target, *parentImage, source);
+            }
+        }
+    }
+
+    // 请求在下一轮事件循环中处理，不在绘制过程中启动任务
+    if (!missing.isEmpty()) {
+        m_cache->requestTiles(missing);
+    }
+}
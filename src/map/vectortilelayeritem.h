@@ -0,0 +1,31 @@
+#ifndef VECTORTILELAYERITEM_H
+#define VECTORTILELAYERITEM_H
+
+#include <QGraphicsItem>
+
+class VectorTileCache;
+
+/**
+ * @brief 矢量栅格瓦片图层图形项
+ * 按当前视图缩放选择像素密度级别，绘制暴露区域内已缓存的瓦片图像；
+ * 缺失的瓦片先用上一级瓦片放大替代，并向缓存请求后台渲染
+ */
+class VectorTileLayerItem : public QGraphicsItem
+{
+public:
+    explicit VectorTileLayerItem(VectorTileCache *cache, QGraphicsItem *parent = nullptr);
+
+    // 设置世界范围（当前缩放级别下的场景范围）
+    void setWorldRect(const QRectF &rect);
+
+    QRectF boundingRect() const override;
+    QPainterPath shape() const override;  // 空形状：不参与点选
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
+               QWidget *widget = nullptr) override;
+
+private:
+    VectorTileCache *m_cache;
+    QRectF m_worldRect;
+};
+
+#endif // VECTORTILELAYERITEM_H
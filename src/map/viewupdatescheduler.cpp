@@ -0,0 +1,66 @@
+#include "map/viewupdatescheduler.h"
+#include <QTimer>
+#include <QWidget>
+#include <QScreen>
+#include <QtMath>
+
+ViewUpdateScheduler::ViewUpdateScheduler(QWidget *widget, QObject *parent)
+    : QObject(parent)
+    , m_widget(widget)
+    , m_timer(new QTimer(this))
+    , m_pending(NoUpdate)
+    , m_inFrame(false)
+{
+    m_timer->setSingleShot(true);
+    m_timer->setTimerType(Qt::PreciseTimer);
+    connect(m_timer, &QTimer::timeout, this, &ViewUpdateScheduler::flush);
+}
+
+void ViewUpdateScheduler::schedule(UpdateFlags flags)
+{
+    m_pending |= flags;
+    if (m_inFrame || m_timer->isActive() || m_pending == NoUpdate) {
+        // 帧内产生的新请求由本帧结束后统一排到下一帧
+        return;
+    }
+
+    // 距上一帧不足一个帧间隔时等到下一帧，否则下一轮事件循环立即执行
+    int delay = 0;
+    if (m_lastFrame.isValid()) {
+        delay = qMax(0, frameIntervalMs() - static_cast<int>(m_lastFrame.elapsed()));
+    }
+    m_timer->start(delay);
+}
+
+void ViewUpdateScheduler::flush()
+{
+    m_timer->stop();
+    if (m_pending == NoUpdate || m_inFrame) {
+        return;
+    }
+
+    UpdateFlags flags = m_pending;
+    m_pending = NoUpdate;
+    m_lastFrame.start();
+
+    m_inFrame = true;
+    emit frameUpdate(flags);
+    m_inFrame = false;
+
+    // 帧处理期间新增的请求
+    if (m_pending != NoUpdate) {
+        m_timer->start(frameIntervalMs());
+    }
+}
+
+int ViewUpdateScheduler::frameIntervalMs() const
+{
+    qreal refreshRate = 60.0;
+    if (m_widget && m_widget->screen()) {
+        refreshRate = m_widget->screen()->refreshRate();
+    }
+    if (refreshRate < 1.0) {
+        refreshRate = 60.0;
+    }
+    return qMax(1, qFloor(1000.0 / refreshRate));
+}
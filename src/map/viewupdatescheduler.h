@@ -0,0 +1,56 @@
+#ifndef VIEWUPDATESCHEDULER_H
+#define VIEWUPDATESCHEDULER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+
+class QTimer;
+class QWidget;
+
+/**
+ * @brief 视图更新调度器
+ * 滚轮、拖拽等事件处理只记录目标视图状态并登记需要更新的内容，
+ * 调度器按显示器刷新间隔合并为每帧一次 frameUpdate()，中间状态直接丢弃
+ *
+ * 空闲后的第一次请求在下一轮事件循环立即执行，之后的请求对齐到帧间隔，
+ * 保证连续滚轮时每帧最多重建一次瓦片、标注与浮层
+ */
+class ViewUpdateScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum UpdateFlag {
+        NoUpdate      = 0x0,
+        ZoomUpdate    = 0x1,    // 视觉缩放/瓦片层级切换（含渲染器层级与标注）
+        TileUpdate    = 0x2,    // 按当前视图中心刷新瓦片
+        OverlayUpdate = 0x4,    // 视图上的浮动控件定位
+        StatusUpdate  = 0x8     // 状态栏文本
+    };
+    Q_DECLARE_FLAGS(UpdateFlags, UpdateFlag)
+
+    // widget 用于获取所在屏幕的刷新率
+    explicit ViewUpdateScheduler(QWidget *widget, QObject *parent = nullptr);
+
+    void schedule(UpdateFlags flags);
+    UpdateFlags pendingFlags() const { return m_pending; }
+
+    // 立即执行已登记的更新（如需要在同一事件中读取最新视图状态时）
+    void flush();
+
+signals:
+    void frameUpdate(ViewUpdateScheduler::UpdateFlags flags);
+
+private:
+    int frameIntervalMs() const;
+
+    QWidget *m_widget;
+    QTimer *m_timer;
+    QElapsedTimer m_lastFrame;
+    UpdateFlags m_pending;
+    bool m_inFrame;
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(ViewUpdateScheduler::UpdateFlags)
+
+#endif // VIEWUPDATESCHEDULER_H
@@ -0,0 +1,282 @@
+#include "tilecompositor.h"
+#include "core/common/logger.h"
+#include <QNetworkAccessManager>
+#include <QNetworkRequest>
+#include <QNetworkReply>
+#include <QEventLoop>
+#include <QTimer>
+#include <QThreadStorage>
+#include <QPainter>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QtConcurrent/QtConcurrent>
+
+namespace {
+// 合成线程数（含下载等待，不宜过多）
+const int MAX_COMPOSITE_THREADS = 4;
+const int TILE_SIZE = 256;
+// 单个原始瓦片下载超时（毫秒）
+const int DOWNLOAD_TIMEOUT_MS = 30000;
+}
+
+size_t qHash(const TileCompositeKey &key, size_t seed)
+{
+    return qHashMulti(seed, key.stack, key.x, key.y, key.z);
+}
+
+TileCompositor::TileCompositor(QObject *parent)
+    : QObject(parent)
+    , m_stackHash(0)
+    , m_activeZoom(new QAtomicInt(-1))
+{
+    m_pool.setMaxThreadCount(MAX_COMPOSITE_THREADS);
+    m_cache.setMaxCost(64 * 1024);
+}
+
+TileCompositor::~TileCompositor()
+{
+    // 未开始的任务直接跳过，等待进行中的任务结束
+    m_activeZoom->storeRelaxed(-1);
+    m_pool.waitForDone();
+}
+
+void TileCompositor::setSources(const QList<TileSourceLayer> &sources)
+{
+    m_sources = sources;
+
+    // 源栈哈希：只计入可见图层的URL与不透明度
+    QString signature;
+    for (const TileSourceLayer &layer : m_sources) {
+        if (layer.visible) {
+            signature += QString("%1|%2|%3;").arg(layer.name, layer.urlTemplate)
+                             .arg(layer.opacity, 0, 'f', 2);
+        }
+    }
+    // 取低 32 位（合成瓦片目录名为 8 位十六进制）
+    m_stackHash = uint(qHash(signature));
+
+    LOG_INFO(QString("Tile source stack: %1 layers, hash %2, compositing %3")
+                 .arg(m_sources.size()).arg(m_stackHash, 8, 16, QChar('0'))
+                 .arg(isActive() ? "on" : "off"));
+}
+
+bool TileCompositor::isActive() const
+{
+    int visibleCount = 0;
+    for (const TileSourceLayer &layer : m_sources) {
+        if (!layer.visible) {
+            continue;
+        }
+        visibleCount++;
+        if (layer.opacity < 1.0) {
+            return true;
+        }
+    }
+    return visibleCount > 1;
+}
+
+void TileCompositor::setCacheLimitMb(int mb)
+{
+    m_cache.setMaxCost(qMax(1, mb) * 1024);
+}
+
+bool TileCompositor::cachedTile(int x, int y, int z, QImage *image) const
+{
+    const QImage *cached = m_cache.object(TileCompositeKey{m_stackHash, z, x, y});
+    if (!cached) {
+        return false;
+    }
+    if (image) {
+        *image = *cached;
+    }
+    return true;
+}
+
+void TileCompositor::requestTile(int x, int y, int z, bool allowDownload)
+{
+    const TileCompositeKey key{m_stackHash, z, x, y};
+    m_activeZoom->storeRelaxed(z);
+    if (m_running.contains(key) || m_cache.contains(key)) {
+        return;
+    }
+    m_running.insert(key);
+
+    auto *watcher = new QFutureWatcher<CompositeResult>(this);
+    m_watchers.insert(watcher);
+    connect(watcher, &QFutureWatcher<CompositeResult>::finished, this, [this, watcher]() {
+        m_watchers.remove(watcher);
+        onTileFinished(watcher->result());
+        watcher->deleteLater();
+    });
+    watcher->setFuture(QtConcurrent::run(&m_pool, &TileCompositor::composeTile,
+                                         key, m_sources, m_diskDir, allowDownload, m_activeZoom));
+}
+
+void TileCompositor::onTileFinished(const CompositeResult &result)
+{
+    m_running.remove(result.key);
+    if (result.image.isNull()) {
+        return;
+    }
+
+    if (result.complete) {
+        int cost = qMax(1, int(result.image.sizeInBytes() / 1024));
+        m_cache.insert(result.key, new QImage(result.image), cost);
+    }
+
+    // 源栈已变化的旧结果只留在缓存中，不再显示
+    if (result.key.stack == m_stackHash) {
+        emit tileReady(result.key.x, result.key.y, result.key.z, result.image, result.complete);
+    }
+}
+
+TileCompositor::CompositeResult TileCompositor::composeTile(TileCompositeKey key,
+                                                            QList<TileSourceLayer> sources,
+                                                            QString diskDir,
+                                                            bool allowDownload,
+                                                            QSharedPointer<QAtomicInt> activeZoom)
+{
+    CompositeResult result;
+    result.key = key;
+
+    // 排队期间已切换缩放级别
+    if (activeZoom->loadRelaxed() != key.z) {
+        return result;
+    }
+
+    // 1. 磁盘合成缓存
+    const QString cachePath = diskDir.isEmpty() ? QString() : compositePath(diskDir, key);
+    if (!cachePath.isEmpty() && QFile::exists(cachePath) && result.image.load(cachePath, "PNG")) {
+        result.complete = true;
+        return result;
+    }
+
+    // 2. 逐层读取原始瓦片并按不透明度叠加
+    QImage image(TILE_SIZE, TILE_SIZE, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    bool complete = true;
+    bool anyLayer = false;
+    {
+        QPainter painter(&image);
+        painter.setRenderHint(QPainter::SmoothPixmapTransform, true);
+        for (const TileSourceLayer &layer : sources) {
+            if (!layer.visible || layer.opacity <= 0.0) {
+                continue;
+            }
+            QImage tile = fetchLayerTile(layer, key.x, key.y, key.z, allowDownload);
+            if (tile.isNull()) {
+                complete = false;
+                continue;
+            }
+            painter.setOpacity(layer.opacity);
+            painter.drawImage(QRect(0, 0, TILE_SIZE, TILE_SIZE), tile);
+            anyLayer = true;
+        }
+    }
+    if (!anyLayer) {
+        return result;
+    }
+    result.image = image;
+    result.complete = complete;
+
+    // 3. 只有完整的合成结果写入磁盘
+    if (complete && !cachePath.isEmpty()) {
+        QDir dir(QFileInfo(cachePath).path());
+        if (dir.exists() || dir.mkpath(".")) {
+            image.save(cachePath, "PNG");
+        }
+    }
+    return result;
+}
+
+QImage TileCompositor::fetchLayerTile(const TileSourceLayer &layer, int x, int y, int z, bool allowDownload)
+{
+    const QString filePath = QString("%1/%2/%3/%4.png").arg(layer.cacheDir).arg(z).arg(x).arg(y);
+    QImage tile;
+    if (QFile::exists(filePath) && tile.load(filePath)) {
+        return tile;
+    }
+    if (!allowDownload || layer.urlTemplate.isEmpty()) {
+        return QImage();
+    }
+
+    // 工作线程内同步下载（与 TileWorker 的请求头一致）
+    // 每个工作线程复用一个网络管理器（连接与 DNS 缓存跨瓦片保留），线程退出时释放
+    static QThreadStorage<QNetworkAccessManager*> managers;
+    if (!managers.hasLocalData()) {
+        managers.setLocalData(new QNetworkAccessManager());
+    }
+    QNetworkAccessManager *manager = managers.localData();
+    QNetworkRequest request{QUrl(tileUrl(layer.urlTemplate, x, y, z))};
+    request.setRawHeader("User-Agent", "Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0.0.0 Safari/537.36");
+    request.setRawHeader("Accept", "image/png,image/jpeg,image/*;q=0.8,*/*;q=0.5");
+    request.setTransferTimeout(DOWNLOAD_TIMEOUT_MS);
+
+    QNetworkReply *reply = manager->get(request);
+    QEventLoop loop;
+    connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
+    loop.exec();
+
+    QByteArray data;
+    if (reply->error() == QNetworkReply::NoError) {
+        data = reply->readAll();
+    } else {
+        LOG_WARNING(QString("Tile source %1 download failed: %2/%3/%4 %5")
+                        .arg(layer.name).arg(z).arg(x).arg(y).arg(reply->errorString()));
+    }
+    // 池线程没有事件循环处理 deleteLater，管理器又不随瓦片销毁，直接释放
+    delete reply;
+
+    // 影像源常为 JPEG，按内容解码后统一以 PNG 保存
+    if (data.isEmpty() || !tile.loadFromData(data)) {
+        return QImage();
+    }
+    QDir dir(QFileInfo(filePath).path());
+    if (dir.exists() || dir.mkpath(".")) {
+        tile.save(filePath, "PNG");
+    }
+    return tile;
+}
+
+QString TileCompositor::tileUrl(const QString &urlTemplate, int x, int y, int z)
+{
+    static const QStringList servers = {"a", "b", "c"};
+    QString url = urlTemplate;
+    url.replace("{x}", QString::number(x));
+    url.replace("{y}", QString::number(y));
+    url.replace("{z}", QString::number(z));
+    // 按瓦片坐标分散到不同服务器（工作线程中不共享轮换计数）
+    url.replace("{server}", servers[(x + y) % servers.size()]);
+    return url;
+}
+
+QString TileCompositor::compositePath(const QString &diskDir, const TileCompositeKey &key)
+{
+    return QString("%1/%2/%3/%4/%5.png").arg(diskDir)
+        .arg(key.stack, 8, 16, QChar('0')).arg(key.z).arg(key.x).arg(key.y);
+}
+
+QList<TileSourceLayer> TileCompositor::parseSourceList(const QString &text, const QString &cacheRoot)
+{
+    QList<TileSourceLayer> layers;
+    const QStringList entries = text.split(';', Qt::SkipEmptyParts);
+    for (const QString &entry : entries) {
+        const QStringList parts = entry.trimmed().split('|');
+        if (parts.size() < 2 || parts[0].trimmed().isEmpty() || parts[1].trimmed().isEmpty()) {
+            LOG_WARNING(QString("Invalid tile source entry: %1").arg(entry));
+            continue;
+        }
+        TileSourceLayer layer;
+        layer.name = parts[0].trimmed();
+        layer.urlTemplate = parts[1].trimmed();
+        layer.cacheDir = cacheRoot + "/sources/" + layer.name;
+        if (parts.size() >= 3) {
+            bool ok = false;
+            qreal opacity = parts[2].trimmed().toDouble(&ok);
+            layer.opacity = ok ? qBound<qreal>(0.0, opacity, 1.0) : 1.0;
+        }
+        layers.append(layer);
+    }
+    return layers;
+}
@@ -0,0 +1,113 @@
+#ifndef TILECOMPOSITOR_H
+#define TILECOMPOSITOR_H
+
+#include <QObject>
+#include <QCache>
+#include <QHash>
+#include <QSet>
+#include <QList>
+#include <QImage>
+#include <QString>
+#include <QThreadPool>
+#include <QFutureWatcher>
+#include <QSharedPointer>
+#include <QAtomicInt>
+
+// 瓦片源图层（按列表顺序自下而上叠加）
+struct TileSourceLayer {
+    QString name;           // 图层名称（同时作为原始瓦片子目录名）
+    QString urlTemplate;    // 瓦片URL模板，支持 {x} {y} {z} {server}
+    QString cacheDir;       // 原始瓦片目录（z/x/y.png）
+    qreal opacity = 1.0;
+    bool visible = true;
+};
+
+// 合成瓦片键值
+struct TileCompositeKey {
+    uint stack;     // 源栈哈希
+    int z, x, y;
+
+    bool operator==(const TileCompositeKey &other) const {
+        return stack == other.stack && z == other.z && x == other.x && y == other.y;
+    }
+};
+
+size_t qHash(const TileCompositeKey &key, size_t seed = 0);
+
+/**
+ * @brief 多源瓦片合成器
+ * 将有序的瓦片源栈（如影像底图 + 街道注记、底图 + 山体阴影）在工作线程池中
+ * 按图层不透明度合成为单张瓦片，GUI 线程每个瓦片位置只需绘制一个 pixmap
+ *
+ * 合成结果以（源栈哈希, z, x, y）为键缓存在内存与磁盘中，源栈或不透明度变化后
+ * 哈希随之改变，旧结果自然失效；缺失的原始瓦片在工作线程中下载并写入各自目录
+ */
+class TileCompositor : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit TileCompositor(QObject *parent = nullptr);
+    ~TileCompositor();
+
+    void setSources(const QList<TileSourceLayer> &sources);
+    QList<TileSourceLayer> sources() const { return m_sources; }
+
+    // 是否需要合成（可见图层多于一个，或存在半透明图层）
+    bool isActive() const;
+    uint stackHash() const { return m_stackHash; }
+
+    // 合成结果磁盘缓存根目录（为空时只使用内存缓存）
+    void setDiskCacheDir(const QString &dir) { m_diskDir = dir; }
+    void setCacheLimitMb(int mb);
+
+    // 当前源栈下的内存缓存（GUI线程）
+    bool cachedTile(int x, int y, int z, QImage *image) const;
+
+    // 请求合成，完成后发出 tileReady（同一瓦片进行中的请求会合并；
+    // 切换到新缩放级别后，尚未开始的旧级别任务直接跳过）
+    void requestTile(int x, int y, int z, bool allowDownload);
+
+    int pendingCount() const { return m_running.size(); }
+
+    // 从配置字符串解析叠加图层："名称|URL模板|不透明度;..."
+    static QList<TileSourceLayer> parseSourceList(const QString &text, const QString &cacheRoot);
+
+signals:
+    // complete 为 false 表示部分图层缺失（如拖拽中不下载），稍后可重新请求
+    void tileReady(int x, int y, int z, const QImage &image, bool complete);
+
+private:
+    struct CompositeResult {
+        TileCompositeKey key;
+        QImage image;           // 所有图层均缺失或任务被跳过时为空
+        bool complete = false;  // 所有可见图层均已取得（只缓存完整结果）
+    };
+
+    void onTileFinished(const CompositeResult &result);
+
+    // 工作线程：读取磁盘合成缓存，未命中时逐层读取/下载原始瓦片并合成
+    static CompositeResult composeTile(TileCompositeKey key,
+                                       QList<TileSourceLayer> sources,
+                                       QString diskDir,
+                                       bool allowDownload,
+                                       QSharedPointer<QAtomicInt> activeZoom);
+    static QImage fetchLayerTile(const TileSourceLayer &layer, int x, int y, int z, bool allowDownload);
+    static QString tileUrl(const QString &urlTemplate, int x, int y, int z);
+    static QString compositePath(const QString &diskDir, const TileCompositeKey &key);
+
+private:
+    QList<TileSourceLayer> m_sources;
+    uint m_stackHash;
+    QString m_diskDir;
+
+    // 内存缓存（成本单位 KB）
+    QCache<TileCompositeKey, QImage> m_cache;
+
+    QThreadPool m_pool;
+    QSharedPointer<QAtomicInt> m_activeZoom;    // 最近一次请求的缩放级别（工作线程读取）
+    QSet<TileCompositeKey> m_running;
+    QSet<QFutureWatcher<CompositeResult>*> m_watchers;
+};
+
+#endif // TILECOMPOSITOR_H
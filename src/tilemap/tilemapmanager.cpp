@@ -10,6 +10,7 @@ void TileMapManager::enqueueInsert(int x, int y, int z, const QPixmap &pixmap)
     pi.z = z;
     pi.pixmap = pixmap;
     m_pendingInsert.enqueue(pi);
+    m_decodedTileCount++;
     if (!m_insertTimer->isActive()) {
         m_insertTimer->start();
     }
@@ -27,6 +28,13 @@ void TileMapManager::flushPendingInserts()
         PendingInsert pi = m_pendingInsert.dequeue();
         // 仅插入当前缩放级别
         if (pi.z != m_zoom) continue;
+        // 已有瓦片（如部分合成瓦片补齐）只替换图像
+        TileKey existingKey = {pi.x, pi.y, pi.z};
+        if (QGraphicsPixmapItem *existing = m_tileItems.value(existingKey)) {
+            existing->setPixmap(pi.pixmap);
+            batch++;
+            continue;
+        }
         QGraphicsPixmapItem *item = m_scene->addPixmap(pi.pixmap);
         double tileXScene = pi.x * m_tileSize;
         double tileYScene = pi.y * m_tileSize;
@@ -41,6 +49,7 @@ void TileMapManager::flushPendingInserts()
     }
 }
 #include "tileworker.h"
+#include "core/common/config.h"
 #include <QGraphicsScene>
 #include <QGraphicsPixmapItem>
 #include <QNetworkRequest>
@@ -113,6 +122,7 @@ TileMapManager::TileMapManager(QObject *parent)
     , m_regionDownloadCurrent(0)
     , m_workerThread(nullptr)
     , m_worker(nullptr)
+    , m_compositor(new TileCompositor(this))
     , m_processTimer(new QTimer(this))
     , m_insertTimer(new QTimer(this))
     , m_isProcessing(false)
@@ -158,6 +168,19 @@ TileMapManager::TileMapManager(QObject *parent)
         if (m_verboseLogging) logMessage("Cache directory already exists");
     }
     
+    // 多源瓦片栈：底图 + 配置中的叠加图层（合成结果缓存在 composite 目录）
+    m_compositor->setDiskCacheDir(m_cacheDir + "/composite");
+    m_compositor->setCacheLimitMb(Config::instance().getInt("Map/tile_composite_cache_mb", 64));
+    connect(m_compositor, &TileCompositor::tileReady, this, &TileMapManager::onCompositeTileReady);
+    QList<TileSourceLayer> sources;
+    TileSourceLayer baseLayer;
+    baseLayer.name = "base";
+    baseLayer.urlTemplate = m_tileUrlTemplate;
+    baseLayer.cacheDir = m_cacheDir;
+    sources.append(baseLayer);
+    sources += TileCompositor::parseSourceList(Config::instance().getString("Map/tile_overlays"), m_cacheDir);
+    m_compositor->setSources(sources);
+    
     // 设置处理定时器
     m_processTimer->setSingleShot(true);
     connect(m_processTimer, &QTimer::timeout, this, &TileMapManager::processNextBatch);
@@ -865,6 +888,74 @@ void TileMapManager::checkAndEmitDownloadFinished()
 void TileMapManager::setTileSource(const QString &urlTemplate)
 {
     m_tileUrlTemplate = urlTemplate;
+    
+    // 同步更新合成栈中的底图
+    QList<TileSourceLayer> sources = m_compositor->sources();
+    for (TileSourceLayer &layer : sources) {
+        if (layer.name == "base") {
+            layer.urlTemplate = urlTemplate;
+        }
+    }
+    m_compositor->setSources(sources);
+}
+
+void TileMapManager::setTileSources(const QList<TileSourceLayer> &sources)
+{
+    // 未指定目录的图层：底图使用瓦片缓存根目录，其余放在 sources/<名称>
+    QList<TileSourceLayer> resolved = sources;
+    for (TileSourceLayer &layer : resolved) {
+        if (layer.cacheDir.isEmpty()) {
+            layer.cacheDir = (layer.name == "base") ? m_cacheDir : m_cacheDir + "/sources/" + layer.name;
+        }
+    }
+    m_compositor->setSources(resolved);
+    
+    // 源栈变化后场景中的瓦片全部重新生成
+    m_pendingInsert.clear();
+    removeAllTileItems();
+    loadTiles();
+}
+
+QList<TileSourceLayer> TileMapManager::tileSources() const
+{
+    return m_compositor->sources();
+}
+
+void TileMapManager::requestCompositeTile(int x, int y, bool allowDownload)
+{
+    // 内存缓存命中时直接插入，否则交给合成线程池
+    QImage image;
+    if (m_compositor->cachedTile(x, y, m_zoom, &image)) {
+        enqueueInsert(x, y, m_zoom, QPixmap::fromImage(image));
+    } else {
+        m_compositor->requestTile(x, y, m_zoom, allowDownload);
+    }
+}
+
+void TileMapManager::onCompositeTileReady(int x, int y, int z, const QImage &image, bool complete)
+{
+    if (!m_scene || z != m_zoom) {
+        return;
+    }
+    TileKey key = {x, y, z};
+    if (complete) {
+        m_partialCompositeTiles.remove(key);
+    } else {
+        m_partialCompositeTiles.insert(key);
+    }
+    enqueueInsert(x, y, z, QPixmap::fromImage(image));
+}
+
+void TileMapManager::removeAllTileItems()
+{
+    for (QGraphicsPixmapItem *item : std::as_const(m_tileItems)) {
+        if (item && m_scene && item->scene() == m_scene) {
+            m_scene->removeItem(item);
+        }
+        delete item;
+    }
+    m_tileItems.clear();
+    m_partialCompositeTiles.clear();
 }
 
 QPointF TileMapManager::getCenterScenePos() const
@@ -1111,6 +1202,17 @@ void TileMapManager::calculateVisibleTiles(bool allowDownload)
             
             // 如果瓦片已经加载，跳过
             if (m_tileItems.contains(key)) {
+                // 缺少部分图层的合成瓦片在允许下载时补齐一次
+                if (allowDownload && m_partialCompositeTiles.remove(key)) {
+                    m_compositor->requestTile(x, y, m_zoom, true);
+                }
+                tilesLoaded++;
+                continue;
+            }
+            
+            // 多源合成：由合成器读取/下载各图层并合成
+            if (m_compositor->isActive()) {
+                requestCompositeTile(x, y, allowDownload);
                 tilesLoaded++;
                 continue;
             }
@@ -1180,6 +1282,7 @@ void TileMapManager::cleanupTiles()
     // 移除瓦片（批量操作，减少单个删除的开销）
     for (const TileKey &key : keysToRemove) {
         QGraphicsPixmapItem *item = m_tileItems.take(key);
+        m_partialCompositeTiles.remove(key);
         if (item) {
             // 检查图形项是否属于当前场景
             if (item->scene() == m_scene) {
@@ -1368,6 +1471,12 @@ int TileMapManager::loadLocalTiles()
                 continue;
             }
             
+            // 多源合成：只使用本地已有的图层
+            if (m_compositor->isActive()) {
+                requestCompositeTile(x, y, false);
+                continue;
+            }
+            
             // 检查本地是否存在瓦片
             if (tileExists(x, y, m_zoom)) {
                 // 直接从文件加载
@@ -1456,6 +1565,17 @@ void TileMapManager::getLocalTilesInfo()
     logMessage(QString("Zoom levels: %1").arg(zoomKeys.join(", ")));
 }
 
+TileMapManager::TileStats TileMapManager::getTileStats() const
+{
+    // 计数均在主线程更新，这里只读取快照
+    TileStats stats;
+    stats.inFlight = m_currentRequests + m_compositor->pendingCount();
+    stats.queued = m_pendingTiles.size();
+    stats.pendingInserts = m_pendingInsert.size();
+    stats.decodedTotal = m_decodedTileCount;
+    return stats;
+}
+
 int TileMapManager::getMaxAvailableZoom() const
 {
     // 检查缓存目录是否存在
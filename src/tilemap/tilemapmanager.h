@@ -10,6 +10,7 @@
 #include <QSet>
 #include <QTimer>
 #include <QPointF>
+#include "tilecompositor.h"
 
 class TileWorker;
 
@@ -49,6 +50,10 @@ public:
                                 double visualScale = 1.0);  // 在鼠标位置缩放
     int getZoom() const { return m_zoom; }
     void setTileSource(const QString &urlTemplate);
+    // 多源瓦片栈（自下而上叠加，第一个为底图）；多于一个可见图层或存在半透明图层时
+    // 由 TileCompositor 在工作线程中合成，场景中每个瓦片位置仍只有一个 pixmap
+    void setTileSources(const QList<TileSourceLayer> &sources);
+    QList<TileSourceLayer> tileSources() const;
     void setViewSize(int width, int height);  // 设置视图大小
     void updateTilesForView(double sceneX, double sceneY);  // 根据场景坐标更新瓦片（带阈值）
     void updateTilesForViewImmediate(double sceneX, double sceneY); // 立即更新（无阈值，用于拖拽中）
@@ -56,6 +61,7 @@ public:
     void setDragging(bool dragging) { m_isDragging = dragging; }
     QPointF getCenterScenePos() const; // 获取当前中心的场景像素坐标
     int getTileSize() const { return m_tileSize; }
+    QString getCacheDir() const { return m_cacheDir; }  // 本地瓦片目录（z/x/y.png）
     // 日志控制
     void setVerboseLogging(bool enable) { m_verboseLogging = enable; }
     // 可开关设置
@@ -74,6 +80,15 @@ public:
     // 获取当前可用的最大缩放级别
     int getMaxAvailableZoom() const;
     
+    // 瓦片管线统计（诊断浮层使用）
+    struct TileStats {
+        int inFlight;           // 正在下载/加载的请求数
+        int queued;             // 等待发起的请求数
+        int pendingInserts;     // 已解码、等待插入场景的瓦片数
+        qint64 decodedTotal;    // 累计解码瓦片数
+    };
+    TileStats getTileStats() const;
+    
     // 坐标转换：地理坐标 -> 场景坐标（与瓦片布局一致）
     QPointF geoToScene(double lon, double lat) const;
     // 坐标转换：场景坐标 -> 地理坐标（使用当前或指定缩放级别）
@@ -106,6 +121,10 @@ private:
     QThread *m_workerThread;
     TileWorker *m_worker;
     
+    // 多源瓦片合成
+    TileCompositor *m_compositor;
+    QSet<TileKey> m_partialCompositeTiles;  // 缺少部分图层的已显示合成瓦片
+    
     // 下载队列和处理相关
     QQueue<TileInfo> m_pendingTiles;
     QTimer *m_processTimer;
@@ -149,6 +168,8 @@ public:
     void enqueueDownload(int x, int y, int z) { downloadTile(x, y, z); }
     void loadTiles();
     void calculateVisibleTiles(bool allowDownload = true);
+    void requestCompositeTile(int x, int y, bool allowDownload);
+    void removeAllTileItems();
     void cleanupTiles();
     void repositionTiles();
     int loadLocalTiles();
@@ -167,6 +188,7 @@ public:
     };
     QQueue<PendingInsert> m_pendingInsert;
     QTimer *m_insertTimer = nullptr;
+    qint64 m_decodedTileCount = 0;  // 累计解码瓦片数（诊断统计）
     mutable double m_lastUpdateSceneX = -1;
     mutable double m_lastUpdateSceneY = -1;
     bool m_verboseLogging = false; // 详细日志开关
@@ -175,6 +197,7 @@ private slots:
     void processNextBatch();
     void onTileDownloaded(int x, int y, int z, const QByteArray &data, bool success, const QString &errorString);
     void onTileLoaded(int x, int y, int z, const QPixmap &pixmap, bool success, const QString &errorString);
+    void onCompositeTileReady(int x, int y, int z, const QImage &image, bool complete);
     void onDownloadProgress(qint64 bytesReceived, qint64 bytesTotal);
 
 signals:
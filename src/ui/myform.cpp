@@ -13,6 +13,8 @@
 #include "widgets/entityviewdialog.h"  // 实体属性查看对话框
 #include "widgets/messagedialog.h"  // 消息对话框
 #include "widgets/profiledialog.h"  // 个人信息对话框
+#include "widgets/mapdiagnosticsoverlay.h"  // 地图诊断浮层
+#include "core/database/queryprofiler.h"  // 查询剖析导出
 #include "core/auth/sessionmanager.h"  // 会话管理
 #include "core/auth/permissionmanager.h"  // 权限管理
 #include "map/mapdrawingmanager.h"  // 添加绘制管理器头文件
@@ -29,6 +31,7 @@
 #include "dao/pipelinedao.h"
 #include "dao/facilitydao.h"
 #include "dao/workorderdao.h"
+#include "dao/asyncdao.h"
 #include "core/database/databasemanager.h"
 #include "widgets/facilityeditdialog.h"
 #include "core/models/workorder.h"
@@ -77,6 +80,8 @@
 #include <QPainter>
 #include <QMainWindow>
 #include <QDesktopServices>
+#include <QInputDialog>
+#include <QProgressDialog>
 #include <QUrl>
 #include <cmath>
 #include <QtGlobal>
@@ -89,8 +94,52 @@
 #include "core/common/logger.h"
 #include "core/common/config.h"
 #include "core/database/databasemanager.h"
+#include "core/database/changelistener.h"
 #include "map/layermanager.h"
 #include "map/pipelinerenderer.h"
+#include "map/facilityrenderer.h"
+#include "map/facilityclusteritem.h"
+#include "map/layeritemregistry.h"
+#include "map/vectortilecache.h"
+#include "map/entitypickindex.h"
+#include "map/entitygraphicsitem.h"
+#include "map/mapexportengine.h"
+
+namespace {
+// 设备树后台加载结果
+struct DeviceTreeData {
+    QVector<Pipeline> pipelines;
+    QVector<Facility> facilities;
+};
+
+// 设备树管线类型映射（数据库类型 -> 显示名称）
+const QMap<QString, QString> &deviceTreePipelineTypeNames()
+{
+    static const QMap<QString, QString> names = {
+        {"water_supply", "📘 给水管"},
+        {"sewage", "📗 排水管"},
+        {"gas", "📙 燃气管"},
+        {"electric", "📕 电力电缆"},
+        {"telecom", "📒 通信光缆"},
+        {"heat", "📓 供热管"}
+    };
+    return names;
+}
+
+// 设备树设施类型映射（数据库类型 -> 显示名称）
+const QMap<QString, QString> &deviceTreeFacilityTypeNames()
+{
+    static const QMap<QString, QString> names = {
+        {"valve", "🚰 阀门井"},
+        {"manhole", "🚪 检查井"},
+        {"pump_station", "⚙️ 泵站"},
+        {"transformer", "⚡ 变压器"},
+        {"regulator", "🔧 调压站"},
+        {"junction_box", "📦 接线盒"}
+    };
+    return names;
+}
+}
 
 MyForm::MyForm(QWidget *parent)
     : QWidget(parent)
@@ -352,6 +401,26 @@ void MyForm::keyPressEvent(QKeyEvent *event)
         event->accept();
         return;
     }
+    // Ctrl+P 导出高分辨率地图（PNG/PDF）
+    else if (event->key() == Qt::Key_P && event->modifiers() == Qt::ControlModifier) {
+        onExportMap();
+        event->accept();
+        return;
+    }
+    // F12 显示/隐藏诊断浮层，Ctrl+F12 导出帧耗时直方图与查询剖析 JSON
+    else if (event->key() == Qt::Key_F12 && m_diagnosticsOverlay) {
+        if (event->modifiers() == Qt::ControlModifier) {
+            QString path = m_diagnosticsOverlay->dumpHistogram();
+            QString profilePath = QueryProfiler::instance().dumpJson();
+            updateStatus(path.isEmpty() || profilePath.isEmpty()
+                             ? "❌ 诊断数据导出失败"
+                             : QString("✅ 诊断数据已导出: %1, %2").arg(path, profilePath));
+        } else {
+            m_diagnosticsOverlay->toggle();
+        }
+        event->accept();
+        return;
+    }
     
     QWidget::keyPressEvent(event);
 
@@ -666,28 +735,37 @@ void MyForm::setupMapArea() {
     tileMapManager->initScene(mapScene);
     ui->graphicsView->setViewportUpdateMode(QGraphicsView::SmartViewportUpdate);
     
+    // 地图诊断浮层（默认隐藏，显示时才统计帧耗时）
+    m_diagnosticsOverlay = new MapDiagnosticsOverlay(ui->graphicsView);
+    m_diagnosticsOverlay->setTileMapManager(tileMapManager);
+    
     // 创建视图更新定时器（用于拖动时延迟更新瓦片）
     viewUpdateTimer = new QTimer(this);
     viewUpdateTimer->setSingleShot(true);
     viewUpdateTimer->setInterval(100);  // 拖动停止100ms后更新，提升响应速度
     connect(viewUpdateTimer, &QTimer::timeout, this, &MyForm::updateVisibleTiles);
     
+    // 逐帧视图更新调度（滚轮/拖拽合并为每帧一次瓦片、标注与浮层更新）
+    m_viewUpdateScheduler = new ViewUpdateScheduler(ui->graphicsView, this);
+    connect(m_viewUpdateScheduler, &ViewUpdateScheduler::frameUpdate,
+            this, &MyForm::onViewUpdateFrame);
+    
     // 连接滚动条变化信号，实现拖拽时的瓦片更新
     connect(ui->graphicsView->horizontalScrollBar(), &QScrollBar::valueChanged, 
             this, [this]() {
         if (tileMapManager && !isDownloading) {
             viewUpdateTimer->start();  // 重启定时器，实现防抖更新
         }
-        positionGraphicsOverlay();
-        positionPanelSwitcher();  // 同步更新面板和按钮位置
+        // 同步更新面板和按钮位置（每帧一次）
+        m_viewUpdateScheduler->schedule(ViewUpdateScheduler::OverlayUpdate);
     });
     connect(ui->graphicsView->verticalScrollBar(), &QScrollBar::valueChanged, 
             this, [this]() {
         if (tileMapManager && !isDownloading) {
             viewUpdateTimer->start();  // 重启定时器，实现防抖更新
         }
-        positionGraphicsOverlay();
-        positionPanelSwitcher();  // 同步更新面板和按钮位置
+        // 同步更新面板和按钮位置（每帧一次）
+        m_viewUpdateScheduler->schedule(ViewUpdateScheduler::OverlayUpdate);
     });
     
     // 连接下载进度信号（在这里连接，因为tileMapManager已经创建）
@@ -796,6 +874,9 @@ void MyForm::setupMapArea() {
             this, &MyForm::onPipelineDrawingFinished);
     connect(m_drawingManager, &MapDrawingManager::facilityDrawingFinished,
             this, &MyForm::onFacilityDrawingFinished);
+    // 绘制期间矢量图层回退为实时绘制
+    connect(m_drawingManager, &MapDrawingManager::drawingStateChanged,
+            this, [this](bool) { updateVectorTileEditing(); });
     qDebug() << "MapDrawingManager created and connected";
     
     // 显示初始状态信息
@@ -972,6 +1053,149 @@ void MyForm::createGraphicsOverlayScene()
     positionGraphicsOverlayScene();
 }
 
+void MyForm::onViewUpdateFrame(ViewUpdateScheduler::UpdateFlags flags)
+{
+    // 1. 缩放（层级切换时已按新中心刷新瓦片）
+    bool tilesUpdated = false;
+    if (flags & ViewUpdateScheduler::ZoomUpdate) {
+        const int zoomBefore = currentZoomLevel;
+        applyPendingWheelZoom();
+        tilesUpdated = (currentZoomLevel != zoomBefore);
+    }
+    
+    // 2. 平移后的瓦片刷新
+    if ((flags & ViewUpdateScheduler::TileUpdate) && !tilesUpdated && tileMapManager && !isDownloading) {
+        QPointF centeredScene = ui->graphicsView->mapToScene(ui->graphicsView->viewport()->rect().center());
+        tileMapManager->updateTilesForViewImmediate(centeredScene.x(), centeredScene.y());
+    }
+    
+    // 3. 浮动控件
+    if (flags & ViewUpdateScheduler::OverlayUpdate) {
+        positionGraphicsOverlay();
+        positionPanelSwitcher();
+    }
+    
+    // 4. 状态栏（只显示本帧最后一条）
+    if ((flags & ViewUpdateScheduler::StatusUpdate) && !m_pendingStatusText.isEmpty()) {
+        updateStatus(m_pendingStatusText);
+        m_pendingStatusText.clear();
+    }
+}
+
+void MyForm::applyPendingWheelZoom()
+{
+    if (!tileMapManager || qFuzzyCompare(m_pendingWheelFactor, 1.0)) {
+        m_pendingWheelFactor = 1.0;
+        return;
+    }
+    
+    // 先在视图层做连续缩放（本帧累积的全部滚轮步进一次应用）
+    QPointF mouseViewportPos = m_pendingWheelAnchor;
+    QPointF mouseScenePos = ui->graphicsView->mapToScene(mouseViewportPos.toPoint());
+    QPointF mouseGeo = tileMapManager->sceneToGeo(mouseScenePos, currentZoomLevel);
+    
+    const double newScale = qBound(0.1, m_visualScale * m_pendingWheelFactor, 8.0); // 限制极值，避免过大/过小
+    const double appliedFactor = newScale / m_visualScale;
+    m_pendingWheelFactor = 1.0;
+    m_visualScale = newScale;
+    double visualScaleForAnchor = m_visualScale; // 记录切级前的视觉缩放，用于精确锚点计算
+    ui->graphicsView->setTransformationAnchor(QGraphicsView::AnchorUnderMouse);
+    ui->graphicsView->scale(appliedFactor, appliedFactor);
+    
+    // 跨阈值时切换瓦片层级（一帧内跨多级只切换一次）
+    double switchedScale = m_visualScale;
+    int switchedLevel = currentZoomLevel;
+    projectWheelZoom(m_visualScale, currentZoomLevel, &switchedScale, &switchedLevel);
+    m_visualScale = switchedScale;
+    
+    if (switchedLevel != currentZoomLevel) {
+        currentZoomLevel = switchedLevel;
+        qDebug() << "[SmoothZoom] Switch tiles to level" << currentZoomLevel 
+                 << "visualScale reset to" << m_visualScale;
+        
+        // 调整瓦片缩放并以鼠标为锚点
+        tileMapManager->setZoomAtMousePosition(
+            currentZoomLevel, 
+            mouseScenePos.x(), 
+            mouseScenePos.y(),
+            mouseViewportPos.x(),
+            mouseViewportPos.y(),
+            ui->graphicsView->viewport()->width(),
+            ui->graphicsView->viewport()->height(),
+            visualScaleForAnchor  // 使用切级前的真实视觉缩放保持锚点一致
+        );
+        
+        // 同步渲染器层级
+        if (m_layerManager) {
+            m_layerManager->setZoom(currentZoomLevel);
+            qDebug() << "[Zoom] Renderer zoom updated to:" << currentZoomLevel;
+        }
+        
+        // 重置视图变换为新的视觉比例，避免累乘误差
+        ui->graphicsView->resetTransform();
+        ui->graphicsView->setTransformationAnchor(QGraphicsView::AnchorUnderMouse);
+        ui->graphicsView->scale(m_visualScale, m_visualScale);
+
+        // 重新对齐视图，使鼠标下的地理位置保持不变
+        if (!mouseGeo.isNull()) {
+            QPointF targetScene = tileMapManager->geoToScene(mouseGeo.x(), mouseGeo.y());
+            QPointF viewportCenterF = QPointF(ui->graphicsView->viewport()->rect().center());
+            QPointF offsetViewport = mouseViewportPos - viewportCenterF;
+            // 视口到场景的偏移（考虑当前视觉缩放）
+            QPointF offsetScene(offsetViewport.x() / m_visualScale,
+                                offsetViewport.y() / m_visualScale);
+            QPointF desiredCenter = targetScene - offsetScene;
+            ui->graphicsView->centerOn(desiredCenter);
+            tileMapManager->updateTilesForViewImmediate(desiredCenter.x(), desiredCenter.y());
+            // 同步瓦片管理器的中心，避免后续缩放累积偏差
+            QPointF desiredGeo = tileMapManager->sceneToGeo(desiredCenter, currentZoomLevel);
+            tileMapManager->setCenter(desiredGeo.y(), desiredGeo.x());
+        } else {
+            // 回退：按当前中心刷新
+            QPointF centerScene = tileMapManager->getCenterScenePos();
+            ui->graphicsView->centerOn(centerScene);
+            tileMapManager->updateTilesForViewImmediate(centerScene.x(), centerScene.y());
+        }
+    }
+    
+    updateStatus(QString("Tile Map Zoom Level: %1/%2  (visual x%3)")
+                 .arg(currentZoomLevel)
+                 .arg(MAX_ZOOM_LEVEL)
+                 .arg(m_visualScale, 0, 'f', 2));
+}
+
+void MyForm::projectWheelZoom(double visualScale, int zoomLevel,
+                              double *outScale, int *outLevel) const
+{
+    const double upscaleThreshold = 2.0;
+    const double downscaleThreshold = 0.5;
+    
+    // 向上跨阈值：切换到更高层级
+    while (visualScale >= upscaleThreshold && zoomLevel < MAX_ZOOM_LEVEL) {
+        visualScale /= 2.0;
+        zoomLevel++;
+    }
+    
+    // 向下跨阈值：切换到更低层级
+    while (visualScale <= downscaleThreshold && zoomLevel > MIN_ZOOM_LEVEL) {
+        visualScale *= 2.0;
+        zoomLevel--;
+    }
+    
+    *outScale = visualScale;
+    *outLevel = zoomLevel;
+}
+
+void MyForm::scheduleStatus(const QString &message)
+{
+    m_pendingStatusText = message;
+    if (m_viewUpdateScheduler) {
+        m_viewUpdateScheduler->schedule(ViewUpdateScheduler::StatusUpdate);
+    } else {
+        updateStatus(message);
+    }
+}
+
 void MyForm::positionGraphicsOverlayScene()
 {
     // disabled
@@ -986,105 +1210,27 @@ bool MyForm::eventFilter(QObject *obj, QEvent *event)
             
             // 如果瓦片地图管理器存在，使用离散的层级缩放
             if (tileMapManager) {
-                // 平滑视觉缩放：累积 visual scale，跨阈值才切换瓦片层级
+                // 平滑视觉缩放：只累积缩放倍数，由逐帧更新统一应用（快速滚动时合并中间状态）
                 const bool zoomingIn = wheelEvent->angleDelta().y() > 0;
                 const double stepFactor = zoomingIn ? 1.12 : (1.0 / 1.12);
-                const double upscaleThreshold = 2.0;
-                const double downscaleThreshold = 0.5;
                 
-                QPointF mouseViewportPos = wheelEvent->position();          // 保留亚像素精度
-                QPointF mouseScenePos = ui->graphicsView->mapToScene(mouseViewportPos.toPoint());
-                QPointF mouseGeo;
-                if (tileMapManager) {
-                    mouseGeo = tileMapManager->sceneToGeo(mouseScenePos, currentZoomLevel);
-                }
-
-                // 边界保护：达到最小级别时不再缩小；达到最大级别时不再放大
-                if (!zoomingIn && currentZoomLevel <= MIN_ZOOM_LEVEL && m_visualScale <= 1.0) {
-                    updateStatus(QString("已到最小层级 (%1)，不能继续缩小").arg(MIN_ZOOM_LEVEL));
+                // 边界保护：按待应用后的目标状态判断
+                double targetScale = m_visualScale;
+                int targetLevel = currentZoomLevel;
+                projectWheelZoom(m_visualScale * m_pendingWheelFactor, currentZoomLevel,
+                                 &targetScale, &targetLevel);
+                if (!zoomingIn && targetLevel <= MIN_ZOOM_LEVEL && targetScale <= 1.0) {
+                    scheduleStatus(QString("已到最小层级 (%1)，不能继续缩小").arg(MIN_ZOOM_LEVEL));
                     return true;
                 }
-                if (zoomingIn && currentZoomLevel >= MAX_ZOOM_LEVEL && m_visualScale >= 1.0) {
-                    updateStatus(QString("已到最大层级 (%1)，不能继续放大").arg(MAX_ZOOM_LEVEL));
+                if (zoomingIn && targetLevel >= MAX_ZOOM_LEVEL && targetScale >= 1.0) {
+                    scheduleStatus(QString("已到最大层级 (%1)，不能继续放大").arg(MAX_ZOOM_LEVEL));
                     return true;
                 }
                 
-                // 先在视图层做连续缩放
-                m_visualScale = qBound(0.1, m_visualScale * stepFactor, 8.0); // 限制极值，避免过大/过小
-                double visualScaleForAnchor = m_visualScale; // 记录切级前的视觉缩放，用于精确锚点计算
-                ui->graphicsView->setTransformationAnchor(QGraphicsView::AnchorUnderMouse);
-                ui->graphicsView->scale(stepFactor, stepFactor);
-                
-                bool zoomLevelChanged = false;
-                
-                // 向上跨阈值：切换到更高层级
-                while (m_visualScale >= upscaleThreshold && currentZoomLevel < MAX_ZOOM_LEVEL) {
-                    m_visualScale /= 2.0;
-                    currentZoomLevel++;
-                    zoomLevelChanged = true;
-                }
-                
-                // 向下跨阈值：切换到更低层级
-                while (m_visualScale <= downscaleThreshold && currentZoomLevel > MIN_ZOOM_LEVEL) {
-                    m_visualScale *= 2.0;
-                    currentZoomLevel--;
-                    zoomLevelChanged = true;
-                }
-                
-                if (zoomLevelChanged) {
-                    qDebug() << "[SmoothZoom] Switch tiles to level" << currentZoomLevel 
-                             << "visualScale reset to" << m_visualScale;
-                    
-                    // 调整瓦片缩放并以鼠标为锚点
-                    tileMapManager->setZoomAtMousePosition(
-                        currentZoomLevel, 
-                        mouseScenePos.x(), 
-                        mouseScenePos.y(),
-                        mouseViewportPos.x(),
-                        mouseViewportPos.y(),
-                        ui->graphicsView->viewport()->width(),
-                        ui->graphicsView->viewport()->height(),
-                        visualScaleForAnchor  // 使用切级前的真实视觉缩放保持锚点一致
-                    );
-                    
-                    // 同步渲染器层级
-                    if (m_layerManager) {
-                        m_layerManager->setZoom(currentZoomLevel);
-                        qDebug() << "[Zoom] Renderer zoom updated to:" << currentZoomLevel;
-                    }
-                    
-                    // 重置视图变换为新的视觉比例，避免累乘误差
-                    ui->graphicsView->resetTransform();
-                    ui->graphicsView->setTransformationAnchor(QGraphicsView::AnchorUnderMouse);
-                    ui->graphicsView->scale(m_visualScale, m_visualScale);
-
-                    // 重新对齐视图，使鼠标下的地理位置保持不变
-                    if (tileMapManager && !mouseGeo.isNull()) {
-                        QPointF targetScene = tileMapManager->geoToScene(mouseGeo.x(), mouseGeo.y());
-                        QPointF viewportCenterF = QPointF(ui->graphicsView->viewport()->rect().center());
-                        QPointF offsetViewport = mouseViewportPos - viewportCenterF;
-                        // 视口到场景的偏移（考虑当前视觉缩放）
-                        QPointF offsetScene(offsetViewport.x() / m_visualScale,
-                                            offsetViewport.y() / m_visualScale);
-                        QPointF desiredCenter = targetScene - offsetScene;
-                        ui->graphicsView->centerOn(desiredCenter);
-                        tileMapManager->updateTilesForViewImmediate(desiredCenter.x(), desiredCenter.y());
-                        // 同步瓦片管理器的中心，避免后续缩放累积偏差
-                        QPointF desiredGeo = tileMapManager->sceneToGeo(desiredCenter, currentZoomLevel);
-                        tileMapManager->setCenter(desiredGeo.y(), desiredGeo.x());
-                    } else {
-                        // 回退：按当前中心刷新
-                        QPointF centerScene = tileMapManager->getCenterScenePos();
-                        ui->graphicsView->centerOn(centerScene);
-                        tileMapManager->updateTilesForViewImmediate(centerScene.x(), centerScene.y());
-                    }
-
-                }
-                
-                updateStatus(QString("Tile Map Zoom Level: %1/%2  (visual x%3)")
-                             .arg(currentZoomLevel)
-                             .arg(MAX_ZOOM_LEVEL)
-                             .arg(m_visualScale, 0, 'f', 2));
+                m_pendingWheelFactor *= stepFactor;
+                m_pendingWheelAnchor = wheelEvent->position();  // 保留亚像素精度
+                m_viewUpdateScheduler->schedule(ViewUpdateScheduler::ZoomUpdate);
             } else {
                 // 如果没有瓦片地图管理器，使用原来的连续缩放
                 qreal scaleFactor = 1.15;
@@ -1175,37 +1321,9 @@ bool MyForm::eventFilter(QObject *obj, QEvent *event)
                     } else {
                         // 没有正在测量，检查是否点击了已完成的距离测量线条
                         QPointF scenePos = ui->graphicsView->mapToScene(mouseEvent->pos());
-                        const qreal screenPixelTolerance = 2.0;
-                        QPointF screenDelta(screenPixelTolerance, 0);
-                        QPointF sceneDelta = ui->graphicsView->mapToScene(screenDelta.toPoint()) - 
-                                             ui->graphicsView->mapToScene(QPoint(0, 0));
-                        qreal searchRadius = qAbs(sceneDelta.x());
-                        if (searchRadius <= 0 || searchRadius > 1000) {
-                            searchRadius = 2.0;
-                        }
-                        QRectF searchRect(scenePos.x() - searchRadius, 
-                                         scenePos.y() - searchRadius, 
-                                         searchRadius * 2, 
-                                         searchRadius * 2);
-                        QList<QGraphicsItem*> items = mapScene->items(searchRect, Qt::IntersectsItemShape, 
-                                                                       Qt::DescendingOrder, 
-                                                                       ui->graphicsView->transform());
-                        if (items.isEmpty()) {
-                            items = mapScene->items(scenePos, Qt::IntersectsItemShape, 
-                                                   Qt::DescendingOrder, 
-                                                   ui->graphicsView->transform());
-                        }
-                        // 查找已完成的距离测量线条
-                        QGraphicsItem *measureItem = nullptr;
-                        for (QGraphicsItem *candidate : items) {
-                            QString itemType = candidate->data(0).toString();
-                            if (itemType == "distance_measure_line" || 
-                                itemType == "distance_measure_label" ||
-                                itemType == "distance_measure_marker") {
-                                measureItem = candidate;
-                                break;
-                            }
-                        }
+                        // 查找已完成的距离测量线条（含标记点）
+                        QGraphicsItem *measureItem = pickMeasureItem(scenePos, pickSearchRadius(),
+                                                                     "distance_measure_", true);
                         // 如果点击的是已完成的测量线条，显示右键菜单
                         if (measureItem) {
                             if (measureItem != m_selectedItem) {
@@ -1234,37 +1352,9 @@ bool MyForm::eventFilter(QObject *obj, QEvent *event)
                     } else {
                         // 没有正在测量，检查是否点击了已完成的面积测量线条
                         QPointF scenePos = ui->graphicsView->mapToScene(mouseEvent->pos());
-                        const qreal screenPixelTolerance = 2.0;
-                        QPointF screenDelta(screenPixelTolerance, 0);
-                        QPointF sceneDelta = ui->graphicsView->mapToScene(screenDelta.toPoint()) - 
-                                             ui->graphicsView->mapToScene(QPoint(0, 0));
-                        qreal searchRadius = qAbs(sceneDelta.x());
-                        if (searchRadius <= 0 || searchRadius > 1000) {
-                            searchRadius = 2.0;
-                        }
-                        QRectF searchRect(scenePos.x() - searchRadius, 
-                                         scenePos.y() - searchRadius, 
-                                         searchRadius * 2, 
-                                         searchRadius * 2);
-                        QList<QGraphicsItem*> items = mapScene->items(searchRect, Qt::IntersectsItemShape, 
-                                                                       Qt::DescendingOrder, 
-                                                                       ui->graphicsView->transform());
-                        if (items.isEmpty()) {
-                            items = mapScene->items(scenePos, Qt::IntersectsItemShape, 
-                                                   Qt::DescendingOrder, 
-                                                   ui->graphicsView->transform());
-                        }
-                        // 查找已完成的面积测量线条
-                        QGraphicsItem *measureItem = nullptr;
-                        for (QGraphicsItem *candidate : items) {
-                            QString itemType = candidate->data(0).toString();
-                            if (itemType == "area_measure_polygon" || 
-                                itemType == "area_measure_label" ||
-                                itemType == "area_measure_marker") {
-                                measureItem = candidate;
-                                break;
-                            }
-                        }
+                        // 查找已完成的面积测量线条（含标记点）
+                        QGraphicsItem *measureItem = pickMeasureItem(scenePos, pickSearchRadius(),
+                                                                     "area_measure_", true);
                         // 如果点击的是已完成的测量线条，显示右键菜单
                         if (measureItem) {
                             if (measureItem != m_selectedItem) {
@@ -1288,176 +1378,22 @@ bool MyForm::eventFilter(QObject *obj, QEvent *event)
                 
                 QPointF scenePos = ui->graphicsView->mapToScene(mouseEvent->pos());
                 
-                // 使用屏幕像素作为基准，转换为场景坐标
-                // 2像素的容差，与双击事件保持一致
-                const qreal screenPixelTolerance = 2.0;
-                QPointF screenDelta(screenPixelTolerance, 0);
-                QPointF sceneDelta = ui->graphicsView->mapToScene(screenDelta.toPoint()) - 
-                                     ui->graphicsView->mapToScene(QPoint(0, 0));
-                qreal searchRadius = qAbs(sceneDelta.x());
-                
-                // 如果转换失败，使用默认值
-                if (searchRadius <= 0 || searchRadius > 1000) {
-                    searchRadius = 2.0;
+                // 低层级设施聚类：左键点击聚类放大到其展开层级
+                if (mouseEvent->button() == Qt::LeftButton && zoomIntoFacilityCluster(scenePos)) {
+                    return true;
                 }
                 
-                QRectF searchRect(scenePos.x() - searchRadius, 
-                                 scenePos.y() - searchRadius, 
-                                 searchRadius * 2, 
-                                 searchRadius * 2);
-                
-                // 获取搜索区域内的所有图形项，按 Z 值排序（Z 值高的在前）
-                QList<QGraphicsItem*> items = mapScene->items(searchRect, Qt::IntersectsItemShape, 
-                                                               Qt::DescendingOrder, 
-                                                               ui->graphicsView->transform());
-                
-                // 如果没有找到项，尝试精确点击位置
-                if (items.isEmpty()) {
-                    items = mapScene->items(scenePos, Qt::IntersectsItemShape, 
-                                           Qt::DescendingOrder, 
-                                           ui->graphicsView->transform());
+                // 优先选择测量线条，然后选择设施，最后选择管线（实体走点选索引，不做全场景求交）
+                const qreal searchRadius = pickSearchRadius();
+                QGraphicsItem *item = pickMeasureItem(scenePos, searchRadius, QString(), false);
+                if (!item) {
+                    item = pickEntityAt(scenePos, searchRadius);
                 }
                 
-                // 在鼠标按下时立即取消所有项的选择状态，避免显示虚线框
+                // 在鼠标按下时立即取消选择状态，避免显示虚线框
                 // 这可以防止Qt默认选择机制在鼠标按下时触发
-                for (QGraphicsItem *candidate : items) {
-                    if (isEntityItem(candidate)) {
-                        candidate->setSelected(false);
-                    }
-                }
-                
-                // 收集所有实体项和测量线条
-                QList<QGraphicsItem*> facilityItems;
-                QList<QGraphicsItem*> pipelineItems;
-                QGraphicsItem *measureItem = nullptr;
-                
-                for (QGraphicsItem *candidate : items) {
-                    QString itemType = candidate->data(0).toString();
-                    // 检查是否是测量线条（优先）
-                    if ((itemType == "distance_measure_line" || 
-                         itemType == "distance_measure_label" ||
-                         itemType == "area_measure_polygon" ||
-                         itemType == "area_measure_label") && !measureItem) {
-                        measureItem = candidate;
-                    }
-                    // 如果点击到标注，尝试找到关联的设施（通过data(10)存储的图形项指针）
-                    if (itemType == "annotation" && candidate->data(1).toString() == "facility") {
-                        QVariant itemPtr = candidate->data(10);
-                        if (itemPtr.isValid()) {
-                            QGraphicsItem *linkedItem = reinterpret_cast<QGraphicsItem*>(itemPtr.toULongLong());
-                            if (linkedItem && isEntityItem(linkedItem) && linkedItem->data(0).toString() == "facility") {
-                                // 将关联的设施添加到列表中
-                                if (!facilityItems.contains(linkedItem)) {
-                                    facilityItems.append(linkedItem);
-                                    qDebug() << "[Click] Found facility via annotation link";
-                                }
-                            }
-                        }
-                    }
-                    // 检查是否是实体
-                    if (isEntityItem(candidate)) {
-                        QString entityType = candidate->data(0).toString();
-                        if (entityType == "facility") {
-                            if (!facilityItems.contains(candidate)) {
-                                facilityItems.append(candidate);
-                            }
-                        } else if (entityType == "pipeline") {
-                            pipelineItems.append(candidate);
-                        }
-                    }
-                }
-                
-                // 优先选择测量线条，然后选择设施，最后选择管线
-                QGraphicsItem *item = nullptr;
-                
-                if (measureItem) {
-                    item = measureItem;
-                } else if (!facilityItems.isEmpty()) {
-                    // 对于设施，也需要检查距离（虽然设施是点，但也要确保在2像素范围内）
-                    qreal minDistance = std::numeric_limits<qreal>::max();
-                    QGraphicsItem *nearestFacility = nullptr;
-                    
-                    // 使用与searchRadius相同的计算方法
-                    qreal maxAllowedDistance = searchRadius;
-                    
-                    for (QGraphicsItem *facility : facilityItems) {
-                        // 获取设施的位置（椭圆的中心点）
-                        QGraphicsEllipseItem *ellipseItem = qgraphicsitem_cast<QGraphicsEllipseItem*>(facility);
-                        QPointF facilityPos;
-                        if (ellipseItem) {
-                            // 计算椭圆的中心点
-                            QRectF rect = ellipseItem->rect();
-                            QPointF center = rect.center();
-                            facilityPos = facility->mapToScene(center);
-                        } else {
-                            // 如果不是椭圆，使用场景位置
-                            facilityPos = facility->scenePos();
-                        }
-                        
-                        qreal dist = QLineF(scenePos, facilityPos).length();
-                        
-                        // 只考虑距离在允许范围内的设施（增加容差，因为设施是点）
-                        qreal facilityTolerance = maxAllowedDistance * 2; // 设施使用更大的容差
-                        if (dist <= facilityTolerance && dist < minDistance) {
-                            minDistance = dist;
-                            nearestFacility = facility;
-                        }
-                    }
-                    
-                    item = nearestFacility;
-                } else if (!pipelineItems.isEmpty()) {
-                    // 对于管线，无论数量多少，都需要计算距离并检查是否在允许范围内
-                    // 这样可以避免在空白区域误选管线
-                    qreal minDistance = std::numeric_limits<qreal>::max();
-                    QGraphicsItem *nearestPipeline = nullptr;
-                    
-                    // 使用与searchRadius相同的值，确保一致性
-                    // searchRadius已经是2像素对应的场景坐标距离
-                    qreal maxAllowedDistance = searchRadius;
-                    
-                    for (QGraphicsItem *pipeline : pipelineItems) {
-                        QGraphicsPathItem *pathItem = qgraphicsitem_cast<QGraphicsPathItem*>(pipeline);
-                        if (pathItem) {
-                            // 计算点击位置到管线路径的最短距离
-                            QPainterPath path = pathItem->path();
-                            qreal minPathDistance = std::numeric_limits<qreal>::max();
-                            
-                            // 遍历路径的所有线段，找到最近的距离
-                            for (int i = 0; i < path.elementCount() - 1; i++) {
-                                QPointF p1 = path.elementAt(i);
-                                QPointF p2 = path.elementAt(i + 1);
-                                QLineF line(p1, p2);
-                                
-                                // 计算点到线段的距离
-                                qreal lineLength = line.length();
-                                if (lineLength > 0) {
-                                    QPointF v = p2 - p1;
-                                    QPointF w = scenePos - p1;
-                                    qreal t = qBound(0.0, QPointF::dotProduct(w, v) / (lineLength * lineLength), 1.0);
-                                    QPointF nearestPoint = p1 + t * v;
-                                    qreal dist = QLineF(scenePos, nearestPoint).length();
-                                    if (dist < minPathDistance) {
-                                        minPathDistance = dist;
-                                    }
-                                } else {
-                                    // 线段长度为0，直接计算点到点的距离
-                                    qreal dist = QLineF(scenePos, p1).length();
-                                    if (dist < minPathDistance) {
-                                        minPathDistance = dist;
-                                    }
-                                }
-                            }
-                            
-                            // 只考虑距离在允许范围内的管线
-                            if (minPathDistance <= maxAllowedDistance && minPathDistance < minDistance) {
-                                minDistance = minPathDistance;
-                                nearestPipeline = pipeline;
-                            }
-                        }
-                    }
-                    
-                    // 如果找到了距离在允许范围内的管线，选择它；否则不选择任何管线
-                    item = nearestPipeline;
+                if (item && isEntityItem(item)) {
+                    item->setSelected(false);
                 }
                 
                 if (mouseEvent->button() == Qt::LeftButton) {
@@ -1531,167 +1467,11 @@ bool MyForm::eventFilter(QObject *obj, QEvent *event)
             } else {
                 QPointF scenePos = ui->graphicsView->mapToScene(mouseEvent->pos());
                 
-                // 使用屏幕像素作为基准，转换为场景坐标
-                // 2像素的容差，与单击事件保持一致
-                const qreal screenPixelTolerance = 2.0;
-                QPointF screenDelta(screenPixelTolerance, 0);
-                QPointF sceneDelta = ui->graphicsView->mapToScene(screenDelta.toPoint()) - 
-                                     ui->graphicsView->mapToScene(QPoint(0, 0));
-                qreal searchRadius = qAbs(sceneDelta.x());
-                
-                // 如果转换失败，使用默认值
-                if (searchRadius <= 0 || searchRadius > 1000) {
-                    searchRadius = 2.0;
-                }
-                
-                QRectF searchRect(scenePos.x() - searchRadius, 
-                                 scenePos.y() - searchRadius, 
-                                 searchRadius * 2, 
-                                 searchRadius * 2);
-                
-                // 获取搜索区域内的所有图形项，按 Z 值排序（Z 值高的在前）
-                QList<QGraphicsItem*> items = mapScene->items(searchRect, Qt::IntersectsItemShape, 
-                                                               Qt::DescendingOrder, 
-                                                               ui->graphicsView->transform());
-                
-                // 如果没有找到项，尝试精确点击位置
-                if (items.isEmpty()) {
-                    items = mapScene->items(scenePos, Qt::IntersectsItemShape, 
-                                           Qt::DescendingOrder, 
-                                           ui->graphicsView->transform());
-                }
-                
-                // 收集所有实体项和测量线条
-                QList<QGraphicsItem*> facilityItems;
-                QList<QGraphicsItem*> pipelineItems;
-                QGraphicsItem *measureItem = nullptr;
-                
-                for (QGraphicsItem *candidate : items) {
-                    QString itemType = candidate->data(0).toString();
-                    // 检查是否是测量线条（优先）
-                    if ((itemType == "distance_measure_line" || 
-                         itemType == "distance_measure_label" ||
-                         itemType == "area_measure_polygon" ||
-                         itemType == "area_measure_label") && !measureItem) {
-                        measureItem = candidate;
-                    }
-                    // 如果点击到标注，尝试找到关联的设施（通过data(10)存储的图形项指针）
-                    if (itemType == "annotation" && candidate->data(1).toString() == "facility") {
-                        QVariant itemPtr = candidate->data(10);
-                        if (itemPtr.isValid()) {
-                            QGraphicsItem *linkedItem = reinterpret_cast<QGraphicsItem*>(itemPtr.toULongLong());
-                            if (linkedItem && isEntityItem(linkedItem) && linkedItem->data(0).toString() == "facility") {
-                                // 将关联的设施添加到列表中
-                                if (!facilityItems.contains(linkedItem)) {
-                                    facilityItems.append(linkedItem);
-                                    qDebug() << "[DoubleClick] Found facility via annotation link";
-                                }
-                            }
-                        }
-                    }
-                    // 检查是否是实体
-                    if (isEntityItem(candidate)) {
-                        QString entityType = candidate->data(0).toString();
-                        if (entityType == "facility") {
-                            if (!facilityItems.contains(candidate)) {
-                                facilityItems.append(candidate);
-                            }
-                        } else if (entityType == "pipeline") {
-                            pipelineItems.append(candidate);
-                        }
-                    }
-                }
-                
-                // 优先选择测量线条，然后选择设施，最后选择管线
-                QGraphicsItem *item = nullptr;
-                
-                if (measureItem) {
-                    item = measureItem;
-                } else if (!facilityItems.isEmpty()) {
-                    // 对于设施，也需要检查距离（虽然设施是点，但也要确保在2像素范围内）
-                    qreal minDistance = std::numeric_limits<qreal>::max();
-                    QGraphicsItem *nearestFacility = nullptr;
-                    
-                    // 使用与searchRadius相同的计算方法
-                    qreal maxAllowedDistance = searchRadius;
-                    
-                    for (QGraphicsItem *facility : facilityItems) {
-                        // 获取设施的位置（椭圆的中心点）
-                        QGraphicsEllipseItem *ellipseItem = qgraphicsitem_cast<QGraphicsEllipseItem*>(facility);
-                        QPointF facilityPos;
-                        if (ellipseItem) {
-                            // 计算椭圆的中心点
-                            QRectF rect = ellipseItem->rect();
-                            QPointF center = rect.center();
-                            facilityPos = facility->mapToScene(center);
-                        } else {
-                            // 如果不是椭圆，使用场景位置
-                            facilityPos = facility->scenePos();
-                        }
-                        
-                        qreal dist = QLineF(scenePos, facilityPos).length();
-                        
-                        // 只考虑距离在允许范围内的设施（增加容差，因为设施是点）
-                        qreal facilityTolerance = maxAllowedDistance * 2; // 设施使用更大的容差
-                        if (dist <= facilityTolerance && dist < minDistance) {
-                            minDistance = dist;
-                            nearestFacility = facility;
-                        }
-                    }
-                    
-                    item = nearestFacility;
-                } else if (!pipelineItems.isEmpty()) {
-                    // 对于管线，无论数量多少，都需要计算距离并检查是否在允许范围内
-                    // 这样可以避免在空白区域误选管线
-                    qreal minDistance = std::numeric_limits<qreal>::max();
-                    QGraphicsItem *nearestPipeline = nullptr;
-                    
-                    // 使用与searchRadius相同的计算方法，确保一致性
-                    qreal maxAllowedDistance = searchRadius;
-                    
-                    for (QGraphicsItem *pipeline : pipelineItems) {
-                        QGraphicsPathItem *pathItem = qgraphicsitem_cast<QGraphicsPathItem*>(pipeline);
-                        if (pathItem) {
-                            // 计算点击位置到管线路径的最短距离
-                            QPainterPath path = pathItem->path();
-                            qreal minPathDistance = std::numeric_limits<qreal>::max();
-                            
-                            // 遍历路径的所有线段，找到最近的距离
-                            for (int i = 0; i < path.elementCount() - 1; i++) {
-                                QPointF p1 = path.elementAt(i);
-                                QPointF p2 = path.elementAt(i + 1);
-                                QLineF line(p1, p2);
-                                
-                                // 计算点到线段的距离
-                                qreal lineLength = line.length();
-                                if (lineLength > 0) {
-                                    QPointF v = p2 - p1;
-                                    QPointF w = scenePos - p1;
-                                    qreal t = qBound(0.0, QPointF::dotProduct(w, v) / (lineLength * lineLength), 1.0);
-                                    QPointF nearestPoint = p1 + t * v;
-                                    qreal dist = QLineF(scenePos, nearestPoint).length();
-                                    if (dist < minPathDistance) {
-                                        minPathDistance = dist;
-                                    }
-                                } else {
-                                    // 线段长度为0，直接计算点到点的距离
-                                    qreal dist = QLineF(scenePos, p1).length();
-                                    if (dist < minPathDistance) {
-                                        minPathDistance = dist;
-                                    }
-                                }
-                            }
-                            
-                            // 只考虑距离在允许范围内的管线
-                            if (minPathDistance <= maxAllowedDistance && minPathDistance < minDistance) {
-                                minDistance = minPathDistance;
-                                nearestPipeline = pipeline;
-                            }
-                        }
-                    }
-                    
-                    // 如果找到了距离在允许范围内的管线，选择它；否则不选择任何管线
-                    item = nearestPipeline;
+                // 双击只处理实体（测量线条优先命中时不触发）
+                const qreal searchRadius = pickSearchRadius();
+                QGraphicsItem *item = pickMeasureItem(scenePos, searchRadius, QString(), false);
+                if (!item) {
+                    item = pickEntityAt(scenePos, searchRadius);
                 }
                 
                 if (item && isEntityItem(item) && mouseEvent->button() == Qt::LeftButton) {
@@ -1740,11 +1520,11 @@ bool MyForm::eventFilter(QObject *obj, QEvent *event)
                 lastRightClickPos = mouseEvent->pos();
                 lastRightClickScenePos = scenePos;
 
+                // 瓦片按帧刷新，同一帧内的多次移动只更新一次
                 if (tileMapManager && !isDownloading) {
-                    QPointF centeredScene = ui->graphicsView->mapToScene(ui->graphicsView->viewport()->rect().center());
-                    tileMapManager->updateTilesForViewImmediate(centeredScene.x(), centeredScene.y());
+                    m_viewUpdateScheduler->schedule(ViewUpdateScheduler::TileUpdate);
                 }
-                    return true; // 事件已处理
+                return true; // 事件已处理
             }
         } else if (event->type() == QEvent::MouseButtonRelease) {
             QMouseEvent *mouseEvent = static_cast<QMouseEvent*>(event);
@@ -1757,7 +1537,8 @@ bool MyForm::eventFilter(QObject *obj, QEvent *event)
                     MoveEntityCommand *cmd = new MoveEntityCommand(
                         m_selectedItem,
                         m_selectedItemStartPos,
-                        currentPos
+                        currentPos,
+                        entityPickIndex()
                     );
                     if (m_undoStack) {
                         m_undoStack->push(cmd);
@@ -2161,19 +1942,11 @@ void MyForm::handleRefreshButtonClicked()
         DrawingDatabaseManager::loadFromDatabase(
             mapScene,
             m_drawnPipelines,
-            m_nextPipelineId
+            m_nextPipelineId,
+            itemRegistry()
         );
         
-        // 延迟刷新标注图层，确保场景中的图形项已经渲染完成
-        if (m_layerManager && m_layerManager->isLayerVisible(LayerManager::Labels)) {
-            QTimer::singleShot(50, this, [this]() {
-                if (m_layerManager) {
-                    qDebug() << "[Refresh] Refreshing annotation layer after data refresh";
-                    m_layerManager->refreshLayer(LayerManager::Labels);
-                }
-            });
-        }
-        
+        // 标注图层在后台加载完成后由 LayerManager 统一刷新
         updateStatus("数据刷新完成");
         QMessageBox::information(this, "刷新完成", 
             QString("已重新加载当前视图范围内的数据。\n\n范围: 经度 %1-%2, 纬度 %3-%4")
@@ -2188,6 +1961,144 @@ void MyForm::handleRefreshButtonClicked()
     }
 }
 
+void MyForm::applyRemoteEntityChanges(const QVector<EntityChange> &changes)
+{
+    if (m_layerManager) {
+        m_layerManager->applyEntityChanges(changes);
+    }
+    for (const EntityChange &change : changes) {
+        updateDeviceTreeEntity(change);
+    }
+    updateStatus(QString("已同步其他用户的 %1 项数据变更").arg(changes.size()));
+}
+
+void MyForm::updateDeviceTreeEntity(const EntityChange &change)
+{
+    if (!deviceTreeModel) {
+        return;
+    }
+    
+    const bool isPipeline = change.table == "pipelines";
+    if (!isPipeline && change.table != "facilities") {
+        return;
+    }
+    const QString kind = isPipeline ? "pipeline" : "facility";
+    
+    QStandardItem *root = deviceTreeRoot(kind);
+    if (!root) {
+        return;
+    }
+    
+    // 移除现有节点（类型可能已变化），类型节点为空时一并移除
+    for (int t = root->rowCount() - 1; t >= 0; --t) {
+        QStandardItem *typeItem = root->child(t);
+        for (int r = typeItem->rowCount() - 1; r >= 0; --r) {
+            if (typeItem->child(r)->data(Qt::UserRole).toString() == change.key) {
+                typeItem->removeRow(r);
+            }
+        }
+        if (typeItem->rowCount() == 0) {
+            root->removeRow(t);
+        }
+    }
+    
+    if (change.op == EntityChange::Delete) {
+        return;
+    }
+    
+    // 后台读取最新数据（缓存已由变更监听器失效），返回后插入节点
+    if (!m_deviceTreeLoader) {
+        m_deviceTreeLoader = new AsyncDAO(this);
+    }
+    const QString key = change.key;
+    if (isPipeline) {
+        m_deviceTreeLoader->run([key]() {
+            return PipelineDAO().findByPipelineId(key);
+        }, [this](const Pipeline &pipeline) {
+            if (pipeline.isValid()) {
+                insertDeviceTreeNode("pipeline", pipeline.pipelineId(), pipeline.pipelineType(),
+                                     formatPipelineDisplayName(pipeline));
+            }
+        });
+    } else {
+        m_deviceTreeLoader->run([key]() {
+            return FacilityDAO().findByFacilityId(key);
+        }, [this](const Facility &facility) {
+            if (facility.isValid()) {
+                insertDeviceTreeNode("facility", facility.facilityId(), facility.facilityType(),
+                                     formatFacilityDisplayName(facility));
+            }
+        });
+    }
+}
+
+QStandardItem* MyForm::deviceTreeRoot(const QString &kind) const
+{
+    if (!deviceTreeModel) {
+        return nullptr;
+    }
+    for (int i = 0; i < deviceTreeModel->rowCount(); ++i) {
+        QStandardItem *item = deviceTreeModel->item(i);
+        if (item && item->data(Qt::UserRole).toString() == kind + "_root") {
+            return item;
+        }
+    }
+    return nullptr;
+}
+
+void MyForm::insertDeviceTreeNode(const QString &kind, const QString &key,
+                                  const QString &type, const QString &displayName)
+{
+    QStandardItem *root = deviceTreeRoot(kind);
+    if (!root || type.isEmpty()) {
+        return;
+    }
+    
+    QStandardItem *typeItem = nullptr;
+    for (int t = 0; t < root->rowCount(); ++t) {
+        if (root->child(t)->data(Qt::UserRole).toString() == type) {
+            typeItem = root->child(t);
+            break;
+        }
+    }
+    if (!typeItem) {
+        const QMap<QString, QString> &typeNames = kind == "pipeline"
+            ? deviceTreePipelineTypeNames()
+            : deviceTreeFacilityTypeNames();
+        typeItem = new QStandardItem(typeNames.value(type, "🔧 " + type));
+        typeItem->setEditable(false);
+        typeItem->setData(type, Qt::UserRole);
+        typeItem->setData(kind + "_type", Qt::UserRole + 1);
+        root->appendRow(typeItem);
+    }
+    
+    // 同一实体的多次变更可能先后返回，先移除已插入的旧节点
+    for (int r = typeItem->rowCount() - 1; r >= 0; --r) {
+        if (typeItem->child(r)->data(Qt::UserRole).toString() == key) {
+            typeItem->removeRow(r);
+        }
+    }
+    
+    QStandardItem *entityItem = new QStandardItem(displayName);
+    entityItem->setEditable(false);
+    entityItem->setData(key, Qt::UserRole);
+    entityItem->setData(kind, Qt::UserRole + 1);
+    typeItem->appendRow(entityItem);
+}
+
+void MyForm::releaseEntityItem(QGraphicsItem *item)
+{
+    m_drawnPipelines.remove(item);
+    m_burstHighlights.removeAll(item);
+    m_connectivityHighlights.removeAll(item);
+    if (m_selectedItem == item) {
+        m_selectedItem = nullptr;
+    }
+    if (m_copiedItem == item) {
+        m_copiedItem = nullptr;
+    }
+}
+
 void MyForm::handleSaveButtonClicked()
 {
     qDebug() << "Save button clicked";
@@ -2226,12 +2137,15 @@ void MyForm::handleUndoForPendingChanges()
         return;
     }
     
-    // 获取场景中所有图形项
-    QList<QGraphicsItem*> allSceneItems = mapScene->items();
-    QSet<QGraphicsItem*> sceneItemSet;
-    for (QGraphicsItem *item : allSceneItems) {
-        sceneItemSet.insert(item);
+    // 通过图层注册表判断实体项是否在场景中，并只取设施图层的图形项（不扫描整个场景）
+    LayerItemRegistry *registry = itemRegistry();
+    if (!registry) {
+        return;
     }
+    auto isInScene = [registry, this](QGraphicsItem *item) {
+        return registry->containsInScene(item, mapScene);
+    };
+    const QList<QGraphicsItem*> sceneFacilityItems = registry->items(LayerManager::Facilities, mapScene);
     
     bool hasChanges = false;
     
@@ -2243,7 +2157,7 @@ void MyForm::handleUndoForPendingChanges()
         // 只处理 ChangeAdded 类型的变更
         if (change.type == ChangeAdded && change.graphicsItem) {
             // 检查图形项是否还在场景中
-            if (!sceneItemSet.contains(change.graphicsItem)) {
+            if (!isInScene(change.graphicsItem)) {
                 // 图形项不在场景中，说明被撤销了
                 QString entityType = change.entityType;
                 QString entityId;
@@ -2271,7 +2185,7 @@ void MyForm::handleUndoForPendingChanges()
     // 检查管线
     for (auto it = m_drawnPipelines.constBegin(); it != m_drawnPipelines.constEnd(); ++it) {
         QGraphicsItem *item = it.key();
-        if (!sceneItemSet.contains(item)) {
+        if (!isInScene(item)) {
             // 这个管线项不在场景中，可能被撤销了
             Pipeline pipeline = it.value();
             
@@ -2324,9 +2238,9 @@ void MyForm::handleUndoForPendingChanges()
     //    应该添加 ChangeAdded 记录（用于恢复）
     
     // 首先，检查场景中的设施，如果有 ChangeDeleted 记录，移除它，然后添加 ChangeAdded 记录
-    for (QGraphicsItem *item : allSceneItems) {
-        if (item->data(0).toString() == "facility") {
-            QString facilityId = item->data(1).toString();
+    for (QGraphicsItem *item : sceneFacilityItems) {
+        if (FacilityGraphicsItem *facilityItem = qgraphicsitem_cast<FacilityGraphicsItem*>(item)) {
+            QString facilityId = facilityItem->entityId();
             
             // 检查是否有 ChangeDeleted 记录（通过 facilityId 或 graphicsItem 匹配）
             bool hadDeleteRecord = false;
@@ -2384,7 +2298,7 @@ void MyForm::handleUndoForPendingChanges()
                         qDebug() << "[Undo] Using facility data from ChangeDeleted record, id:" << facility.id();
                         
                         // 确保从图形项获取最新的名称（如果图形项中有）
-                        QString facilityName = item->data(3).toString();
+                        QString facilityName = facilityItem->name();
                         if (!facilityName.isEmpty() && facility.facilityName().isEmpty()) {
                             facility.setFacilityName(facilityName);
                             qDebug() << "[Undo] Updated facility name from graphics item:" << facilityName;
@@ -2398,47 +2312,39 @@ void MyForm::handleUndoForPendingChanges()
                             qDebug() << "[Undo] Got facility data from database, id:" << facility.id();
                         } else {
                             // 如果数据库中没有，说明已经删除了，需要从图形项重建完整信息
-                            QString facilityName = item->data(3).toString();
-                            QString facilityType = item->data(2).toString();
+                            QString facilityName = facilityItem->name();
+                            QString facilityType = facilityItem->entityType();
                             
                             facility.setFacilityId(facilityId);
                             facility.setFacilityName(facilityName);
                             facility.setFacilityType(facilityType);
                             
                             // 尝试从图形项获取数据库ID
-                            QVariant dbIdVariant = item->data(10);  // 优先从 data(10) 获取
-                            if (!dbIdVariant.isValid() || dbIdVariant.toInt() <= 0) {
-                                dbIdVariant = item->data(1);  // 如果 data(10) 没有，尝试 data(1)
-                            }
-                            
-                            if (dbIdVariant.isValid() && dbIdVariant.toInt() > 0) {
-                                facility.setId(dbIdVariant.toInt());
-                                qDebug() << "[Undo] Got facility database ID from item data:" << facility.id();
+                            if (facilityItem->databaseId() > 0) {
+                                facility.setId(facilityItem->databaseId());
+                                qDebug() << "[Undo] Got facility database ID from item:" << facility.id();
                             }
                             
                             // 从图形项中获取几何信息
-                            QGraphicsEllipseItem *ellipseItem = qgraphicsitem_cast<QGraphicsEllipseItem*>(item);
-                            if (ellipseItem) {
-                                QRectF rect = ellipseItem->rect();
-                                QPointF centerScene = ellipseItem->pos() + rect.center();
-                                
-                                // 转换为地理坐标
-                                QPointF geoCoord;
-                                if (tileMapManager) {
-                                    geoCoord = tileMapManager->sceneToGeo(centerScene);
-                                } else {
-                                    geoCoord = centerScene;
-                                }
-                                
-                                // 生成 WKT 格式
-                                QString wkt = QString("POINT(%1 %2)")
-                                                .arg(geoCoord.x(), 0, 'f', 8)
-                                                .arg(geoCoord.y(), 0, 'f', 8);
-                                
-                                facility.setCoordinate(geoCoord);
-                                facility.setGeomWkt(wkt);
+                            QRectF rect = facilityItem->rect();
+                            QPointF centerScene = facilityItem->pos() + rect.center();
+                            
+                            // 转换为地理坐标
+                            QPointF geoCoord;
+                            if (tileMapManager) {
+                                geoCoord = tileMapManager->sceneToGeo(centerScene);
+                            } else {
+                                geoCoord = centerScene;
                             }
                             
+                            // 生成 WKT 格式
+                            QString wkt = QString("POINT(%1 %2)")
+                                            .arg(geoCoord.x(), 0, 'f', 8)
+                                            .arg(geoCoord.y(), 0, 'f', 8);
+                            
+                            facility.setCoordinate(geoCoord);
+                            facility.setGeomWkt(wkt);
+                            
                             qDebug() << "[Undo] Facility not found in database, rebuilding from graphics item, name:" << facilityName;
                         }
                     }
@@ -2466,7 +2372,7 @@ void MyForm::handleUndoForPendingChanges()
         PendingChange &change = m_pendingChanges[i];
         if (change.type == ChangeDeleted && change.entityType == "facility") {
             // 如果 ChangeDeleted 记录有 graphicsItem，检查它是否在场景中
-            if (change.graphicsItem && sceneItemSet.contains(change.graphicsItem)) {
+            if (change.graphicsItem && isInScene(change.graphicsItem)) {
                 // 设施在场景中，说明撤销了删除操作
                 // 移除 ChangeDeleted 记录，然后添加 ChangeAdded 记录（这样保存时会恢复设施）
                 Facility facility = change.data.value<Facility>();
@@ -2491,8 +2397,8 @@ void MyForm::handleUndoForPendingChanges()
                 
                 if (!hasAddedRecord) {
                     // 确保设施信息完整：从图形项获取最新的名称（如果图形项中有）
-                    if (change.graphicsItem) {
-                        QString facilityName = change.graphicsItem->data(3).toString();
+                    if (const EntityGraphicsItem *entity = EntityGraphicsItem::fromItem(change.graphicsItem)) {
+                        QString facilityName = entity->name();
                         if (!facilityName.isEmpty() && facility.facilityName().isEmpty()) {
                             facility.setFacilityName(facilityName);
                             qDebug() << "[Undo] Updated facility name from graphics item:" << facilityName;
@@ -2537,12 +2443,15 @@ void MyForm::handleRedoForPendingChanges()
         return;
     }
     
-    // 获取场景中所有图形项
-    QList<QGraphicsItem*> allSceneItems = mapScene->items();
-    QSet<QGraphicsItem*> sceneItemSet;
-    for (QGraphicsItem *item : allSceneItems) {
-        sceneItemSet.insert(item);
+    // 通过图层注册表判断实体项是否在场景中，并只取设施图层的图形项（不扫描整个场景）
+    LayerItemRegistry *registry = itemRegistry();
+    if (!registry) {
+        return;
     }
+    auto isInScene = [registry, this](QGraphicsItem *item) {
+        return registry->containsInScene(item, mapScene);
+    };
+    const QList<QGraphicsItem*> sceneFacilityItems = registry->items(LayerManager::Facilities, mapScene);
     
     bool hasChanges = false;
     
@@ -2553,7 +2462,7 @@ void MyForm::handleRedoForPendingChanges()
         Pipeline pipeline = it.value();
         
         // 如果图形项在场景中
-        if (sceneItemSet.contains(item)) {
+        if (isInScene(item)) {
             // 检查是否已经在待保存列表中
             bool foundInPending = false;
             int pendingIndex = -1;
@@ -2611,9 +2520,9 @@ void MyForm::handleRedoForPendingChanges()
     
     // 检查场景中的设施项
     // 如果设施项在场景中，但不在待保存列表中，可能是重做的未保存实体
-    for (QGraphicsItem *item : allSceneItems) {
-        if (item->data(0).toString() == "facility") {
-            QString facilityId = item->data(1).toString();
+    for (QGraphicsItem *item : sceneFacilityItems) {
+        if (FacilityGraphicsItem *facilityItem = qgraphicsitem_cast<FacilityGraphicsItem*>(item)) {
+            QString facilityId = facilityItem->entityId();
             
             // 检查是否已经在待保存列表中
             bool foundInPending = false;
@@ -2634,11 +2543,7 @@ void MyForm::handleRedoForPendingChanges()
             // 3. 或者设施ID不在数据库中（通过查询数据库确认）
             if (!foundInPending && !facilityId.isEmpty()) {
                 // 检查实体状态
-                QVariant stateVariant = item->data(100);
-                EntityState entityState = EntityState::Detached;
-                if (stateVariant.isValid()) {
-                    entityState = static_cast<EntityState>(stateVariant.toInt());
-                }
+                EntityState entityState = facilityItem->state();
                 
                 bool isUnsavedEntity = false;
                 
@@ -2660,43 +2565,39 @@ void MyForm::handleRedoForPendingChanges()
                 }
                 
                 if (isUnsavedEntity) {
-                    // 从图形项的data中获取设施信息
-                    QString facilityName = item->data(3).toString();
-                    QString facilityType = item->data(2).toString();
+                    // 从图形项中获取设施信息
+                    QString facilityName = facilityItem->name();
+                    QString facilityType = facilityItem->entityType();
                     
                     Facility facility;
                     facility.setFacilityId(facilityId);
                     facility.setFacilityName(facilityName);
                     facility.setFacilityType(facilityType);
                     
-                    // 从图形项中获取几何信息
-                    QGraphicsEllipseItem *ellipseItem = qgraphicsitem_cast<QGraphicsEllipseItem*>(item);
-                    if (ellipseItem) {
-                        // 获取图形项的中心点（场景坐标）
-                        QRectF rect = ellipseItem->rect();
-                        QPointF centerScene = ellipseItem->pos() + rect.center();
-                        
-                        // 转换为地理坐标
-                        QPointF geoCoord;
-                        if (tileMapManager) {
-                            geoCoord = tileMapManager->sceneToGeo(centerScene);
-                        } else {
-                            // 如果没有瓦片管理器，使用原始坐标（降级方案）
-                            geoCoord = centerScene;
-                        }
-                        
-                        // 生成 WKT 格式
-                        QString wkt = QString("POINT(%1 %2)")
-                                        .arg(geoCoord.x(), 0, 'f', 8)
-                                        .arg(geoCoord.y(), 0, 'f', 8);
-                        
-                        // 设置几何信息
-                        facility.setCoordinate(geoCoord);
-                        facility.setGeomWkt(wkt);
-                        
-                        qDebug() << "[Redo] Facility geometry restored from graphics item:" << wkt;
+                    // 从图形项中获取几何信息（中心点场景坐标）
+                    QRectF rect = facilityItem->rect();
+                    QPointF centerScene = facilityItem->pos() + rect.center();
+                    
+                    // 转换为地理坐标
+                    QPointF geoCoord;
+                    if (tileMapManager) {
+                        geoCoord = tileMapManager->sceneToGeo(centerScene);
+                    } else {
+                        // 如果没有瓦片管理器，使用原始坐标（降级方案）
+                        geoCoord = centerScene;
                     }
                     
+                    // 生成 WKT 格式
+                    QString wkt = QString("POINT(%1 %2)")
+                                    .arg(geoCoord.x(), 0, 'f', 8)
+                                    .arg(geoCoord.y(), 0, 'f', 8);
+                    
+                    // 设置几何信息
+                    facility.setCoordinate(geoCoord);
+                    facility.setGeomWkt(wkt);
+                    
+                    qDebug() << "[Redo] Facility geometry restored from graphics item:" << wkt;
+                    
                     PendingChange change;
                     change.type = ChangeAdded;
                     change.entityType = "facility";
@@ -2955,6 +2856,11 @@ void MyForm::handleZoomInTileMapButtonClicked()
 {
     qDebug() << "Zoom In Tile Map button clicked";
     
+    // 先应用尚未生效的滚轮缩放，避免与按钮缩放叠加
+    if (m_viewUpdateScheduler) {
+        m_viewUpdateScheduler->flush();
+    }
+    
     // 使用固定的10级缩放限制
     if (currentZoomLevel < MAX_ZOOM_LEVEL) {
         currentZoomLevel++;
@@ -3007,6 +2913,11 @@ void MyForm::handleZoomOutTileMapButtonClicked()
 {
     qDebug() << "Zoom Out Tile Map button clicked";
     
+    // 先应用尚未生效的滚轮缩放，避免与按钮缩放叠加
+    if (m_viewUpdateScheduler) {
+        m_viewUpdateScheduler->flush();
+    }
+    
     // 使用固定的10级缩放限制
     if (currentZoomLevel > MIN_ZOOM_LEVEL) {
         currentZoomLevel--;
@@ -3234,20 +3145,51 @@ void MyForm::clearBurstHighlights()
     }
 }
 
-void MyForm::highlightPipelineById(const QString &pipelineId)
+QPainterPath MyForm::pipelineScenePath(const QString &pipelineId)
 {
-    if (!mapScene || !tileMapManager) return;
+    if (LayerItemRegistry *registry = itemRegistry()) {
+        if (PipelineGraphicsItem *pipelineItem = registry->findPipeline(pipelineId, mapScene)) {
+            return pipelineItem->sceneTransform().map(pipelineItem->path());
+        }
+    }
+
+    // 未加载到场景的管线：查询数据库并投影
+    QPainterPath path;
     PipelineDAO dao;
     Pipeline pl = dao.findByPipelineId(pipelineId);
-    if (!pl.isValid() || pl.coordinates().isEmpty()) return;
+    if (!pl.isValid() || pl.coordinates().isEmpty()) return path;
 
-    QPainterPath path;
     bool first = true;
     for (const QPointF &geo : pl.coordinates()) {
         QPointF scenePt = tileMapManager->geoToScene(geo.x(), geo.y());
         if (first) { path.moveTo(scenePt); first = false; }
         else { path.lineTo(scenePt); }
     }
+    return path;
+}
+
+bool MyForm::facilityScenePos(const QString &facilityId, QPointF *scenePos)
+{
+    if (LayerItemRegistry *registry = itemRegistry()) {
+        if (FacilityGraphicsItem *facilityItem = registry->findFacility(facilityId, mapScene)) {
+            *scenePos = facilityItem->sceneTransform().map(facilityItem->rect().center());
+            return true;
+        }
+    }
+
+    FacilityDAO dao;
+    Facility fa = dao.findByFacilityId(facilityId);
+    if (!fa.isValid() || fa.coordinate().isNull()) return false;
+    *scenePos = tileMapManager->geoToScene(fa.coordinate().x(), fa.coordinate().y());
+    return true;
+}
+
+void MyForm::highlightPipelineById(const QString &pipelineId)
+{
+    if (!mapScene || !tileMapManager) return;
+    QPainterPath path = pipelineScenePath(pipelineId);
+    if (path.isEmpty()) return;
+
     QGraphicsPathItem *item = mapScene->addPath(path, QPen(QColor(255, 0, 0), 4.0, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin));
     item->setZValue(1e6 - 1);
     m_burstHighlights << item;
@@ -3256,11 +3198,9 @@ void MyForm::highlightPipelineById(const QString &pipelineId)
 void MyForm::highlightFacilityById(const QString &facilityId)
 {
     if (!mapScene || !tileMapManager) return;
-    FacilityDAO dao;
-    Facility fa = dao.findByFacilityId(facilityId);
-    if (!fa.isValid() || fa.coordinate().isNull()) return;
+    QPointF scenePt;
+    if (!facilityScenePos(facilityId, &scenePt)) return;
 
-    QPointF scenePt = tileMapManager->geoToScene(fa.coordinate().x(), fa.coordinate().y());
     const double r = 8.0;
     QGraphicsEllipseItem *item = mapScene->addEllipse(scenePt.x() - r, scenePt.y() - r, 2*r, 2*r,
                                                       QPen(QColor(255, 120, 0), 3.0),
@@ -3585,6 +3525,31 @@ void MyForm::initializePipelineVisualization()
             updateStatus(QString("加载管网数据: %1/%2").arg(current).arg(total));
         });
         
+        // 后台查询完成、图层渲染结束后统计结果
+        connect(m_layerManager, &LayerManager::layersLoaded,
+                this, &MyForm::checkPipelineRenderResult);
+        
+        // 增量更新删除图形项前释放界面持有的指针
+        connect(m_layerManager, &LayerManager::entityItemAboutToBeRemoved,
+                this, &MyForm::releaseEntityItem);
+        
+        // 其他客户端的数据变更：增量更新图层与设备树；可能漏掉通知时整体刷新
+        ChangeListener &listener = ChangeListener::instance();
+        disconnect(&listener, nullptr, this, nullptr);
+        connect(&listener, &ChangeListener::changesReceived, this,
+                [this](const QVector<EntityChange> &changes) {
+            applyRemoteEntityChanges(changes);
+        });
+        connect(&listener, &ChangeListener::resyncRequired, this, [this]() {
+            if (m_layerManager) {
+                m_layerManager->onDataChanged();
+            }
+            setupDeviceTree();
+        });
+        if (!listener.start()) {
+            LOG_WARNING("Live data sync unavailable, use refresh to load changes from other users");
+        }
+        
         qDebug() << "[Pipeline] ✅ Signals connected";
         updateStatus("数据库已连接，准备加载管网数据...");
         
@@ -3594,6 +3559,14 @@ void MyForm::initializePipelineVisualization()
             qDebug() << "[Pipeline] ✅ LayerManager connected to control panel";
         }
         
+        // 诊断浮层统计各图层图形项数量
+        if (m_diagnosticsOverlay) {
+            m_diagnosticsOverlay->setLayerManager(m_layerManager);
+            if (Config::instance().getBool("Map/diagnostics_overlay", false)) {
+                m_diagnosticsOverlay->setOverlayEnabled(true);
+            }
+        }
+        
         // 6. 延迟加载初始数据（延迟2秒，确保地图视图已完全初始化）
         // 这样可以根据实际地图视图范围加载数据，而不是使用固定范围
         qDebug() << "[Pipeline] Scheduling data load in 2 seconds (waiting for map view to be ready)...";
@@ -3672,24 +3645,12 @@ void MyForm::loadPipelineData()
     DrawingDatabaseManager::loadFromDatabase(
         mapScene,
         m_drawnPipelines,
-        m_nextPipelineId
+        m_nextPipelineId,
+        itemRegistry()
     );
     
-    LOG_INFO("Pipeline layers refreshed");
-    updateStatus("管网数据加载完成");
-    
-    // 延迟刷新标注图层，确保场景中的图形项已经渲染完成
-    // 标注渲染器需要从场景中查找图形项，所以需要在其他图层渲染完成后再渲染标注
-    if (m_layerManager && m_layerManager->isLayerVisible(LayerManager::Labels)) {
-        QTimer::singleShot(50, this, [this]() {
-            if (m_layerManager) {
-                qDebug() << "[Pipeline] Refreshing annotation layer after data load";
-                m_layerManager->refreshLayer(LayerManager::Labels);
-            }
-        });
-    }
-    
-    checkPipelineRenderResult();
+    // 管线/设施在后台查询，标注与渲染结果统计在 LayerManager::layersLoaded 后进行
+    LOG_INFO("Pipeline layer refresh requested");
 }
 
 void MyForm::checkPipelineRenderResult()
@@ -3701,23 +3662,12 @@ void MyForm::checkPipelineRenderResult()
             return;
         }
         
-        // 统计场景中的项目
-        QList<QGraphicsItem*> allItems = mapScene->items();
-        int totalItems = allItems.size();
-        int pipelineItems = 0;
-        int facilityItems = 0;
-        
-        for (QGraphicsItem *item : allItems) {
-            QString type = item->data(0).toString();
-            if (type == "pipeline") {
-                pipelineItems++;
-            } else if (type == "facility") {
-                facilityItems++;
-            }
-        }
+        // 按图层注册表统计实体数量
+        LayerItemRegistry *registry = itemRegistry();
+        int pipelineItems = registry ? registry->pipelineItems(mapScene).size() : 0;
+        int facilityItems = registry ? registry->count(LayerManager::Facilities, mapScene) : 0;
         
         qDebug() << "[Pipeline] ========== Render Result ==========";
-        qDebug() << "[Pipeline] Total scene items:" << totalItems;
         qDebug() << "[Pipeline] Pipeline items:" << pipelineItems;
         qDebug() << "[Pipeline] Facility items:" << facilityItems;
         
@@ -3940,17 +3890,9 @@ void MyForm::renderConnectivityResult(const ConnectivityResult &result)
 void MyForm::highlightPipelineByIdForConnectivity(const QString &pipelineId, const QColor &color)
 {
     if (!mapScene || !tileMapManager) return;
-    PipelineDAO dao;
-    Pipeline pl = dao.findByPipelineId(pipelineId);
-    if (!pl.isValid() || pl.coordinates().isEmpty()) return;
+    QPainterPath path = pipelineScenePath(pipelineId);
+    if (path.isEmpty()) return;
 
-    QPainterPath path;
-    bool first = true;
-    for (const QPointF &geo : pl.coordinates()) {
-        QPointF scenePt = tileMapManager->geoToScene(geo.x(), geo.y());
-        if (first) { path.moveTo(scenePt); first = false; }
-        else { path.lineTo(scenePt); }
-    }
     QGraphicsPathItem *item = mapScene->addPath(path, QPen(color, 4.0, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin));
     item->setZValue(1e6 - 1);
     m_connectivityHighlights << item;
@@ -5094,7 +5036,8 @@ void MyForm::onAssetManagementButtonClicked()
                 DrawingDatabaseManager::loadFromDatabase(
                     mapScene,
                     m_drawnPipelines,
-                    m_nextPipelineId
+                    m_nextPipelineId,
+                    itemRegistry()
                 );
             }
             // 延迟刷新标注层
@@ -5111,17 +5054,13 @@ void MyForm::onAssetManagementButtonClicked()
     connect(dialog, &AssetManagerDialog::pipelineDeleted, this, [this, scheduleMapRefresh](int id, const QString &pipelineId) {
         qDebug() << "[Asset Delete] Pipeline deleted:" << pipelineId;
         // 从场景中移除对应的管线图形项
-        if (mapScene) {
-            QList<QGraphicsItem*> allItems = mapScene->items();
-            for (QGraphicsItem *item : allItems) {
-                if (item->data(0).toString() == "pipeline" && 
-                    item->data(1).toString() == pipelineId) {
-                    qDebug() << "[Asset Delete] Removing pipeline graphics item from scene:" << pipelineId;
-                    mapScene->removeItem(item);
-                    delete item;
-                    break;
-                }
-            }
+        LayerItemRegistry *registry = itemRegistry();
+        QGraphicsItem *item = (mapScene && registry) ? registry->findEntity("pipeline", pipelineId, mapScene) : nullptr;
+        if (item) {
+            qDebug() << "[Asset Delete] Removing pipeline graphics item from scene:" << pipelineId;
+            registry->removeItem(item);
+            mapScene->removeItem(item);
+            delete item;
         }
         scheduleMapRefresh();
     });
@@ -5129,17 +5068,13 @@ void MyForm::onAssetManagementButtonClicked()
     connect(dialog, &AssetManagerDialog::facilityDeleted, this, [this, scheduleMapRefresh](int id, const QString &facilityId) {
         qDebug() << "[Asset Delete] Facility deleted:" << facilityId;
         // 从场景中移除对应的设施图形项
-        if (mapScene) {
-            QList<QGraphicsItem*> allItems = mapScene->items();
-            for (QGraphicsItem *item : allItems) {
-                if (item->data(0).toString() == "facility" && 
-                    item->data(1).toString() == facilityId) {
-                    qDebug() << "[Asset Delete] Removing facility graphics item from scene:" << facilityId;
-                    mapScene->removeItem(item);
-                    delete item;
-                    break;
-                }
-            }
+        LayerItemRegistry *registry = itemRegistry();
+        QGraphicsItem *item = (mapScene && registry) ? registry->findEntity("facility", facilityId, mapScene) : nullptr;
+        if (item) {
+            qDebug() << "[Asset Delete] Removing facility graphics item from scene:" << facilityId;
+            registry->removeItem(item);
+            mapScene->removeItem(item);
+            delete item;
         }
         scheduleMapRefresh();
     });
@@ -5256,37 +5191,37 @@ void MyForm::setupDeviceTree()
         return;
     }
     
-    // 从数据库加载管线和设施数据
-    PipelineDAO pipelineDao;
-    FacilityDAO facilityDao;
+    // 后台加载管线和设施数据，完成后构建设备树（重复刷新时只采用最后一次结果）
+    if (!m_deviceTreeLoader) {
+        m_deviceTreeLoader = new AsyncDAO(this);
+    }
+    m_deviceTreeLoader->cancelAll();
+    updateStatus("正在加载设备树...");
     
-    // 加载所有管线（限制1000条以避免性能问题）
-    QVector<Pipeline> allPipelines = pipelineDao.findAll(1000);
+    m_deviceTreeLoader->run([]() {
+        DeviceTreeData data;
+        // 流式加载全部管线与设施（按 id 键集分页，不截断）
+        PipelineDAO().forEach([&data](const Pipeline &pipeline) {
+            data.pipelines.append(pipeline);
+            return true;
+        });
+        FacilityDAO().forEach([&data](const Facility &facility) {
+            data.facilities.append(facility);
+            return true;
+        });
+        return data;
+    }, [this](const DeviceTreeData &data) {
+        populateDeviceTree(data.pipelines, data.facilities);
+    });
+}
+
+void MyForm::populateDeviceTree(const QVector<Pipeline> &allPipelines, const QVector<Facility> &allFacilities)
+{
     qDebug() << "[DeviceTree] Loaded" << allPipelines.size() << "pipelines from database";
-    
-    // 加载所有设施（限制1000个）
-    QVector<Facility> allFacilities = facilityDao.findAll(1000);
     qDebug() << "[DeviceTree] Loaded" << allFacilities.size() << "facilities from database";
     
-    // 定义管线类型映射（数据库类型 -> 显示名称）
-    QMap<QString, QString> pipelineTypeMap = {
-        {"water_supply", "📘 给水管"},
-        {"sewage", "📗 排水管"},
-        {"gas", "📙 燃气管"},
-        {"electric", "📕 电力电缆"},
-        {"telecom", "📒 通信光缆"},
-        {"heat", "📓 供热管"}
-    };
-    
-    // 定义设施类型映射（数据库类型 -> 显示名称）
-    QMap<QString, QString> facilityTypeMap = {
-        {"valve", "🚰 阀门井"},
-        {"manhole", "🚪 检查井"},
-        {"pump_station", "⚙️ 泵站"},
-        {"transformer", "⚡ 变压器"},
-        {"regulator", "🔧 调压站"},
-        {"junction_box", "📦 接线盒"}
-    };
+    const QMap<QString, QString> &pipelineTypeMap = deviceTreePipelineTypeNames();
+    const QMap<QString, QString> &facilityTypeMap = deviceTreeFacilityTypeNames();
     
     // 按管线类型分组
     QMap<QString, QVector<Pipeline>> pipelinesByType;
@@ -6197,20 +6132,8 @@ void MyForm::onDeviceTreeEdit()
     m_deviceTreeDialogActive = true;
     
     // 查找地图上的图形项
-    QGraphicsItem *graphicsItem = nullptr;
-    if (mapScene) {
-        QList<QGraphicsItem*> allItems = mapScene->items();
-        for (QGraphicsItem *sceneItem : allItems) {
-            QString sceneItemType = sceneItem->data(0).toString();
-            QString sceneItemId = sceneItem->data(1).toString();
-            
-            if ((itemType == "pipeline" && sceneItemType == "pipeline" && sceneItemId == deviceId) ||
-                (itemType == "facility" && sceneItemType == "facility" && sceneItemId == deviceId)) {
-                graphicsItem = sceneItem;
-                break;
-            }
-        }
-    }
+    LayerItemRegistry *registry = itemRegistry();
+    QGraphicsItem *graphicsItem = (mapScene && registry) ? registry->findEntity(itemType, deviceId, mapScene) : nullptr;
     
     if (itemType == "pipeline") {
         PipelineDAO pipelineDao;
@@ -6265,17 +6188,9 @@ void MyForm::onDeviceTreeEdit()
                         m_pendingChanges.append(change);
                     }
                     
-                    // 更新图形项的状态
-                    if (graphicsItem) {
-                        QVariant stateVariant = graphicsItem->data(100);
-                        EntityState currentState = EntityState::Detached;
-                        if (stateVariant.isValid()) {
-                            currentState = static_cast<EntityState>(stateVariant.toInt());
-                        }
-                        // 只有未变更状态才标记为修改
-                        if (currentState == EntityState::Unchanged) {
-                            graphicsItem->setData(100, static_cast<int>(EntityState::Modified));
-                        }
+                    // 更新图形项的状态（只有未变更状态才标记为修改）
+                    if (EntityGraphicsItem *entity = EntityGraphicsItem::fromItem(graphicsItem)) {
+                        entity->markModified();
                     }
                     
                     markAsModified();
@@ -6340,17 +6255,9 @@ void MyForm::onDeviceTreeEdit()
                         m_pendingChanges.append(change);
                     }
                     
-                    // 更新图形项的状态
-                    if (graphicsItem) {
-                        QVariant stateVariant = graphicsItem->data(100);
-                        EntityState currentState = EntityState::Detached;
-                        if (stateVariant.isValid()) {
-                            currentState = static_cast<EntityState>(stateVariant.toInt());
-                        }
-                        // 只有未变更状态才标记为修改
-                        if (currentState == EntityState::Unchanged) {
-                            graphicsItem->setData(100, static_cast<int>(EntityState::Modified));
-                        }
+                    // 更新图形项的状态（只有未变更状态才标记为修改）
+                    if (EntityGraphicsItem *entity = EntityGraphicsItem::fromItem(graphicsItem)) {
+                        entity->markModified();
                     }
                     
                     markAsModified();
@@ -6400,47 +6307,33 @@ void MyForm::onDeviceTreeDelete()
     int databaseId = -1;
     EntityState entityState = EntityState::Detached;
     
-    if (mapScene) {
-        QList<QGraphicsItem*> allItems = mapScene->items();
-        for (QGraphicsItem *sceneItem : allItems) {
-            QString sceneItemType = sceneItem->data(0).toString();
-            QString sceneItemId = sceneItem->data(1).toString();
-            
-            if ((itemType == "pipeline" && sceneItemType == "pipeline" && sceneItemId == deviceId) ||
-                (itemType == "facility" && sceneItemType == "facility" && sceneItemId == deviceId)) {
-                graphicsItem = sceneItem;
-                
-                // 获取实体状态
-                QVariant stateVariant = sceneItem->data(100);
-                if (stateVariant.isValid()) {
-                    entityState = static_cast<EntityState>(stateVariant.toInt());
-                }
-                
-                // 获取数据库ID
-                QVariant dbIdVariant = sceneItem->data(10);
-                if (!dbIdVariant.isValid() || dbIdVariant.toInt() <= 0) {
-                    dbIdVariant = sceneItem->data(1);
+    LayerItemRegistry *registry = itemRegistry();
+    QGraphicsItem *sceneItem = (mapScene && registry) ? registry->findEntity(itemType, deviceId, mapScene) : nullptr;
+    if (sceneItem) {
+        graphicsItem = sceneItem;
+        
+        // 获取实体状态与数据库ID
+        const EntityGraphicsItem *entity = EntityGraphicsItem::fromItem(sceneItem);
+        if (entity) {
+            entityState = entity->state();
+        }
+        
+        if (entity && entity->databaseId() > 0) {
+            databaseId = entity->databaseId();
+        } else {
+            // 通过设备ID查询数据库
+            if (itemType == "pipeline") {
+                PipelineDAO dao;
+                Pipeline pipeline = dao.findByPipelineId(deviceId);
+                if (pipeline.isValid()) {
+                    databaseId = pipeline.id();
                 }
-                
-                if (dbIdVariant.isValid() && dbIdVariant.toInt() > 0) {
-                    databaseId = dbIdVariant.toInt();
-                } else {
-                    // 通过设备ID查询数据库
-                    if (itemType == "pipeline") {
-                        PipelineDAO dao;
-                        Pipeline pipeline = dao.findByPipelineId(deviceId);
-                        if (pipeline.isValid()) {
-                            databaseId = pipeline.id();
-                        }
-                    } else if (itemType == "facility") {
-                        FacilityDAO dao;
-                        Facility facility = dao.findByFacilityId(deviceId);
-                        if (facility.isValid()) {
-                            databaseId = facility.id();
-                        }
-                    }
+            } else if (itemType == "facility") {
+                FacilityDAO dao;
+                Facility facility = dao.findByFacilityId(deviceId);
+                if (facility.isValid()) {
+                    databaseId = facility.id();
                 }
-                break;
             }
         }
     }
@@ -6500,7 +6393,9 @@ void MyForm::onDeviceTreeDelete()
     
     // 如果找到了图形项，更新实体状态为已删除
     if (graphicsItem) {
-        graphicsItem->setData(100, static_cast<int>(EntityState::Deleted));
+        if (EntityGraphicsItem *entity = EntityGraphicsItem::fromItem(graphicsItem)) {
+            entity->setState(EntityState::Deleted);
+        }
         
         // 使用命令模式删除（支持撤销）- 立即从界面移除
         DeleteEntityCommand *cmd = new DeleteEntityCommand(
@@ -6554,6 +6449,48 @@ void MyForm::onDeviceTreeCopy()
     updateStatus("已复制设备ID: " + deviceId);
 }
 
+// 点击设施聚类：放大到聚类拆分的层级
+bool MyForm::zoomIntoFacilityCluster(const QPointF &scenePos)
+{
+    if (!tileMapManager || !m_layerManager || !m_layerManager->getFacilityRenderer()) {
+        return false;
+    }
+    
+    FacilityRenderer *renderer = m_layerManager->getFacilityRenderer();
+    FacilityClusterItem *clusterItem = renderer->clusterItem();
+    if (!clusterItem || !clusterItem->isVisible() || !renderer->isClustered()) {
+        return false;
+    }
+    
+    FacilityClusterIndex::Cluster cluster = clusterItem->clusterAt(scenePos);
+    if (cluster.nodeId < 0 || cluster.count <= 1) {
+        return false;  // 单个设施交给常规点选处理
+    }
+    
+    // 以聚类中心为新的地图中心，放大到聚类拆分的层级
+    QPointF geo = FacilityClusterIndex::normToLonLat(QPointF(cluster.x, cluster.y));
+    int targetZoom = qBound(MIN_ZOOM_LEVEL, renderer->expansionZoom(cluster.nodeId), MAX_ZOOM_LEVEL);
+    if (targetZoom <= currentZoomLevel) {
+        targetZoom = qMin(currentZoomLevel + 1, MAX_ZOOM_LEVEL);
+    }
+    
+    // 丢弃尚未生效的滚轮缩放（直接跳转到目标层级）
+    m_pendingWheelFactor = 1.0;
+    
+    tileMapManager->setCenter(geo.y(), geo.x());
+    currentZoomLevel = targetZoom;
+    tileMapManager->setZoom(currentZoomLevel);
+    
+    m_layerManager->setZoom(currentZoomLevel);
+    
+    QPointF centerScene = tileMapManager->geoToScene(geo.x(), geo.y());
+    ui->graphicsView->centerOn(centerScene);
+    tileMapManager->updateTilesForViewImmediate(centerScene.x(), centerScene.y());
+    
+    updateStatus(QString("展开设施聚类（%1 个设施），层级: %2").arg(cluster.count).arg(currentZoomLevel));
+    return true;
+}
+
 // 在地图上定位
 void MyForm::onDeviceTreeLocateOnMap()
 {
@@ -6570,20 +6507,36 @@ void MyForm::onDeviceTreeLocateOnMap()
     QString itemType = item->data(Qt::UserRole + 1).toString();
     QString deviceId = item->data(Qt::UserRole).toString();
     
+    LayerItemRegistry *registry = itemRegistry();
+    
     if (itemType == "pipeline") {
-        PipelineDAO pipelineDao;
-        Pipeline pipeline = pipelineDao.findByPipelineId(deviceId);
-        if (pipeline.isValid() && !pipeline.coordinates().isEmpty()) {
-            // 定位到管线中心点
-            QPointF center = calculateCenter(pipeline.coordinates());
-            
+        // 已渲染的管线直接取图形项几何与名称，否则查询数据库
+        QPointF center;
+        QString pipelineName;
+        bool found = false;
+        if (PipelineGraphicsItem *pipelineItem = registry ? registry->findPipeline(deviceId, mapScene) : nullptr) {
+            QRectF bounds = pipelineItem->sceneTransform().mapRect(pipelineItem->path().boundingRect());
+            center = tileMapManager->sceneToGeo(bounds.center(), currentZoomLevel);
+            pipelineName = pipelineItem->name();
+            found = true;
+        } else {
+            PipelineDAO pipelineDao;
+            Pipeline pipeline = pipelineDao.findByPipelineId(deviceId);
+            if (pipeline.isValid() && !pipeline.coordinates().isEmpty()) {
+                center = calculateCenter(pipeline.coordinates());
+                pipelineName = pipeline.pipelineName();
+                found = true;
+            }
+        }
+        if (found) {
             // 设置地图中心点
             tileMapManager->setCenter(center.y(), center.x());
             
-            // 确保合适的缩放级别
+            // 确保合适的缩放级别（图形项同步到新层级，高亮复用其几何）
             if (currentZoomLevel < 8) {
                 currentZoomLevel = 8;  // 设置为较高级别以便查看细节
                 tileMapManager->setZoom(currentZoomLevel);
+                m_layerManager->setZoom(currentZoomLevel);
             }
             
             // 高亮显示管线
@@ -6595,17 +6548,30 @@ void MyForm::onDeviceTreeLocateOnMap()
             ui->graphicsView->centerOn(centerScene);
             tileMapManager->updateTilesForViewImmediate(centerScene.x(), centerScene.y());
             
-            updateStatus("已定位到管线: " + pipeline.pipelineName());
+            updateStatus("已定位到管线: " + pipelineName);
             qDebug() << "[DeviceTree] Located pipeline:" << deviceId << "at" << center;
         } else {
             QMessageBox::warning(this, "定位失败", "管线数据无效或缺少坐标信息");
         }
     } else if (itemType == "facility") {
-        FacilityDAO facilityDao;
-        Facility facility = facilityDao.findByFacilityId(deviceId);
-        if (facility.isValid() && !facility.coordinate().isNull()) {
-            QPointF coord = facility.coordinate();
-            
+        QPointF coord;
+        QString facilityName;
+        bool found = false;
+        if (FacilityGraphicsItem *facilityItem = registry ? registry->findFacility(deviceId, mapScene) : nullptr) {
+            QPointF scenePos = facilityItem->sceneTransform().map(facilityItem->rect().center());
+            coord = tileMapManager->sceneToGeo(scenePos, currentZoomLevel);
+            facilityName = facilityItem->name();
+            found = true;
+        } else {
+            FacilityDAO facilityDao;
+            Facility facility = facilityDao.findByFacilityId(deviceId);
+            if (facility.isValid() && !facility.coordinate().isNull()) {
+                coord = facility.coordinate();
+                facilityName = facility.facilityName();
+                found = true;
+            }
+        }
+        if (found) {
             // 设置地图中心点
             tileMapManager->setCenter(coord.y(), coord.x());
             
@@ -6613,6 +6579,7 @@ void MyForm::onDeviceTreeLocateOnMap()
             if (currentZoomLevel < 9) {
                 currentZoomLevel = 9;  // 设置为更高级别以便查看设施
                 tileMapManager->setZoom(currentZoomLevel);
+                m_layerManager->setZoom(currentZoomLevel);
             }
             
             // 高亮显示设施
@@ -6624,7 +6591,7 @@ void MyForm::onDeviceTreeLocateOnMap()
             ui->graphicsView->centerOn(centerScene);
             tileMapManager->updateTilesForViewImmediate(centerScene.x(), centerScene.y());
             
-            updateStatus("已定位到设施: " + facility.facilityName());
+            updateStatus("已定位到设施: " + facilityName);
             qDebug() << "[DeviceTree] Located facility:" << deviceId << "at" << coord;
         } else {
             QMessageBox::warning(this, "定位失败", "设施数据无效或缺少坐标信息");
@@ -7690,7 +7657,9 @@ void MyForm::onPipelineDrawingFinished(const QString &pipelineType, const QStrin
             QPen pen(lineColor, 4, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin);
             
             // 添加到场景
-            QGraphicsPathItem *item = mapScene->addPath(path, pen);
+            PipelineGraphicsItem *item = new PipelineGraphicsItem(path);
+            item->setPen(pen);
+            mapScene->addItem(item);
             item->setZValue(100);  // 确保在瓦片地图之上
             
             // 设置工具提示
@@ -7700,15 +7669,16 @@ void MyForm::onPipelineDrawingFinished(const QString &pipelineType, const QStrin
                                   .arg(pipeline.diameterMm());
             item->setToolTip(tooltip);
             
-            // 存储数据（用于后续查询和删除）
-            item->setData(0, "pipeline");
-            item->setData(1, pipeline.pipelineId());
-            item->setData(2, pipelineType);
-            item->setData(3, pipeline.pipelineName());  // 管线名称（用于标注显示）
-            item->setData(100, static_cast<int>(EntityState::Added));  // 新增：设置实体状态为Added
+            // 设置实体字段（用于后续查询和删除）
+            item->setEntityId(pipeline.pipelineId());
+            item->setEntityType(pipelineType);
+            item->setName(pipeline.pipelineName());  // 管线名称（用于标注显示）
+            item->setDiameterMm(pipeline.diameterMm());
+            item->setState(EntityState::Added);  // 新增：设置实体状态为Added
             
             // 关键：保存管线对象到hash表，用于后续编辑
             m_drawnPipelines[item] = pipeline;
+            registerEntityItem(item);
             
             // 更新连接的设施的 pipeline_id 字段
             if (!connectedFacilityIds.isEmpty()) {
@@ -7797,6 +7767,7 @@ void MyForm::markAsModified()
     if (!title.contains("*")) {
         setWindowTitle(title + " *");
     }
+    updateVectorTileEditing();
 }
 
 void MyForm::clearPendingChanges()
@@ -7807,6 +7778,91 @@ void MyForm::clearPendingChanges()
     QString title = windowTitle();
     title.remove(" *");
     setWindowTitle(title);
+    updateVectorTileEditing();
+}
+
+void MyForm::onExportMap()
+{
+    if (m_mapExportEngine && m_mapExportEngine->isRunning()) {
+        updateStatus("⏳ 地图导出进行中，请稍候");
+        return;
+    }
+    if (!mapScene || !tileMapManager) {
+        return;
+    }
+
+    QString fileName = QFileDialog::getSaveFileName(this, "导出地图",
+        QDir::homePath() + "/map_export.png",
+        "PNG 图像 (*.png);;PDF 文档 (*.pdf)");
+    if (fileName.isEmpty()) {
+        return;
+    }
+
+    // 导出层级越高，同一范围的输出幅面越大（每级长宽各翻倍）
+    bool ok = false;
+    int zoom = QInputDialog::getInt(this, "导出地图", "导出缩放级别：",
+                                    qMin(currentZoomLevel + 1, 20), currentZoomLevel, 20, 1, &ok);
+    if (!ok) {
+        return;
+    }
+
+    // 导出范围取当前视口
+    QRectF visible = ui->graphicsView->mapToScene(ui->graphicsView->viewport()->rect()).boundingRect();
+    QPointF topLeft = tileMapManager->sceneToGeo(visible.topLeft(), currentZoomLevel);
+    QPointF bottomRight = tileMapManager->sceneToGeo(visible.bottomRight(), currentZoomLevel);
+
+    MapExportSpec spec;
+    spec.geoBounds = QRectF(QPointF(topLeft.x(), bottomRight.y()),
+                            QPointF(bottomRight.x(), topLeft.y())).normalized();
+    spec.zoom = zoom;
+    spec.outputPath = fileName;
+    spec.format = MapExportSpec::formatForPath(fileName);
+    spec.dpi = Config::instance().getInt("Map/export_dpi", 300);
+    spec.memoryBudgetMb = Config::instance().getInt("Map/export_memory_mb", 64);
+    spec.basemapDir = tileMapManager->getCacheDir();
+
+    QVector<MapExportFeature> features = MapExportEngine::snapshotScene(
+        mapScene, itemRegistry(), m_layerManager, currentZoomLevel, spec);
+
+    if (!m_mapExportEngine) {
+        m_mapExportEngine = new MapExportEngine(this);
+    }
+
+    QRect pixels = MapExportEngine::pixelRect(spec);
+    QProgressDialog *progressDialog = new QProgressDialog(
+        QString("正在导出地图（%1 x %2 像素）...").arg(pixels.width()).arg(pixels.height()),
+        "取消", 0, 100, this);
+    progressDialog->setWindowTitle("导出地图");
+    progressDialog->setWindowModality(Qt::WindowModal);
+    progressDialog->setMinimumDuration(0);
+    progressDialog->setAutoClose(false);
+    progressDialog->setValue(0);
+
+    connect(progressDialog, &QProgressDialog::canceled, m_mapExportEngine, &MapExportEngine::cancel);
+    connect(m_mapExportEngine, &MapExportEngine::progress, progressDialog,
+            [progressDialog](int done, int total) {
+        progressDialog->setMaximum(total);
+        progressDialog->setValue(done);
+    });
+    connect(m_mapExportEngine, &MapExportEngine::finished, this,
+            [this, progressDialog](bool success, const QString &result) {
+        bool canceled = progressDialog->wasCanceled();
+        progressDialog->deleteLater();
+        if (success) {
+            updateStatus(QString("✅ 地图已导出: %1").arg(result));
+        } else if (canceled) {
+            updateStatus("已取消地图导出");
+        } else {
+            updateStatus("❌ 地图导出失败");
+            QMessageBox::warning(this, "导出地图", QString("地图导出失败：%1").arg(result));
+        }
+    }, Qt::SingleShotConnection);
+
+    if (!m_mapExportEngine->start(spec, features)) {
+        progressDialog->deleteLater();
+        return;
+    }
+    updateStatus(QString("⏳ 正在导出地图: %1").arg(fileName));
 }
 
 void MyForm::onSaveAll()
@@ -7884,9 +7940,12 @@ bool MyForm::savePendingChanges()
                                 .arg(originalId).arg(finalId);
                     pipeline.setPipelineId(finalId);
                     
-                    // 更新图形项的数据（如果有关联）
-                    if (change.graphicsItem) {
-                        change.graphicsItem->setData(1, finalId);
+                    // 更新图形项的编号（如果有关联）
+                    if (EntityGraphicsItem *entity = EntityGraphicsItem::fromItem(change.graphicsItem)) {
+                        entity->setEntityId(finalId);
+                        if (LayerItemRegistry *registry = itemRegistry()) {
+                            registry->reindexEntity(change.graphicsItem);
+                        }
                     }
                 }
                 
@@ -7912,7 +7971,7 @@ bool MyForm::savePendingChanges()
             if (change.type == ChangeAdded) {
                 // 如果 Facility 对象没有几何信息，从图形项中获取
                 if (facility.geomWkt().isEmpty() && change.graphicsItem) {
-                    QGraphicsEllipseItem *ellipseItem = qgraphicsitem_cast<QGraphicsEllipseItem*>(change.graphicsItem);
+                    FacilityGraphicsItem *ellipseItem = qgraphicsitem_cast<FacilityGraphicsItem*>(change.graphicsItem);
                     if (ellipseItem) {
                         // 获取图形项的中心点（场景坐标）
                         QRectF rect = ellipseItem->rect();
@@ -7965,9 +8024,12 @@ bool MyForm::savePendingChanges()
                                 .arg(originalId).arg(finalId);
                     facility.setFacilityId(finalId);
                     
-                    // 更新图形项的数据（如果有关联）
-                    if (change.graphicsItem) {
-                        change.graphicsItem->setData(1, finalId);
+                    // 更新图形项的编号（如果有关联）
+                    if (EntityGraphicsItem *entity = EntityGraphicsItem::fromItem(change.graphicsItem)) {
+                        entity->setEntityId(finalId);
+                        if (LayerItemRegistry *registry = itemRegistry()) {
+                            registry->reindexEntity(change.graphicsItem);
+                        }
                     }
                 }
                 
@@ -8070,12 +8132,12 @@ void MyForm::onFacilityDrawingFinished(const QString &facilityType, const QStrin
             
             // 创建圆形图形项
             double radius = 8.0;  // 设施半径
-            QGraphicsEllipseItem *ellipseItem = new QGraphicsEllipseItem(
+            FacilityGraphicsItem *ellipseItem = new FacilityGraphicsItem(QRectF(
                 point.x() - radius,
                 point.y() - radius,
                 radius * 2,
                 radius * 2
-            );
+            ));
             
             // 设置样式（根据类型）
             QColor color;
@@ -8108,12 +8170,11 @@ void MyForm::onFacilityDrawingFinished(const QString &facilityType, const QStrin
             ellipseItem->setPen(QPen(Qt::black, 2));
             ellipseItem->setZValue(150);  // 确保在管线之上
             
-            // 设置数据
-            ellipseItem->setData(0, "facility");  // 实体类型
-            ellipseItem->setData(1, facility.facilityId());  // 设施ID（现在保证不为空）
-            ellipseItem->setData(2, facilityTypeStr);  // 设施类型
-            ellipseItem->setData(3, facility.facilityName());  // 设施名称（用于标注显示）
-            ellipseItem->setData(100, static_cast<int>(EntityState::Added));  // 新增：设置实体状态为Added
+            // 设置实体字段
+            ellipseItem->setEntityId(facility.facilityId());  // 设施ID（现在保证不为空）
+            ellipseItem->setEntityType(facilityTypeStr);  // 设施类型
+            ellipseItem->setName(facility.facilityName());  // 设施名称（用于标注显示）
+            ellipseItem->setState(EntityState::Added);  // 新增：设置实体状态为Added
             
             // 设置可选中和可交互标志（重要：使设施可以被点击选中）
             ellipseItem->setFlag(QGraphicsItem::ItemIsSelectable, true);
@@ -8131,6 +8192,7 @@ void MyForm::onFacilityDrawingFinished(const QString &facilityType, const QStrin
             
             // 添加到场景
             mapScene->addItem(ellipseItem);
+            registerEntityItem(ellipseItem);
             
             // 添加到待保存变更列表
             PendingChange change;
@@ -8157,7 +8219,12 @@ void MyForm::onFacilityDrawingFinished(const QString &facilityType, const QStrin
             
             qDebug() << "✅ Facility created on scene (pending save):" << typeName;
             qDebug() << "   Pending changes count:" << m_pendingChanges.size();
-            
+
+            // 增量加入设施聚类索引（低层级聚类计数随之更新）
+            if (m_layerManager && m_layerManager->getFacilityRenderer()) {
+                m_layerManager->getFacilityRenderer()->insertFacility(FacilityRenderRecord::fromFacility(facility));
+            }
+
             // 延迟刷新标注图层，让新绘制的设备也显示标注
             // 注意：即使标注层当前不可见，也要刷新，这样当用户显示标注层时就能看到标注
             QTimer::singleShot(100, this, [this]() {
@@ -8199,7 +8266,8 @@ void MyForm::onEntityClicked(QGraphicsItem *item)
         return;
     }
     
-    qDebug() << "Entity clicked:" << item->data(1).toString();
+    const EntityGraphicsItem *entity = EntityGraphicsItem::fromItem(item);
+    qDebug() << "Entity clicked:" << (entity ? entity->entityId() : item->data(0).toString());
     
     // 清除之前的选中（必须先清除，否则之前的项不会取消高亮）
     if (m_selectedItem) {
@@ -8210,12 +8278,14 @@ void MyForm::onEntityClicked(QGraphicsItem *item)
     // 选中新项
     selectItem(item);
     
-    // 更新状态栏
-    QString entityType = item->data(0).toString();
-    QString entityId = item->data(2).toString(); // 使用编号（pipelineId/facilityId）
-    QString typeName = item->data(3).toString(); // 类型
+    // 更新状态栏（测量图形无实体字段）
+    if (!entity) {
+        return;
+    }
+    QString entityId = entity->entityId(); // 使用编号（pipelineId/facilityId）
+    QString typeName = entity->entityType(); // 类型
     
-    if (entityType == "pipeline") {
+    if (entity->entityKind() == EntityGraphicsItem::PipelineKind) {
         // 尝试从数据库获取更多信息
         QString pipelineId = entityId;
         QString statusText = QString("已选中管线: %1 (类型: %2)").arg(pipelineId).arg(typeName);
@@ -8233,7 +8303,7 @@ void MyForm::onEntityClicked(QGraphicsItem *item)
         }
         
         updateStatus(statusText);
-    } else if (entityType == "facility") {
+    } else {
         // 尝试从数据库获取更多信息
         QString facilityId = entityId;
         QString statusText = QString("已选中设施: %1 (类型: %2)").arg(facilityId).arg(typeName);
@@ -8259,7 +8329,7 @@ void MyForm::onEntityDoubleClicked(QGraphicsItem *item)
         return;
     }
     
-    qDebug() << "Entity double-clicked:" << item->data(1).toString();
+    qDebug() << "Entity double-clicked:" << EntityGraphicsItem::fromItem(item)->entityId();
     
     // 先选中
     if (item != m_selectedItem) {
@@ -8386,8 +8456,12 @@ void MyForm::onDeleteSelectedEntity()
         return;
     }
     
-    QString entityType = m_selectedItem->data(0).toString();
-    QString entityId = m_selectedItem->data(1).toString();
+    EntityGraphicsItem *entity = EntityGraphicsItem::fromItem(m_selectedItem);
+    if (!entity) {
+        return;
+    }
+    QString entityType = entity->kindName();
+    QString entityId = entity->entityId();
     
     // 检查权限
     bool hasPermission = false;
@@ -8417,11 +8491,7 @@ void MyForm::onDeleteSelectedEntity()
         qDebug() << "Deleting entity:" << entityId;
         
         // 获取实体状态
-        QVariant stateVariant = m_selectedItem->data(100);
-        EntityState entityState = EntityState::Detached;
-        if (stateVariant.isValid()) {
-            entityState = static_cast<EntityState>(stateVariant.toInt());
-        }
+        EntityState entityState = entity->state();
         
         qDebug() << "Entity state:" << static_cast<int>(entityState);
         
@@ -8448,21 +8518,13 @@ void MyForm::onDeleteSelectedEntity()
                     Pipeline pipeline = m_drawnPipelines[m_selectedItem];
                     databaseId = pipeline.id();
                 } else {
-                    // 如果 hash 表中没有（LayerManager 加载的数据），尝试从图形项获取数据库ID
-                    // PipelineRenderer 可能将数据库ID存储在 data(1) 或 data(10)
-                    QVariant dbIdVariant = m_selectedItem->data(10);  // 优先从 data(10) 获取
-                    if (!dbIdVariant.isValid() || dbIdVariant.toInt() <= 0) {
-                        dbIdVariant = m_selectedItem->data(1);  // 如果 data(10) 没有，尝试 data(1)
-                    }
-                    
-                    if (dbIdVariant.isValid() && dbIdVariant.toInt() > 0) {
-                        // 如果 data(1) 或 data(10) 存储的是数据库ID
-                        databaseId = dbIdVariant.toInt();
-                        qDebug() << "Got database ID from item data:" << databaseId;
+                    // 如果 hash 表中没有（LayerManager 加载的数据），从图形项获取数据库ID
+                    if (entity->databaseId() > 0) {
+                        databaseId = entity->databaseId();
+                        qDebug() << "Got database ID from item:" << databaseId;
                     } else {
-                        // 如果 data(1) 和 data(10) 都不是数据库ID，那么 data(1) 可能是 pipelineId
-                        // 尝试通过 pipelineId 查询数据库
-                        QString pipelineId = entityId;  // entityId 来自 data(1)
+                        // 图形项未记录数据库ID，通过 pipelineId 查询数据库
+                        QString pipelineId = entityId;
                         PipelineDAO dao;
                         Pipeline pipeline = dao.findByPipelineId(pipelineId);
                         if (pipeline.isValid()) {
@@ -8470,25 +8532,17 @@ void MyForm::onDeleteSelectedEntity()
                             qDebug() << "Got database ID from database query by pipelineId:" << pipelineId << "->" << databaseId;
                         } else {
                             qWarning() << "Failed to find pipeline by ID:" << pipelineId;
-                            qWarning() << "  data(1):" << m_selectedItem->data(1);
-                            qWarning() << "  data(10):" << m_selectedItem->data(10);
                         }
                     }
                 }
             } else if (entityType == "facility") {
                 // 尝试从图形项获取数据库ID
-                QVariant dbIdVariant = m_selectedItem->data(10);  // 优先从 data(10) 获取
-                if (!dbIdVariant.isValid() || dbIdVariant.toInt() <= 0) {
-                    dbIdVariant = m_selectedItem->data(1);  // 如果 data(10) 没有，尝试 data(1)
-                }
-                
-                if (dbIdVariant.isValid() && dbIdVariant.toInt() > 0) {
-                    // 如果 data(1) 或 data(10) 存储的是数据库ID
-                    databaseId = dbIdVariant.toInt();
-                    qDebug() << "Got facility database ID from item data:" << databaseId;
+                if (entity->databaseId() > 0) {
+                    databaseId = entity->databaseId();
+                    qDebug() << "Got facility database ID from item:" << databaseId;
                 } else {
-                    // 如果都不是，通过 facilityId 查询数据库
-                    QString facilityId = entityId;  // entityId 来自 data(1)，应该是 facilityId
+                    // 图形项未记录数据库ID，通过 facilityId 查询数据库
+                    QString facilityId = entityId;
                     FacilityDAO dao;
                     Facility facility = dao.findByFacilityId(facilityId);
                     if (facility.isValid()) {
@@ -8496,8 +8550,6 @@ void MyForm::onDeleteSelectedEntity()
                         qDebug() << "Got facility database ID from database query by facilityId:" << facilityId << "->" << databaseId;
                     } else {
                         qWarning() << "Failed to find facility by ID:" << facilityId;
-                        qWarning() << "  data(1):" << m_selectedItem->data(1);
-                        qWarning() << "  data(10):" << m_selectedItem->data(10);
                     }
                 }
             }
@@ -8528,11 +8580,11 @@ void MyForm::onDeleteSelectedEntity()
                         facility.setId(databaseId);
                         facility.setFacilityId(entityId);
                         // 尝试从图形项获取名称（如果存在）
-                        QString facilityName = m_selectedItem->data(3).toString();
+                        QString facilityName = entity->name();
                         if (!facilityName.isEmpty()) {
                             facility.setFacilityName(facilityName);
                         }
-                        QString facilityType = m_selectedItem->data(2).toString();
+                        QString facilityType = entity->entityType();
                         if (!facilityType.isEmpty()) {
                             facility.setFacilityType(facilityType);
                         }
@@ -8551,7 +8603,7 @@ void MyForm::onDeleteSelectedEntity()
         }
         
         // 更新实体状态为已删除
-        m_selectedItem->setData(100, static_cast<int>(EntityState::Deleted));
+        entity->setState(EntityState::Deleted);
         
         // 使用命令模式删除（支持撤销）- 立即从界面移除
         DeleteEntityCommand *cmd = new DeleteEntityCommand(
@@ -8574,6 +8626,7 @@ void MyForm::onDeleteSelectedEntity()
         
         // 清除选中
         m_selectedItem = nullptr;
+        updateVectorTileEditing();
         
         updateStatus(QString("已删除%1（待保存，共 %2 项待保存）")
                      .arg(entityType == "pipeline" ? "管线" : "设施")
@@ -8588,9 +8641,12 @@ void MyForm::onEditSelectedEntity()
         return;
     }
     
-    QString entityType = m_selectedItem->data(0).toString();
+    EntityGraphicsItem *entity = EntityGraphicsItem::fromItem(m_selectedItem);
+    if (!entity) {
+        return;
+    }
     
-    if (entityType == "pipeline") {
+    if (entity->entityKind() == EntityGraphicsItem::PipelineKind) {
         // 编辑管线
         Pipeline pipeline;
         bool found = false;
@@ -8601,7 +8657,7 @@ void MyForm::onEditSelectedEntity()
             found = true;
         } else {
             // 尝试从数据库查询（使用管线编号）
-            QString pipelineId = m_selectedItem->data(1).toString();
+            QString pipelineId = entity->entityId();
             if (!pipelineId.isEmpty() && DatabaseManager::instance().isConnected()) {
                 PipelineDAO dao;
                 pipeline = dao.findByPipelineId(pipelineId);
@@ -8651,7 +8707,7 @@ void MyForm::onEditSelectedEntity()
                             change.data = QVariant::fromValue(updatedPipeline);
                             // 更新图形项上的管线名称
                             QString newPipelineName = updatedPipeline.pipelineName();
-                            m_selectedItem->setData(3, newPipelineName);
+                            entity->setName(newPipelineName);
                             // 更新 m_drawnPipelines
                             m_drawnPipelines[m_selectedItem] = updatedPipeline;
                             found = true;
@@ -8662,7 +8718,7 @@ void MyForm::onEditSelectedEntity()
                             change.data = QVariant::fromValue(updatedPipeline);
                             // 更新图形项上的管线名称
                             QString newPipelineName = updatedPipeline.pipelineName();
-                            m_selectedItem->setData(3, newPipelineName);
+                            entity->setName(newPipelineName);
                             // 更新 m_drawnPipelines（如果存在）
                             if (m_drawnPipelines.contains(m_selectedItem)) {
                                 m_drawnPipelines[m_selectedItem] = updatedPipeline;
@@ -8686,24 +8742,17 @@ void MyForm::onEditSelectedEntity()
                     qDebug() << "[Edit Pipeline] Added new ChangeModified record";
                 }
                 
-                // 更新图形项上的管线名称（无论是否找到现有记录都要更新）
+                // 更新图形项上的管线名称与管径（无论是否找到现有记录都要更新）
                 QString newPipelineName = updatedPipeline.pipelineName();
-                m_selectedItem->setData(3, newPipelineName);
+                entity->setName(newPipelineName);
+                static_cast<PipelineGraphicsItem*>(m_selectedItem)->setDiameterMm(updatedPipeline.diameterMm());
                 // 更新 m_drawnPipelines（如果存在）
                 if (m_drawnPipelines.contains(m_selectedItem)) {
                     m_drawnPipelines[m_selectedItem] = updatedPipeline;
                 }
                 
-                // 更新图形项的状态
-                QVariant stateVariant = m_selectedItem->data(100);
-                EntityState currentState = EntityState::Detached;
-                if (stateVariant.isValid()) {
-                    currentState = static_cast<EntityState>(stateVariant.toInt());
-                }
-                // 只有未变更状态才标记为修改
-                if (currentState == EntityState::Unchanged) {
-                    m_selectedItem->setData(100, static_cast<int>(EntityState::Modified));
-                }
+                // 更新图形项的状态（只有未变更状态才标记为修改）
+                entity->markModified();
                 
                 markAsModified();
                 
@@ -8723,16 +8772,13 @@ void MyForm::onEditSelectedEntity()
         
         delete dialog;
         
-    } else if (entityType == "facility") {
+    } else {
         // 编辑设施
         Facility facility;
         bool found = false;
         
         // 获取设施ID（用于数据库查询和调试）
-        QString facilityId = m_selectedItem->data(1).toString();
-        if (facilityId.isEmpty()) {
-            facilityId = m_selectedItem->data(2).toString();
-        }
+        QString facilityId = entity->entityId();
         
         qDebug() << "[Edit Facility] Searching for facility, graphicsItem:" << m_selectedItem 
                  << "facilityId:" << facilityId 
@@ -8828,12 +8874,15 @@ void MyForm::onEditSelectedEntity()
                             // 更新图形项上的设施ID和名称（如果改变了）
                             QString newFacilityId = updatedFacility.facilityId();
                             if (!newFacilityId.isEmpty()) {
-                                m_selectedItem->setData(1, newFacilityId);
+                                entity->setEntityId(newFacilityId);
+                                if (LayerItemRegistry *registry = itemRegistry()) {
+                                    registry->reindexEntity(m_selectedItem);
+                                }
                             }
                             QString newFacilityName = updatedFacility.facilityName();
-                            m_selectedItem->setData(3, newFacilityName);  // 更新设施名称
+                            entity->setName(newFacilityName);  // 更新设施名称
                             // 更新tooltip
-                            QString typeName = m_selectedItem->data(2).toString();
+                            QString typeName = entity->entityType();
                             m_selectedItem->setToolTip(QString("%1\n类型: %2")
                                                        .arg(newFacilityName.isEmpty() ? newFacilityId : newFacilityName)
                                                        .arg(typeName));
@@ -8845,10 +8894,10 @@ void MyForm::onEditSelectedEntity()
                             change.data = QVariant::fromValue(updatedFacility);
                             // 更新图形项上的设施名称
                             QString newFacilityName = updatedFacility.facilityName();
-                            m_selectedItem->setData(3, newFacilityName);
+                            entity->setName(newFacilityName);
                             // 更新tooltip
-                            QString typeName = m_selectedItem->data(2).toString();
-                            QString facilityId = m_selectedItem->data(1).toString();
+                            QString typeName = entity->entityType();
+                            QString facilityId = entity->entityId();
                             m_selectedItem->setToolTip(QString("%1\n类型: %2")
                                                        .arg(newFacilityName.isEmpty() ? facilityId : newFacilityName)
                                                        .arg(typeName));
@@ -8873,24 +8922,16 @@ void MyForm::onEditSelectedEntity()
                 
                 // 更新图形项上的设施名称（无论是否找到现有记录都要更新）
                 QString newFacilityName = updatedFacility.facilityName();
-                m_selectedItem->setData(3, newFacilityName);
+                entity->setName(newFacilityName);
                 // 更新tooltip
-                QString typeName = m_selectedItem->data(2).toString();
-                QString facilityId = m_selectedItem->data(1).toString();
+                QString typeName = entity->entityType();
+                QString facilityId = entity->entityId();
                 m_selectedItem->setToolTip(QString("%1\n类型: %2")
                                            .arg(newFacilityName.isEmpty() ? facilityId : newFacilityName)
                                            .arg(typeName));
                 
-                // 更新图形项的状态
-                QVariant stateVariant = m_selectedItem->data(100);
-                EntityState currentState = EntityState::Detached;
-                if (stateVariant.isValid()) {
-                    currentState = static_cast<EntityState>(stateVariant.toInt());
-                }
-                // 只有未变更状态才标记为修改
-                if (currentState == EntityState::Unchanged) {
-                    m_selectedItem->setData(100, static_cast<int>(EntityState::Modified));
-                }
+                // 更新图形项的状态（只有未变更状态才标记为修改）
+                entity->markModified();
                 
                 markAsModified();
                 
@@ -8911,9 +8952,12 @@ void MyForm::onViewEntityProperties()
         return;
     }
     
-    QString entityType = m_selectedItem->data(0).toString();
+    const EntityGraphicsItem *entity = EntityGraphicsItem::fromItem(m_selectedItem);
+    if (!entity) {
+        return;
+    }
     
-    if (entityType == "pipeline") {
+    if (entity->entityKind() == EntityGraphicsItem::PipelineKind) {
         Pipeline pipeline;
         bool found = false;
         
@@ -8923,40 +8967,30 @@ void MyForm::onViewEntityProperties()
             found = true;
         } else {
             // 尝试从数据库查询（使用管线编号）
-            // 管线ID存储在data(1)，data(2)存储的是管线类型
-            QString pipelineId = m_selectedItem->data(1).toString();
+            QString pipelineId = entity->entityId();
             if (!pipelineId.isEmpty() && DatabaseManager::instance().isConnected()) {
                 PipelineDAO dao;
                 pipeline = dao.findByPipelineId(pipelineId);
                 if (pipeline.isValid()) {
                     found = true;
                 } else {
-                    qDebug() << "[ViewProperties] Pipeline not found in database, pipelineId:" << pipelineId;
-                    qDebug() << "[ViewProperties] Item data(0):" << m_selectedItem->data(0);
-                    qDebug() << "[ViewProperties] Item data(1):" << m_selectedItem->data(1);
-                    qDebug() << "[ViewProperties] Item data(2):" << m_selectedItem->data(2);
-                    qDebug() << "[ViewProperties] Item data(10):" << m_selectedItem->data(10);
+                    qDebug() << "[ViewProperties] Pipeline not found in database, pipelineId:" << pipelineId
+                             << "type:" << entity->entityType() << "databaseId:" << entity->databaseId();
                 }
             } else {
-                qDebug() << "[ViewProperties] PipelineId is empty or database not connected";
-                qDebug() << "[ViewProperties] Item data(0):" << m_selectedItem->data(0);
-                qDebug() << "[ViewProperties] Item data(1):" << m_selectedItem->data(1);
-                qDebug() << "[ViewProperties] Item data(2):" << m_selectedItem->data(2);
+                qDebug() << "[ViewProperties] PipelineId is empty or database not connected, type:"
+                         << entity->entityType();
             }
         }
         
         if (!found) {
             // 如果管线不在数据库中，尝试从图形项中获取基本信息
-            QString pipelineId = m_selectedItem->data(1).toString();
-            QString pipelineName = m_selectedItem->data(3).toString();
-            QString pipelineType = m_selectedItem->data(2).toString();
+            QString pipelineId = entity->entityId();
+            QString pipelineName = entity->name();
+            QString pipelineType = entity->entityType();
             
             // 检查实体状态
-            QVariant stateVariant = m_selectedItem->data(100);
-            EntityState entityState = EntityState::Detached;
-            if (stateVariant.isValid()) {
-                entityState = static_cast<EntityState>(stateVariant.toInt());
-            }
+            EntityState entityState = entity->state();
             
             // 如果是新添加的管线（还没保存），显示基本信息
             if (entityState == EntityState::Added && !pipelineId.isEmpty()) {
@@ -8978,15 +9012,12 @@ void MyForm::onViewEntityProperties()
         viewDialog->setPipeline(pipeline);
         connect(viewDialog, &EntityViewDialog::editRequested, this, &MyForm::onEditSelectedEntity);
         viewDialog->exec();
-    } else if (entityType == "facility") {
+    } else {
         Facility facility;
         bool found = false;
         
         // 获取设施ID（用于数据库查询和调试）
-        QString facilityId = m_selectedItem->data(1).toString();
-        if (facilityId.isEmpty()) {
-            facilityId = m_selectedItem->data(2).toString();
-        }
+        QString facilityId = entity->entityId();
         
         qDebug() << "[View Facility] Searching for facility, graphicsItem:" << m_selectedItem 
                  << "facilityId:" << facilityId 
@@ -9066,7 +9097,8 @@ void MyForm::clearSelection()
             MoveEntityCommand *cmd = new MoveEntityCommand(
                 m_selectedItem,
                 m_selectedItemStartPos,
-                currentPos
+                currentPos,
+                entityPickIndex()
             );
             if (m_undoStack) {
                 m_undoStack->push(cmd);
@@ -9082,6 +9114,7 @@ void MyForm::clearSelection()
         unhighlightItem(m_selectedItem);
         m_selectedItem = nullptr;
         updateStatus("Ready");
+        updateVectorTileEditing();
     }
 }
 
@@ -9099,12 +9132,12 @@ void MyForm::selectItem(QGraphicsItem *item)
     item->setSelected(false);
     
     // 设置图形项为可移动（仅对设施有效，管线移动需要特殊处理）
-    QString entityType = item->data(0).toString();
-    if (entityType == "facility") {
+    if (EntityGraphicsItem::isFacility(item)) {
         item->setFlag(QGraphicsItem::ItemIsMovable, true);
     }
     
     highlightItem(item);
+    updateVectorTileEditing();
 }
 
 void MyForm::highlightItem(QGraphicsItem *item)
@@ -9113,11 +9146,9 @@ void MyForm::highlightItem(QGraphicsItem *item)
         return;
     }
     
-    QString entityType = item->data(0).toString();
-    
-    // 处理管线（QGraphicsPathItem）
-    QGraphicsPathItem *pathItem = qgraphicsitem_cast<QGraphicsPathItem*>(item);
-    if (pathItem && entityType == "pipeline") {
+    // 处理管线
+    PipelineGraphicsItem *pathItem = qgraphicsitem_cast<PipelineGraphicsItem*>(item);
+    if (pathItem) {
         // 保存原始画笔
         m_originalPen = pathItem->pen();
         
@@ -9132,9 +9163,9 @@ void MyForm::highlightItem(QGraphicsItem *item)
         return;
     }
     
-    // 处理设施（QGraphicsEllipseItem）
-    QGraphicsEllipseItem *ellipseItem = qgraphicsitem_cast<QGraphicsEllipseItem*>(item);
-    if (ellipseItem && entityType == "facility") {
+    // 处理设施
+    FacilityGraphicsItem *ellipseItem = qgraphicsitem_cast<FacilityGraphicsItem*>(item);
+    if (ellipseItem) {
         // 保存原始画笔和画刷
         m_originalPen = ellipseItem->pen();
         m_originalBrush = ellipseItem->brush();
@@ -9180,11 +9211,9 @@ void MyForm::unhighlightItem(QGraphicsItem *item)
         return;
     }
     
-    QString entityType = item->data(0).toString();
-    
-    // 处理管线（QGraphicsPathItem）
-    QGraphicsPathItem *pathItem = qgraphicsitem_cast<QGraphicsPathItem*>(item);
-    if (pathItem && entityType == "pipeline") {
+    // 处理管线
+    PipelineGraphicsItem *pathItem = qgraphicsitem_cast<PipelineGraphicsItem*>(item);
+    if (pathItem) {
         // 恢复原始画笔
         pathItem->setPen(m_originalPen);
         pathItem->setZValue(10);  // 恢复层级（管线原始Z值是10）
@@ -9193,9 +9222,9 @@ void MyForm::unhighlightItem(QGraphicsItem *item)
         return;
     }
     
-    // 处理设施（QGraphicsEllipseItem）
-    QGraphicsEllipseItem *ellipseItem = qgraphicsitem_cast<QGraphicsEllipseItem*>(item);
-    if (ellipseItem && entityType == "facility") {
+    // 处理设施
+    FacilityGraphicsItem *ellipseItem = qgraphicsitem_cast<FacilityGraphicsItem*>(item);
+    if (ellipseItem) {
         // 恢复原始画笔和画刷
         ellipseItem->setPen(m_originalPen);
         ellipseItem->setBrush(m_originalBrush);
@@ -9211,13 +9240,137 @@ void MyForm::unhighlightItem(QGraphicsItem *item)
 
 bool MyForm::isEntityItem(QGraphicsItem *item)
 {
+    // 按图形项类型判断（管线/设施图形项）
+    return EntityGraphicsItem::isEntity(item);
+}
+
+LayerItemRegistry* MyForm::itemRegistry() const
+{
+    return m_layerManager ? m_layerManager->itemRegistry() : nullptr;
+}
+
+EntityPickIndex* MyForm::entityPickIndex() const
+{
+    return m_layerManager ? m_layerManager->entityPickIndex() : nullptr;
+}
+
+qreal MyForm::pickSearchRadius() const
+{
+    // 使用屏幕像素作为基准，转换为场景坐标（2像素的容差）
+    const qreal screenPixelTolerance = 2.0;
+    QPointF screenDelta(screenPixelTolerance, 0);
+    QPointF sceneDelta = ui->graphicsView->mapToScene(screenDelta.toPoint()) - 
+                         ui->graphicsView->mapToScene(QPoint(0, 0));
+    qreal searchRadius = qAbs(sceneDelta.x());
+    
+    // 如果转换失败，使用默认值
+    if (searchRadius <= 0 || searchRadius > 1000) {
+        searchRadius = 2.0;
+    }
+    return searchRadius;
+}
+
+QGraphicsItem* MyForm::pickEntityAt(const QPointF &scenePos, qreal searchRadius)
+{
+    EntityPickIndex *pickIndex = entityPickIndex();
+    LayerItemRegistry *registry = itemRegistry();
+    if (!pickIndex || !registry) {
+        return nullptr;
+    }
+    
+    // 只接受仍在当前场景、可见且未标记删除的实体（撤销删除时图形项只移出场景）
+    auto accept = [this, registry](QGraphicsItem *candidate) {
+        return registry->containsInScene(candidate, mapScene)
+            && candidate->isVisible()
+            && EntityGraphicsItem::fromItem(candidate)->state() != EntityState::Deleted;
+    };
+    
+    // 设施是点，使用更大的容差
+    QGraphicsItem *item = pickIndex->pickNearest(scenePos, searchRadius * 2,
+                                                 EntityPickIndex::FacilityEntity, accept);
     if (!item) {
-        return false;
+        // 管线按点到线段的精确距离，避免在空白区域误选
+        item = pickIndex->pickNearest(scenePos, searchRadius,
+                                      EntityPickIndex::PipelineEntity, accept);
+    }
+    return item;
+}
+
+QGraphicsItem* MyForm::pickMeasureItem(const QPointF &scenePos, qreal searchRadius,
+                                       const QString &typePrefix, bool includeMarkers)
+{
+    // 测量结果数量很少，直接遍历各自的图形项，不做全场景查询
+    QList<QGraphicsItem*> candidates;
+    for (const DistanceMeasureResult &result : m_distanceMeasureResults) {
+        candidates << result.line << result.label;
+        if (includeMarkers) {
+            candidates << result.markers;
+        }
+    }
+    for (const AreaMeasureResult &result : m_areaMeasureResults) {
+        candidates << result.polygon << result.label;
+        if (includeMarkers) {
+            candidates << result.markers;
+        }
     }
     
-    // 检查是否有实体标记
-    QString entityType = item->data(0).toString();
-    return (entityType == "pipeline" || entityType == "facility");
+    // 搜索矩形换算到视口坐标，再映射回各图形项坐标（兼容忽略缩放的标签）
+    const QTransform viewportTransform = ui->graphicsView->viewportTransform();
+    const QRectF searchRect(scenePos.x() - searchRadius, scenePos.y() - searchRadius,
+                            searchRadius * 2, searchRadius * 2);
+    const QPolygonF devicePolygon = viewportTransform.map(QPolygonF(searchRect));
+    
+    for (QGraphicsItem *candidate : candidates) {
+        if (!candidate || candidate->scene() != mapScene || !candidate->isVisible()) {
+            continue;
+        }
+        const QString itemType = candidate->data(0).toString();
+        if (!typePrefix.isEmpty() && !itemType.startsWith(typePrefix)) {
+            continue;
+        }
+        
+        bool invertible = false;
+        const QTransform toItem = candidate->deviceTransform(viewportTransform).inverted(&invertible);
+        if (!invertible) {
+            continue;
+        }
+        QPainterPath searchPath;
+        searchPath.addPolygon(toItem.map(devicePolygon));
+        searchPath.closeSubpath();
+        if (!candidate->boundingRect().intersects(searchPath.boundingRect())) {
+            continue;
+        }
+        if (candidate->collidesWithPath(searchPath, Qt::IntersectsItemShape)) {
+            return candidate;
+        }
+    }
+    return nullptr;
+}
+
+void MyForm::registerEntityItem(QGraphicsItem *item)
+{
+    if (LayerItemRegistry *registry = itemRegistry()) {
+        registry->addEntityItem(item);
+    }
+}
+
+void MyForm::unregisterEntityItem(QGraphicsItem *item)
+{
+    if (LayerItemRegistry *registry = itemRegistry()) {
+        registry->removeItem(item);
+    }
+}
+
+void MyForm::updateVectorTileEditing()
+{
+    if (!m_layerManager || !m_layerManager->vectorTileCache()) {
+        return;
+    }
+    // 选中、绘制或存在未保存修改时，管线/设施以矢量图形项实时绘制
+    bool editing = m_selectedItem != nullptr
+                   || m_hasUnsavedChanges
+                   || (m_drawingManager && m_drawingManager->isDrawing());
+    m_layerManager->vectorTileCache()->setEditingActive(editing);
 }
 
 // ==========================================
@@ -9250,35 +9403,38 @@ void MyForm::onPasteEntity()
     // 复制图形项
     QGraphicsItem *newItem = nullptr;
     
-    if (auto pathItem = qgraphicsitem_cast<QGraphicsPathItem*>(m_copiedItem)) {
-        // 复制路径项（管线）
-        QGraphicsPathItem *newPathItem = new QGraphicsPathItem();
+    if (auto pathItem = qgraphicsitem_cast<PipelineGraphicsItem*>(m_copiedItem)) {
+        // 复制管线图形项
+        PipelineGraphicsItem *newPathItem = new PipelineGraphicsItem();
         newPathItem->setPath(pathItem->path());
         newPathItem->setPen(pathItem->pen());
         newPathItem->setBrush(pathItem->brush());
         newPathItem->setZValue(100);
         
-        // 复制数据
-        for (int i = 0; i < 10; ++i) {
-            newPathItem->setData(i, m_copiedItem->data(i));
-        }
+        // 复制实体字段（不复制数据库ID，副本未入库）
+        newPathItem->setEntityId(pathItem->entityId());
+        newPathItem->setEntityType(pathItem->entityType());
+        newPathItem->setName(pathItem->name());
+        newPathItem->setDiameterMm(pathItem->diameterMm());
+        newPathItem->setState(EntityState::Detached);
         
         // 偏移位置（20像素）
         newPathItem->setPos(m_copiedItem->pos() + QPointF(20, 20));
         
         newItem = newPathItem;
-    } else if (auto ellipseItem = qgraphicsitem_cast<QGraphicsEllipseItem*>(m_copiedItem)) {
-        // 复制椭圆项（设施）
-        QGraphicsEllipseItem *newEllipseItem = new QGraphicsEllipseItem();
+    } else if (auto ellipseItem = qgraphicsitem_cast<FacilityGraphicsItem*>(m_copiedItem)) {
+        // 复制设施图形项
+        FacilityGraphicsItem *newEllipseItem = new FacilityGraphicsItem();
         newEllipseItem->setRect(ellipseItem->rect());
         newEllipseItem->setPen(ellipseItem->pen());
         newEllipseItem->setBrush(ellipseItem->brush());
         newEllipseItem->setZValue(100);
         
-        // 复制数据
-        for (int i = 0; i < 10; ++i) {
-            newEllipseItem->setData(i, m_copiedItem->data(i));
-        }
+        // 复制实体字段（不复制数据库ID，副本未入库）
+        newEllipseItem->setEntityId(ellipseItem->entityId());
+        newEllipseItem->setEntityType(ellipseItem->entityType());
+        newEllipseItem->setName(ellipseItem->name());
+        newEllipseItem->setState(EntityState::Detached);
         
         // 偏移位置
         newEllipseItem->setPos(m_copiedItem->pos() + QPointF(20, 20));
@@ -9289,6 +9445,7 @@ void MyForm::onPasteEntity()
     if (newItem) {
         // 添加到场景
         mapScene->addItem(newItem);
+        registerEntityItem(newItem);
         
         // 选中新复制的项
         clearSelection();
@@ -9324,9 +9481,16 @@ void MyForm::onCopyStyle()
         return;
     }
     
-    // 获取颜色和线宽
-    QColor color = m_selectedItem->data(3).value<QColor>();
-    int lineWidth = m_selectedItem->data(4).toInt();
+    // 获取颜色和线宽（管线取画笔颜色，设施取填充颜色）
+    QColor color;
+    int lineWidth = 0;
+    if (auto pathItem = qgraphicsitem_cast<PipelineGraphicsItem*>(m_selectedItem)) {
+        color = pathItem->pen().color();
+        lineWidth = pathItem->pen().width();
+    } else if (auto ellipseItem = qgraphicsitem_cast<FacilityGraphicsItem*>(m_selectedItem)) {
+        color = ellipseItem->brush().color();
+        lineWidth = ellipseItem->pen().width();
+    }
     
     if (color.isValid() && lineWidth > 0) {
         m_copiedColor = color;
@@ -9348,9 +9512,16 @@ void MyForm::onPasteStyle()
         return;
     }
     
-    // 获取旧样式
-    QColor oldColor = m_selectedItem->data(3).value<QColor>();
-    int oldWidth = m_selectedItem->data(4).toInt();
+    // 获取旧样式（与 onCopyStyle 取值方式一致）
+    QColor oldColor;
+    int oldWidth = 0;
+    if (auto pathItem = qgraphicsitem_cast<PipelineGraphicsItem*>(m_selectedItem)) {
+        oldColor = pathItem->pen().color();
+        oldWidth = pathItem->pen().width();
+    } else if (auto ellipseItem = qgraphicsitem_cast<FacilityGraphicsItem*>(m_selectedItem)) {
+        oldColor = ellipseItem->brush().color();
+        oldWidth = ellipseItem->pen().width();
+    }
     
     // 使用命令模式修改样式（支持撤销）
     ChangeStyleCommand *cmd = new ChangeStyleCommand(
@@ -9417,7 +9588,8 @@ void MyForm::onSaveDrawingData()
     // 保存到数据库
     bool success = DrawingDatabaseManager::saveToDatabase(
         mapScene,
-        m_drawnPipelines
+        m_drawnPipelines,
+        itemRegistry()
     );
     
     if (success) {
@@ -9433,15 +9605,12 @@ void MyForm::onLoadDrawingData()
 {
     // 只加载用户绘制的数据（created_by = 'user_drawing'），不清空 LayerManager 加载的数据
     // 先检查是否已有用户绘制的数据，如果有则提示
+    // 用户绘制的管线均记录在 m_drawnPipelines 中，无需扫描场景
     bool hasUserDrawnData = false;
-    for (QGraphicsItem *item : mapScene->items()) {
-        QString entityType = item->data(0).toString();
-        if (entityType == "pipeline" || entityType == "facility") {
-            // 检查是否是用户绘制的数据（在 m_drawnPipelines 中）
-            if (m_drawnPipelines.contains(item)) {
-                hasUserDrawnData = true;
-                break;
-            }
+    for (auto it = m_drawnPipelines.constBegin(); it != m_drawnPipelines.constEnd(); ++it) {
+        if (it.key()->scene() == mapScene) {
+            hasUserDrawnData = true;
+            break;
         }
     }
     
@@ -9465,6 +9634,7 @@ void MyForm::onLoadDrawingData()
         }
         
         for (QGraphicsItem *item : itemsToRemove) {
+            unregisterEntityItem(item);
             mapScene->removeItem(item);
             delete item;
             m_drawnPipelines.remove(item);
@@ -9482,7 +9652,8 @@ void MyForm::onLoadDrawingData()
     bool success = DrawingDatabaseManager::loadFromDatabase(
         mapScene,
         m_drawnPipelines,
-        m_nextPipelineId
+        m_nextPipelineId,
+        itemRegistry()
     );
     
     if (success) {
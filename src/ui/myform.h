@@ -22,19 +22,26 @@
 #include <QDockWidget>
 #include <QStackedWidget>
 #include <QUndoStack>  // 撤销栈
+#include "map/viewupdatescheduler.h"  // 视图更新调度
 
 // 添加TileMapManager的前置声明
 class TileMapManager;
 class LayerManager;
+class LayerItemRegistry;
+class EntityPickIndex;
 class LayerControlPanel;
+class MapDiagnosticsOverlay;
+class MapExportEngine;
 class DrawingToolPanel;
 class MapDrawingManager;
+class AsyncDAO;
 class Pipeline;  // 添加Pipeline前置声明
 class Facility;  // 添加Facility前置声明
 class QGraphicsEllipseItem;
 class QGraphicsTextItem;
 class QGraphicsPolygonItem;
 struct BurstAnalysisResult;
+struct EntityChange;
 struct ConnectivityResult;
 enum class ConnectivityType;  // 前置声明
 class MessageDialog;  // 消息对话框前向声明
@@ -246,12 +253,30 @@ private:
     // 图层管理器（管网可视化）
     LayerManager *m_layerManager;
     
+    // 地图诊断浮层（F12 显示/隐藏，Ctrl+F12 导出帧耗时直方图）
+    MapDiagnosticsOverlay *m_diagnosticsOverlay = nullptr;
+    
+    // 高分辨率地图导出（Ctrl+P）
+    MapExportEngine *m_mapExportEngine = nullptr;
+    void onExportMap();
+    
     // 进度条相关
     QProgressBar *progressBar;
     bool isDownloading;
     
     // 拖动更新相关
     QTimer *viewUpdateTimer;  // 延迟更新定时器
+    
+    // 逐帧视图更新：事件处理只记录目标状态，每帧统一应用一次
+    ViewUpdateScheduler *m_viewUpdateScheduler = nullptr;
+    double m_pendingWheelFactor = 1.0;  // 尚未应用到视图的滚轮缩放倍数
+    QPointF m_pendingWheelAnchor;       // 最近一次滚轮的鼠标视口位置
+    QString m_pendingStatusText;        // 本帧待显示的状态栏文本
+    void onViewUpdateFrame(ViewUpdateScheduler::UpdateFlags flags);
+    void applyPendingWheelZoom();
+    void projectWheelZoom(double visualScale, int zoomLevel,
+                          double *outScale, int *outLevel) const;  // 视觉缩放跨阈值后的层级
+    void scheduleStatus(const QString &message);
     // 滚动条悬浮延迟展开
     QTimer *hScrollHoverTimer = nullptr;
     QTimer *vScrollHoverTimer = nullptr;
@@ -284,6 +309,7 @@ private:
     QModelIndex m_currentDeviceTreeIndex;  // 当前右键菜单选中的索引
     bool m_deviceTreeMenuActive;  // 右键菜单是否正在显示
     bool m_deviceTreeDialogActive;  // 设备详情对话框是否正在显示
+    AsyncDAO *m_deviceTreeLoader = nullptr;  // 设备树后台查询（重新加载时取消上一次）
     
     // 绘制工具相关成员
     QWidget *m_drawingToolContainer;       // 绘制工具容器（右侧滑出面板）
@@ -354,7 +380,16 @@ private:
     void clearPendingChanges();             // 清空待保存变更
     
     void setupFunctionalArea();
-    void setupDeviceTree();  // 设置设备树
+    void setupDeviceTree();  // 设置设备树（后台加载数据）
+    void populateDeviceTree(const QVector<Pipeline> &allPipelines, const QVector<Facility> &allFacilities);  // 按加载结果构建设备树
+    
+    // 其他客户端的数据变更（LISTEN/NOTIFY）：增量更新地图图层与设备树
+    void applyRemoteEntityChanges(const QVector<EntityChange> &changes);
+    void updateDeviceTreeEntity(const EntityChange &change);  // 增量更新设备树中的单个实体节点
+    QStandardItem* deviceTreeRoot(const QString &kind) const;  // 设备树一级节点（"pipeline"/"facility"）
+    void insertDeviceTreeNode(const QString &kind, const QString &key,
+                              const QString &type, const QString &displayName);  // 插入实体节点（必要时创建类型节点）
+    void releaseEntityItem(QGraphicsItem *item);  // 图形项删除前释放界面持有的引用
     QString formatPipelineDisplayName(const Pipeline &pipeline);  // 格式化管线显示名称
     QString formatFacilityDisplayName(const Facility &facility);  // 格式化设施显示名称
     QString getStatusIcon(const QString &status, int healthScore);  // 获取状态图标
@@ -406,6 +441,9 @@ private:
     void clearBurstHighlights();
     void highlightPipelineById(const QString &pipelineId);
     void highlightFacilityById(const QString &facilityId);
+    // 实体场景几何：优先按编号索引复用已渲染的图形项，不在场景中时才查询数据库
+    QPainterPath pipelineScenePath(const QString &pipelineId);
+    bool facilityScenePos(const QString &facilityId, QPointF *scenePos);
     void setUiEnabledDuringBurst(bool enabled);
     void startBurstSelectionMode();
     void cancelBurstSelectionMode();
@@ -458,6 +496,18 @@ private:
     void highlightItem(QGraphicsItem *item);  // 高亮显示
     void unhighlightItem(QGraphicsItem *item);// 取消高亮
     bool isEntityItem(QGraphicsItem *item);   // 判断是否为实体项
+    bool zoomIntoFacilityCluster(const QPointF &scenePos);  // 点击设施聚类时放大展开
+    qreal pickSearchRadius() const;                         // 点选容差（2像素对应的场景距离）
+    QGraphicsItem* pickEntityAt(const QPointF &scenePos, qreal searchRadius);  // 点选索引查找实体
+    QGraphicsItem* pickMeasureItem(const QPointF &scenePos, qreal searchRadius,
+                                   const QString &typePrefix, bool includeMarkers);  // 查找已完成的测量图形项
+    
+    // 图层图形项注册表辅助方法（新建实体项后登记，delete 前注销）
+    LayerItemRegistry* itemRegistry() const;
+    EntityPickIndex* entityPickIndex() const;
+    void registerEntityItem(QGraphicsItem *item);
+    void unregisterEntityItem(QGraphicsItem *item);
+    void updateVectorTileEditing();  // 编辑状态变化时切换矢量/栅格瓦片显示
     
     // 添加公共方法来触发区域下载
 public:
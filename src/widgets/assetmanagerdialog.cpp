@@ -9,6 +9,7 @@
 #include "widgets/assetstatisticsdialog.h"
 #include "core/auth/permissionmanager.h"
 #include "core/database/databasemanager.h"
+#include "dao/asyncdao.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QGroupBox>
@@ -21,10 +22,13 @@
 #include <QThread>
 #include <QSqlQuery>
 #include <QSqlError>
+#include <algorithm>
 
 AssetManagerDialog::AssetManagerDialog(QWidget *parent)
     : QDialog(parent)
     , m_currentTabIndex(0)
+    , m_pipelineLoader(new AsyncDAO(this))
+    , m_facilityLoader(new AsyncDAO(this))
 {
     setWindowTitle("资产管理");
     setMinimumSize(1200, 700);
@@ -212,11 +216,28 @@ void AssetManagerDialog::setupTables()
 void AssetManagerDialog::loadPipelines()
 {
     qDebug() << "[AssetManager] loadPipelines() called - reloading from database";
-    // 创建新的DAO实例，确保不使用缓存
-    PipelineDAO dao;
-    QVector<Pipeline> pipelines = dao.findAll(1000);
     
-    qDebug() << "[AssetManager] Loading pipelines: total=" << pipelines.size() << "from database";
+    // 后台查询，结果缓存在 m_pipelines 中，筛选条件变化时不再访问数据库
+    m_pipelineLoader->cancelAll();
+    m_tabWidget->setTabText(0, "管线资产 (加载中...)");
+    m_pipelineLoader->run([]() {
+        // 创建新的DAO实例，确保不使用缓存；按 id 键集分页读取全部记录（不截断）
+        QVector<Pipeline> pipelines;
+        PipelineDAO().forEach([&pipelines](const Pipeline &entity) {
+            pipelines.append(entity);
+            return true;
+        });
+        return pipelines;
+    }, [this](const QVector<Pipeline> &pipelines) {
+        qDebug() << "[AssetManager] Loading pipelines: total=" << pipelines.size() << "from database";
+        m_pipelines = pipelines;
+        refreshPipelineTable();
+    });
+}
+
+void AssetManagerDialog::refreshPipelineTable()
+{
+    const QVector<Pipeline> &pipelines = m_pipelines;
     
     // 暂时断开信号，避免加载时频繁触发
     m_pipelineTable->blockSignals(true);
@@ -303,11 +324,28 @@ void AssetManagerDialog::loadPipelines()
 void AssetManagerDialog::loadFacilities()
 {
     qDebug() << "[AssetManager] loadFacilities() called - reloading from database";
-    // 创建新的DAO实例，确保不使用缓存
-    FacilityDAO dao;
-    QVector<Facility> facilities = dao.findAll(1000);
     
-    qDebug() << "[AssetManager] Loading facilities: total=" << facilities.size() << "from database";
+    // 后台查询，结果缓存在 m_facilities 中，筛选条件变化时不再访问数据库
+    m_facilityLoader->cancelAll();
+    m_tabWidget->setTabText(1, "设施资产 (加载中...)");
+    m_facilityLoader->run([]() {
+        // 创建新的DAO实例，确保不使用缓存；按 id 键集分页读取全部记录（不截断）
+        QVector<Facility> facilities;
+        FacilityDAO().forEach([&facilities](const Facility &entity) {
+            facilities.append(entity);
+            return true;
+        });
+        return facilities;
+    }, [this](const QVector<Facility> &facilities) {
+        qDebug() << "[AssetManager] Loading facilities: total=" << facilities.size() << "from database";
+        m_facilities = facilities;
+        refreshFacilityTable();
+    });
+}
+
+void AssetManagerDialog::refreshFacilityTable()
+{
+    const QVector<Facility> &facilities = m_facilities;
     
     // 暂时断开信号，避免加载时频繁触发
     m_facilityTable->blockSignals(true);
@@ -390,16 +428,6 @@ void AssetManagerDialog::loadFacilities()
     onCheckBoxStateChanged();
 }
 
-void AssetManagerDialog::refreshPipelineTable()
-{
-    loadPipelines();
-}
-
-void AssetManagerDialog::refreshFacilityTable()
-{
-    loadFacilities();
-}
-
 QString AssetManagerDialog::getStatusDisplayName(const QString &status)
 {
     if (status == "active") return "运行中";
@@ -433,36 +461,12 @@ void AssetManagerDialog::onRefreshClicked()
 {
     qDebug() << "[AssetManager] Refresh button clicked, current tab:" << m_currentTabIndex;
     
-    // 强制处理事件，确保界面状态更新
-    QApplication::processEvents();
-    
+    // 重新从数据库加载数据（后台执行，返回后刷新表格）
     if (m_currentTabIndex == 0) {
-        // 清空表格并重新加载
-        m_pipelineTable->blockSignals(true);
-        m_pipelineTable->setRowCount(0);
-        m_pipelineTable->blockSignals(false);
-        // 强制刷新表格视图
-        m_pipelineTable->viewport()->update();
-        m_pipelineTable->update();
-        QApplication::processEvents();
-        // 重新从数据库加载数据
         loadPipelines();
     } else {
-        // 清空表格并重新加载
-        m_facilityTable->blockSignals(true);
-        m_facilityTable->setRowCount(0);
-        m_facilityTable->blockSignals(false);
-        // 强制刷新表格视图
-        m_facilityTable->viewport()->update();
-        m_facilityTable->update();
-        QApplication::processEvents();
-        // 重新从数据库加载数据
         loadFacilities();
     }
-    
-    // 最终强制刷新界面
-    QApplication::processEvents();
-    qDebug() << "[AssetManager] Refresh completed";
 }
 
 void AssetManagerDialog::onViewClicked()
@@ -790,6 +794,7 @@ void AssetManagerDialog::onDeleteClicked()
             deleteParams[":id"] = dbId;
             
             QSqlQuery deleteQuery = DatabaseManager::instance().executeQuery(deleteSql, deleteParams);
+            PipelineDAO::cache().invalidateById(dbId);
             if (deleteQuery.lastError().isValid()) {
                 failCount++;
                 failedIds.append(assetId);
@@ -891,6 +896,7 @@ void AssetManagerDialog::onDeleteClicked()
             deleteParams[":id"] = dbId;
             
             QSqlQuery deleteQuery = DatabaseManager::instance().executeQuery(deleteSql, deleteParams);
+            FacilityDAO::cache().invalidateById(dbId);
             if (deleteQuery.lastError().isValid()) {
                 failCount++;
                 failedIds.append(assetId);
@@ -974,58 +980,25 @@ void AssetManagerDialog::onDeleteClicked()
     // 7. 刷新表格界面
     qDebug() << "[AssetManager] Refreshing table after delete...";
     
-    // 强制处理事件，确保所有删除操作都完成
-    QApplication::processEvents();
-    
-    // 等待一小段时间，确保数据库操作完全提交（PostgreSQL默认自动提交）
-    QThread::msleep(100);
-    
-    // 重新加载数据（直接调用load函数，确保从数据库重新查询）
-    // 先清空表格，然后重新加载，确保界面同步更新
+    // 已删除的记录先从本地列表移除并立即刷新表格，再后台从数据库重新加载
+    const QSet<QString> deletedSet(deletedAssetIds.begin(), deletedAssetIds.end());
     if (isPipeline) {
-        // 清空表格并重新加载
-        m_pipelineTable->blockSignals(true);
-        m_pipelineTable->setRowCount(0);
-        m_pipelineTable->blockSignals(false);
-        // 强制刷新表格视图
-        m_pipelineTable->viewport()->update();
-        m_pipelineTable->update();
-        QApplication::processEvents();
-        // 重新从数据库加载数据
+        m_pipelines.erase(std::remove_if(m_pipelines.begin(), m_pipelines.end(),
+                                         [&deletedSet](const Pipeline &p) {
+            return deletedSet.contains(p.pipelineId());
+        }), m_pipelines.end());
+        refreshPipelineTable();
         loadPipelines();
     } else {
-        // 清空表格并重新加载
-        m_facilityTable->blockSignals(true);
-        m_facilityTable->setRowCount(0);
-        m_facilityTable->blockSignals(false);
-        // 强制刷新表格视图
-        m_facilityTable->viewport()->update();
-        m_facilityTable->update();
-        QApplication::processEvents();
-        // 重新从数据库加载数据
+        m_facilities.erase(std::remove_if(m_facilities.begin(), m_facilities.end(),
+                                          [&deletedSet](const Facility &f) {
+            return deletedSet.contains(f.facilityId());
+        }), m_facilities.end());
+        refreshFacilityTable();
         loadFacilities();
     }
-    
-    QApplication::processEvents();
     qDebug() << "[AssetManager] Table refreshed, current row count:" << currentTable->rowCount();
     
-    // 验证删除的设备是否还在表格中（用于调试）
-    if (successCount > 0 && !deletedAssetIds.isEmpty()) {
-        QStringList remainingIds;
-        for (int row = 0; row < currentTable->rowCount(); ++row) {
-            QString id = currentTable->item(row, 1)->text();
-            if (deletedAssetIds.contains(id)) {
-                remainingIds.append(id);
-            }
-        }
-        if (!remainingIds.isEmpty()) {
-            qWarning() << "[AssetManager] WARNING: Deleted assets still in table after refresh:" << remainingIds;
-            qWarning() << "[AssetManager] This indicates the deletion may not have been committed to database";
-        } else {
-            qDebug() << "[AssetManager] Verified: All deleted assets removed from table";
-        }
-    }
-    
     // 8. 显示操作结果
     QString resultMessage;
     if (failCount == 0) {
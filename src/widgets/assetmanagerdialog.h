@@ -7,10 +7,14 @@
 #include <QComboBox>
 #include <QLineEdit>
 #include <QTabWidget>
+#include <QVector>
+#include "core/models/pipeline.h"
+#include "core/models/facility.h"
 
 class QVBoxLayout;
 class QHBoxLayout;
 class QGroupBox;
+class AsyncDAO;
 
 /**
  * @brief 资产管理对话框
@@ -46,10 +50,10 @@ private:
     void setupUI();
     void setupFilterPanel();
     void setupTables();
-    void loadPipelines();
-    void loadFacilities();
-    void refreshPipelineTable();
-    void refreshFacilityTable();
+    void loadPipelines();           // 后台重新查询管线
+    void loadFacilities();          // 后台重新查询设施
+    void refreshPipelineTable();    // 按筛选条件重建管线表格（不访问数据库）
+    void refreshFacilityTable();    // 按筛选条件重建设施表格（不访问数据库）
     
     QString getStatusDisplayName(const QString &status);
     QString getTypeDisplayName(const QString &type, bool isPipeline);
@@ -80,6 +84,10 @@ private:
     
     // 数据
     int m_currentTabIndex;
+    QVector<Pipeline> m_pipelines;      // 最近一次查询结果
+    QVector<Facility> m_facilities;
+    AsyncDAO *m_pipelineLoader;         // 对话框关闭时随之取消
+    AsyncDAO *m_facilityLoader;
 };
 
 #endif // ASSETMANAGERDIALOG_H
@@ -1,8 +1,4 @@
 #include "assetstatisticsdialog.h"
-#include "dao/pipelinedao.h"
-#include "dao/facilitydao.h"
-#include "core/models/pipeline.h"
-#include "core/models/facility.h"
 #include "core/common/logger.h"
 #include "core/auth/permissionmanager.h"
 #include <QVBoxLayout>
@@ -205,347 +201,161 @@ void AssetStatisticsDialog::refreshStatistics()
 
 void AssetStatisticsDialog::calculateByType()
 {
-    QMap<QString, QVariant> statistics;
-    int total = 0;
+    QMap<QString, qint64> counts;
+    qint64 total = 0;
     
     if (m_isPipelineStatistics) {
-        PipelineDAO dao;
         QStringList types = {"water_supply", "sewage", "gas", "electric", "telecom", "heat"};
         QStringList typeNames = {"给水管线", "排水管线", "燃气管线", "电力电缆", "通信线缆", "供热管线"};
-        
-        for (int i = 0; i < types.size(); i++) {
-            QVector<Pipeline> pipelines = dao.findByType(types[i], 10000);
-            int count = pipelines.size();
-            statistics[typeNames[i]] = count;
-            total += count;
+        for (const QString &name : typeNames) {
+            counts[name] = 0;
         }
-    } else {
-        FacilityDAO dao;
-        QVector<Facility> facilities = dao.findAll(10000);
         
-        QMap<QString, int> typeCount;
-        for (const Facility &facility : facilities) {
-            QString type = facility.facilityType();
-            typeCount[type]++;
-            total++;
+        for (const AssetStatisticsDAO::Bucket &bucket : loadBuckets("type")) {
+            int index = types.indexOf(bucket.name);
+            QString name = index >= 0 ? typeNames[index] : bucket.name;
+            counts[name] += bucket.count;
+            total += bucket.count;
         }
-        
-        for (auto it = typeCount.constBegin(); it != typeCount.constEnd(); ++it) {
-            statistics[it.key()] = it.value();
+    } else {
+        for (const AssetStatisticsDAO::Bucket &bucket : loadBuckets("type")) {
+            counts[bucket.name] += bucket.count;
+            total += bucket.count;
         }
     }
     
-    // 计算占比
-    QMap<QString, QVariant> result;
-    for (auto it = statistics.constBegin(); it != statistics.constEnd(); ++it) {
-        int count = it.value().toInt();
-        double percentage = total > 0 ? (count * 100.0 / total) : 0.0;
-        QMap<QString, QVariant> item;
-        item["count"] = count;
-        item["percentage"] = percentage;
-        result[it.key()] = item;
-    }
-    
-    updateStatisticsTable(result, QStringList() << "分类" << "数量" << "占比(%)");
+    showCounts(counts, total, QStringList() << "分类" << "数量" << "占比(%)");
     m_totalLabel->setText(QString("总计: %1").arg(total));
-    m_summaryLabel->setText(QString("共 %1 个分类").arg(statistics.size()));
+    m_summaryLabel->setText(QString("共 %1 个分类").arg(counts.size()));
 }
 
 void AssetStatisticsDialog::calculateByStatus()
 {
-    QMap<QString, QVariant> statistics;
-    int total = 0;
+    QMap<QString, qint64> counts;
+    qint64 total = 0;
     
-    if (m_isPipelineStatistics) {
-        PipelineDAO dao;
-        QVector<Pipeline> pipelines = dao.findAll(10000);
-        
-        QMap<QString, int> statusCount;
-        for (const Pipeline &pipeline : pipelines) {
-            QString status = pipeline.status().isEmpty() ? "未知" : pipeline.status();
-            statusCount[status]++;
-            total++;
-        }
-        
-        for (auto it = statusCount.constBegin(); it != statusCount.constEnd(); ++it) {
-            statistics[it.key()] = it.value();
-        }
-    } else {
-        FacilityDAO dao;
-        QVector<Facility> facilities = dao.findAll(10000);
-        
-        QMap<QString, int> statusCount;
-        for (const Facility &facility : facilities) {
-            QString status = facility.status().isEmpty() ? "未知" : facility.status();
-            statusCount[status]++;
-            total++;
-        }
-        
-        for (auto it = statusCount.constBegin(); it != statusCount.constEnd(); ++it) {
-            statistics[it.key()] = it.value();
-        }
-    }
-    
-    // 计算占比
-    QMap<QString, QVariant> result;
-    for (auto it = statistics.constBegin(); it != statistics.constEnd(); ++it) {
-        int count = it.value().toInt();
-        double percentage = total > 0 ? (count * 100.0 / total) : 0.0;
-        QMap<QString, QVariant> item;
-        item["count"] = count;
-        item["percentage"] = percentage;
-        result[it.key()] = item;
+    for (const AssetStatisticsDAO::Bucket &bucket : loadBuckets("status")) {
+        counts[bucket.name] += bucket.count;
+        total += bucket.count;
     }
     
-    updateStatisticsTable(result, QStringList() << "状态" << "数量" << "占比(%)");
+    showCounts(counts, total, QStringList() << "状态" << "数量" << "占比(%)");
     m_totalLabel->setText(QString("总计: %1").arg(total));
-    m_summaryLabel->setText(QString("共 %1 种状态").arg(statistics.size()));
+    m_summaryLabel->setText(QString("共 %1 种状态").arg(counts.size()));
 }
 
 void AssetStatisticsDialog::calculateByMaterial()
 {
-    QMap<QString, QVariant> statistics;
-    int total = 0;
+    QMap<QString, qint64> counts;
+    qint64 total = 0;
     
-    if (m_isPipelineStatistics) {
-        PipelineDAO dao;
-        QVector<Pipeline> pipelines = dao.findAll(10000);
-        
-        QMap<QString, int> materialCount;
-        for (const Pipeline &pipeline : pipelines) {
-            QString material = pipeline.material().isEmpty() ? "未知" : pipeline.material();
-            materialCount[material]++;
-            total++;
-        }
-        
-        for (auto it = materialCount.constBegin(); it != materialCount.constEnd(); ++it) {
-            statistics[it.key()] = it.value();
-        }
-    } else {
-        FacilityDAO dao;
-        QVector<Facility> facilities = dao.findAll(10000);
-        
-        QMap<QString, int> materialCount;
-        for (const Facility &facility : facilities) {
-            QString material = facility.material().isEmpty() ? "未知" : facility.material();
-            materialCount[material]++;
-            total++;
-        }
-        
-        for (auto it = materialCount.constBegin(); it != materialCount.constEnd(); ++it) {
-            statistics[it.key()] = it.value();
-        }
+    for (const AssetStatisticsDAO::Bucket &bucket : loadBuckets("material")) {
+        counts[bucket.name] += bucket.count;
+        total += bucket.count;
     }
     
-    // 计算占比
-    QMap<QString, QVariant> result;
-    for (auto it = statistics.constBegin(); it != statistics.constEnd(); ++it) {
-        int count = it.value().toInt();
-        double percentage = total > 0 ? (count * 100.0 / total) : 0.0;
-        QMap<QString, QVariant> item;
-        item["count"] = count;
-        item["percentage"] = percentage;
-        result[it.key()] = item;
-    }
-    
-    updateStatisticsTable(result, QStringList() << "材质" << "数量" << "占比(%)");
+    showCounts(counts, total, QStringList() << "材质" << "数量" << "占比(%)");
     m_totalLabel->setText(QString("总计: %1").arg(total));
-    m_summaryLabel->setText(QString("共 %1 种材质").arg(statistics.size()));
+    m_summaryLabel->setText(QString("共 %1 种材质").arg(counts.size()));
 }
 
 void AssetStatisticsDialog::calculateByBuildYear()
 {
-    QMap<QString, QVariant> statistics;
-    int total = 0;
+    QMap<QString, qint64> counts;
+    qint64 total = 0;
     
-    if (m_isPipelineStatistics) {
-        PipelineDAO dao;
-        QVector<Pipeline> pipelines = dao.findAll(10000);
-        
-        QMap<QString, int> yearCount;
-        for (const Pipeline &pipeline : pipelines) {
-            QDate buildDate = pipeline.buildDate();
-            QString yearRange = buildDate.isValid() ? getBuildYearRange(buildDate.year()) : "未知";
-            yearCount[yearRange]++;
-            total++;
-        }
-        
-        for (auto it = yearCount.constBegin(); it != yearCount.constEnd(); ++it) {
-            statistics[it.key()] = it.value();
-        }
-    } else {
-        FacilityDAO dao;
-        QVector<Facility> facilities = dao.findAll(10000);
-        
-        QMap<QString, int> yearCount;
-        for (const Facility &facility : facilities) {
-            QDate buildDate = facility.buildDate();
-            QString yearRange = buildDate.isValid() ? getBuildYearRange(buildDate.year()) : "未知";
-            yearCount[yearRange]++;
-            total++;
-        }
-        
-        for (auto it = yearCount.constBegin(); it != yearCount.constEnd(); ++it) {
-            statistics[it.key()] = it.value();
-        }
+    for (const AssetStatisticsDAO::Bucket &bucket : loadBuckets("build_year")) {
+        counts[bucket.name] += bucket.count;
+        total += bucket.count;
     }
     
-    // 计算占比
-    QMap<QString, QVariant> result;
-    for (auto it = statistics.constBegin(); it != statistics.constEnd(); ++it) {
-        int count = it.value().toInt();
-        double percentage = total > 0 ? (count * 100.0 / total) : 0.0;
-        QMap<QString, QVariant> item;
-        item["count"] = count;
-        item["percentage"] = percentage;
-        result[it.key()] = item;
-    }
-    
-    updateStatisticsTable(result, QStringList() << "建设年代" << "数量" << "占比(%)");
+    showCounts(counts, total, QStringList() << "建设年代" << "数量" << "占比(%)");
     m_totalLabel->setText(QString("总计: %1").arg(total));
-    m_summaryLabel->setText(QString("共 %1 个年代区间").arg(statistics.size()));
+    m_summaryLabel->setText(QString("共 %1 个年代区间").arg(counts.size()));
 }
 
 void AssetStatisticsDialog::calculateByHealthLevel()
 {
-    QMap<QString, QVariant> statistics;
-    int total = 0;
+    QMap<QString, qint64> counts;
+    qint64 total = 0;
+    qint64 totalScore = 0;
     
     // 初始化健康度等级
     QStringList levels = {"优秀(90-100)", "良好(80-89)", "一般(60-79)", "较差(40-59)", "危险(0-39)"};
     for (const QString &level : levels) {
-        statistics[level] = 0;
+        counts[level] = 0;
     }
     
-    if (m_isPipelineStatistics) {
-        PipelineDAO dao;
-        QVector<Pipeline> pipelines = dao.findAll(10000);
-        
-        for (const Pipeline &pipeline : pipelines) {
-            int score = pipeline.healthScore();
-            QString level;
-            if (score >= 90) level = "优秀(90-100)";
-            else if (score >= 80) level = "良好(80-89)";
-            else if (score >= 60) level = "一般(60-79)";
-            else if (score >= 40) level = "较差(40-59)";
-            else level = "危险(0-39)";
-            
-            statistics[level] = statistics[level].toInt() + 1;
-            total++;
-        }
-    } else {
-        FacilityDAO dao;
-        QVector<Facility> facilities = dao.findAll(10000);
-        
-        for (const Facility &facility : facilities) {
-            int score = facility.healthScore();
-            QString level;
-            if (score >= 90) level = "优秀(90-100)";
-            else if (score >= 80) level = "良好(80-89)";
-            else if (score >= 60) level = "一般(60-79)";
-            else if (score >= 40) level = "较差(40-59)";
-            else level = "危险(0-39)";
-            
-            statistics[level] = statistics[level].toInt() + 1;
-            total++;
-        }
+    for (const AssetStatisticsDAO::Bucket &bucket : loadBuckets("health_level")) {
+        counts[bucket.name] += bucket.count;
+        total += bucket.count;
+        totalScore += bucket.healthSum;
     }
     
-    // 计算占比
-    QMap<QString, QVariant> result;
-    for (auto it = statistics.constBegin(); it != statistics.constEnd(); ++it) {
-        int count = it.value().toInt();
-        double percentage = total > 0 ? (count * 100.0 / total) : 0.0;
-        QMap<QString, QVariant> item;
-        item["count"] = count;
-        item["percentage"] = percentage;
-        result[it.key()] = item;
-    }
-    
-    updateStatisticsTable(result, QStringList() << "健康度等级" << "数量" << "占比(%)");
+    showCounts(counts, total, QStringList() << "健康度等级" << "数量" << "占比(%)");
     m_totalLabel->setText(QString("总计: %1").arg(total));
     
-    // 计算平均健康度
-    double avgScore = calculateAverageHealthScore();
+    // 平均健康度由各等级的健康度合计得出
+    double avgScore = total > 0 ? static_cast<double>(totalScore) / total : 0.0;
     m_summaryLabel->setText(QString("平均健康度: %1").arg(formatNumber(avgScore, 1)));
 }
 
 void AssetStatisticsDialog::calculateByLength()
 {
-    QMap<QString, QVariant> statistics;
-    int total = 0;
+    QMap<QString, qint64> counts;
+    qint64 total = 0;
     double totalLength = 0.0;
     
-    PipelineDAO dao;
-    QVector<Pipeline> pipelines = dao.findAll(10000);
-    
     QStringList ranges = {"0-100m", "100-500m", "500-1000m", "1000-2000m", "2000m以上"};
     for (const QString &range : ranges) {
-        statistics[range] = 0;
+        counts[range] = 0;
     }
     
-    for (const Pipeline &pipeline : pipelines) {
-        double length = pipeline.lengthM();
-        totalLength += length;
-        total++;
-        
-        QString range;
-        if (length < 100) range = "0-100m";
-        else if (length < 500) range = "100-500m";
-        else if (length < 1000) range = "500-1000m";
-        else if (length < 2000) range = "1000-2000m";
-        else range = "2000m以上";
-        
-        statistics[range] = statistics[range].toInt() + 1;
+    for (const AssetStatisticsDAO::Bucket &bucket : loadBuckets("length")) {
+        counts[bucket.name] += bucket.count;
+        total += bucket.count;
+        totalLength += bucket.lengthSum;
     }
     
-    // 计算占比
-    QMap<QString, QVariant> result;
-    for (auto it = statistics.constBegin(); it != statistics.constEnd(); ++it) {
-        int count = it.value().toInt();
-        double percentage = total > 0 ? (count * 100.0 / total) : 0.0;
-        QMap<QString, QVariant> item;
-        item["count"] = count;
-        item["percentage"] = percentage;
-        result[it.key()] = item;
-    }
-    
-    updateStatisticsTable(result, QStringList() << "长度区间" << "数量" << "占比(%)");
+    showCounts(counts, total, QStringList() << "长度区间" << "数量" << "占比(%)");
     m_totalLabel->setText(QString("总计: %1 条管线，总长度: %2 m").arg(total).arg(formatNumber(totalLength, 2)));
     m_summaryLabel->setText(QString("平均长度: %1 m").arg(formatNumber(total > 0 ? totalLength / total : 0, 2)));
 }
 
 void AssetStatisticsDialog::calculateByDiameter()
 {
-    QMap<QString, QVariant> statistics;
-    int total = 0;
-    
-    PipelineDAO dao;
-    QVector<Pipeline> pipelines = dao.findAll(10000);
+    QMap<QString, qint64> counts;
+    qint64 total = 0;
     
     QStringList ranges = {"DN50以下", "DN50-DN100", "DN100-DN200", "DN200-DN500", "DN500以上"};
     for (const QString &range : ranges) {
-        statistics[range] = 0;
+        counts[range] = 0;
     }
     
-    for (const Pipeline &pipeline : pipelines) {
-        int diameter = pipeline.diameterMm();
-        total++;
-        
-        QString range;
-        if (diameter < 50) range = "DN50以下";
-        else if (diameter < 100) range = "DN50-DN100";
-        else if (diameter < 200) range = "DN100-DN200";
-        else if (diameter < 500) range = "DN200-DN500";
-        else range = "DN500以上";
-        
-        statistics[range] = statistics[range].toInt() + 1;
+    for (const AssetStatisticsDAO::Bucket &bucket : loadBuckets("diameter")) {
+        counts[bucket.name] += bucket.count;
+        total += bucket.count;
     }
     
+    showCounts(counts, total, QStringList() << "管径区间" << "数量" << "占比(%)");
+    m_totalLabel->setText(QString("总计: %1 条管线").arg(total));
+    m_summaryLabel->setText(QString("共 %1 个管径区间").arg(counts.size()));
+}
+
+QVector<AssetStatisticsDAO::Bucket> AssetStatisticsDialog::loadBuckets(const QString &dimension) const
+{
+    AssetStatisticsDAO dao;
+    return dao.findByDimension(m_isPipelineStatistics ? AssetStatisticsDAO::PIPELINE
+                                                      : AssetStatisticsDAO::FACILITY,
+                               dimension);
+}
+
+void AssetStatisticsDialog::showCounts(const QMap<QString, qint64> &counts, qint64 total, const QStringList &headers)
+{
     // 计算占比
     QMap<QString, QVariant> result;
-    for (auto it = statistics.constBegin(); it != statistics.constEnd(); ++it) {
-        int count = it.value().toInt();
+    for (auto it = counts.constBegin(); it != counts.constEnd(); ++it) {
+        qint64 count = it.value();
         double percentage = total > 0 ? (count * 100.0 / total) : 0.0;
         QMap<QString, QVariant> item;
         item["count"] = count;
@@ -553,9 +363,7 @@ void AssetStatisticsDialog::calculateByDiameter()
         result[it.key()] = item;
     }
     
-    updateStatisticsTable(result, QStringList() << "管径区间" << "数量" << "占比(%)");
-    m_totalLabel->setText(QString("总计: %1 条管线").arg(total));
-    m_summaryLabel->setText(QString("共 %1 个管径区间").arg(statistics.size()));
+    updateStatisticsTable(result, headers);
 }
 
 void AssetStatisticsDialog::updateStatisticsTable(const QMap<QString, QVariant> &statistics, const QStringList &headers)
@@ -571,7 +379,7 @@ void AssetStatisticsDialog::updateStatisticsTable(const QMap<QString, QVariant>
     
     for (const QString &key : keys) {
         QMap<QString, QVariant> item = statistics[key].toMap();
-        int count = item["count"].toInt();
+        qint64 count = item["count"].toLongLong();
         double percentage = item["percentage"].toDouble();
         
         m_statisticsTable->setItem(row, 0, new QTableWidgetItem(key));
@@ -587,40 +395,6 @@ QString AssetStatisticsDialog::formatNumber(double value, int decimals) const
     return QString::number(value, 'f', decimals);
 }
 
-QString AssetStatisticsDialog::getBuildYearRange(int year) const
-{
-    if (year < 1980) return "1980年以前";
-    else if (year < 1990) return "1980-1989年";
-    else if (year < 2000) return "1990-1999年";
-    else if (year < 2010) return "2000-2009年";
-    else if (year < 2020) return "2010-2019年";
-    else return "2020年及以后";
-}
-
-double AssetStatisticsDialog::calculateAverageHealthScore() const
-{
-    double totalScore = 0.0;
-    int count = 0;
-    
-    if (m_isPipelineStatistics) {
-        PipelineDAO dao;
-        QVector<Pipeline> pipelines = dao.findAll(10000);
-        for (const Pipeline &pipeline : pipelines) {
-            totalScore += pipeline.healthScore();
-            count++;
-        }
-    } else {
-        FacilityDAO dao;
-        QVector<Facility> facilities = dao.findAll(10000);
-        for (const Facility &facility : facilities) {
-            totalScore += facility.healthScore();
-            count++;
-        }
-    }
-    
-    return count > 0 ? totalScore / count : 0.0;
-}
-
 void AssetStatisticsDialog::onExportExcelClicked()
 {
     // 设置默认导出目录为 docs
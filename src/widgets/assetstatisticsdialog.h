@@ -9,6 +9,7 @@
 #include <QDateEdit>
 #include <QGroupBox>
 #include <QLabel>
+#include "dao/assetstatisticsdao.h"
 
 class QVBoxLayout;
 class QHBoxLayout;
@@ -48,9 +49,10 @@ private:
     void calculateByDiameter();      // 按管径区间统计（管线）
     
     // 辅助方法
+    QVector<AssetStatisticsDAO::Bucket> loadBuckets(const QString &dimension) const;
+    void showCounts(const QMap<QString, qint64> &counts, qint64 total, const QStringList &headers);
     void updateStatisticsTable(const QMap<QString, QVariant> &statistics, const QStringList &headers);
     QString formatNumber(double value, int decimals = 2) const;
-    QString getBuildYearRange(int year) const;
 
 private:
     // UI组件
@@ -80,9 +82,6 @@ private:
     // 数据
     bool m_isPipelineStatistics;  // true=管线统计, false=设施统计
     QString m_currentDimension;   // 当前统计维度
-    
-    // 辅助方法
-    double calculateAverageHealthScore() const;
 };
 
 #endif // ASSETSTATISTICSDIALOG_H
@@ -4,6 +4,9 @@
 #include "core/models/facility.h"
 #include "dao/pipelinedao.h"
 #include "dao/facilitydao.h"
+#include "dao/bulkwriter.h"
+#include "core/common/logger.h"
+#include "core/database/databasemanager.h"
 #include "widgets/healthdevicelistdialog.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
@@ -142,7 +145,7 @@ void HealthAssessmentDialog::onAssessPipelinesClicked()
     m_allDevices.clear();
     
     // 异步执行评估
-    QFuture<QMap<QString, int>> future = QtConcurrent::run([this]() {
+    QFuture<QMap<QString, int>> future = QtConcurrent::run(DatabaseManager::instance().queryPool(), [this]() {
         QMap<QString, int> statistics;
         statistics["优秀"] = 0;
         statistics["良好"] = 0;
@@ -151,22 +154,17 @@ void HealthAssessmentDialog::onAssessPipelinesClicked()
         statistics["危险"] = 0;
         
         PipelineDAO dao;
-        QStringList types = {"water_supply", "sewage", "gas", "electric", "telecom", "heat"};
-        QVector<Pipeline> pipelines;
-        for (const QString &type : types) {
-            QVector<Pipeline> typePipelines = dao.findByType(type, 10000);
-            pipelines.append(typePipelines);
-        }
-        
-        int total = pipelines.size();
+        // 流式遍历全部管线（按批读取，不设数量上限）
+        int total = dao.count();
         int current = 0;
         
-        for (const Pipeline &pipeline : pipelines) {
+        BulkWriter writer(dao.tableName(), BulkWriter::Update, {"id", "integer"},
+                          {{"health_score", "integer"}});
+        dao.forEach([&](const Pipeline &pipeline) {
             HealthAssessmentResult result = m_analyzer->assessPipeline(pipeline);
             
-            Pipeline updatedPipeline = pipeline;
-            updatedPipeline.setHealthScore(result.score);
-            dao.update(updatedPipeline, pipeline.id());
+            // 健康度分数按批写回（单事务、只更新 health_score 列）
+            writer.add(pipeline.id(), {result.score});
             
             statistics[result.level]++;
             
@@ -180,6 +178,10 @@ void HealthAssessmentDialog::onAssessPipelinesClicked()
             
             current++;
             emit m_analyzer->assessmentProgress(current, total);
+            return true;
+        });
+        if (!writer.finish()) {
+            LOG_ERROR(QString("Failed to write health scores: %1").arg(writer.lastError()));
         }
         
         emit m_analyzer->assessmentComplete(total, 0);
@@ -219,7 +221,7 @@ void HealthAssessmentDialog::onAssessFacilitiesClicked()
     m_allDevices.clear();
     
     // 异步执行评估
-    QFuture<QMap<QString, int>> future = QtConcurrent::run([this]() {
+    QFuture<QMap<QString, int>> future = QtConcurrent::run(DatabaseManager::instance().queryPool(), [this]() {
         QMap<QString, int> statistics;
         statistics["优秀"] = 0;
         statistics["良好"] = 0;
@@ -228,17 +230,17 @@ void HealthAssessmentDialog::onAssessFacilitiesClicked()
         statistics["危险"] = 0;
         
         FacilityDAO dao;
-        QVector<Facility> facilities = dao.findAll(10000);
-        
-        int total = facilities.size();
+        // 流式遍历全部设施
+        int total = dao.count();
         int current = 0;
         
-        for (const Facility &facility : facilities) {
+        BulkWriter writer(dao.tableName(), BulkWriter::Update, {"id", "integer"},
+                          {{"health_score", "integer"}});
+        dao.forEach([&](const Facility &facility) {
             HealthAssessmentResult result = m_analyzer->assessFacility(facility);
             
-            Facility updatedFacility = facility;
-            updatedFacility.setHealthScore(result.score);
-            dao.update(updatedFacility, facility.id());
+            // 健康度分数按批写回（单事务、只更新 health_score 列）
+            writer.add(facility.id(), {result.score});
             
             statistics[result.level]++;
             
@@ -252,6 +254,10 @@ void HealthAssessmentDialog::onAssessFacilitiesClicked()
             
             current++;
             emit m_analyzer->assessmentProgress(current, total);
+            return true;
+        });
+        if (!writer.finish()) {
+            LOG_ERROR(QString("Failed to write health scores: %1").arg(writer.lastError()));
         }
         
         emit m_analyzer->assessmentComplete(0, total);
@@ -290,7 +296,7 @@ void HealthAssessmentDialog::onAssessAllClicked()
     m_allDevices.clear();
     
     // 异步执行评估（先评估管线，再评估设施）
-    QFuture<QMap<QString, int>> pipelineFuture = QtConcurrent::run([this]() {
+    QFuture<QMap<QString, int>> pipelineFuture = QtConcurrent::run(DatabaseManager::instance().queryPool(), [this]() {
         QMap<QString, int> statistics;
         statistics["优秀"] = 0;
         statistics["良好"] = 0;
@@ -299,22 +305,17 @@ void HealthAssessmentDialog::onAssessAllClicked()
         statistics["危险"] = 0;
         
         PipelineDAO dao;
-        QStringList types = {"water_supply", "sewage", "gas", "electric", "telecom", "heat"};
-        QVector<Pipeline> pipelines;
-        for (const QString &type : types) {
-            QVector<Pipeline> typePipelines = dao.findByType(type, 10000);
-            pipelines.append(typePipelines);
-        }
-        
-        int total = pipelines.size();
+        // 流式遍历全部管线（按批读取，不设数量上限）
+        int total = dao.count();
         int current = 0;
         
-        for (const Pipeline &pipeline : pipelines) {
+        BulkWriter writer(dao.tableName(), BulkWriter::Update, {"id", "integer"},
+                          {{"health_score", "integer"}});
+        dao.forEach([&](const Pipeline &pipeline) {
             HealthAssessmentResult result = m_analyzer->assessPipeline(pipeline);
             
-            Pipeline updatedPipeline = pipeline;
-            updatedPipeline.setHealthScore(result.score);
-            dao.update(updatedPipeline, pipeline.id());
+            // 健康度分数按批写回（单事务、只更新 health_score 列）
+            writer.add(pipeline.id(), {result.score});
             
             statistics[result.level]++;
             
@@ -328,12 +329,16 @@ void HealthAssessmentDialog::onAssessAllClicked()
             
             current++;
             emit m_analyzer->assessmentProgress(current, total * 2); // 总进度是管线+设施
+            return true;
+        });
+        if (!writer.finish()) {
+            LOG_ERROR(QString("Failed to write health scores: %1").arg(writer.lastError()));
         }
         
         return statistics;
     });
     
-    QFuture<QMap<QString, int>> facilityFuture = QtConcurrent::run([this]() {
+    QFuture<QMap<QString, int>> facilityFuture = QtConcurrent::run(DatabaseManager::instance().queryPool(), [this]() {
         QMap<QString, int> statistics;
         statistics["优秀"] = 0;
         statistics["良好"] = 0;
@@ -342,17 +347,17 @@ void HealthAssessmentDialog::onAssessAllClicked()
         statistics["危险"] = 0;
         
         FacilityDAO dao;
-        QVector<Facility> facilities = dao.findAll(10000);
-        
-        int total = facilities.size();
+        // 流式遍历全部设施
+        int total = dao.count();
         int current = 0;
         
-        for (const Facility &facility : facilities) {
+        BulkWriter writer(dao.tableName(), BulkWriter::Update, {"id", "integer"},
+                          {{"health_score", "integer"}});
+        dao.forEach([&](const Facility &facility) {
             HealthAssessmentResult result = m_analyzer->assessFacility(facility);
             
-            Facility updatedFacility = facility;
-            updatedFacility.setHealthScore(result.score);
-            dao.update(updatedFacility, facility.id());
+            // 健康度分数按批写回（单事务、只更新 health_score 列）
+            writer.add(facility.id(), {result.score});
             
             statistics[result.level]++;
             
@@ -366,6 +371,10 @@ void HealthAssessmentDialog::onAssessAllClicked()
             
             current++;
             emit m_analyzer->assessmentProgress(current, total * 2);
+            return true;
+        });
+        if (!writer.finish()) {
+            LOG_ERROR(QString("Failed to write health scores: %1").arg(writer.lastError()));
         }
         
         return statistics;
@@ -16,6 +16,7 @@ LayerControlPanel::LayerControlPanel(QWidget *parent)
     , m_heatPipelineCheck(nullptr)
     , m_facilitiesCheck(nullptr)
     , m_labelsCheck(nullptr)
+    , m_heatmapCheck(nullptr)
 {
     setupUI();
     setupConnections();
@@ -72,6 +73,7 @@ void LayerControlPanel::setupUI()
     otherLayout->setContentsMargins(8, 8, 8, 8);
     
     otherLayout->addWidget(createLayerItem(LayerManager::Labels, "标注", QColor(64, 64, 64)));
+    otherLayout->addWidget(createLayerItem(LayerManager::Heatmap, "热力图", QColor(255, 64, 0)));
     
     m_otherGroup->setContentLayout(otherLayout);
     m_mainLayout->addWidget(m_otherGroup);
@@ -193,6 +195,9 @@ QWidget* LayerControlPanel::createLayerItem(LayerManager::LayerType type,
     case LayerManager::Labels:
         m_labelsCheck = checkBox;
         break;
+    case LayerManager::Heatmap:
+        m_heatmapCheck = checkBox;
+        break;
     default:
         break;
     }
@@ -61,6 +61,7 @@ private:
     // 设施图层复选框
     QCheckBox *m_facilitiesCheck;
     QCheckBox *m_labelsCheck;
+    QCheckBox *m_heatmapCheck;
     
     // 布局
     QVBoxLayout *m_mainLayout;
@@ -0,0 +1,356 @@
+#include "widgets/mapdiagnosticsoverlay.h"
+#include "map/layermanager.h"
+#include "map/layeritemregistry.h"
+#include "tilemap/tilemapmanager.h"
+#include "core/database/databasemanager.h"
+#include "core/database/queryprofiler.h"
+#include "core/common/logger.h"
+#include <QGraphicsView>
+#include <QCoreApplication>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QTimer>
+#include <QFile>
+#include <QDir>
+#include <QTextStream>
+#include <QDateTime>
+#include <QFontDatabase>
+#include <algorithm>
+
+namespace {
+// 直方图分桶上界（毫秒），最后一桶为超出上界的帧
+const double BUCKET_BOUNDS[] = {2, 4, 8, 16, 33, 50, 100, 200, 500};
+const int BUCKET_COUNT = sizeof(BUCKET_BOUNDS) / sizeof(BUCKET_BOUNDS[0]) + 1;
+
+double percentile(const QVector<double> &sorted, double p)
+{
+    if (sorted.isEmpty()) {
+        return 0.0;
+    }
+    const int index = qBound(0, static_cast<int>(p * (sorted.size() - 1) + 0.5), sorted.size() - 1);
+    return sorted[index];
+}
+}
+
+MapDiagnosticsOverlay::MapDiagnosticsOverlay(QGraphicsView *view)
+    : QWidget(view)
+    , m_view(view)
+    , m_viewport(view->viewport())
+    , m_layerManager(nullptr)
+    , m_tileMapManager(nullptr)
+    , m_refreshTimer(new QTimer(this))
+    , m_enabled(false)
+    , m_inPaint(false)
+    , m_frameHead(0)
+    , m_frameCount(0)
+    , m_totalFrames(0)
+    , m_lastRateFrames(0)
+    , m_lastDecodedTiles(0)
+    , m_framesPerSecond(0.0)
+    , m_decodedPerSecond(0.0)
+{
+    m_frameTimes.resize(FRAME_WINDOW);
+
+    // 不透明背景：浮层刷新不触发下方视口重绘，避免干扰帧耗时统计
+    setAttribute(Qt::WA_TransparentForMouseEvents);
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    move(8, 8);
+    hide();
+
+    m_refreshTimer->setInterval(REFRESH_INTERVAL);
+    connect(m_refreshTimer, &QTimer::timeout, this, &MapDiagnosticsOverlay::refreshText);
+}
+
+MapDiagnosticsOverlay::~MapDiagnosticsOverlay()
+{
+    if (m_enabled && m_viewport) {
+        m_viewport->removeEventFilter(this);
+    }
+}
+
+void MapDiagnosticsOverlay::setOverlayEnabled(bool enabled)
+{
+    if (m_enabled == enabled) {
+        return;
+    }
+    m_enabled = enabled;
+
+    if (enabled) {
+        // 后安装的过滤器先执行，保证在视图自身的绘制处理之前计时
+        m_viewport->installEventFilter(this);
+        m_rateTimer.start();
+        m_lastRateFrames = m_totalFrames;
+        m_lastDecodedTiles = m_tileMapManager ? m_tileMapManager->getTileStats().decodedTotal : 0;
+        refreshText();
+        show();
+        raise();
+        m_refreshTimer->start();
+        LOG_INFO("Map diagnostics overlay enabled");
+    } else {
+        m_viewport->removeEventFilter(this);
+        m_refreshTimer->stop();
+        hide();
+        LOG_INFO("Map diagnostics overlay disabled");
+    }
+}
+
+bool MapDiagnosticsOverlay::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == m_viewport && event->type() == QEvent::Paint && !m_inPaint) {
+        // 在本过滤器内重新分发绘制事件，以测得视图完整的绘制耗时
+        m_inPaint = true;
+        QElapsedTimer timer;
+        timer.start();
+        QCoreApplication::sendEvent(m_viewport, event);
+        recordFrame(timer.nsecsElapsed() / 1.0e6);
+        m_inPaint = false;
+        return true;
+    }
+    return QWidget::eventFilter(watched, event);
+}
+
+void MapDiagnosticsOverlay::recordFrame(double elapsedMs)
+{
+    m_frameTimes[m_frameHead] = elapsedMs;
+    m_frameHead = (m_frameHead + 1) % FRAME_WINDOW;
+    m_frameCount = qMin(m_frameCount + 1, static_cast<int>(FRAME_WINDOW));
+    m_totalFrames++;
+}
+
+QVector<double> MapDiagnosticsOverlay::frameSamples() const
+{
+    QVector<double> samples;
+    samples.reserve(m_frameCount);
+    const int start = m_frameCount < FRAME_WINDOW ? 0 : m_frameHead;
+    for (int i = 0; i < m_frameCount; ++i) {
+        samples.append(m_frameTimes[(start + i) % FRAME_WINDOW]);
+    }
+    return samples;
+}
+
+QVector<int> MapDiagnosticsOverlay::histogram(const QVector<double> &samples) const
+{
+    QVector<int> buckets(BUCKET_COUNT, 0);
+    for (double value : samples) {
+        int bucket = 0;
+        while (bucket < BUCKET_COUNT - 1 && value > BUCKET_BOUNDS[bucket]) {
+            bucket++;
+        }
+        buckets[bucket]++;
+    }
+    return buckets;
+}
+
+void MapDiagnosticsOverlay::refreshText()
+{
+    // 帧率与解码速率
+    const qint64 elapsedMs = m_rateTimer.restart();
+    if (elapsedMs > 0) {
+        m_framesPerSecond = (m_totalFrames - m_lastRateFrames) * 1000.0 / elapsedMs;
+        if (m_tileMapManager) {
+            const qint64 decoded = m_tileMapManager->getTileStats().decodedTotal;
+            m_decodedPerSecond = (decoded - m_lastDecodedTiles) * 1000.0 / elapsedMs;
+            m_lastDecodedTiles = decoded;
+        }
+    }
+    m_lastRateFrames = m_totalFrames;
+
+    m_lines = buildReport(false);
+
+    // 按文本调整浮层尺寸
+    const QFontMetrics metrics(font());
+    int width = 0;
+    for (const QString &line : m_lines) {
+        width = qMax(width, metrics.horizontalAdvance(line));
+    }
+    resize(width + 16, m_lines.size() * metrics.lineSpacing() + 12);
+    update();
+}
+
+QStringList MapDiagnosticsOverlay::buildReport(bool includeHistogram) const
+{
+    QStringList lines;
+
+    // 1. 帧耗时
+    QVector<double> samples = frameSamples();
+    QVector<double> sorted = samples;
+    std::sort(sorted.begin(), sorted.end());
+    const double lastFrame = samples.isEmpty() ? 0.0 : samples.last();
+    lines << QString("帧耗时  最近 %1 ms  FPS %2  窗口 %3 帧")
+                 .arg(lastFrame, 0, 'f', 1)
+                 .arg(m_framesPerSecond, 0, 'f', 1)
+                 .arg(samples.size());
+    lines << QString("        p50 %1  p95 %2  p99 %3  max %4 ms")
+                 .arg(percentile(sorted, 0.50), 0, 'f', 1)
+                 .arg(percentile(sorted, 0.95), 0, 'f', 1)
+                 .arg(percentile(sorted, 0.99), 0, 'f', 1)
+                 .arg(sorted.isEmpty() ? 0.0 : sorted.last(), 0, 'f', 1);
+
+    if (includeHistogram) {
+        const QVector<int> buckets = histogram(samples);
+        double lower = 0.0;
+        for (int i = 0; i < BUCKET_COUNT; ++i) {
+            const QString range = i < BUCKET_COUNT - 1
+                ? QString("%1-%2 ms").arg(lower, 0, 'f', 0).arg(BUCKET_BOUNDS[i], 0, 'f', 0)
+                : QString(">%1 ms").arg(lower, 0, 'f', 0);
+            const double ratio = samples.isEmpty() ? 0.0 : buckets[i] * 100.0 / samples.size();
+            lines << QString("  %1 %2 %3%  %4")
+                         .arg(range, -12)
+                         .arg(buckets[i], 6)
+                         .arg(ratio, 5, 'f', 1)
+                         .arg(QString(qRound(ratio / 2), QChar('#')));
+            if (i < BUCKET_COUNT - 1) {
+                lower = BUCKET_BOUNDS[i];
+            }
+        }
+    }
+
+    // 2. 图层图形项数量
+    if (m_layerManager && m_layerManager->itemRegistry()) {
+        LayerItemRegistry *registry = m_layerManager->itemRegistry();
+        const QGraphicsScene *scene = m_view->scene();
+        QStringList counts;
+        for (LayerManager::LayerType type : m_layerManager->getAllLayerTypes()) {
+            if (type == LayerManager::BaseMap) {
+                continue;
+            }
+            counts << QString("%1 %2").arg(m_layerManager->getLayerName(type))
+                                      .arg(registry->count(type, scene));
+        }
+        lines << QString("图形项  %1").arg(counts.join("  "));
+    }
+
+    // 3. 瓦片管线
+    if (m_tileMapManager) {
+        const TileMapManager::TileStats stats = m_tileMapManager->getTileStats();
+        lines << QString("瓦片    在途 %1  排队 %2  待插入 %3  解码 %4/s")
+                     .arg(stats.inFlight)
+                     .arg(stats.queued)
+                     .arg(stats.pendingInserts)
+                     .arg(m_decodedPerSecond, 0, 'f', 1);
+    }
+
+    // 4. 最近数据库查询
+    const QVector<DatabaseManager::QueryTiming> timings = DatabaseManager::instance().recentQueryTimings();
+    const int shown = includeHistogram ? timings.size() : qMin(5, timings.size());
+    lines << QString("数据库  最近 %1 条查询").arg(timings.size());
+    for (int i = timings.size() - 1; i >= timings.size() - shown; --i) {
+        const DatabaseManager::QueryTiming &timing = timings[i];
+        lines << QString("  %1 ms%2  %3")
+                     .arg(timing.elapsedMs, 7, 'f', 1)
+                     .arg(timing.success ? " " : "!")
+                     .arg(includeHistogram ? timing.sql : timing.sql.left(48));
+    }
+
+    // 5. 预编译语句缓存（导出时列出每条语句）
+    const QVector<DatabaseManager::StatementStats> statements = DatabaseManager::instance().statementStats();
+    if (!statements.isEmpty()) {
+        qint64 executions = 0;
+        qint64 hits = 0;
+        for (const DatabaseManager::StatementStats &stats : statements) {
+            executions += stats.executions;
+            hits += stats.cacheHits;
+        }
+        lines << QString("语句缓存  %1 条SQL  命中 %2/%3").arg(statements.size()).arg(hits).arg(executions);
+        if (includeHistogram) {
+            for (const DatabaseManager::StatementStats &stats : statements) {
+                lines << QString("  %1 次  命中 %2  平均 %3 ms  最大 %4 ms  %5")
+                             .arg(stats.executions)
+                             .arg(stats.cacheHits)
+                             .arg(stats.totalMs / qMax<qint64>(1, stats.executions), 0, 'f', 2)
+                             .arg(stats.maxMs, 0, 'f', 2)
+                             .arg(stats.sql);
+            }
+        }
+    }
+
+    // 6. 查询剖析：耗时最多的语句、慢查询与 N+1（导出时列出全部）
+    QueryProfiler &profiler = QueryProfiler::instance();
+    if (profiler.isEnabled()) {
+        const QVector<QueryProfiler::StatementProfile> profiles = profiler.statementProfiles();
+        const QVector<QueryProfiler::SlowQuery> slowQueries = profiler.slowQueries();
+        const QVector<QueryProfiler::NPlusOneWarning> warnings = profiler.nPlusOneWarnings();
+        lines << QString("查询剖析  %1 类语句  慢查询 %2  N+1 %3")
+                     .arg(profiles.size()).arg(slowQueries.size()).arg(warnings.size());
+
+        const int topCount = includeHistogram ? profiles.size() : qMin(3, profiles.size());
+        for (int i = 0; i < topCount; ++i) {
+            const QueryProfiler::StatementProfile &profile = profiles[i];
+            lines << QString("  %1 次  合计 %2 ms  p95 %3 ms  行 %4  字节 %5  %6")
+                         .arg(profile.executions)
+                         .arg(profile.totalMs, 0, 'f', 0)
+                         .arg(profile.percentileMs(0.95), 0, 'f', 1)
+                         .arg(profile.averageRows(), 0, 'f', 0)
+                         .arg(profile.averageBytes(), 0, 'f', 0)
+                         .arg(includeHistogram ? profile.sql : profile.sql.left(40));
+        }
+
+        const int warningCount = includeHistogram ? warnings.size() : qMin(1, warnings.size());
+        for (int i = warnings.size() - warningCount; i < warnings.size(); ++i) {
+            const QueryProfiler::NPlusOneWarning &warning = warnings[i];
+            lines << QString("  N+1 %1  %2 次  %3")
+                         .arg(warning.action)
+                         .arg(warning.executions)
+                         .arg(includeHistogram ? warning.sql : warning.sql.left(40));
+        }
+
+        if (includeHistogram) {
+            for (const QueryProfiler::SlowQuery &slow : slowQueries) {
+                lines << QString("  慢查询 %1  %2 ms  %3")
+                             .arg(slow.time.toString("HH:mm:ss"))
+                             .arg(slow.elapsedMs, 0, 'f', 1)
+                             .arg(slow.sql);
+                for (const QString &planLine : slow.plan.split('\n', Qt::SkipEmptyParts)) {
+                    lines << "      " + planLine;
+                }
+            }
+        }
+    }
+
+    return lines;
+}
+
+QString MapDiagnosticsOverlay::dumpHistogram(const QString &filePath) const
+{
+    QString path = filePath;
+    if (path.isEmpty()) {
+        const QString logDir = QDir::currentPath() + "/logs";
+        QDir().mkpath(logDir);
+        path = logDir + QString("/frame_stats_%1.txt")
+                            .arg(QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss"));
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        LOG_WARNING(QString("Failed to write frame stats: %1").arg(path));
+        return QString();
+    }
+
+    QTextStream out(&file);
+    out << "UGIMS 地图诊断  " << QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss") << "\n";
+    out << "累计帧数 " << m_totalFrames << "\n\n";
+    for (const QString &line : buildReport(true)) {
+        out << line << "\n";
+    }
+    file.close();
+
+    LOG_INFO(QString("Frame stats written to %1").arg(path));
+    return path;
+}
+
+void MapDiagnosticsOverlay::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+
+    QPainter painter(this);
+    painter.fillRect(rect(), QColor(30, 30, 30));
+    painter.setPen(QColor(120, 255, 120));
+
+    const QFontMetrics metrics(font());
+    int y = 6 + metrics.ascent();
+    for (const QString &line : m_lines) {
+        painter.drawText(8, y, line);
+        y += metrics.lineSpacing();
+    }
+}
@@ -0,0 +1,90 @@
+#ifndef MAPDIAGNOSTICSOVERLAY_H
+#define MAPDIAGNOSTICSOVERLAY_H
+
+#include <QWidget>
+#include <QVector>
+#include <QElapsedTimer>
+
+class QGraphicsView;
+class QTimer;
+class LayerManager;
+class TileMapManager;
+
+/**
+ * @brief 地图诊断浮层
+ *
+ * 特点：
+ * - 统计地图视口每帧绘制耗时（滚动窗口直方图与分位数）
+ * - 显示各图层场景图形项数量、瓦片在途/排队/待插入数量与每秒解码数
+ * - 显示最近的数据库查询耗时，以及查询剖析摘要（QueryProfiler：耗时最多的语句、慢查询、N+1）
+ * - 直方图可导出为文本文件，便于现场问题反馈附带数据
+ *
+ * 仅在显示时挂接视口绘制事件，隐藏后不产生额外开销
+ */
+class MapDiagnosticsOverlay : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit MapDiagnosticsOverlay(QGraphicsView *view);
+    ~MapDiagnosticsOverlay();
+
+    void setLayerManager(LayerManager *layerManager) { m_layerManager = layerManager; }
+    void setTileMapManager(TileMapManager *tileMapManager) { m_tileMapManager = tileMapManager; }
+
+    /**
+     * @brief 显示/隐藏浮层（同时开始/停止采样）
+     */
+    void setOverlayEnabled(bool enabled);
+    bool isOverlayEnabled() const { return m_enabled; }
+    void toggle() { setOverlayEnabled(!m_enabled); }
+
+    /**
+     * @brief 导出帧耗时直方图与当前统计
+     * @param filePath 为空时写入 logs/frame_stats_<时间>.txt
+     * @return 实际写入的文件路径，失败时为空
+     */
+    QString dumpHistogram(const QString &filePath = QString()) const;
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+    void paintEvent(QPaintEvent *event) override;
+
+private slots:
+    void refreshText();
+
+private:
+    void recordFrame(double elapsedMs);
+    QVector<double> frameSamples() const;          // 按时间顺序的窗口样本
+    QVector<int> histogram(const QVector<double> &samples) const;
+    QStringList buildReport(bool includeHistogram) const;
+
+    QGraphicsView *m_view;
+    QWidget *m_viewport;
+    LayerManager *m_layerManager;
+    TileMapManager *m_tileMapManager;
+    QTimer *m_refreshTimer;
+
+    bool m_enabled;
+    bool m_inPaint;                 // 重新分发绘制事件时避免重入
+
+    // 帧耗时滚动窗口（环形缓冲）
+    QVector<double> m_frameTimes;
+    int m_frameHead;
+    int m_frameCount;
+    qint64 m_totalFrames;
+
+    // 帧率与解码速率（按刷新间隔计算）
+    QElapsedTimer m_rateTimer;
+    qint64 m_lastRateFrames;
+    qint64 m_lastDecodedTiles;
+    double m_framesPerSecond;
+    double m_decodedPerSecond;
+
+    QStringList m_lines;
+
+    static const int FRAME_WINDOW = 1200;       // 滚动窗口帧数
+    static const int REFRESH_INTERVAL = 500;    // 浮层刷新间隔（毫秒）
+};
+
+#endif // MAPDIAGNOSTICSOVERLAY_H
@@ -1,5 +1,6 @@
 #include "workordermanagerdialog.h"
 #include "dao/workorderdao.h"
+#include "dao/asyncdao.h"
 #include "workordereditdialog.h"
 #include "core/common/logger.h"
 #include "core/auth/sessionmanager.h"
@@ -16,6 +17,7 @@ WorkOrderManagerDialog::WorkOrderManagerDialog(QWidget *parent)
     : QDialog(parent)
     , m_currentSelectedRow(-1)
     , m_statusTransition(new WorkOrderStatusTransition(this))
+    , m_loader(new AsyncDAO(this))
 {
     setWindowTitle("工单管理");
     setMinimumSize(1000, 600);
@@ -183,9 +185,15 @@ void WorkOrderManagerDialog::setupTable()
 
 void WorkOrderManagerDialog::loadWorkOrders()
 {
-    WorkOrderDAO dao;
-    m_workOrders = dao.findAll(1000);
-    refreshTable();
+    // 后台查询，返回后刷新表格；连续刷新只采用最后一次结果
+    m_loader->cancelAll();
+    setWindowTitle("工单管理 - 正在加载...");
+    m_loader->run([]() {
+        return WorkOrderDAO().findAll(1000);
+    }, [this](const QVector<WorkOrder> &workOrders) {
+        m_workOrders = workOrders;
+        refreshTable();
+    });
 }
 
 void WorkOrderManagerDialog::refreshTable()
@@ -14,6 +14,7 @@
 class QVBoxLayout;
 class QHBoxLayout;
 class QGroupBox;
+class AsyncDAO;
 
 /**
  * @brief 工单管理对话框
@@ -47,8 +48,8 @@ private:
     void setupUI();
     void setupFilterPanel();
     void setupTable();
-    void loadWorkOrders();
-    void refreshTable();
+    void loadWorkOrders();      // 后台重新查询工单
+    void refreshTable();        // 按筛选条件重建表格（不访问数据库）
     WorkOrder getSelectedWorkOrder();
     QString getStatusDisplayName(const QString &status);
     QString getTypeDisplayName(const QString &type);
@@ -90,6 +91,9 @@ private:
     // 状态转换管理器
     WorkOrderStatusTransition *m_statusTransition;
     
+    // 工单列表后台加载（对话框关闭时随之取消）
+    AsyncDAO *m_loader;
+    
     // 辅助方法
     void updateStatusTransitionButtons();
     bool performStatusTransition(const QString &targetStatus);